@@ -103,6 +103,7 @@ options {\n\
 	rrset-order { order random; };\n\
 	secroots-file \"named.secroots\";\n\
 	send-cookie true;\n\
+	serial-query-batch 256;\n\
 	serial-query-rate 20;\n\
 	server-id none;\n\
 	session-keyalg hmac-sha256;\n\
@@ -118,8 +119,11 @@ options {\n\
 	tcp-listen-queue 10;\n\
 	tcp-receive-buffer 0;\n\
 	tcp-send-buffer 0;\n\
+	tls-session-ticket-key-lifetime 43200; /* 12 hours */\n\
 #	tkey-domain <none>\n\
 #	tkey-gssapi-credential <none>\n\
+	transfer-cache-entries 64;\n\
+	transfer-cache-size 64M;\n\
 	transfer-message-size 20480;\n\
 	transfers-in 10;\n\
 	transfers-out 10;\n\
@@ -104,8 +104,9 @@ struct named_server {
 
 	dns_dtenv_t *dtenv; /*%< Dnstap environment */
 
-	isc_tlsctx_cache_t *tlsctx_server_cache;
-	isc_tlsctx_cache_t *tlsctx_client_cache;
+	isc_tlsctx_cache_t	 *tlsctx_server_cache;
+	isc_tlsctx_cache_t	 *tlsctx_client_cache;
+	isc_tlsctx_ticket_keys_t *tls_ticket_keys;
 
 	isc_signal_t *sighup;
 };
@@ -43,6 +43,23 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
  * \li	'zone' to be initialized.
  */
 
+isc_result_t
+named_zone_reattach(const cfg_obj_t *config, const cfg_obj_t *vconfig,
+		    const cfg_obj_t *zconfig, cfg_aclconfctx_t *ac,
+		    dns_kasplist_t *kasplist, dns_zone_t *zone,
+		    dns_zone_t *raw);
+/*%<
+ * Attach a zone whose configuration has not changed since it was last
+ * configured by named_zone_configure() to the dnssec-policy and ACLs
+ * of the new configuration, which are new objects even when their
+ * definitions are the same.
+ *
+ * Require:
+ * \li	'ac' to point to an initialized cfg_aclconfctx_t.
+ * \li	'kasplist' to be initialized.
+ * \li	'zone' to be initialized.
+ */
+
 bool
 named_zone_reusable(dns_zone_t *zone, const cfg_obj_t *zconfig,
 		    const cfg_obj_t *vconfig, const cfg_obj_t *config,
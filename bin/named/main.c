@@ -47,6 +47,7 @@
 #include <dns/dispatch.h>
 #include <dns/dyndb.h>
 #include <dns/name.h>
+#include <dns/qp.h>
 #include <dns/resolver.h>
 #include <dns/view.h>
 
@@ -741,6 +742,8 @@ parse_T_opt(char *option) {
 		named_g_nosyslog = true;
 	} else if (!strcmp(option, "notcp")) {
 		notcp = true;
+	} else if (!strcmp(option, "qphugepages")) {
+		dns_qp_hugepages(true);
 	} else if (!strncmp(option, "maxcachesize=", 13)) {
 		named_g_maxcachesize = atoi(option + 13);
 	} else if (!strcmp(option, "maxudp512")) {
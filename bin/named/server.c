@@ -61,6 +61,7 @@
 #include <isc/time.h>
 #include <isc/timer.h>
 #include <isc/util.h>
+#include <isc/work.h>
 
 #include <dns/adb.h>
 #include <dns/badcache.h>
@@ -120,6 +121,7 @@
 #include <ns/hooks.h>
 #include <ns/interfacemgr.h>
 #include <ns/listenlist.h>
+#include <ns/xfrout.h>
 
 #include <named/config.h>
 #include <named/control.h>
@@ -307,26 +309,63 @@ typedef struct {
 	named_server_t *server;
 	bool reconfig;
 	isc_refcount_t refs;
+	isc_nanosecs_t start;
 } ns_zoneload_t;
 
+typedef enum {
+	CATZ_ADDZONE,
+	CATZ_MODZONE,
+	CATZ_DELZONE,
+} catz_type_t;
+
+typedef struct catz_chgzone catz_chgzone_t;
+
+/*%
+ * The maximum number of catalog zone member changes applied while
+ * the loop manager is paused; the server goes back to answering
+ * queries between batches.  Only the changes in the current batch
+ * have a zone configuration.
+ */
+#define CATZ_BATCH_SIZE 1024
+
+/*%
+ * Catalog zone member changes waiting to be applied, and the batch
+ * being applied.  Only accessed from the main loop.
+ */
 typedef struct {
 	named_server_t *server;
+	ISC_LIST(catz_chgzone_t) queue;
+	bool scheduled;
+	catz_chgzone_t *batch[CATZ_BATCH_SIZE];
+	size_t nbatch;
+	unsigned int generating;
 } catz_cb_data_t;
 
-typedef struct catz_chgzone {
+struct catz_chgzone {
 	isc_mem_t *mctx;
 	dns_catz_entry_t *entry;
 	dns_catz_zone_t *origin;
 	dns_view_t *view;
 	catz_cb_data_t *cbd;
-	bool mod;
-} catz_chgzone_t;
+	catz_type_t type;
+	isc_result_t result;
+	cfg_parser_t *parser;
+	cfg_obj_t *zoneconf;
+	ns_cfgctx_t *cfg;
+	dns_zone_t *zone;
+	char nameb[DNS_NAME_FORMATSIZE];
+	ISC_LINK(catz_chgzone_t) link;
+};
 
-typedef enum {
-	CATZ_ADDZONE,
-	CATZ_MODZONE,
-	CATZ_DELZONE,
-} catz_type_t;
+/*%
+ * A share of a batch whose zone configurations are generated and
+ * parsed in the thread pool.
+ */
+typedef struct {
+	catz_cb_data_t *cbd;
+	size_t first;
+	size_t last;
+} catz_genwork_t;
 
 typedef struct {
 	unsigned int magic;
@@ -446,7 +485,7 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	       const cfg_obj_t *vconfig, dns_view_t *view,
 	       dns_viewlist_t *viewlist, dns_kasplist_t *kasplist,
 	       dns_keystorelist_t *keystores, cfg_aclconfctx_t *aclconf,
-	       bool added, bool old_rpz_ok, bool modify);
+	       bool added, bool old_rpz_ok, bool modify, uint64_t cfgdigest);
 
 static void
 configure_zone_setviewcommit(isc_result_t result, const cfg_obj_t *zconfig,
@@ -2642,38 +2681,60 @@ configure_rpz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t **maps,
 }
 
 static void
-catz_addmodzone_cb(void *arg) {
-	catz_chgzone_t *cz = (catz_chgzone_t *)arg;
+catz_stats_increment(isc_statscounter_t counter) {
+	isc_stats_increment(named_g_server->zonestats, counter);
+}
+
+/*
+ * Generate and parse the zone configuration for an added or modified
+ * member zone, with the parser of the calling thread.  This runs in
+ * the thread pool; the generated text is freed as soon as it has been
+ * parsed.
+ */
+static void
+catz_parsezone(catz_chgzone_t *cz, cfg_parser_t *parser) {
 	isc_result_t result;
-	dns_forwarders_t *dnsforwarders = NULL;
-	dns_name_t *name = NULL;
-	isc_buffer_t namebuf;
 	isc_buffer_t *confbuf = NULL;
-	char nameb[DNS_NAME_FORMATSIZE];
-	const cfg_obj_t *zlist = NULL;
-	cfg_obj_t *zoneconf = NULL;
-	cfg_obj_t *zoneobj = NULL;
-	ns_cfgctx_t *cfg = NULL;
-	dns_zone_t *zone = NULL;
 
-	if (isc_loop_shuttingdown(isc_loop_get(named_g_loopmgr, isc_tid()))) {
-		goto cleanup;
+	result = dns_catz_generate_zonecfg(cz->origin, cz->entry, &confbuf);
+	if (result == ISC_R_SUCCESS) {
+		cfg_parser_reset(parser);
+		result = cfg_parse_buffer(parser, confbuf, "catz", 0,
+					  &cfg_type_addzoneconf, 0,
+					  &cz->zoneconf);
+		isc_buffer_free(&confbuf);
 	}
-
-	cfg = (ns_cfgctx_t *)cz->view->new_zone_config;
-	if (cfg == NULL) {
+	/*
+	 * Fail if either dns_catz_generate_zonecfg() or cfg_parse_buffer()
+	 * failed.
+	 */
+	if (result != ISC_R_SUCCESS) {
 		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
 			      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-			      "catz: allow-new-zones statement missing from "
-			      "config; cannot add zone from the catalog");
-		goto cleanup;
+			      "catz: error \"%s\" while trying to generate "
+			      "config for zone '%s'",
+			      isc_result_totext(result), cz->nameb);
+	} else {
+		cfg_parser_attach(parser, &cz->parser);
 	}
+	cz->result = result;
+}
 
-	name = dns_catz_entry_getname(cz->entry);
+/*
+ * Check whether a member zone can be added or modified, and configure
+ * it.  Called with the loop manager paused.
+ */
+static void
+catz_addmodzone(catz_chgzone_t *cz) {
+	isc_result_t result;
+	dns_forwarders_t *dnsforwarders = NULL;
+	dns_name_t *name = dns_catz_entry_getname(cz->entry);
+	const cfg_obj_t *zlist = NULL;
+	const cfg_obj_t *zoneobj = NULL;
+	ns_cfgctx_t *cfg = cz->cfg;
+	dns_zone_t *zone = NULL;
 
-	isc_buffer_init(&namebuf, nameb, DNS_NAME_FORMATSIZE);
-	dns_name_totext(name, DNS_NAME_OMITFINALDOT, &namebuf);
-	isc_buffer_putuint8(&namebuf, 0);
+	CHECK(cz->result);
 
 	result = dns_fwdtable_find(cz->view->fwdtable, name, &dnsforwarders);
 	if (result == ISC_R_SUCCESS &&
@@ -2684,13 +2745,13 @@ catz_addmodzone_cb(void *arg) {
 			      "catz: catz_addmodzone_cb: "
 			      "zone '%s' will not be processed because of the "
 			      "explicitly configured forwarding for that zone",
-			      nameb);
-		goto cleanup;
+			      cz->nameb);
+		CHECK(ISC_R_FAILURE);
 	}
 
 	result = dns_view_findzone(cz->view, name, DNS_ZTFIND_EXACT, &zone);
 
-	if (cz->mod) {
+	if (cz->type == CATZ_MODZONE) {
 		dns_catz_zone_t *parentcatz;
 
 		if (result != ISC_R_SUCCESS) {
@@ -2698,7 +2759,7 @@ catz_addmodzone_cb(void *arg) {
 				      NAMED_LOGMODULE_SERVER, ISC_LOG_WARNING,
 				      "catz: error \"%s\" while trying to "
 				      "modify zone '%s'",
-				      isc_result_totext(result), nameb);
+				      isc_result_totext(result), cz->nameb);
 			goto cleanup;
 		}
 
@@ -2708,8 +2769,8 @@ catz_addmodzone_cb(void *arg) {
 				      "catz: catz_addmodzone_cb: "
 				      "zone '%s' is not a dynamically "
 				      "added zone",
-				      nameb);
-			goto cleanup;
+				      cz->nameb);
+			CHECK(ISC_R_FAILURE);
 		}
 
 		parentcatz = dns_zone_get_parentcatz(zone);
@@ -2720,8 +2781,8 @@ catz_addmodzone_cb(void *arg) {
 				      "catz: catz_addmodzone_cb: "
 				      "zone '%s' exists and is not added by "
 				      "a catalog zone, so won't be modified",
-				      nameb);
-			goto cleanup;
+				      cz->nameb);
+			CHECK(ISC_R_FAILURE);
 		}
 		if (parentcatz != cz->origin) {
 			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
@@ -2729,8 +2790,8 @@ catz_addmodzone_cb(void *arg) {
 				      "catz: catz_addmodzone_cb: "
 				      "zone '%s' exists in multiple "
 				      "catalog zones",
-				      nameb);
-			goto cleanup;
+				      cz->nameb);
+			CHECK(ISC_R_FAILURE);
 		}
 
 		dns_zone_detach(&zone);
@@ -2746,7 +2807,7 @@ catz_addmodzone_cb(void *arg) {
 					"zone '%s' will not be added "
 					"because it is an explicitly "
 					"configured zone",
-					nameb);
+					cz->nameb);
 			} else {
 				isc_log_write(
 					named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
@@ -2757,36 +2818,16 @@ catz_addmodzone_cb(void *arg) {
 					"because another catalog zone "
 					"already contains an entry with "
 					"that zone",
-					nameb);
+					cz->nameb);
 			}
-			goto cleanup;
+			CHECK(ISC_R_EXISTS);
 		} else {
 			RUNTIME_CHECK(result == ISC_R_NOTFOUND);
 		}
 	}
 	RUNTIME_CHECK(zone == NULL);
-	/* Create a config for new zone */
-	confbuf = NULL;
-	result = dns_catz_generate_zonecfg(cz->origin, cz->entry, &confbuf);
-	if (result == ISC_R_SUCCESS) {
-		cfg_parser_reset(cfg->add_parser);
-		result = cfg_parse_buffer(cfg->add_parser, confbuf, "catz", 0,
-					  &cfg_type_addzoneconf, 0, &zoneconf);
-		isc_buffer_free(&confbuf);
-	}
-	/*
-	 * Fail if either dns_catz_generate_zonecfg() or cfg_parse_buffer3()
-	 * failed.
-	 */
-	if (result != ISC_R_SUCCESS) {
-		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-			      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-			      "catz: error \"%s\" while trying to generate "
-			      "config for zone '%s'",
-			      isc_result_totext(result), nameb);
-		goto cleanup;
-	}
-	CHECK(cfg_map_get(zoneconf, "zone", &zlist));
+
+	CHECK(cfg_map_get(cz->zoneconf, "zone", &zlist));
 	if (!cfg_obj_islist(zlist)) {
 		CHECK(ISC_R_FAILURE);
 	}
@@ -2795,26 +2836,43 @@ catz_addmodzone_cb(void *arg) {
 	zoneobj = cfg_listelt_value(cfg_list_first(zlist));
 
 	/* Mark view unfrozen so that zone can be added */
-	isc_loopmgr_pause(named_g_loopmgr);
 	dns_view_thaw(cz->view);
 	result = configure_zone(cfg->config, zoneobj, cfg->vconfig, cz->view,
 				&cz->cbd->server->viewlist,
 				&cz->cbd->server->kasplist,
 				&cz->cbd->server->keystorelist, cfg->actx, true,
-				false, cz->mod);
+				false, cz->type == CATZ_MODZONE, 0);
 	dns_view_freeze(cz->view);
-	isc_loopmgr_resume(named_g_loopmgr);
 
 	if (result != ISC_R_SUCCESS) {
 		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
 			      NAMED_LOGMODULE_SERVER, ISC_LOG_WARNING,
-			      "catz: failed to configure zone '%s' - %d", nameb,
-			      result);
+			      "catz: failed to configure zone '%s' - %d",
+			      cz->nameb, result);
 		goto cleanup;
 	}
 
 	/* Is it there yet? */
-	CHECK(dns_view_findzone(cz->view, name, DNS_ZTFIND_EXACT, &zone));
+	CHECK(dns_view_findzone(cz->view, name, DNS_ZTFIND_EXACT, &cz->zone));
+
+cleanup:
+	if (zone != NULL) {
+		dns_zone_detach(&zone);
+	}
+	if (dnsforwarders != NULL) {
+		dns_forwarders_detach(&dnsforwarders);
+	}
+	cz->result = result;
+}
+
+/*
+ * Load a member zone configured by catz_addmodzone().  Called after
+ * the loop manager has been resumed.
+ */
+static void
+catz_loadzone(catz_chgzone_t *cz) {
+	isc_result_t result;
+	dns_zone_t *zone = cz->zone;
 
 	/*
 	 * Load the zone from the master file.	If this fails, we'll
@@ -2837,46 +2895,25 @@ catz_addmodzone_cb(void *arg) {
 
 		/* Remove the zone from the zone table */
 		dns_view_delzone(cz->view, zone);
-		goto cleanup;
+		cz->result = result;
+		return;
 	}
 
 	/* Flag the zone as having been added at runtime */
 	dns_zone_setadded(zone, true);
 	dns_zone_set_parentcatz(zone, cz->origin);
-
-cleanup:
-	if (zone != NULL) {
-		dns_zone_detach(&zone);
-	}
-	if (zoneconf != NULL) {
-		cfg_obj_destroy(cfg->add_parser, &zoneconf);
-	}
-	if (dnsforwarders != NULL) {
-		dns_forwarders_detach(&dnsforwarders);
-	}
-	dns_catz_entry_detach(cz->origin, &cz->entry);
-	dns_catz_zone_detach(&cz->origin);
-	dns_view_weakdetach(&cz->view);
-	isc_mem_putanddetach(&cz->mctx, cz, sizeof(*cz));
 }
 
+/*
+ * Delete a member zone.  Called with the loop manager paused.
+ */
 static void
-catz_delzone_cb(void *arg) {
-	catz_chgzone_t *cz = (catz_chgzone_t *)arg;
+catz_delzone_apply(catz_chgzone_t *cz) {
 	isc_result_t result;
 	dns_zone_t *zone = NULL;
 	dns_db_t *dbp = NULL;
-	char cname[DNS_NAME_FORMATSIZE];
 	const char *file = NULL;
 
-	if (isc_loop_shuttingdown(isc_loop_get(named_g_loopmgr, isc_tid()))) {
-		goto cleanup;
-	}
-
-	isc_loopmgr_pause(named_g_loopmgr);
-
-	dns_name_format(dns_catz_entry_getname(cz->entry), cname,
-			DNS_NAME_FORMATSIZE);
 	result = dns_view_findzone(cz->view, dns_catz_entry_getname(cz->entry),
 				   DNS_ZTFIND_EXACT, &zone);
 	if (result != ISC_R_SUCCESS) {
@@ -2884,8 +2921,8 @@ catz_delzone_cb(void *arg) {
 			      NAMED_LOGMODULE_SERVER, ISC_LOG_WARNING,
 			      "catz: catz_delzone_cb: "
 			      "zone '%s' not found",
-			      cname);
-		goto resume;
+			      cz->nameb);
+		goto cleanup;
 	}
 
 	if (!dns_zone_getadded(zone)) {
@@ -2893,8 +2930,8 @@ catz_delzone_cb(void *arg) {
 			      NAMED_LOGMODULE_SERVER, ISC_LOG_WARNING,
 			      "catz: catz_delzone_cb: "
 			      "zone '%s' is not a dynamically added zone",
-			      cname);
-		goto resume;
+			      cz->nameb);
+		CHECK(ISC_R_FAILURE);
 	}
 
 	if (dns_zone_get_parentcatz(zone) != cz->origin) {
@@ -2902,8 +2939,8 @@ catz_delzone_cb(void *arg) {
 			      NAMED_LOGMODULE_SERVER, ISC_LOG_WARNING,
 			      "catz: catz_delzone_cb: zone "
 			      "'%s' exists in multiple catalog zones",
-			      cname);
-		goto resume;
+			      cz->nameb);
+		CHECK(ISC_R_FAILURE);
 	}
 
 	/* Stop answering for this zone */
@@ -2912,9 +2949,7 @@ catz_delzone_cb(void *arg) {
 		dns_zone_unload(zone);
 	}
 
-	if (dns_view_delzone(cz->view, zone) != ISC_R_SUCCESS) {
-		goto resume;
-	}
+	CHECK(dns_view_delzone(cz->view, zone));
 	file = dns_zone_getfile(zone);
 	if (file != NULL) {
 		isc_file_remove(file);
@@ -2928,42 +2963,251 @@ catz_delzone_cb(void *arg) {
 		      NAMED_LOGMODULE_SERVER, ISC_LOG_WARNING,
 		      "catz: catz_delzone_cb: "
 		      "zone '%s' deleted",
-		      cname);
-resume:
-	isc_loopmgr_resume(named_g_loopmgr);
+		      cz->nameb);
+
 cleanup:
 	if (zone != NULL) {
 		dns_zone_detach(&zone);
 	}
+	cz->result = result;
+}
+
+static void
+catz_chgzone_free(catz_chgzone_t *cz) {
+	isc_stats_decrement(named_g_server->zonestats,
+			    dns_zonestatscounter_catzqueued);
+
+	if (cz->zone != NULL) {
+		dns_zone_detach(&cz->zone);
+	}
+	if (cz->zoneconf != NULL) {
+		cfg_obj_destroy(cz->parser, &cz->zoneconf);
+	}
+	if (cz->parser != NULL) {
+		cfg_parser_destroy(&cz->parser);
+	}
 	dns_catz_entry_detach(cz->origin, &cz->entry);
 	dns_catz_zone_detach(&cz->origin);
 	dns_view_weakdetach(&cz->view);
 	isc_mem_putanddetach(&cz->mctx, cz, sizeof(*cz));
 }
 
+static void
+catz_process(void *arg);
+
+/*
+ * Apply the current batch of member zone changes: pause the loop
+ * manager once to delete and configure all the zones in the batch,
+ * mounting them on each view's zone table in a single transaction,
+ * and load the new zones once the server is running again.
+ */
+static void
+catz_apply(catz_cb_data_t *cbd) {
+	catz_chgzone_t *cz = NULL;
+	dns_view_t *view = NULL;
+	size_t n = cbd->nbatch;
+
+	isc_loopmgr_pause(named_g_loopmgr);
+	for (size_t i = 0; i < n; i++) {
+		cz = cbd->batch[i];
+		if (cz->view != view) {
+			if (view != NULL) {
+				dns_view_endzonebatch(view);
+			}
+			view = cz->view;
+			dns_view_beginzonebatch(view);
+		}
+
+		if (cz->type == CATZ_DELZONE) {
+			catz_delzone_apply(cz);
+		} else {
+			catz_addmodzone(cz);
+		}
+	}
+	if (view != NULL) {
+		dns_view_endzonebatch(view);
+	}
+	isc_loopmgr_resume(named_g_loopmgr);
+
+	for (size_t i = 0; i < n; i++) {
+		cz = cbd->batch[i];
+		if (cz->zone != NULL) {
+			catz_loadzone(cz);
+		}
+
+		if (cz->result != ISC_R_SUCCESS) {
+			catz_stats_increment(dns_zonestatscounter_catzfailed);
+		} else if (cz->type == CATZ_ADDZONE) {
+			catz_stats_increment(dns_zonestatscounter_catzadded);
+		} else if (cz->type == CATZ_MODZONE) {
+			catz_stats_increment(dns_zonestatscounter_catzmodified);
+		} else {
+			catz_stats_increment(dns_zonestatscounter_catzdeleted);
+		}
+		catz_chgzone_free(cz);
+		cbd->batch[i] = NULL;
+	}
+	cbd->nbatch = 0;
+
+	if (n > 1) {
+		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+			      NAMED_LOGMODULE_SERVER, ISC_LOG_DEBUG(1),
+			      "catz: applied %zu member zone changes", n);
+	}
+
+	if (ISC_LIST_EMPTY(cbd->queue)) {
+		cbd->scheduled = false;
+	} else {
+		isc_async_run(named_g_mainloop, catz_process, cbd);
+	}
+}
+
+static void
+catz_generate(void *arg) {
+	catz_genwork_t *work = (catz_genwork_t *)arg;
+	cfg_parser_t *parser = NULL;
+	isc_result_t result;
+
+	result = cfg_parser_create(named_g_mctx, named_g_lctx, &parser);
+	for (size_t i = work->first; i < work->last; i++) {
+		catz_chgzone_t *cz = work->cbd->batch[i];
+		if (cz->type == CATZ_DELZONE || cz->result != ISC_R_SUCCESS) {
+			continue;
+		}
+		if (result != ISC_R_SUCCESS) {
+			cz->result = result;
+			continue;
+		}
+		catz_parsezone(cz, parser);
+	}
+	if (parser != NULL) {
+		cfg_parser_destroy(&parser);
+	}
+}
+
+static void
+catz_generate_done(void *arg) {
+	catz_genwork_t *work = (catz_genwork_t *)arg;
+	catz_cb_data_t *cbd = work->cbd;
+
+	isc_mem_put(named_g_mctx, work, sizeof(*work));
+
+	INSIST(cbd->generating > 0);
+	if (--cbd->generating > 0) {
+		return;
+	}
+
+	if (isc_loop_shuttingdown(isc_loop_get(named_g_loopmgr, isc_tid()))) {
+		/* catz_process() discards the rest of the queue */
+		for (size_t i = 0; i < cbd->nbatch; i++) {
+			catz_chgzone_free(cbd->batch[i]);
+			cbd->batch[i] = NULL;
+		}
+		cbd->nbatch = 0;
+		catz_process(cbd);
+		return;
+	}
+
+	catz_apply(cbd);
+}
+
+/*
+ * Take the next batch of queued member zone changes and generate the
+ * zone configurations for it, split between the threads of the thread
+ * pool; catz_apply() runs when they are all done.
+ */
+static void
+catz_process(void *arg) {
+	catz_cb_data_t *cbd = (catz_cb_data_t *)arg;
+	catz_chgzone_t *cz = NULL;
+	size_t n = 0, nadd = 0, nwork, share;
+
+	INSIST(cbd->nbatch == 0 && cbd->generating == 0);
+
+	if (isc_loop_shuttingdown(isc_loop_get(named_g_loopmgr, isc_tid()))) {
+		while ((cz = ISC_LIST_HEAD(cbd->queue)) != NULL) {
+			ISC_LIST_UNLINK(cbd->queue, cz, link);
+			catz_chgzone_free(cz);
+		}
+		cbd->scheduled = false;
+		return;
+	}
+
+	while (n < CATZ_BATCH_SIZE &&
+	       (cz = ISC_LIST_HEAD(cbd->queue)) != NULL)
+	{
+		ISC_LIST_UNLINK(cbd->queue, cz, link);
+		cbd->batch[n++] = cz;
+
+		if (cz->type == CATZ_DELZONE) {
+			continue;
+		}
+		cz->cfg = (ns_cfgctx_t *)cz->view->new_zone_config;
+		if (cz->cfg == NULL) {
+			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+				      "catz: allow-new-zones statement missing "
+				      "from config; cannot add zone from the "
+				      "catalog");
+			cz->result = ISC_R_FAILURE;
+			continue;
+		}
+		nadd++;
+	}
+	cbd->nbatch = n;
+
+	if (nadd == 0) {
+		catz_apply(cbd);
+		return;
+	}
+
+	nwork = ISC_MIN(isc_loopmgr_nloops(named_g_loopmgr), nadd);
+	share = (n + nwork - 1) / nwork;
+	for (size_t first = 0; first < n; first += share) {
+		catz_genwork_t *work = isc_mem_get(named_g_mctx,
+						   sizeof(*work));
+		*work = (catz_genwork_t){
+			.cbd = cbd,
+			.first = first,
+			.last = ISC_MIN(first + share, n),
+		};
+		cbd->generating++;
+		isc_work_enqueue(named_g_mainloop, catz_generate,
+				 catz_generate_done, work);
+	}
+}
+
+static void
+catz_enqueue(void *arg) {
+	catz_chgzone_t *cz = (catz_chgzone_t *)arg;
+	catz_cb_data_t *cbd = cz->cbd;
+
+	ISC_LIST_APPEND(cbd->queue, cz, link);
+	if (!cbd->scheduled) {
+		cbd->scheduled = true;
+		isc_async_run(named_g_mainloop, catz_process, cbd);
+	}
+}
+
+/*
+ * Called for each changed member zone while a catalog zone update is
+ * merged.  The change is queued on the main loop, to be applied in
+ * batches together with the other changes of the update.
+ */
 static isc_result_t
 catz_run(dns_catz_entry_t *entry, dns_catz_zone_t *origin, dns_view_t *view,
 	 void *udata, catz_type_t type) {
 	catz_chgzone_t *cz = NULL;
-	isc_job_cb action = NULL;
 
-	switch (type) {
-	case CATZ_ADDZONE:
-	case CATZ_MODZONE:
-		action = catz_addmodzone_cb;
-		break;
-	case CATZ_DELZONE:
-		action = catz_delzone_cb;
-		break;
-	default:
-		REQUIRE(0);
-		UNREACHABLE();
-	}
+	REQUIRE(type == CATZ_ADDZONE || type == CATZ_MODZONE ||
+		type == CATZ_DELZONE);
 
 	cz = isc_mem_get(view->mctx, sizeof(*cz));
 	*cz = (catz_chgzone_t){
 		.cbd = (catz_cb_data_t *)udata,
-		.mod = (type == CATZ_MODZONE),
+		.type = type,
+		.result = ISC_R_SUCCESS,
+		.link = ISC_LINK_INITIALIZER,
 	};
 	isc_mem_attach(view->mctx, &cz->mctx);
 
@@ -2971,7 +3215,12 @@ catz_run(dns_catz_entry_t *entry, dns_catz_zone_t *origin, dns_view_t *view,
 	dns_catz_zone_attach(origin, &cz->origin);
 	dns_view_weakattach(view, &cz->view);
 
-	isc_async_run(named_g_mainloop, action, cz);
+	dns_name_format(dns_catz_entry_getname(entry), cz->nameb,
+			sizeof(cz->nameb));
+
+	isc_stats_increment(named_g_server->zonestats,
+			    dns_zonestatscounter_catzqueued);
+	isc_async_run(named_g_mainloop, catz_enqueue, cz);
 
 	return (ISC_R_SUCCESS);
 }
@@ -3871,6 +4120,25 @@ configure_dnstap(const cfg_obj_t **maps, dns_view_t *view) {
 				   cfg_obj_asstring(obj));
 	}
 
+	obj = NULL;
+	result = named_config_get(maps, "dnstap-sample-rate", &obj);
+	if (result == ISC_R_SUCCESS) {
+		dns_dtsample_t mode = dns_dtsample_message;
+
+		obj2 = NULL;
+		result = named_config_get(maps, "dnstap-sample-mode", &obj2);
+		if (result == ISC_R_SUCCESS &&
+		    strcasecmp(cfg_obj_asstring(obj2), "client") == 0)
+		{
+			mode = dns_dtsample_client;
+		}
+		dns_dt_setsampling(named_g_server->dtenv,
+				   cfg_obj_asuint32(obj), mode);
+	} else {
+		dns_dt_setsampling(named_g_server->dtenv, 1,
+				   dns_dtsample_message);
+	}
+
 	dns_dt_attach(named_g_server->dtenv, &view->dtenv);
 	view->dttypes = dttypes;
 
@@ -3980,6 +4248,39 @@ minimal_cache_allowed(const cfg_obj_t *maps[4],
 
 static const char *const response_synonyms[] = { "response", NULL };
 
+static void
+digest_print(void *closure, const char *text, int textlen) {
+	isc_hash64_hash(closure, text, textlen, true);
+}
+
+/*
+ * Hash every clause of 'map' except the zones (and, at the top level,
+ * the views), i.e. everything that zones in it can inherit settings
+ * from.
+ */
+static void
+digest_options(isc_hash64_t *state, const cfg_obj_t *map) {
+	const void *clauses = NULL;
+	unsigned int idx;
+
+	for (const char *name = cfg_map_firstclause(map->type, &clauses,
+						    &idx);
+	     name != NULL;
+	     name = cfg_map_nextclause(map->type, &clauses, &idx))
+	{
+		const cfg_obj_t *obj = NULL;
+
+		if (strcasecmp(name, "zone") == 0 ||
+		    strcasecmp(name, "view") == 0 ||
+		    cfg_map_get(map, name, &obj) != ISC_R_SUCCESS)
+		{
+			continue;
+		}
+		isc_hash64_hash(state, name, strlen(name), true);
+		cfg_printx(obj, CFG_PRINTER_ONELINE, digest_print, state);
+	}
+}
+
 /*
  * Configure 'view' according to 'vconfig', taking defaults from
  * 'config' where values are missing in 'vconfig'.
@@ -4013,6 +4314,8 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	const cfg_obj_t *obj, *obj2;
 	const cfg_listelt_t *element = NULL;
 	const cfg_listelt_t *zone_element_latest = NULL;
+	isc_hash64_t digest;
+	uint64_t cfgdigest;
 	in_port_t port;
 	dns_cache_t *cache = NULL;
 	isc_result_t result;
@@ -4029,6 +4332,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	dns_dispatch_t *dispatch6 = NULL;
 	bool rpz_configured = false;
 	bool catz_configured = false;
+	bool zonebatch = false;
 	bool shared_cache = false;
 	int i = 0, j = 0, k = 0;
 	const char *str;
@@ -4130,15 +4434,33 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	}
 
 	/*
-	 * Load zone configuration
+	 * Summarize the configuration that the zones in this view inherit,
+	 * so that zones whose configuration has not changed since the
+	 * last reconfiguration can be reused as they are.
+	 */
+	isc_hash64_init(&digest);
+	digest_options(&digest, config);
+	if (voptions != NULL) {
+		digest_options(&digest, voptions);
+	}
+	isc_hash64_hash(&digest, view->name, strlen(view->name), true);
+	isc_hash64_hash(&digest, &view->rdclass, sizeof(view->rdclass), true);
+	cfgdigest = isc_hash64_finalize(&digest);
+
+	/*
+	 * Load zone configuration.  The zones configured here and the
+	 * ones added at runtime (below) are mounted on the zone table
+	 * in a single transaction, rather than one per zone.
 	 */
+	dns_view_beginzonebatch(view);
+	zonebatch = true;
 	for (element = cfg_list_first(zonelist); element != NULL;
 	     element = cfg_list_next(element))
 	{
 		const cfg_obj_t *zconfig = cfg_listelt_value(element);
 		CHECK(configure_zone(config, zconfig, vconfig, view, viewlist,
 				     kasplist, keystores, actx, false,
-				     old_rpz_ok, false));
+				     old_rpz_ok, false, cfgdigest));
 		zone_element_latest = element;
 	}
 
@@ -4176,6 +4498,9 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	 */
 	CHECK(configure_newzones(view, config, vconfig, actx));
 
+	dns_view_endzonebatch(view);
+	zonebatch = false;
+
 	/*
 	 * Create Dynamically Loadable Zone driver.
 	 */
@@ -5934,6 +6259,10 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	result = ISC_R_SUCCESS;
 
 cleanup:
+	if (zonebatch) {
+		dns_view_endzonebatch(view);
+	}
+
 	/*
 	 * Revert to the old view if there was an error.
 	 */
@@ -6454,7 +6783,7 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	       const cfg_obj_t *vconfig, dns_view_t *view,
 	       dns_viewlist_t *viewlist, dns_kasplist_t *kasplist,
 	       dns_keystorelist_t *keystores, cfg_aclconfctx_t *aclconf,
-	       bool added, bool old_rpz_ok, bool modify) {
+	       bool added, bool old_rpz_ok, bool modify, uint64_t cfgdigest) {
 	dns_view_t *pview = NULL; /* Production view */
 	dns_zone_t *zone = NULL;  /* New or reused zone */
 	dns_zone_t *raw = NULL;	  /* New or reused raw zone */
@@ -6479,6 +6808,8 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	bool zone_maybe_inline = false;
 	bool inline_signing = false;
 	bool fullsign = false;
+	bool unchanged = false;
+	uint64_t zdigest = 0;
 
 	options = NULL;
 	(void)cfg_map_get(config, "options", &options);
@@ -6734,12 +7065,31 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		dns_zone_detach(&zone);
 	}
 
+	if (cfgdigest != 0) {
+		isc_hash64_t digest;
+
+		isc_hash64_init(&digest);
+		isc_hash64_hash(&digest, &cfgdigest, sizeof(cfgdigest), true);
+		cfg_printx(zconfig, CFG_PRINTER_ONELINE, digest_print, &digest);
+		zdigest = isc_hash64_finalize(&digest);
+	}
+
 	if (zone != NULL) {
 		/*
 		 * We found a reusable zone.  Make it use the
 		 * new view.
 		 */
 		dns_zone_setview(zone, view);
+
+		/*
+		 * If neither the zone's own configuration nor anything
+		 * it inherits has changed, it is already configured.
+		 * Response policy and catalog zones are set up afresh
+		 * each time.
+		 */
+		unchanged = !modify && zdigest != 0 &&
+			    zdigest == dns_zone_getconfigdigest(zone) &&
+			    rpz_num == DNS_RPZ_INVALID_NUM && !zone_is_catz;
 	} else {
 		/*
 		 * We cannot reuse an existing zone, we have
@@ -6795,7 +7145,7 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 			      strcasecmp(ztypestr, "secondary") == 0 ||
 			      strcasecmp(ztypestr, "slave") == 0));
 
-	if (zone_maybe_inline) {
+	if (zone_maybe_inline && !unchanged) {
 		inline_signing = named_zone_inlinesigning(zconfig, vconfig,
 							  config, kasplist);
 	}
@@ -6823,8 +7173,19 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	/*
 	 * Configure the zone.
 	 */
-	CHECK(named_zone_configure(config, vconfig, zconfig, aclconf, kasplist,
-				   keystores, zone, raw));
+	if (!unchanged) {
+		dns_zone_setconfigdigest(zone, 0);
+		CHECK(named_zone_configure(config, vconfig, zconfig, aclconf,
+					   kasplist, keystores, zone, raw));
+		dns_zone_setconfigdigest(zone, zdigest);
+	} else {
+		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+			      NAMED_LOGMODULE_SERVER, ISC_LOG_DEBUG(1),
+			      "zone '%s': configuration unchanged", zname);
+		dns_zone_getraw(zone, &raw);
+		CHECK(named_zone_reattach(config, vconfig, zconfig, aclconf,
+					  kasplist, zone, raw));
+	}
 
 	/*
 	 * Add the zone to its view in the new view list.
@@ -6972,20 +7333,21 @@ configure_server_quota(const cfg_obj_t **maps, const char *name,
 /*
  * This function is called as soon as the 'directory' statement has been
  * parsed.  This can be extended to support other options if necessary.
+ *
+ * The configuration is parsed while the loops are running, and may yet
+ * be rejected, so this only makes the rest of the configuration include
+ * files relative to the new directory; load_configuration() changes
+ * into it once the configuration has been accepted.
  */
 static isc_result_t
 directory_callback(const char *clausename, const cfg_obj_t *obj, void *arg) {
-	isc_result_t result;
+	cfg_parser_t *parser = arg;
 	const char *directory;
 
 	REQUIRE(strcasecmp("directory", clausename) == 0);
 
-	UNUSED(arg);
 	UNUSED(clausename);
 
-	/*
-	 * Change directory.
-	 */
 	directory = cfg_obj_asstring(obj);
 
 	if (!isc_file_ischdiridempotent(directory)) {
@@ -7001,13 +7363,7 @@ directory_callback(const char *clausename, const cfg_obj_t *obj, void *arg) {
 		return (ISC_R_NOPERM);
 	}
 
-	result = isc_dir_chdir(directory);
-	if (result != ISC_R_SUCCESS) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_ERROR,
-			    "change directory to '%s' failed: %s", directory,
-			    isc_result_totext(result));
-		return (result);
-	}
+	cfg_parser_setdirectory(parser, directory);
 
 	return (ISC_R_SUCCESS);
 }
@@ -7826,7 +8182,7 @@ configure_newzones(dns_view_t *view, cfg_obj_t *config, cfg_obj_t *vconfig,
 				     &named_g_server->viewlist,
 				     &named_g_server->kasplist,
 				     &named_g_server->keystorelist, actx, true,
-				     false, false));
+				     false, false, 0));
 	}
 
 	result = ISC_R_SUCCESS;
@@ -8011,7 +8367,7 @@ configure_newzone(const cfg_obj_t *zconfig, cfg_obj_t *config,
 	return (configure_zone(
 		config, zconfig, vconfig, view, &named_g_server->viewlist,
 		&named_g_server->kasplist, &named_g_server->keystorelist, actx,
-		true, false, false));
+		true, false, false, 0));
 }
 
 /*%
@@ -8179,6 +8535,7 @@ load_configuration(const char *filename, named_server_t *server,
 	uint32_t interface_interval;
 	uint32_t udpsize;
 	uint32_t transfer_message_size;
+	uint64_t transfer_cache_size;
 	uint32_t recv_tcp_buffer_size;
 	uint32_t send_tcp_buffer_size;
 	uint32_t recv_udp_buffer_size;
@@ -8191,7 +8548,9 @@ load_configuration(const char *filename, named_server_t *server,
 	uint32_t max;
 	uint64_t initial, idle, keepalive, advertised;
 	bool loadbalancesockets;
-	bool exclusive = true;
+	bool exclusive = false;
+	isc_nanosecs_t start = isc_time_monotonic();
+	isc_nanosecs_t parsed, checked, paused, viewstart, viewdone;
 	dns_aclenv_t *env =
 		ns_interfacemgr_getaclenv(named_g_server->interfacemgr);
 
@@ -8207,23 +8566,6 @@ load_configuration(const char *filename, named_server_t *server,
 	ISC_LIST_INIT(cachelist);
 	ISC_LIST_INIT(altsecrets);
 
-	/* Ensure exclusive access to configuration data. */
-	isc_loopmgr_pause(named_g_loopmgr);
-
-	/* Create the ACL configuration context */
-	if (named_g_aclconfctx != NULL) {
-		cfg_aclconfctx_detach(&named_g_aclconfctx);
-	}
-	result = cfg_aclconfctx_create(named_g_mctx, &named_g_aclconfctx);
-	if (result != ISC_R_SUCCESS) {
-		goto cleanup_exclusive;
-	}
-
-	/*
-	 * Shut down all dyndb instances.
-	 */
-	dns_dyndb_cleanup(false);
-
 	/*
 	 * Parse the global default pseudo-config file.
 	 */
@@ -8251,12 +8593,13 @@ load_configuration(const char *filename, named_server_t *server,
 		goto cleanup_exclusive;
 	}
 
-	cfg_parser_setcallback(conf_parser, directory_callback, NULL);
+	cfg_parser_setcallback(conf_parser, directory_callback, conf_parser);
 	result = cfg_parse_file(conf_parser, filename, &cfg_type_namedconf,
 				&config);
 	if (result != ISC_R_SUCCESS) {
 		goto cleanup_conf_parser;
 	}
+	parsed = isc_time_monotonic();
 
 	/*
 	 * Check the validity of the configuration.
@@ -8271,6 +8614,32 @@ load_configuration(const char *filename, named_server_t *server,
 		goto cleanup_config;
 	}
 
+	/*
+	 * Parsing and checking only touch the new configuration, so they
+	 * are done before pausing; with a large configuration they take
+	 * much longer than the rest of the reconfiguration.
+	 *
+	 * Ensure exclusive access to configuration data.
+	 */
+	checked = isc_time_monotonic();
+	isc_loopmgr_pause(named_g_loopmgr);
+	exclusive = true;
+	paused = isc_time_monotonic();
+
+	/* Create the ACL configuration context */
+	if (named_g_aclconfctx != NULL) {
+		cfg_aclconfctx_detach(&named_g_aclconfctx);
+	}
+	result = cfg_aclconfctx_create(named_g_mctx, &named_g_aclconfctx);
+	if (result != ISC_R_SUCCESS) {
+		goto cleanup_config;
+	}
+
+	/*
+	 * Shut down all dyndb instances.
+	 */
+	dns_dyndb_cleanup(false);
+
 	/* Let's recreate the TLS context cache */
 	if (server->tlsctx_server_cache != NULL) {
 		isc_tlsctx_cache_detach(&server->tlsctx_server_cache);
@@ -8299,6 +8668,24 @@ load_configuration(const char *filename, named_server_t *server,
 	maps[i++] = named_g_defaults;
 	maps[i] = NULL;
 
+	/*
+	 * Change to the new working directory, now that nothing else is
+	 * running and the configuration has been accepted.
+	 */
+	obj = NULL;
+	if (options != NULL &&
+	    cfg_map_get(options, "directory", &obj) == ISC_R_SUCCESS)
+	{
+		result = isc_dir_chdir(cfg_obj_asstring(obj));
+		if (result != ISC_R_SUCCESS) {
+			cfg_obj_log(obj, named_g_lctx, ISC_LOG_ERROR,
+				    "change directory to '%s' failed: %s",
+				    cfg_obj_asstring(obj),
+				    isc_result_totext(result));
+			goto cleanup_config;
+		}
+	}
+
 #if HAVE_LIBNGHTTP2
 	obj = NULL;
 	result = named_config_get(maps, "http-port", &obj);
@@ -8546,6 +8933,17 @@ load_configuration(const char *filename, named_server_t *server,
 
 #undef CAP_IF_NOT_ZERO
 
+	/*
+	 * Set the rotation interval of the TLS session ticket keys before
+	 * the listeners (and their TLS contexts) are configured below.
+	 */
+	obj = NULL;
+	result = named_config_get(maps, "tls-session-ticket-key-lifetime",
+				  &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	isc_tlsctx_ticket_keys_setinterval(server->tls_ticket_keys,
+					   cfg_obj_asduration(obj));
+
 	/*
 	 * Configure sets of UDP query source ports.
 	 */
@@ -8667,6 +9065,21 @@ load_configuration(const char *filename, named_server_t *server,
 	server->sctx->transfer_tcp_message_size =
 		(uint16_t)transfer_message_size;
 
+	/* Set the limits of the outgoing transfer message cache */
+	obj = NULL;
+	result = named_config_get(maps, "transfer-cache-size", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	transfer_cache_size = cfg_obj_asuint64(obj);
+	if (transfer_cache_size > SIZE_MAX) {
+		transfer_cache_size = SIZE_MAX;
+	}
+	obj = NULL;
+	result = named_config_get(maps, "transfer-cache-entries", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	ns_xfrcache_setlimits(server->sctx->xfrcache,
+			      (size_t)transfer_cache_size,
+			      cfg_obj_asuint32(obj));
+
 	/*
 	 * Configure the zone manager.
 	 */
@@ -8696,6 +9109,12 @@ load_configuration(const char *filename, named_server_t *server,
 	INSIST(result == ISC_R_SUCCESS);
 	dns_zonemgr_setserialqueryrate(server->zonemgr, cfg_obj_asuint32(obj));
 
+	obj = NULL;
+	result = named_config_get(maps, "serial-query-batch", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_setserialquerybatch(server->zonemgr,
+					cfg_obj_asuint32(obj));
+
 	/*
 	 * Determine which port to use for listening for incoming connections.
 	 */
@@ -9035,6 +9454,7 @@ load_configuration(const char *filename, named_server_t *server,
 	/*
 	 * Configure the views.
 	 */
+	viewstart = isc_time_monotonic();
 	views = NULL;
 	(void)cfg_map_get(config, "view", &views);
 
@@ -9176,6 +9596,7 @@ load_configuration(const char *filename, named_server_t *server,
 	{
 		dns_view_setviewcommit(view);
 	}
+	viewdone = isc_time_monotonic();
 
 	/* Swap our new view list with the production one. */
 	tmpviewlist = server->viewlist;
@@ -9577,6 +9998,17 @@ load_configuration(const char *filename, named_server_t *server,
 	 */
 	named_g_configtime = isc_time_now();
 
+	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+		      NAMED_LOGMODULE_SERVER, ISC_LOG_INFO,
+		      "configuration loaded in %" PRIu64 " ms: "
+		      "parsing %" PRIu64 " ms, checking %" PRIu64 " ms, "
+		      "pausing %" PRIu64 " ms, views and zones %" PRIu64 " ms",
+		      (isc_time_monotonic() - start) / NS_PER_MS,
+		      (parsed - start) / NS_PER_MS,
+		      (checked - parsed) / NS_PER_MS,
+		      (paused - checked) / NS_PER_MS,
+		      (viewdone - viewstart) / NS_PER_MS);
+
 	isc_loopmgr_resume(named_g_loopmgr);
 	exclusive = false;
 
@@ -9710,6 +10142,7 @@ view_loaded(void *arg) {
 	if (isc_refcount_decrement(&zl->refs) == 1) {
 		named_server_t *server = zl->server;
 		bool reconfig = zl->reconfig;
+		isc_nanosecs_t elapsed = isc_time_monotonic() - zl->start;
 		dns_view_t *view = NULL;
 
 		isc_refcount_destroy(&zl->refs);
@@ -9730,6 +10163,10 @@ view_loaded(void *arg) {
 				      NAMED_LOGMODULE_SERVER, ISC_LOG_NOTICE,
 				      "all zones loaded");
 		}
+		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+			      NAMED_LOGMODULE_SERVER, ISC_LOG_INFO,
+			      "zone loading took %" PRIu64 " ms",
+			      elapsed / NS_PER_MS);
 
 		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
@@ -9790,6 +10227,7 @@ load_zones(named_server_t *server, bool reconfig) {
 	zl = isc_mem_get(server->mctx, sizeof(*zl));
 	zl->server = server;
 	zl->reconfig = reconfig;
+	zl->start = isc_time_monotonic();
 
 	isc_loopmgr_pause(named_g_loopmgr);
 
@@ -10133,6 +10571,17 @@ named_server_create(isc_mem_t *mctx, named_server_t **serverp) {
 	isc_stats_create(named_g_mctx, &server->resolverstats,
 			 dns_resstatscounter_max);
 
+	/*
+	 * The TLS session ticket keys are shared by all the listeners and
+	 * survive reconfiguration, so that clients can resume their
+	 * sessions regardless of the endpoint and the moment they
+	 * reconnect.  The rotation interval set here is replaced with
+	 * the configured "tls-session-ticket-key-lifetime" on every
+	 * (re)configuration.
+	 */
+	isc_tlsctx_ticket_keys_create(named_g_mctx, 12 * 3600,
+				      &server->tls_ticket_keys);
+
 	CHECKFATAL(named_controls_create(server, &server->controls),
 		   "named_controls_create");
 
@@ -10206,6 +10655,8 @@ named_server_destroy(named_server_t **serverp) {
 		isc_tlsctx_cache_detach(&server->tlsctx_client_cache);
 	}
 
+	isc_tlsctx_ticket_keys_detach(&server->tls_ticket_keys);
+
 	server->magic = 0;
 	isc_mem_put(server->mctx, server, sizeof(*server));
 	*serverp = NULL;
@@ -10998,7 +11449,8 @@ listenelt_fromconfig(const cfg_obj_t *listener, const cfg_obj_t *config,
 		.prefer_server_ciphers = tls_prefer_server_ciphers,
 		.prefer_server_ciphers_set = tls_prefer_server_ciphers_set,
 		.session_tickets = tls_session_tickets,
-		.session_tickets_set = tls_session_tickets_set
+		.session_tickets_set = tls_session_tickets_set,
+		.ticket_keys = named_g_server->tls_ticket_keys
 	};
 
 	httpobj = cfg_tuple_get(ltup, "http");
@@ -12079,6 +12531,21 @@ named_server_flushnode(named_server_t *server, isc_lex_t *lex, bool tree) {
 	return (result);
 }
 
+static isc_result_t
+status_xfrprimary(const dns_xfrprimary_t *primary, void *arg) {
+	isc_buffer_t **text = arg;
+	char addrbuf[ISC_NETADDR_FORMATSIZE];
+	char line[1024];
+
+	isc_netaddr_format(&primary->addr, addrbuf, sizeof(addrbuf));
+	snprintf(line, sizeof(line),
+		 "xfers from %s: %u running (limit %u), %u waiting, %" PRIu64
+		 " completed, %" PRIu64 " failed, %" PRIu64 " bytes/s\n",
+		 addrbuf, primary->running, primary->limit, primary->waiting,
+		 primary->transfers, primary->failures, primary->rate);
+	return (putstr(text, line));
+}
+
 isc_result_t
 named_server_status(named_server_t *server, isc_buffer_t **text) {
 	isc_result_t result;
@@ -12168,6 +12635,9 @@ named_server_status(named_server_t *server, isc_buffer_t **text) {
 		 xferfirstrefresh);
 	CHECK(putstr(text, line));
 
+	CHECK(dns_zonemgr_xfrprimaries(server->zonemgr, status_xfrprimary,
+				       text));
+
 	snprintf(line, sizeof(line), "soa queries in progress: %u\n",
 		 soaqueries);
 	CHECK(putstr(text, line));
@@ -13450,7 +13920,7 @@ do_addzone(named_server_t *server, ns_cfgctx_t *cfg, dns_view_t *view,
 	result = configure_zone(cfg->config, zoneobj, cfg->vconfig, view,
 				&server->viewlist, &server->kasplist,
 				&server->keystorelist, cfg->actx, true, false,
-				false);
+				false, 0);
 	dns_view_freeze(view);
 
 	isc_loopmgr_resume(named_g_loopmgr);
@@ -13636,7 +14106,7 @@ do_modzone(named_server_t *server, ns_cfgctx_t *cfg, dns_view_t *view,
 	result = configure_zone(cfg->config, zoneobj, cfg->vconfig, view,
 				&server->viewlist, &server->kasplist,
 				&server->keystorelist, cfg->actx, true, false,
-				true);
+				true, 0);
 	dns_view_freeze(view);
 
 	isc_loopmgr_resume(named_g_loopmgr);
@@ -17,11 +17,13 @@
 #include <stdbool.h>
 
 #include <isc/buffer.h>
+#include <isc/histo.h>
 #include <isc/httpd.h>
 #include <isc/mem.h>
 #include <isc/once.h>
 #include <isc/stats.h>
 #include <isc/string.h>
+#include <isc/tls.h>
 #include <isc/util.h>
 
 #include <dns/adb.h>
@@ -159,6 +161,7 @@ static const char *tcpinsizestats_desc[dns_sizecounter_in_max];
 static const char *tcpoutsizestats_desc[dns_sizecounter_out_max];
 static const char *dnstapstats_desc[dns_dnstapcounter_max];
 static const char *gluecachestats_desc[dns_gluecachestatscounter_max];
+static const char *tlsticketstats_desc[isc_tlsticketcounter_max];
 #if defined(EXTENDED_STATS)
 static const char *nsstats_xmldesc[ns_statscounter_max];
 static const char *resstats_xmldesc[dns_resstatscounter_max];
@@ -172,6 +175,7 @@ static const char *tcpinsizestats_xmldesc[dns_sizecounter_in_max];
 static const char *tcpoutsizestats_xmldesc[dns_sizecounter_out_max];
 static const char *dnstapstats_xmldesc[dns_dnstapcounter_max];
 static const char *gluecachestats_xmldesc[dns_gluecachestatscounter_max];
+static const char *tlsticketstats_xmldesc[isc_tlsticketcounter_max];
 #else /* if defined(EXTENDED_STATS) */
 #define nsstats_xmldesc		NULL
 #define resstats_xmldesc	NULL
@@ -185,6 +189,7 @@ static const char *gluecachestats_xmldesc[dns_gluecachestatscounter_max];
 #define tcpoutsizestats_xmldesc NULL
 #define dnstapstats_xmldesc	NULL
 #define gluecachestats_xmldesc	NULL
+#define tlsticketstats_xmldesc	NULL
 #endif /* EXTENDED_STATS */
 
 #define TRY0(a)                       \
@@ -211,6 +216,7 @@ static int tcpinsizestats_index[dns_sizecounter_in_max];
 static int tcpoutsizestats_index[dns_sizecounter_out_max];
 static int dnstapstats_index[dns_dnstapcounter_max];
 static int gluecachestats_index[dns_gluecachestatscounter_max];
+static int tlsticketstats_index[isc_tlsticketcounter_max];
 
 static void
 set_desc(int counter, int maxcounter, const char *fdesc, const char **fdescs,
@@ -532,6 +538,15 @@ init_desc(void) {
 	SET_ZONESTATDESC(xfrsuccess, "transfer requests succeeded",
 			 "XfrSuccess");
 	SET_ZONESTATDESC(xfrfail, "transfer requests failed", "XfrFail");
+	SET_ZONESTATDESC(catzqueued, "catalog member changes pending",
+			 "CatzQueued");
+	SET_ZONESTATDESC(catzadded, "catalog member zones added", "CatzAdded");
+	SET_ZONESTATDESC(catzmodified, "catalog member zones modified",
+			 "CatzModified");
+	SET_ZONESTATDESC(catzdeleted, "catalog member zones deleted",
+			 "CatzDeleted");
+	SET_ZONESTATDESC(catzfailed, "catalog member changes failed",
+			 "CatzFailed");
 	INSIST(i == dns_zonestatscounter_max);
 
 	/* Initialize socket statistics */
@@ -696,6 +711,23 @@ init_desc(void) {
 			      "GLUECACHEinsertsabsent");
 	INSIST(i == dns_gluecachestatscounter_max);
 
+#define SET_TLSTICKETSTATDESC(counterid, desc, xmldesc)                       \
+	do {                                                                  \
+		set_desc(isc_tlsticketcounter_##counterid,                    \
+			 isc_tlsticketcounter_max, desc, tlsticketstats_desc, \
+			 xmldesc, tlsticketstats_xmldesc);                    \
+		tlsticketstats_index[i++] = isc_tlsticketcounter_##counterid; \
+	} while (0)
+	i = 0;
+	SET_TLSTICKETSTATDESC(issued, "TLS session tickets issued",
+			      "TicketIssued");
+	SET_TLSTICKETSTATDESC(resumed, "TLS sessions resumed with a ticket",
+			      "TicketResumed");
+	SET_TLSTICKETSTATDESC(unknownkey,
+			      "TLS session tickets with an unknown key",
+			      "TicketUnknownKey");
+	INSIST(i == isc_tlsticketcounter_max);
+
 	/* Sanity check */
 	for (i = 0; i < ns_statscounter_max; i++) {
 		INSIST(nsstats_desc[i] != NULL);
@@ -721,6 +753,9 @@ init_desc(void) {
 	for (i = 0; i < dns_gluecachestatscounter_max; i++) {
 		INSIST(gluecachestats_desc[i] != NULL);
 	}
+	for (i = 0; i < isc_tlsticketcounter_max; i++) {
+		INSIST(tlsticketstats_desc[i] != NULL);
+	}
 #if defined(EXTENDED_STATS)
 	for (i = 0; i < ns_statscounter_max; i++) {
 		INSIST(nsstats_xmldesc[i] != NULL);
@@ -746,6 +781,9 @@ init_desc(void) {
 	for (i = 0; i < dns_gluecachestatscounter_max; i++) {
 		INSIST(gluecachestats_xmldesc[i] != NULL);
 	}
+	for (i = 0; i < isc_tlsticketcounter_max; i++) {
+		INSIST(tlsticketstats_xmldesc[i] != NULL);
+	}
 #endif /* if defined(EXTENDED_STATS) */
 
 	/* Initialize traffic size statistics */
@@ -943,6 +981,143 @@ cleanup:
 #endif /* ifdef HAVE_LIBXML2 */
 }
 
+/*%
+ * Quantiles reported for latency and size histograms, in the decreasing
+ * order that isc_histo_quantiles() requires.
+ */
+static const double quantile_fractions[] = { 0.999, 0.99, 0.9, 0.5 };
+static const char *quantile_names[] = { "p999", "p99", "p90", "p50" };
+
+STATIC_ASSERT(ARRAY_SIZE(quantile_fractions) == ARRAY_SIZE(quantile_names),
+	      "each quantile must have a name");
+
+static isc_result_t
+dump_quantiles(isc_histomulti_t *hm, isc_statsformat_t type, void *arg,
+	       const char *name) {
+	isc_histo_t *hg = NULL;
+	double count = 0.0, mean = 0.0;
+	uint64_t values[ARRAY_SIZE(quantile_fractions)] = { 0 };
+	FILE *fp;
+#ifdef HAVE_LIBXML2
+	void *writer;
+	int xmlrc;
+#endif /* ifdef HAVE_LIBXML2 */
+#ifdef HAVE_JSON_C
+	json_object *job, *histo, *obj;
+#endif /* ifdef HAVE_JSON_C */
+
+	/*
+	 * Merge the per-thread histograms into a private copy first,
+	 * so that the quantiles are computed from a stable snapshot.
+	 * An empty histogram leaves the quantiles at zero.
+	 */
+	isc_histomulti_merge(&hg, hm);
+	isc_histo_moments(hg, &count, &mean, NULL);
+	(void)isc_histo_quantiles(hg, ARRAY_SIZE(quantile_fractions),
+				  quantile_fractions, values);
+	isc_histo_destroy(&hg);
+
+	switch (type) {
+	case isc_statsformat_file:
+		fp = arg;
+		fprintf(fp, "%20" PRIu64 " %s count\n", (uint64_t)count, name);
+		fprintf(fp, "%20" PRIu64 " %s mean\n", (uint64_t)mean, name);
+		for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+			fprintf(fp, "%20" PRIu64 " %s %s\n", values[i], name,
+				quantile_names[i]);
+		}
+		break;
+	case isc_statsformat_xml:
+#ifdef HAVE_LIBXML2
+		writer = arg;
+
+		/* <histogram name="..."> */
+		TRY0(xmlTextWriterStartElement(writer,
+					       ISC_XMLCHAR "histogram"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "name",
+						 ISC_XMLCHAR name));
+		TRY0(xmlTextWriterWriteFormatElement(writer,
+						     ISC_XMLCHAR "count",
+						     "%" PRIu64,
+						     (uint64_t)count));
+		TRY0(xmlTextWriterWriteFormatElement(writer,
+						     ISC_XMLCHAR "mean",
+						     "%" PRIu64,
+						     (uint64_t)mean));
+		for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+			TRY0(xmlTextWriterStartElement(writer,
+						       ISC_XMLCHAR "quantile"));
+			TRY0(xmlTextWriterWriteAttribute(
+				writer, ISC_XMLCHAR "name",
+				ISC_XMLCHAR quantile_names[i]));
+			TRY0(xmlTextWriterWriteFormatString(
+				writer, "%" PRIu64, values[i]));
+			TRY0(xmlTextWriterEndElement(writer)); /* quantile */
+		}
+		TRY0(xmlTextWriterEndElement(writer)); /* </histogram> */
+#endif /* ifdef HAVE_LIBXML2 */
+		break;
+	case isc_statsformat_json:
+#ifdef HAVE_JSON_C
+		job = arg;
+
+		histo = json_object_new_object();
+		if (histo == NULL) {
+			return (ISC_R_NOMEMORY);
+		}
+		json_object_object_add(job, name, histo);
+
+		obj = json_object_new_int64(count);
+		if (obj == NULL) {
+			return (ISC_R_NOMEMORY);
+		}
+		json_object_object_add(histo, "count", obj);
+
+		obj = json_object_new_int64(mean);
+		if (obj == NULL) {
+			return (ISC_R_NOMEMORY);
+		}
+		json_object_object_add(histo, "mean", obj);
+
+		for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+			obj = json_object_new_int64(values[i]);
+			if (obj == NULL) {
+				return (ISC_R_NOMEMORY);
+			}
+			json_object_object_add(histo, quantile_names[i], obj);
+		}
+#endif /* ifdef HAVE_JSON_C */
+		break;
+	}
+	return (ISC_R_SUCCESS);
+#ifdef HAVE_LIBXML2
+cleanup:
+	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+		      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+		      "failed at dump_quantiles()");
+	return (ISC_R_FAILURE);
+#endif /* ifdef HAVE_LIBXML2 */
+}
+
+/*%
+ * Names of the response latency and size histograms, indexed by
+ * dns_transport_type_t and ns_rcodehisto_t respectively.
+ */
+static const char *transporthisto_names[DNS_TRANSPORT_COUNT] = {
+	[DNS_TRANSPORT_UDP] = "udp",
+	[DNS_TRANSPORT_TCP] = "tcp",
+	[DNS_TRANSPORT_TLS] = "tls",
+	[DNS_TRANSPORT_HTTP] = "https",
+};
+
+static const char *rcodehisto_names[ns_rcodehisto_max] = {
+	[ns_rcodehisto_noerror] = "NOERROR",
+	[ns_rcodehisto_nxdomain] = "NXDOMAIN",
+	[ns_rcodehisto_servfail] = "SERVFAIL",
+	[ns_rcodehisto_refused] = "REFUSED",
+	[ns_rcodehisto_other] = "other",
+};
+
 static void
 rdtypestat_dump(dns_rdatastatstype_t type, uint64_t val, void *arg) {
 	char typebuf[64];
@@ -1732,6 +1907,55 @@ cleanup:
 	return (ISC_R_FAILURE);
 }
 
+static isc_result_t
+xfrprimary_xmlrender(const dns_xfrprimary_t *primary, void *arg) {
+	xmlTextWriterPtr writer = arg;
+	char addr_buf[ISC_NETADDR_FORMATSIZE];
+	int xmlrc;
+
+	isc_netaddr_format(&primary->addr, addr_buf, sizeof(addr_buf));
+
+	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "primary"));
+	TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "address",
+					 ISC_XMLCHAR addr_buf));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "running",
+					     "%u", primary->running));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "limit", "%u",
+					     primary->limit));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "rate",
+					     "%" PRIu64, primary->rate));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "transfers",
+					     "%" PRIu64, primary->transfers));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "failures",
+					     "%" PRIu64, primary->failures));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "waiting",
+					     "%u", primary->waiting));
+	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "queue"));
+	for (unsigned int i = 0; i < primary->waiting; i++) {
+		dns_zone_t *zone = primary->queue[i];
+		dns_view_t *view = dns_zone_getview(zone);
+		char zone_buf[DNS_NAME_FORMATSIZE];
+
+		dns_zone_nameonly(zone, zone_buf, sizeof(zone_buf));
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "zone"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "view",
+						 ISC_XMLCHAR view->name));
+		TRY0(xmlTextWriterWriteString(writer, ISC_XMLCHAR zone_buf));
+		TRY0(xmlTextWriterEndElement(writer)); /* zone */
+	}
+	TRY0(xmlTextWriterEndElement(writer)); /* queue */
+	TRY0(xmlTextWriterEndElement(writer)); /* primary */
+
+	return (ISC_R_SUCCESS);
+
+cleanup:
+	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+		      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+		      "Failed at xfrprimary_xmlrender()");
+
+	return (ISC_R_FAILURE);
+}
+
 static isc_result_t
 generatexml(named_server_t *server, uint32_t flags, int *buflen,
 	    xmlChar **buf) {
@@ -1757,6 +1981,8 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 #ifdef HAVE_DNSTAP
 	uint64_t dnstapstat_values[dns_dnstapcounter_max];
 #endif /* ifdef HAVE_DNSTAP */
+	uint64_t tlsticketstat_values[isc_tlsticketcounter_max];
+	isc_stats_t *tlsticketstats = NULL;
 	isc_result_t result;
 
 	isc_time_formatISO8601ms(&named_g_boottime, boottime, sizeof boottime);
@@ -1885,6 +2111,21 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 			TRY0(xmlTextWriterEndElement(writer)); /* dnstap */
 		}
 #endif /* ifdef HAVE_DNSTAP */
+
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "counters"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "type",
+						 ISC_XMLCHAR "tlsticket"));
+		isc_tlsctx_ticket_keys_getstats(server->tls_ticket_keys,
+						&tlsticketstats);
+		result = dump_stats(tlsticketstats, isc_statsformat_xml, writer,
+				    NULL, tlsticketstats_xmldesc,
+				    isc_tlsticketcounter_max,
+				    tlsticketstats_index, tlsticketstat_values,
+				    0);
+		isc_stats_detach(&tlsticketstats);
+		CHECK(result);
+
+		TRY0(xmlTextWriterEndElement(writer)); /* tlsticket */
 	}
 
 	if ((flags & STATS_XML_NET) != 0) {
@@ -2001,6 +2242,43 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 		TRY0(xmlTextWriterEndElement(writer)); /* </counters> */
 		TRY0(xmlTextWriterEndElement(writer)); /* </tcp> */
 		TRY0(xmlTextWriterEndElement(writer)); /* </ipv6> */
+
+		TRY0(xmlTextWriterStartElement(writer,
+					       ISC_XMLCHAR "histograms"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "type",
+						 ISC_XMLCHAR "latency"));
+		for (size_t i = DNS_TRANSPORT_UDP; i <= DNS_TRANSPORT_HTTP;
+		     i++)
+		{
+			CHECK(dump_quantiles(server->sctx->latencystats[i],
+					     isc_statsformat_xml, writer,
+					     transporthisto_names[i]));
+		}
+		TRY0(xmlTextWriterEndElement(writer)); /* </histograms> */
+
+		TRY0(xmlTextWriterStartElement(writer,
+					       ISC_XMLCHAR "histograms"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "type",
+						 ISC_XMLCHAR "rcode-latency"));
+		for (size_t i = 0; i < ns_rcodehisto_max; i++) {
+			CHECK(dump_quantiles(server->sctx->rcodelatencystats[i],
+					     isc_statsformat_xml, writer,
+					     rcodehisto_names[i]));
+		}
+		TRY0(xmlTextWriterEndElement(writer)); /* </histograms> */
+
+		TRY0(xmlTextWriterStartElement(writer,
+					       ISC_XMLCHAR "histograms"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "type",
+						 ISC_XMLCHAR "response-size"));
+		for (size_t i = DNS_TRANSPORT_UDP; i <= DNS_TRANSPORT_HTTP;
+		     i++)
+		{
+			CHECK(dump_quantiles(server->sctx->respsizestats[i],
+					     isc_statsformat_xml, writer,
+					     transporthisto_names[i]));
+		}
+		TRY0(xmlTextWriterEndElement(writer)); /* </histograms> */
 		TRY0(xmlTextWriterEndElement(writer)); /* </traffic> */
 	}
 
@@ -2072,6 +2350,9 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 		isc_stats_detach(&istats);
 		TRY0(xmlTextWriterEndElement(writer)); /* </resstats> */
 
+		CHECK(dump_quantiles(dns_resolver_getrttstats(view->resolver),
+				     isc_statsformat_xml, writer, "queryrtt"));
+
 		cacherrstats = dns_db_getrrsetstats(view->cachedb);
 		if (cacherrstats != NULL) {
 			TRY0(xmlTextWriterStartElement(writer,
@@ -2115,6 +2396,14 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 	}
 	TRY0(xmlTextWriterEndElement(writer)); /* /views */
 
+	if ((flags & STATS_XML_XFRINS) != 0) {
+		TRY0(xmlTextWriterStartElement(writer,
+					       ISC_XMLCHAR "xfrinprimaries"));
+		CHECK(dns_zonemgr_xfrprimaries(server->zonemgr,
+					       xfrprimary_xmlrender, writer));
+		TRY0(xmlTextWriterEndElement(writer)); /* /xfrinprimaries */
+	}
+
 	if ((flags & STATS_XML_MEM) != 0) {
 		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "memory"));
 		TRY0(isc_mem_renderxml(writer));
@@ -2783,13 +3072,71 @@ cleanup:
 	return (result);
 }
 
+static isc_result_t
+xfrprimary_jsonrender(const dns_xfrprimary_t *primary, void *arg) {
+	isc_result_t result;
+	json_object *primaryarray = (json_object *)arg;
+	json_object *primaryobj = NULL, *queue = NULL;
+	char addr_buf[ISC_NETADDR_FORMATSIZE];
+
+	isc_netaddr_format(&primary->addr, addr_buf, sizeof(addr_buf));
+
+	primaryobj = json_object_new_object();
+	CHECKMEM(primaryobj);
+
+	json_object_object_add(primaryobj, "address",
+			       json_object_new_string(addr_buf));
+	json_object_object_add(primaryobj, "running",
+			       json_object_new_int64(primary->running));
+	json_object_object_add(primaryobj, "limit",
+			       json_object_new_int64(primary->limit));
+	json_object_object_add(primaryobj, "rate",
+			       json_object_new_int64((int64_t)primary->rate));
+	json_object_object_add(
+		primaryobj, "transfers",
+		json_object_new_int64((int64_t)primary->transfers));
+	json_object_object_add(
+		primaryobj, "failures",
+		json_object_new_int64((int64_t)primary->failures));
+	json_object_object_add(primaryobj, "waiting",
+			       json_object_new_int64(primary->waiting));
+
+	queue = json_object_new_array();
+	CHECKMEM(queue);
+	json_object_object_add(primaryobj, "queue", queue);
+	for (unsigned int i = 0; i < primary->waiting; i++) {
+		dns_zone_t *zone = primary->queue[i];
+		dns_view_t *view = dns_zone_getview(zone);
+		char zone_buf[DNS_NAME_FORMATSIZE];
+		json_object *zoneobj = json_object_new_object();
+
+		CHECKMEM(zoneobj);
+		json_object_array_add(queue, zoneobj);
+		dns_zone_nameonly(zone, zone_buf, sizeof(zone_buf));
+		json_object_object_add(zoneobj, "name",
+				       json_object_new_string(zone_buf));
+		json_object_object_add(zoneobj, "view",
+				       json_object_new_string(view->name));
+	}
+
+	json_object_array_add(primaryarray, primaryobj);
+	primaryobj = NULL;
+	result = ISC_R_SUCCESS;
+
+cleanup:
+	if (primaryobj != NULL) {
+		json_object_put(primaryobj);
+	}
+	return (result);
+}
+
 static isc_result_t
 generatejson(named_server_t *server, size_t *msglen, const char **msg,
 	     json_object **rootp, uint32_t flags) {
 	dns_view_t *view;
 	isc_result_t result = ISC_R_SUCCESS;
 	json_object *bindstats, *viewlist, *counters, *obj;
-	json_object *traffic = NULL;
+	json_object *traffic = NULL, *histos = NULL;
 	json_object *udpreq4 = NULL, *udpresp4 = NULL;
 	json_object *tcpreq4 = NULL, *tcpresp4 = NULL;
 	json_object *udpreq6 = NULL, *udpresp6 = NULL;
@@ -2806,6 +3153,8 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 #ifdef HAVE_DNSTAP
 	uint64_t dnstapstat_values[dns_dnstapcounter_max];
 #endif /* ifdef HAVE_DNSTAP */
+	uint64_t tlsticketstat_values[isc_tlsticketcounter_max];
+	isc_stats_t *tlsticketstats = NULL;
 	stats_dumparg_t dumparg;
 	char boottime[sizeof "yyyy-mm-ddThh:mm:ss.sssZ"];
 	char configtime[sizeof "yyyy-mm-ddThh:mm:ss.sssZ"];
@@ -2999,6 +3348,30 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 			}
 		}
 #endif /* ifdef HAVE_DNSTAP */
+
+		/* TLS session ticket stat counters */
+		counters = json_object_new_object();
+		CHECKMEM(counters);
+
+		isc_tlsctx_ticket_keys_getstats(server->tls_ticket_keys,
+						&tlsticketstats);
+		result = dump_stats(tlsticketstats, isc_statsformat_json,
+				    counters, NULL, tlsticketstats_xmldesc,
+				    isc_tlsticketcounter_max,
+				    tlsticketstats_index, tlsticketstat_values,
+				    0);
+		isc_stats_detach(&tlsticketstats);
+		if (result != ISC_R_SUCCESS) {
+			json_object_put(counters);
+			goto cleanup;
+		}
+
+		if (json_object_get_object(counters)->count != 0) {
+			json_object_object_add(bindstats, "tlsticketstats",
+					       counters);
+		} else {
+			json_object_put(counters);
+		}
 	}
 
 	if ((flags &
@@ -3099,6 +3472,14 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 					dns_stats_detach(&dstats);
 				}
 
+				result = dump_quantiles(
+					dns_resolver_getrttstats(
+						view->resolver),
+					isc_statsformat_json, res, "queryrtt");
+				if (result != ISC_R_SUCCESS) {
+					goto cleanup;
+				}
+
 				dstats = dns_db_getrrsetstats(view->cachedb);
 				if (dstats != NULL) {
 					counters = json_object_new_object();
@@ -3163,6 +3544,20 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 		}
 	}
 
+	if ((flags & STATS_JSON_XFRINS) != 0) {
+		json_object *pa = json_object_new_array();
+		CHECKMEM(pa);
+
+		result = dns_zonemgr_xfrprimaries(server->zonemgr,
+						  xfrprimary_jsonrender, pa);
+		if (result != ISC_R_SUCCESS) {
+			json_object_put(pa);
+			goto cleanup;
+		}
+
+		json_object_object_add(bindstats, "xfrinprimaries", pa);
+	}
+
 	if ((flags & STATS_JSON_NET) != 0) {
 		/* socket stat counters */
 		counters = json_object_new_object();
@@ -3276,6 +3671,39 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 				 dns_sizecounter_out_max, tcpoutsizestats_index,
 				 tcpoutsizestat_values, 0));
 
+		histos = json_object_new_object();
+		CHECKMEM(histos);
+		json_object_object_add(traffic, "dns-response-latency",
+				       histos);
+		for (size_t i = DNS_TRANSPORT_UDP; i <= DNS_TRANSPORT_HTTP;
+		     i++)
+		{
+			CHECK(dump_quantiles(server->sctx->latencystats[i],
+					     isc_statsformat_json, histos,
+					     transporthisto_names[i]));
+		}
+
+		histos = json_object_new_object();
+		CHECKMEM(histos);
+		json_object_object_add(traffic, "dns-response-latency-rcode",
+				       histos);
+		for (size_t i = 0; i < ns_rcodehisto_max; i++) {
+			CHECK(dump_quantiles(server->sctx->rcodelatencystats[i],
+					     isc_statsformat_json, histos,
+					     rcodehisto_names[i]));
+		}
+
+		histos = json_object_new_object();
+		CHECKMEM(histos);
+		json_object_object_add(traffic, "dns-response-sizes", histos);
+		for (size_t i = DNS_TRANSPORT_UDP; i <= DNS_TRANSPORT_HTTP;
+		     i++)
+		{
+			CHECK(dump_quantiles(server->sctx->respsizestats[i],
+					     isc_statsformat_json, histos,
+					     transporthisto_names[i]));
+		}
+
 		json_object_object_add(traffic,
 				       "dns-udp-requests-sizes-received-ipv4",
 				       udpreq4);
@@ -3922,6 +4350,8 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 	uint64_t zonestat_values[dns_zonestatscounter_max];
 	uint64_t sockstat_values[isc_sockstatscounter_max];
 	uint64_t gluecachestats_values[dns_gluecachestatscounter_max];
+	uint64_t tlsticketstat_values[isc_tlsticketcounter_max];
+	isc_stats_t *tlsticketstats = NULL;
 	isc_stdtime_t now = isc_stdtime_now();
 
 	isc_once_do(&once, init_desc);
@@ -4072,6 +4502,14 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 			 sockstats_desc, isc_sockstatscounter_max,
 			 sockstats_index, sockstat_values, 0);
 
+	fprintf(fp, "++ TLS Session Ticket Statistics ++\n");
+	isc_tlsctx_ticket_keys_getstats(server->tls_ticket_keys,
+					&tlsticketstats);
+	(void)dump_stats(tlsticketstats, isc_statsformat_file, fp, NULL,
+			 tlsticketstats_desc, isc_tlsticketcounter_max,
+			 tlsticketstats_index, tlsticketstat_values, 0);
+	isc_stats_detach(&tlsticketstats);
+
 	fprintf(fp, "++ Per Zone Query Statistics ++\n");
 	zone = NULL;
 	for (result = dns_zone_first(server->zonemgr, &zone);
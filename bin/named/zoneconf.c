@@ -191,6 +191,44 @@ parse_acl:
 	return (ISC_R_SUCCESS);
 }
 
+/*%
+ * Attach 'zone' to the default policy and to its dnssec-policy from
+ * 'kasplist'. The policy, if any, is returned in '*kaspp'.
+ */
+static isc_result_t
+configure_zone_kasp(const cfg_obj_t **maps, dns_kasplist_t *kasplist,
+		    dns_zone_t *zone, dns_kasp_t **kaspp) {
+	isc_result_t result;
+	const cfg_obj_t *obj = NULL;
+	dns_kasp_t *kasp = NULL;
+
+	REQUIRE(kaspp != NULL && *kaspp == NULL);
+
+	/* Make a reference to the default policy. */
+	result = dns_kasplist_find(kasplist, "default", &kasp);
+	INSIST(result == ISC_R_SUCCESS && kasp != NULL);
+	dns_zone_setdefaultkasp(zone, kasp);
+	dns_kasp_detach(&kasp);
+
+	result = named_config_get(maps, "dnssec-policy", &obj);
+	if (result == ISC_R_SUCCESS) {
+		const char *kaspname = cfg_obj_asstring(obj);
+		if (strcmp(kaspname, "none") != 0) {
+			result = dns_kasplist_find(kasplist, kaspname, &kasp);
+			if (result != ISC_R_SUCCESS) {
+				cfg_obj_log(obj, named_g_lctx, ISC_LOG_ERROR,
+					    "dnssec-policy '%s' not found ",
+					    kaspname);
+				return (result);
+			}
+		}
+	}
+	dns_zone_setkasp(zone, kasp);
+
+	*kaspp = kasp;
+	return (ISC_R_SUCCESS);
+}
+
 /*%
  * Parse the zone update-policy statement.
  */
@@ -878,7 +916,6 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 	const cfg_obj_t *options = NULL;
 	const cfg_obj_t *obj;
 	const char *filename = NULL;
-	const char *kaspname = NULL;
 	const char *dupcheck;
 	dns_checkdstype_t checkdstype = dns_checkdstype_yes;
 	dns_notifytype_t notifytype = dns_notifytype_yes;
@@ -1202,34 +1239,8 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 	if (ztype != dns_zone_stub && ztype != dns_zone_staticstub &&
 	    ztype != dns_zone_redirect)
 	{
-		/* Make a reference to the default policy. */
-		result = dns_kasplist_find(kasplist, "default", &kasp);
-		INSIST(result == ISC_R_SUCCESS && kasp != NULL);
-		dns_zone_setdefaultkasp(zone, kasp);
-		dns_kasp_detach(&kasp);
-
-		obj = NULL;
-		result = named_config_get(maps, "dnssec-policy", &obj);
-		if (result == ISC_R_SUCCESS) {
-			kaspname = cfg_obj_asstring(obj);
-			if (strcmp(kaspname, "none") != 0) {
-				result = dns_kasplist_find(kasplist, kaspname,
-							   &kasp);
-				if (result != ISC_R_SUCCESS) {
-					cfg_obj_log(
-						obj, named_g_lctx,
-						ISC_LOG_ERROR,
-						"dnssec-policy '%s' not found ",
-						kaspname);
-					CHECK(result);
-				}
-				dns_zone_setkasp(zone, kasp);
-				use_kasp = true;
-			}
-		}
-		if (!use_kasp) {
-			dns_zone_setkasp(zone, NULL);
-		}
+		CHECK(configure_zone_kasp(maps, kasplist, zone, &kasp));
+		use_kasp = (kasp != NULL);
 
 		obj = NULL;
 		result = named_config_get(maps, "notify", &obj);
@@ -1918,6 +1929,77 @@ named_zone_configure_writeable_dlz(dns_dlzdb_t *dlzdatabase, dns_zone_t *zone,
 	return (result);
 }
 
+isc_result_t
+named_zone_reattach(const cfg_obj_t *config, const cfg_obj_t *vconfig,
+		    const cfg_obj_t *zconfig, cfg_aclconfctx_t *ac,
+		    dns_kasplist_t *kasplist, dns_zone_t *zone,
+		    dns_zone_t *raw) {
+	isc_result_t result;
+	const cfg_obj_t *maps[5];
+	const cfg_obj_t *zoptions = NULL;
+	const cfg_obj_t *options = NULL;
+	dns_zone_t *mayberaw = (raw != NULL) ? raw : zone;
+	dns_zonetype_t ztype;
+	dns_kasp_t *kasp = NULL;
+	int i = 0;
+
+	zoptions = cfg_tuple_get(zconfig, "options");
+	maps[i++] = zoptions;
+	if (vconfig != NULL) {
+		maps[i++] = cfg_tuple_get(vconfig, "options");
+	}
+	if (config != NULL) {
+		(void)cfg_map_get(config, "options", &options);
+		if (options != NULL) {
+			maps[i++] = options;
+		}
+	}
+	maps[i++] = named_g_defaults;
+	maps[i] = NULL;
+
+	/*
+	 * The conditions here must match those in named_zone_configure().
+	 */
+	ztype = zonetype_fromconfig(zoptions);
+	if (ztype == dns_zone_secondary || ztype == dns_zone_mirror) {
+		CHECK(configure_zone_acl(zconfig, vconfig, config, allow_notify,
+					 ac, mayberaw, dns_zone_setnotifyacl,
+					 dns_zone_clearnotifyacl));
+		CHECK(configure_zone_acl(zconfig, vconfig, config,
+					 allow_update_forwarding, ac, mayberaw,
+					 dns_zone_setforwardacl,
+					 dns_zone_clearforwardacl));
+	}
+
+	CHECK(configure_zone_acl(zconfig, vconfig, config, allow_query, ac,
+				 zone, dns_zone_setqueryacl,
+				 dns_zone_clearqueryacl));
+	CHECK(configure_zone_acl(zconfig, vconfig, config, allow_query_on, ac,
+				 zone, dns_zone_setqueryonacl,
+				 dns_zone_clearqueryonacl));
+
+	if (ztype != dns_zone_stub && ztype != dns_zone_staticstub &&
+	    ztype != dns_zone_redirect)
+	{
+		CHECK(configure_zone_kasp(maps, kasplist, zone, &kasp));
+		CHECK(configure_zone_acl(
+			zconfig, vconfig, config, allow_transfer, ac, zone,
+			dns_zone_setxfracl, dns_zone_clearxfracl));
+	}
+
+	if (ztype == dns_zone_primary) {
+		CHECK(configure_zone_acl(zconfig, vconfig, config, allow_update,
+					 ac, mayberaw, dns_zone_setupdateacl,
+					 dns_zone_clearupdateacl));
+	}
+
+cleanup:
+	if (kasp != NULL) {
+		dns_kasp_detach(&kasp);
+	}
+	return (result);
+}
+
 bool
 named_zone_reusable(dns_zone_t *zone, const cfg_obj_t *zconfig,
 		    const cfg_obj_t *vconfig, const cfg_obj_t *config,
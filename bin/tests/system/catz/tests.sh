@@ -312,6 +312,21 @@ wait_for_no_zonefile "ns2/zonedir/__catz__default_catalog1.example_dom1.example.
 if [ $ret -ne 0 ]; then echo_i "failed"; fi
 status=$((status + ret))
 
+n=$((n + 1))
+echo_i "checking catalog zone statistics ($n)"
+ret=0
+rm -f ns2/named.stats
+rndccmd 10.53.0.2 stats || ret=1
+retry_quiet 5 test -f ns2/named.stats || ret=1
+added=$(sed -n 's/^ *\([0-9][0-9]*\) catalog member zones added$/\1/p' ns2/named.stats)
+deleted=$(sed -n 's/^ *\([0-9][0-9]*\) catalog member zones deleted$/\1/p' ns2/named.stats)
+[ "${added:-0}" -ge 1 ] || ret=1
+[ "${deleted:-0}" -ge 1 ] || ret=1
+# nothing is left in the queue
+grep "catalog member changes pending" ns2/named.stats >/dev/null && ret=1
+if [ $ret -ne 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
 nextpart ns2/named.run >/dev/null
 
 ##########################################################################
@@ -1154,6 +1154,33 @@ if [ -x "$MDIG" ]; then
   if [ $ret -ne 0 ]; then echo_i "failed"; fi
   status=$((status + ret))
 
+  n=$((n + 1))
+  echo_i "checking mdig +rate load generation over UDP ($n)"
+  ret=0
+  mdig_with_opts @10.53.0.3 +rate=100 +duration=2 +workers=2 +sockets=4 a.example >dig.out.test$n 2>&1 || ret=1
+  grep "^;; Load: 100 queries/sec for 2 seconds over UDP" dig.out.test$n >/dev/null || ret=1
+  sent=$(sed -n 's/^;; Queries sent: \([0-9]*\) .*/\1/p' dig.out.test$n)
+  answered=$(sed -n 's/^;; Queries sent: .*, answered: \([0-9]*\) .*/\1/p' dig.out.test$n)
+  [ "${sent:-0}" -gt 0 ] || ret=1
+  [ "$answered" = "$sent" ] || ret=1
+  grep "^;; Queries lost: 0, failed to send: 0" dig.out.test$n >/dev/null || ret=1
+  grep "^;; Response codes: NOERROR $sent\$" dig.out.test$n >/dev/null || ret=1
+  if [ $ret -ne 0 ]; then echo_i "failed"; fi
+  status=$((status + ret))
+
+  n=$((n + 1))
+  echo_i "checking mdig +rate load generation over TCP ($n)"
+  ret=0
+  mdig_with_opts +tcp @10.53.0.3 +rate=100 +duration=2 +sockets=2 a.example >dig.out.test$n 2>&1 || ret=1
+  grep "^;; Load: 100 queries/sec for 2 seconds over TCP" dig.out.test$n >/dev/null || ret=1
+  sent=$(sed -n 's/^;; Queries sent: \([0-9]*\) .*/\1/p' dig.out.test$n)
+  answered=$(sed -n 's/^;; Queries sent: .*, answered: \([0-9]*\) .*/\1/p' dig.out.test$n)
+  [ "${sent:-0}" -gt 0 ] || ret=1
+  [ "$answered" = "$sent" ] || ret=1
+  grep "^;; Queries lost: 0, failed to send: 0" dig.out.test$n >/dev/null || ret=1
+  if [ $ret -ne 0 ]; then echo_i "failed"; fi
+  status=$((status + ret))
+
   if [ $HAS_PYYAML -ne 0 ]; then
     n=$((n + 1))
     echo_i "check mdig +yaml output ($n)"
@@ -546,6 +546,29 @@ set_key_default_values "KEY1"
 echo_i "check zone ${ZONE} after reconfig"
 check_nsec3
 
+# Reconfig named again without changing anything. The zones are not
+# reconfigured, but they must use the policies from the new configuration.
+n=$((n + 1))
+echo_i "check unchanged zones use the new policies after reconfig ($n)"
+ret=0
+nextpart ns3/named.run >/dev/null
+rndc_reconfig ns3 10.53.0.3
+nextpart ns3/named.run >named.run.test$n
+grep "zone 'nsec3.kasp': configuration unchanged" named.run.test$n >/dev/null || ret=1
+grep "zone 'nsec3-other.kasp': configuration unchanged" named.run.test$n >/dev/null || ret=1
+rndccmd 10.53.0.3 dnssec -status nsec3-other.kasp >rndc.dnssec.status.test$n 2>&1 || ret=1
+grep "dnssec-policy: nsec3-other" rndc.dnssec.status.test$n >/dev/null || ret=1
+rndccmd 10.53.0.3 loadkeys nsec3-other.kasp >/dev/null 2>&1 || ret=1
+test "$ret" -eq 0 || echo_i "failed"
+status=$((status + ret))
+
+# Zone: nsec3-other.kasp. (unchanged)
+set_zone_policy "nsec3-other.kasp" "nsec3-other" 1 3600
+set_nsec3param "1" "8"
+set_key_default_values "KEY1"
+echo_i "check zone ${ZONE} after unchanged reconfig"
+check_nsec3
+
 # Test NSEC3 and NSEC3PARAM is the same after restart
 set_zone_policy "nsec3.kasp" "nsec3" 1 3600
 set_nsec3param "0" "0"
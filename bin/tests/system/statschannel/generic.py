@@ -227,3 +227,27 @@ def test_traffic(fetch_traffic, **kwargs):
     data = fetch_traffic(statsip, statsport)
 
     check_traffic(data, exp)
+
+
+def test_response_size_histogram(fetch_histogram, **kwargs):
+    statsip = kwargs["statsip"]
+    statsport = kwargs["statsport"]
+
+    before = fetch_histogram(statsip, statsport, "response-size", "tcp")
+
+    # Enough identical responses to dominate the median even if other
+    # tests have already sent TCP responses from this server.
+    count = 100
+    msg = create_msg("long.example.", "TXT")
+    for _ in range(count):
+        ans = isctest.query.tcp(msg, statsip)
+        isctest.check.noerror(ans)
+    size = len(ans.to_wire())
+
+    after = fetch_histogram(statsip, statsport, "response-size", "tcp")
+
+    assert after["count"] == before["count"] + count
+    assert after["p50"] <= after["p90"] <= after["p99"] <= after["p999"]
+
+    # Sizes are kept with seven significant bits, i.e. within about 0.8%.
+    assert abs(after["p50"] - size) <= size / 100
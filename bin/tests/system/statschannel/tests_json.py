@@ -43,7 +43,33 @@ def fetch_traffic_json(statsip, statsport):
 
     data = r.json()
 
-    return data["traffic"]
+    # Leave only the fixed-width size counters
+    traffic = data["traffic"]
+    for key in [
+        "dns-response-latency",
+        "dns-response-latency-rcode",
+        "dns-response-sizes",
+    ]:
+        del traffic[key]
+
+    return traffic
+
+
+def fetch_histogram_json(statsip, statsport, histogram, name):
+    keys = {
+        "latency": "dns-response-latency",
+        "rcode-latency": "dns-response-latency-rcode",
+        "response-size": "dns-response-sizes",
+    }
+
+    r = requests.get(
+        "http://{}:{}/json/v1/traffic".format(statsip, statsport), timeout=600
+    )
+    assert r.status_code == 200
+
+    data = r.json()
+
+    return data["traffic"][keys[histogram]][name]
 
 
 def load_timers_json(zone, primary=True):
@@ -102,3 +128,9 @@ def test_zone_with_many_keys_json(statsport):
 
 def test_traffic_json(statsport):
     generic.test_traffic(fetch_traffic_json, statsip="10.53.0.2", statsport=statsport)
+
+
+def test_response_size_histogram_json(statsport):
+    generic.test_response_size_histogram(
+        fetch_histogram_json, statsip="10.53.0.2", statsport=statsport
+    )
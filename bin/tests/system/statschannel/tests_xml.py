@@ -75,6 +75,31 @@ def fetch_traffic_xml(statsip, statsport):
     return traffic
 
 
+def fetch_histogram_xml(statsip, statsport, histogram, name):
+    r = requests.get(
+        "http://{}:{}/xml/v3/traffic".format(statsip, statsport), timeout=600
+    )
+    assert r.status_code == 200
+
+    root = ET.fromstring(r.text)
+
+    for histograms in root.find("traffic").findall("histograms"):
+        if histograms.attrib["type"] != histogram:
+            continue
+        for el in histograms.findall("histogram"):
+            if el.attrib["name"] != name:
+                continue
+            out = {
+                "count": int(el.find("count").text),
+                "mean": int(el.find("mean").text),
+            }
+            for quantile in el.findall("quantile"):
+                out[quantile.attrib["name"]] = int(quantile.text)
+            return out
+
+    assert False, "histogram {}/{} not found".format(histogram, name)
+
+
 def load_timers_xml(zone, primary=True):
     name = zone.attrib["name"]
 
@@ -132,3 +157,9 @@ def test_zone_with_many_keys_xml(statsport):
 
 def test_traffic_xml(statsport):
     generic.test_traffic(fetch_traffic_xml, statsip="10.53.0.2", statsport=statsport)
+
+
+def test_response_size_histogram_xml(statsport):
+    generic.test_response_size_histogram(
+        fetch_histogram_xml, statsip="10.53.0.2", statsport=statsport
+    )
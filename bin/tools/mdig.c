@@ -12,16 +12,19 @@
  */
 
 #include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <isc/atomic.h>
 #include <isc/attributes.h>
 #include <isc/base64.h>
 #include <isc/getaddresses.h>
 #include <isc/hash.h>
 #include <isc/hex.h>
+#include <isc/histo.h>
 #include <isc/log.h>
 #include <isc/loop.h>
 #include <isc/managers.h>
@@ -36,10 +39,14 @@
 #include <isc/sockaddr.h>
 #include <isc/string.h>
 #include <isc/time.h>
+#include <isc/timer.h>
+#include <isc/tls.h>
 #include <isc/util.h>
 
 #include <dns/byaddr.h>
+#include <dns/compress.h>
 #include <dns/dispatch.h>
+#include <dns/dnstap.h>
 #include <dns/fixedname.h>
 #include <dns/message.h>
 #include <dns/name.h>
@@ -111,7 +118,7 @@ static uint32_t display_splitwidth = 0xffffffff;
 static isc_sockaddr_t srcaddr;
 static char *server = NULL;
 static isc_sockaddr_t dstaddr;
-static in_port_t port = 53;
+static in_port_t port = 0;
 static unsigned char cookie_secret[33];
 static int onfly = 0;
 static char hexcookie[81];
@@ -122,6 +129,92 @@ static dns_dispatchmgr_t *dispatchmgr = NULL;
 static dns_dispatch_t *dispatchvx = NULL;
 static dns_view_t *view = NULL;
 
+/*
+ * Load generation mode (+rate).
+ */
+#define LOAD_MAXRATE	   10000000
+#define LOAD_MAXDURATION   3600
+#define LOAD_MAXWORKERS	   128
+#define LOAD_MAXSOCKETS	   1024
+#define LOAD_MAXBURST	   1024
+#define LOAD_MINWINDOW	   64
+#define LOAD_HISTO_SIGBITS 5
+
+typedef struct loadgen loadgen_t;
+
+/*%
+ * A query in flight, kept in its connection's window at the slot given
+ * by the low bits of its ID.
+ */
+typedef struct loadslot {
+	uint32_t sentat; /*%< send time (usec + 1), 0 if free */
+	uint16_t id;
+} loadslot_t;
+
+typedef struct loadconn {
+	loadgen_t *lg;
+	isc_nmhandle_t *handle;
+	uint16_t nextid;
+	loadslot_t *window; /*%< 'load_window' slots */
+} loadconn_t;
+
+typedef struct loadsend {
+	loadgen_t *lg;
+	loadconn_t *conn;	/*%< NULL for DoH */
+	isc_nmhandle_t *handle; /*%< DoH connection */
+	isc_nanosecs_t sentat;
+	unsigned int references;
+	uint16_t id;
+	isc_region_t region;
+	unsigned char data[];
+} loadsend_t;
+
+struct loadgen {
+	isc_loop_t *loop;
+	isc_timer_t *timer;
+	uint32_t tid;
+	loadconn_t *conns;
+	uint32_t nextconn;
+	size_t nexttemplate;
+	double interval; /*%< mean nanoseconds between queries */
+	isc_nanosecs_t start;
+	isc_nanosecs_t stop;
+	isc_nanosecs_t drain;
+	isc_nanosecs_t next;
+	uint32_t connecting;
+	bool sending;
+	bool finished;
+	uint64_t sent;
+	uint64_t received;
+	uint64_t lost;
+	uint64_t failed;
+	uint64_t outstanding;
+	uint64_t rcodes[16];
+	isc_histo_t *latency;
+};
+
+static uint32_t load_rate = 0;
+static uint32_t load_duration = 10;
+static uint32_t load_workers = 1;
+static uint32_t load_sockets = 1;
+static uint32_t load_timeout = 0;
+static uint32_t load_window = LOAD_MINWINDOW;
+static bool load_poisson = false;
+static bool load_tls = false;
+static bool load_https = false;
+#if HAVE_LIBNGHTTP2
+static char load_httppath[256] = ISC_NM_HTTP_DEFAULT_PATH;
+static char load_uri[512];
+#endif /* HAVE_LIBNGHTTP2 */
+static const char *load_replay = NULL;
+static isc_region_t *templates = NULL;
+static size_t ntemplates = 0;
+static size_t templates_size = 0;
+static loadgen_t *loadgens = NULL;
+static isc_tlsctx_t *load_tlsctx = NULL;
+static isc_tlsctx_client_session_cache_t *load_sesscache = NULL;
+static atomic_uint_fast32_t load_running;
+
 struct query {
 	char textname[MXNAME]; /*% Name we're going to be
 				* looking up */
@@ -574,18 +667,17 @@ compute_cookie(unsigned char *cookie, size_t len) {
 	memmove(cookie, cookie_secret, 8);
 }
 
-static isc_result_t
-sendquery(struct query *query) {
-	dns_request_t *request = NULL;
+/*%
+ * Build the query message described by 'query'.
+ */
+static dns_message_t *
+buildquery(struct query *query) {
 	dns_message_t *message = NULL;
 	dns_name_t *qname = NULL;
 	dns_rdataset_t *qrdataset = NULL;
 	isc_result_t result;
 	dns_fixedname_t queryname;
 	isc_buffer_t buf;
-	unsigned int options = 0;
-
-	onfly++;
 
 	dns_fixedname_init(&queryname);
 	isc_buffer_init(&buf, query->textname, strlen(query->textname));
@@ -746,6 +838,20 @@ sendquery(struct query *query) {
 		add_opt(message, query->udpsize, query->edns, flags, opts, i);
 	}
 
+	return (message);
+}
+
+static isc_result_t
+sendquery(struct query *query) {
+	dns_request_t *request = NULL;
+	dns_message_t *message = NULL;
+	isc_result_t result;
+	unsigned int options = 0;
+
+	onfly++;
+
+	message = buildquery(query);
+
 	if (tcp_mode) {
 		options |= DNS_REQUESTOPT_TCP;
 	}
@@ -848,6 +954,21 @@ help(void) {
 	       "expanded format)\n"
 	       "                 +[no]split=##       (Split hex/base64 fields "
 	       "into chunks)\n"
+	       "                 +rate=###           (Load mode: send ### "
+	       "queries/sec)\n"
+	       "                 +duration=###       (Length of the load run "
+	       "in seconds) [10]\n"
+	       "                 +[no]poisson        (Poisson instead of "
+	       "constant pacing)\n"
+	       "                 +workers=###        (Number of load worker "
+	       "loops) [1]\n"
+	       "                 +sockets=###        (Sockets per load worker) "
+	       "[1]\n"
+	       "                 +[no]tls            (Load over DNS-over-TLS)\n"
+	       "                 +[no]https[=###]    (Load over DNS-over-HTTPS,"
+	       " optional path)\n"
+	       "                 +replay=file        (Load queries from a query"
+	       " log or dnstap file)\n"
 	       " local opt       is one of:\n"
 	       "                 -c class            (specify query class)\n"
 	       "                 -t type             (specify query type)\n"
@@ -1310,6 +1431,22 @@ plus_option(char *option, struct query *query, bool global) {
 			}
 			query->dnssec = state;
 			break;
+		case 'u': /* duration */
+			FULLCHECK("duration");
+			GLOBAL();
+			if (value == NULL) {
+				goto need_value;
+			}
+			if (!state) {
+				goto invalid_option;
+			}
+			result = parse_uint(&load_duration, value,
+					    LOAD_MAXDURATION, "duration");
+			CHECK("parse_uint(duration)", result);
+			if (load_duration == 0) {
+				load_duration = 1;
+			}
+			break;
 		default:
 			goto invalid_option;
 		}
@@ -1400,6 +1537,24 @@ plus_option(char *option, struct query *query, bool global) {
 			goto invalid_option;
 		}
 		break;
+	case 'h': /* https */
+		FULLCHECK("https");
+		GLOBAL();
+#if HAVE_LIBNGHTTP2
+		load_https = state;
+		if (state && value != NULL) {
+			n = strlcpy(load_httppath, value,
+				    sizeof(load_httppath));
+			if (n >= sizeof(load_httppath)) {
+				fatal("HTTP path too long");
+			}
+		}
+#else  /* HAVE_LIBNGHTTP2 */
+		if (state) {
+			fatal("DNS-over-HTTPS is not supported in this build");
+		}
+#endif /* HAVE_LIBNGHTTP2 */
+		break;
 	case 'm': /* multiline */
 		FULLCHECK("multiline");
 		GLOBAL();
@@ -1412,6 +1567,11 @@ plus_option(char *option, struct query *query, bool global) {
 		}
 		query->nsid = state;
 		break;
+	case 'p': /* poisson */
+		FULLCHECK("poisson");
+		GLOBAL();
+		load_poisson = state;
+		break;
 	case 'q':
 		FULLCHECK("question");
 		GLOBAL();
@@ -1419,6 +1579,20 @@ plus_option(char *option, struct query *query, bool global) {
 		break;
 	case 'r':
 		switch (cmd[1]) {
+		case 'a': /* rate */
+			FULLCHECK("rate");
+			GLOBAL();
+			if (!state) {
+				load_rate = 0;
+				break;
+			}
+			if (value == NULL) {
+				goto need_value;
+			}
+			result = parse_uint(&load_rate, value, LOAD_MAXRATE,
+					    "rate");
+			CHECK("parse_uint(rate)", result);
+			break;
 		case 'e':
 			switch (cmd[2]) {
 			case 'c': /* recurse */
@@ -1437,6 +1611,18 @@ plus_option(char *option, struct query *query, bool global) {
 						    MAXTRIES - 1, "udpretries");
 				CHECK("parse_uint(udpretries)", result);
 				break;
+			case 'p': /* replay */
+				FULLCHECK("replay");
+				GLOBAL();
+				if (!state) {
+					load_replay = NULL;
+					break;
+				}
+				if (value == NULL) {
+					goto need_value;
+				}
+				load_replay = value;
+				break;
 			default:
 				goto invalid_option;
 			}
@@ -1465,6 +1651,22 @@ plus_option(char *option, struct query *query, bool global) {
 				display_rrcomments = -1;
 			}
 			break;
+		case 'o': /* sockets */
+			FULLCHECK("sockets");
+			GLOBAL();
+			if (value == NULL) {
+				goto need_value;
+			}
+			if (!state) {
+				goto invalid_option;
+			}
+			result = parse_uint(&load_sockets, value,
+					    LOAD_MAXSOCKETS, "sockets");
+			CHECK("parse_uint(sockets)", result);
+			if (load_sockets == 0) {
+				load_sockets = 1;
+			}
+			break;
 		case 'p': /* split */
 			FULLCHECK("split");
 			GLOBAL();
@@ -1545,6 +1747,11 @@ plus_option(char *option, struct query *query, bool global) {
 				query->timeout = 1;
 			}
 			break;
+		case 'l': /* tls */
+			FULLCHECK("tls");
+			GLOBAL();
+			load_tls = state;
+			break;
 		case 'r':
 			FULLCHECK("tries");
 			if (value == NULL) {
@@ -1615,6 +1822,17 @@ plus_option(char *option, struct query *query, bool global) {
 		GLOBAL();
 		tcp_mode = state;
 		break;
+	case 'w': /* workers */
+		FULLCHECK("workers");
+		GLOBAL();
+		if (value == NULL) {
+			goto need_value;
+		}
+		if (!state) {
+			goto invalid_option;
+		}
+		/* The loop manager has already been sized by preparse_args() */
+		break;
 	case 'y': /* yaml */
 		FULLCHECK("yaml");
 		yaml = state;
@@ -1836,6 +2054,31 @@ preparse_args(int argc, char **argv) {
 	rc = argc;
 	rv = argv;
 	for (rc--, rv++; rc > 0; rc--, rv++) {
+		if (rv[0][0] == '+') {
+			/*
+			 * +workers sizes the loop manager, which has to
+			 * exist before the main argument parser runs.
+			 */
+			const char *value = strchr(rv[0], '=');
+			size_t len = 0;
+
+			if (value != NULL) {
+				len = value - &rv[0][1];
+			}
+			if (len > 0 && len < sizeof("workers") &&
+			    strncasecmp(&rv[0][1], "workers", len) == 0)
+			{
+				isc_result_t result;
+
+				result = parse_uint(&load_workers, value + 1,
+						    LOAD_MAXWORKERS, "workers");
+				CHECK("parse_uint(workers)", result);
+				if (load_workers == 0) {
+					load_workers = 1;
+				}
+			}
+			continue;
+		}
 		if (rv[0][0] != '-') {
 			continue;
 		}
@@ -2077,6 +2320,769 @@ set_source_ports(dns_dispatchmgr_t *manager) {
 	isc_portset_destroy(mctx, &v6portset);
 }
 
+/*
+ * Load generation mode.
+ *
+ * Every query given on the command line, or read from a +replay file, is
+ * rendered once into a wire format template.  Each worker loop then sends
+ * copies of the templates over its own sockets on an open-loop schedule:
+ * the next query is due a fixed (or, with +poisson, an exponentially
+ * distributed) interval after the previous one, whether or not earlier
+ * queries have been answered.  Latency is measured from the time a query
+ * was due rather than from when it was actually sent, so neither a slow
+ * server nor a slow generator can hide queueing delay.
+ */
+
+static void
+load_addtemplate(const unsigned char *data, size_t len) {
+	isc_region_t *template = NULL;
+
+	if (len < DNS_MESSAGE_HEADERLEN) {
+		return;
+	}
+
+	if (ntemplates == templates_size) {
+		size_t newsize = ISC_MAX(2 * templates_size, 64);
+
+		templates = isc_mem_creget(mctx, templates, templates_size,
+					   newsize, sizeof(templates[0]));
+		templates_size = newsize;
+	}
+
+	template = &templates[ntemplates++];
+	template->base = isc_mem_get(mctx, len);
+	template->length = len;
+	memmove(template->base, data, len);
+}
+
+static void
+load_addquery(struct query *query) {
+	static unsigned char wire[COMMSIZE];
+	dns_message_t *message = NULL;
+	dns_compress_t cctx;
+	isc_buffer_t b;
+	isc_result_t result;
+
+	message = buildquery(query);
+
+	isc_buffer_init(&b, wire, sizeof(wire));
+	dns_compress_init(&cctx, mctx, 0);
+	result = dns_message_renderbegin(message, &cctx, &b);
+	CHECK("dns_message_renderbegin", result);
+	result = dns_message_rendersection(message, DNS_SECTION_QUESTION, 0);
+	CHECK("dns_message_rendersection", result);
+	result = dns_message_rendersection(message, DNS_SECTION_ADDITIONAL, 0);
+	CHECK("dns_message_rendersection", result);
+	result = dns_message_renderend(message);
+	CHECK("dns_message_renderend", result);
+	dns_compress_invalidate(&cctx);
+
+	load_addtemplate(isc_buffer_base(&b), isc_buffer_usedlength(&b));
+
+	dns_message_detach(&message);
+}
+
+/*%
+ * Read query templates from 'filename', which is either a dnstap file
+ * (client queries are replayed verbatim) or a named query log, where
+ * each "query: NAME CLASS TYPE FLAGS" entry is turned into a query using
+ * the global query options.
+ */
+static void
+load_readreplay(const char *filename) {
+	char line[MXNAME + 1024];
+	FILE *fp = NULL;
+	unsigned int count = 0;
+
+#ifdef HAVE_DNSTAP
+	dns_dthandle_t *handle = NULL;
+
+	if (dns_dt_open(filename, dns_dtmode_file, mctx, &handle) ==
+	    ISC_R_SUCCESS)
+	{
+		isc_result_t result;
+
+		for (;;) {
+			dns_dtdata_t *dt = NULL;
+			isc_region_t r;
+			uint8_t *data = NULL;
+			size_t len = 0;
+
+			result = dns_dt_getframe(handle, &data, &len);
+			if (result != ISC_R_SUCCESS) {
+				break;
+			}
+
+			r.base = data;
+			r.length = len;
+			if (dns_dt_parse(mctx, &r, &dt) != ISC_R_SUCCESS) {
+				continue;
+			}
+			if (dt->type == DNS_DTTYPE_CQ) {
+				load_addtemplate(dt->msgdata.base,
+						 dt->msgdata.length);
+			}
+			dns_dtdata_free(&dt);
+		}
+		dns_dt_close(&handle);
+
+		if (result != ISC_R_NOMORE) {
+			fatal("couldn't read dnstap file '%s': %s", filename,
+			      isc_result_totext(result));
+		}
+		return;
+	}
+#endif /* HAVE_DNSTAP */
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) {
+		perror(filename);
+		fatal("couldn't open replay file '%s'", filename);
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		struct query *query = NULL;
+		char *name = NULL, *class = NULL, *type = NULL, *flags = NULL;
+		char *p = NULL, *last = NULL;
+		isc_textregion_t tr;
+		dns_rdataclass_t rdclass;
+		dns_rdatatype_t rdtype;
+
+		p = strstr(line, "query: ");
+		if (p == NULL) {
+			continue;
+		}
+
+		name = strtok_r(p + strlen("query: "), " \t\r\n", &last);
+		class = strtok_r(NULL, " \t\r\n", &last);
+		type = strtok_r(NULL, " \t\r\n", &last);
+		flags = strtok_r(NULL, " \t\r\n", &last);
+		if (type == NULL || strlen(name) >= MXNAME) {
+			continue;
+		}
+
+		tr.base = class;
+		tr.length = strlen(class);
+		if (dns_rdataclass_fromtext(&rdclass, &tr) != ISC_R_SUCCESS) {
+			continue;
+		}
+		tr.base = type;
+		tr.length = strlen(type);
+		if (dns_rdatatype_fromtext(&rdtype, &tr) != ISC_R_SUCCESS) {
+			continue;
+		}
+
+		query = clone_default_query();
+		strlcpy(query->textname, name, sizeof(query->textname));
+		query->rdclass = rdclass;
+		query->rdtype = rdtype;
+		if (flags != NULL) {
+			query->recurse = (flags[0] == '+');
+		}
+
+		load_addquery(query);
+		count++;
+
+		if (query->ecs_addr != NULL) {
+			isc_mem_free(mctx, query->ecs_addr);
+		}
+		isc_mem_free(mctx, query);
+	}
+
+	fclose(fp);
+
+	if (count == 0) {
+		fatal("no queries found in replay file '%s'", filename);
+	}
+}
+
+static isc_nanosecs_t
+load_nextinterval(loadgen_t *lg) {
+	double u;
+
+	if (!load_poisson) {
+		return ((isc_nanosecs_t)lg->interval);
+	}
+
+	/* Exponentially distributed gaps give a Poisson arrival process. */
+	u = isc_random32() / 4294967296.0;
+	return ((isc_nanosecs_t)(-log(1.0 - u) * lg->interval));
+}
+
+static loadsend_t *
+load_newsend(loadgen_t *lg, loadconn_t *conn, isc_nanosecs_t when) {
+	isc_region_t *template = NULL;
+	loadsend_t *send = NULL;
+
+	template = &templates[lg->nexttemplate++ % ntemplates];
+	send = isc_mem_get(mctx, sizeof(*send) + template->length);
+	*send = (loadsend_t){
+		.lg = lg,
+		.conn = conn,
+		.sentat = when,
+		.region = { .base = send->data, .length = template->length },
+	};
+	memmove(send->data, template->base, template->length);
+
+	return (send);
+}
+
+static void
+load_freesend(loadsend_t *send) {
+	isc_mem_put(mctx, send, sizeof(*send) + send->region.length);
+}
+
+static void
+load_response(loadgen_t *lg, isc_region_t *region, isc_nanosecs_t sentat) {
+	isc_nanosecs_t now = isc_time_monotonic();
+
+	lg->received++;
+	lg->rcodes[region->base[3] & 0x0f]++;
+	isc_histo_inc(lg->latency, (now - sentat) / NS_PER_US);
+}
+
+static void
+load_connect(loadconn_t *conn);
+
+static void
+load_read(isc_nmhandle_t *handle, isc_result_t eresult, isc_region_t *region,
+	  void *arg) {
+	loadconn_t *conn = (loadconn_t *)arg;
+	loadgen_t *lg = conn->lg;
+
+	if (lg->finished) {
+		return;
+	}
+
+	if (eresult != ISC_R_SUCCESS) {
+		/*
+		 * The connection is gone, and so is any answer to the
+		 * queries that were sent over it.
+		 */
+		for (size_t i = 0; i < load_window; i++) {
+			if (conn->window[i].sentat != 0) {
+				conn->window[i].sentat = 0;
+				lg->outstanding--;
+				lg->lost++;
+			}
+		}
+		isc_nmhandle_detach(&conn->handle);
+		if (lg->sending) {
+			load_connect(conn);
+		}
+		return;
+	}
+
+	if (region->length >= DNS_MESSAGE_HEADERLEN) {
+		uint16_t id = (region->base[0] << 8) | region->base[1];
+		loadslot_t *slot = &conn->window[id & (load_window - 1)];
+
+		if (slot->sentat != 0 && slot->id == id) {
+			isc_nanosecs_t sentat = slot->sentat - 1;
+
+			sentat = lg->start + sentat * NS_PER_US;
+			slot->sentat = 0;
+			lg->outstanding--;
+			load_response(lg, region, sentat);
+		}
+	}
+
+	isc_nm_read(handle, load_read, conn);
+}
+
+static void
+load_senddone(isc_nmhandle_t *handle ISC_ATTR_UNUSED, isc_result_t eresult,
+	      void *arg) {
+	loadsend_t *send = (loadsend_t *)arg;
+	loadconn_t *conn = send->conn;
+	loadgen_t *lg = send->lg;
+	loadslot_t *slot = &conn->window[send->id & (load_window - 1)];
+
+	if (eresult != ISC_R_SUCCESS && !lg->finished && slot->sentat != 0 &&
+	    slot->id == send->id)
+	{
+		slot->sentat = 0;
+		lg->outstanding--;
+		lg->failed++;
+	}
+
+	load_freesend(send);
+}
+
+static void
+load_begin(loadgen_t *lg);
+
+static void
+load_connected(isc_nmhandle_t *handle, isc_result_t eresult, void *arg) {
+	loadconn_t *conn = (loadconn_t *)arg;
+	loadgen_t *lg = conn->lg;
+
+	if (lg->finished) {
+		return;
+	}
+
+	if (eresult == ISC_R_SUCCESS) {
+		isc_nmhandle_attach(handle, &conn->handle);
+		isc_nmhandle_cleartimeout(handle);
+		isc_nm_read(handle, load_read, conn);
+	} else {
+		fprintf(stderr, ";; connection to %s failed: %s\n", server,
+			isc_result_totext(eresult));
+	}
+
+	/*
+	 * Start the clock once every socket has been given the chance
+	 * to connect.
+	 */
+	if (lg->connecting > 0 && --lg->connecting == 0) {
+		load_begin(lg);
+	}
+}
+
+static void
+load_connect(loadconn_t *conn) {
+	isc_sockaddr_t *local = have_src ? &srcaddr : &bind_any;
+	unsigned int timeout = load_timeout * 1000;
+
+	if (tcp_mode || load_tls) {
+		isc_nm_streamdnsconnect(netmgr, local, &dstaddr, load_connected,
+					conn, timeout,
+					load_tls ? load_tlsctx : NULL,
+					load_tls ? load_sesscache : NULL,
+					ISC_NM_PROXY_NONE, NULL);
+	} else {
+		isc_nm_udpconnect(netmgr, local, &dstaddr, load_connected, conn,
+				  timeout);
+	}
+}
+
+#if HAVE_LIBNGHTTP2
+static void
+load_dohdetach(loadsend_t *send) {
+	INSIST(send->references > 0);
+
+	if (--send->references == 0) {
+		if (send->handle != NULL) {
+			isc_nmhandle_detach(&send->handle);
+		}
+		load_freesend(send);
+	}
+}
+
+static void
+load_dohread(isc_nmhandle_t *handle ISC_ATTR_UNUSED, isc_result_t eresult,
+	     isc_region_t *region, void *arg) {
+	loadsend_t *send = (loadsend_t *)arg;
+	loadgen_t *lg = send->lg;
+
+	if (!lg->finished) {
+		lg->outstanding--;
+		if (eresult == ISC_R_SUCCESS &&
+		    region->length >= DNS_MESSAGE_HEADERLEN)
+		{
+			load_response(lg, region, send->sentat);
+		} else {
+			lg->lost++;
+		}
+	}
+
+	load_dohdetach(send);
+}
+
+static void
+load_dohsenddone(isc_nmhandle_t *handle ISC_ATTR_UNUSED,
+		 isc_result_t eresult ISC_ATTR_UNUSED, void *arg) {
+	load_dohdetach((loadsend_t *)arg);
+}
+
+static void
+load_dohconnected(isc_nmhandle_t *handle, isc_result_t eresult, void *arg) {
+	loadsend_t *send = (loadsend_t *)arg;
+	loadgen_t *lg = send->lg;
+
+	if (eresult != ISC_R_SUCCESS) {
+		if (!lg->finished) {
+			lg->outstanding--;
+			lg->failed++;
+		}
+		load_dohdetach(send);
+		return;
+	}
+
+	isc_nmhandle_attach(handle, &send->handle);
+	send->references += 2;
+	isc_nm_read(handle, load_dohread, send);
+	isc_nm_send(handle, &send->region, load_dohsenddone, send);
+	load_dohdetach(send);
+}
+#endif /* HAVE_LIBNGHTTP2 */
+
+static void
+load_send(loadgen_t *lg, isc_nanosecs_t when) {
+	loadconn_t *conn = NULL;
+	loadsend_t *send = NULL;
+	loadslot_t *slot = NULL;
+
+	lg->sent++;
+
+#if HAVE_LIBNGHTTP2
+	if (load_https) {
+		/*
+		 * Every DoH query gets a connection of its own; TLS session
+		 * resumption keeps the handshakes cheap.
+		 */
+		send = load_newsend(lg, NULL, when);
+		/* RFC 8484 recommends a zero ID to make answers cacheable */
+		send->data[0] = send->data[1] = 0;
+		send->references = 1;
+		lg->outstanding++;
+		isc_nm_httpconnect(netmgr, have_src ? &srcaddr : &bind_any,
+				   &dstaddr, load_uri, true, load_dohconnected,
+				   send, load_tlsctx, load_sesscache,
+				   load_timeout * 1000, ISC_NM_PROXY_NONE,
+				   NULL);
+		return;
+	}
+#endif /* HAVE_LIBNGHTTP2 */
+
+	for (uint32_t i = 0; i < load_sockets && conn == NULL; i++) {
+		loadconn_t *c = &lg->conns[lg->nextconn++ % load_sockets];
+
+		if (c->handle != NULL) {
+			conn = c;
+		}
+	}
+	if (conn == NULL) {
+		lg->failed++;
+		return;
+	}
+
+	send = load_newsend(lg, conn, when);
+	send->id = conn->nextid++;
+	send->data[0] = send->id >> 8;
+	send->data[1] = send->id & 0xff;
+
+	slot = &conn->window[send->id & (load_window - 1)];
+	if (slot->sentat != 0) {
+		/* The window wrapped around before an answer arrived. */
+		lg->outstanding--;
+		lg->lost++;
+	}
+	*slot = (loadslot_t){
+		.sentat = (when - lg->start) / NS_PER_US + 1,
+		.id = send->id,
+	};
+	lg->outstanding++;
+
+	isc_nm_send(conn->handle, &send->region, load_senddone, send);
+}
+
+static void
+load_stop(loadgen_t *lg) {
+	lg->sending = false;
+	lg->finished = true;
+
+	if (lg->timer != NULL) {
+		isc_timer_stop(lg->timer);
+		isc_timer_destroy(&lg->timer);
+	}
+
+	for (size_t i = 0; lg->conns != NULL && i < load_sockets; i++) {
+		loadconn_t *conn = &lg->conns[i];
+
+		if (conn->handle != NULL) {
+			isc_nmhandle_close(conn->handle);
+			isc_nmhandle_detach(&conn->handle);
+		}
+	}
+
+	lg->lost += lg->outstanding;
+	lg->outstanding = 0;
+}
+
+static void
+load_tick(void *arg) {
+	loadgen_t *lg = (loadgen_t *)arg;
+	isc_nanosecs_t now = isc_time_monotonic();
+	unsigned int burst = 0;
+
+	if (lg->sending) {
+		while (lg->next <= now && lg->next < lg->stop &&
+		       burst++ < LOAD_MAXBURST)
+		{
+			load_send(lg, lg->next);
+			lg->next += load_nextinterval(lg);
+		}
+
+		/*
+		 * Queries that fell due while the generator was saturated
+		 * are not sent late; the achieved rate shows the shortfall.
+		 */
+		if (lg->next >= lg->stop || now >= lg->stop) {
+			lg->sending = false;
+			lg->drain = now + (isc_nanosecs_t)load_timeout *
+						  NS_PER_SEC;
+		}
+	}
+
+	if (!lg->sending && (lg->outstanding == 0 || now >= lg->drain)) {
+		load_stop(lg);
+		if (atomic_fetch_sub_release(&load_running, 1) == 1) {
+			isc_loopmgr_shutdown(loopmgr);
+		}
+	}
+}
+
+static void
+load_begin(loadgen_t *lg) {
+	isc_interval_t interval;
+
+	lg->start = isc_time_monotonic();
+	lg->stop = lg->start + (isc_nanosecs_t)load_duration * NS_PER_SEC;
+	/* Stagger the workers so that constant pacing stays even. */
+	lg->next = lg->start +
+		   (isc_nanosecs_t)(lg->interval * lg->tid / load_workers);
+	lg->sending = true;
+
+	isc_interval_set(&interval, 0, NS_PER_MS);
+	isc_timer_create(lg->loop, load_tick, lg, &lg->timer);
+	isc_timer_start(lg->timer, isc_timertype_ticker, &interval);
+}
+
+static void
+load_start(void *arg) {
+	loadgen_t *lg = (loadgen_t *)arg;
+
+	if (load_https) {
+		load_begin(lg);
+		return;
+	}
+
+	lg->connecting = load_sockets;
+	for (size_t i = 0; i < load_sockets; i++) {
+		load_connect(&lg->conns[i]);
+	}
+}
+
+static void
+load_teardown(void *arg) {
+	loadgen_t *lg = (loadgen_t *)arg;
+
+	/* Interrupted before the run completed. */
+	if (!lg->finished) {
+		load_stop(lg);
+	}
+}
+
+static void
+load_prepare(void) {
+	struct query *query = NULL;
+	isc_result_t result;
+
+	for (query = ISC_LIST_HEAD(queries); query != NULL;
+	     query = ISC_LIST_NEXT(query, link))
+	{
+		load_addquery(query);
+	}
+	if (load_replay != NULL) {
+		load_readreplay(load_replay);
+	}
+	if (ntemplates == 0) {
+		fatal("no queries to send");
+	}
+
+	load_timeout = default_query.timeout;
+	if (load_timeout == 0) {
+		load_timeout = (tcp_mode || load_tls || load_https)
+				       ? TCPTIMEOUT
+				       : UDPTIMEOUT;
+	}
+
+	/*
+	 * Size the in-flight window of each socket for twice the queries
+	 * it sends within the timeout; anything older than that is lost
+	 * anyway.  This keeps the memory proportional to the load rather
+	 * than to the number of sockets times the query ID space.
+	 */
+	if (!load_https) {
+		uint64_t inflight = (uint64_t)load_rate * load_timeout * 2 /
+				    ((uint64_t)load_workers * load_sockets);
+
+		while (load_window < inflight && load_window <= UINT16_MAX) {
+			load_window <<= 1;
+		}
+	}
+
+	if (load_tls || load_https) {
+		result = isc_tlsctx_createclient(&load_tlsctx);
+		CHECK("isc_tlsctx_createclient", result);
+		if (load_https) {
+			isc_tlsctx_enable_http2client_alpn(load_tlsctx);
+		} else {
+			isc_tlsctx_enable_dot_client_alpn(load_tlsctx);
+		}
+		isc_tlsctx_client_session_cache_create(
+			mctx, load_tlsctx,
+			ISC_TLSCTX_CLIENT_SESSION_CACHE_DEFAULT_SIZE,
+			&load_sesscache);
+	}
+
+#if HAVE_LIBNGHTTP2
+	if (load_https) {
+		isc_nm_http_makeuri(true, &dstaddr, NULL, 0, load_httppath,
+				    load_uri, sizeof(load_uri));
+	}
+#endif /* HAVE_LIBNGHTTP2 */
+
+	if (have_ipv4) {
+		isc_sockaddr_any(&bind_any);
+	} else {
+		isc_sockaddr_any6(&bind_any);
+	}
+
+	atomic_init(&load_running, load_workers);
+	loadgens = isc_mem_cget(mctx, load_workers, sizeof(loadgens[0]));
+	for (uint32_t i = 0; i < load_workers; i++) {
+		loadgen_t *lg = &loadgens[i];
+
+		*lg = (loadgen_t){
+			.loop = isc_loop_get(loopmgr, i),
+			.tid = i,
+			.nexttemplate = i,
+			.interval = (double)NS_PER_SEC * load_workers /
+				    load_rate,
+		};
+		isc_histo_create(mctx, LOAD_HISTO_SIGBITS, &lg->latency);
+
+		if (!load_https) {
+			lg->conns = isc_mem_cget(mctx, load_sockets,
+						 sizeof(lg->conns[0]));
+			for (size_t j = 0; j < load_sockets; j++) {
+				loadconn_t *conn = &lg->conns[j];
+
+				conn->lg = lg;
+				conn->nextid = isc_random16();
+				conn->window = isc_mem_cget(
+					mctx, load_window,
+					sizeof(conn->window[0]));
+			}
+		}
+
+		isc_loop_setup(lg->loop, load_start, lg);
+		isc_loop_teardown(lg->loop, load_teardown, lg);
+	}
+}
+
+static void
+load_report(void) {
+	static const double fractions[] = { 1.0, 0.999, 0.99, 0.9, 0.5 };
+	static const char *const labels[] = { "max", "99.9%", "99%", "90%",
+					      "50%" };
+	uint64_t values[ARRAY_SIZE(fractions)];
+	uint64_t sent = 0, received = 0, lost = 0, failed = 0;
+	uint64_t rcodes[16] = { 0 };
+	isc_histo_t *latency = NULL;
+	const char *transport = NULL;
+	bool first = true;
+
+	for (uint32_t i = 0; i < load_workers; i++) {
+		loadgen_t *lg = &loadgens[i];
+
+		sent += lg->sent;
+		received += lg->received;
+		lost += lg->lost;
+		failed += lg->failed;
+		for (size_t r = 0; r < ARRAY_SIZE(rcodes); r++) {
+			rcodes[r] += lg->rcodes[r];
+		}
+		isc_histo_merge(&latency, lg->latency);
+	}
+
+	if (load_https) {
+		transport = "HTTPS";
+	} else if (load_tls) {
+		transport = "TLS";
+	} else if (tcp_mode) {
+		transport = "TCP";
+	} else {
+		transport = "UDP";
+	}
+
+	printf(";; Load: %u queries/sec for %u seconds over %s, %s pacing\n",
+	       load_rate, load_duration, transport,
+	       load_poisson ? "Poisson" : "constant");
+	if (load_https) {
+		printf(";; Workers: %u, one connection per query\n",
+		       load_workers);
+	} else {
+		printf(";; Workers: %u, sockets per worker: %u\n",
+		       load_workers, load_sockets);
+	}
+	printf(";; Queries sent: %" PRIu64 " (%.1f/sec), answered: %" PRIu64
+	       " (%.1f/sec)\n",
+	       sent, (double)sent / load_duration, received,
+	       (double)received / load_duration);
+	printf(";; Queries lost: %" PRIu64 ", failed to send: %" PRIu64 "\n",
+	       lost, failed);
+
+	printf(";; Response codes:");
+	for (size_t r = 0; r < ARRAY_SIZE(rcodes); r++) {
+		if (rcodes[r] != 0) {
+			printf("%s %s %" PRIu64, first ? "" : ",",
+			       rcode_totext(r), rcodes[r]);
+			first = false;
+		}
+	}
+	printf("%s\n", first ? " none" : "");
+
+	if (received != 0 &&
+	    isc_histo_quantiles(latency, ARRAY_SIZE(fractions), fractions,
+				values) == ISC_R_SUCCESS)
+	{
+		printf(";; Latency (usec):");
+		for (size_t i = ARRAY_SIZE(fractions); i-- > 0;) {
+			printf(" %s %" PRIu64 "%s", labels[i], values[i],
+			       i > 0 ? "," : "\n");
+		}
+	}
+
+	isc_histo_destroy(&latency);
+}
+
+static void
+load_cleanup(void) {
+	for (uint32_t i = 0; i < load_workers; i++) {
+		loadgen_t *lg = &loadgens[i];
+
+		isc_histo_destroy(&lg->latency);
+		if (lg->conns != NULL) {
+			for (size_t j = 0; j < load_sockets; j++) {
+				isc_mem_cput(mctx, lg->conns[j].window,
+					     load_window,
+					     sizeof(lg->conns[j].window[0]));
+			}
+			isc_mem_cput(mctx, lg->conns, load_sockets,
+				     sizeof(lg->conns[0]));
+		}
+	}
+	isc_mem_cput(mctx, loadgens, load_workers, sizeof(loadgens[0]));
+
+	for (size_t i = 0; i < ntemplates; i++) {
+		isc_mem_put(mctx, templates[i].base, templates[i].length);
+	}
+	if (templates != NULL) {
+		isc_mem_cput(mctx, templates, templates_size,
+			     sizeof(templates[0]));
+	}
+
+	if (load_sesscache != NULL) {
+		isc_tlsctx_client_session_cache_detach(&load_sesscache);
+	}
+	if (load_tlsctx != NULL) {
+		isc_tlsctx_free(&load_tlsctx);
+	}
+}
+
 static void
 teardown(void *arg ISC_ATTR_UNUSED) {
 	dns_view_detach(&view);
@@ -2129,7 +3135,7 @@ main(int argc, char *argv[]) {
 
 	preparse_args(argc, argv);
 
-	isc_managers_create(&mctx, 1, &loopmgr, &netmgr);
+	isc_managers_create(&mctx, load_workers, &loopmgr, &netmgr);
 	isc_log_create(mctx, &lctx, &lcfg);
 
 	RUNCHECK(dst_lib_init(mctx, NULL));
@@ -2141,6 +3147,22 @@ main(int argc, char *argv[]) {
 		fatal("a server '@xxx' is required");
 	}
 
+	if (load_rate == 0 &&
+	    (load_tls || load_https || load_replay != NULL || load_workers > 1))
+	{
+		fatal("+tls, +https, +replay and +workers require +rate");
+	}
+
+	if (port == 0) {
+		if (load_https) {
+			port = 443;
+		} else if (load_tls) {
+			port = 853;
+		} else {
+			port = PORT;
+		}
+	}
+
 	ns = 0;
 	result = isc_getaddresses(server, port, &dstaddr, 1, &ns);
 	if (result != ISC_R_SUCCESS) {
@@ -2159,10 +3181,14 @@ main(int argc, char *argv[]) {
 		fatal("can't choose between IPv4 and IPv6");
 	}
 
-	query = ISC_LIST_HEAD(queries);
-	isc_loopmgr_setup(loopmgr, setup, NULL);
-	isc_loopmgr_setup(loopmgr, sendqueries, query);
-	isc_loopmgr_teardown(loopmgr, teardown, NULL);
+	if (load_rate > 0) {
+		load_prepare();
+	} else {
+		query = ISC_LIST_HEAD(queries);
+		isc_loopmgr_setup(loopmgr, setup, NULL);
+		isc_loopmgr_setup(loopmgr, sendqueries, query);
+		isc_loopmgr_teardown(loopmgr, teardown, NULL);
+	}
 
 	/*
 	 * Stall to the start of a new second.
@@ -2192,6 +3218,11 @@ main(int argc, char *argv[]) {
 
 	isc_loopmgr_run(loopmgr);
 
+	if (load_rate > 0) {
+		load_report();
+		load_cleanup();
+	}
+
 	dst_lib_destroy();
 
 	isc_log_destroy(&lctx);
@@ -88,16 +88,33 @@ dns_compress_getpermitted(dns_compress_t *cctx) {
 /*
  * Our hash value needs to cover the entire suffix of a name, and we need
  * to calculate it one label at a time. So this function mixes a label into
- * an existing hash. (We don't use isc_hash32() because the djb2 hash is a
- * lot faster, and we limit the impact of collision attacks by restricting
- * the size and occupancy of the hash set.) The accumulator is 32 bits to
- * keep more of the fun mixing that happens in the upper bits.
+ * an existing hash. (We don't use isc_hash32() because a simple
+ * multiplicative hash is a lot faster, and we limit the impact of
+ * collision attacks by restricting the size and occupancy of the hash
+ * set.) The accumulator is 32 bits to keep more of the fun mixing that
+ * happens in the upper bits.
+ *
+ * Long labels are mixed in eight bytes at a time, using the SWAR
+ * tolower, so that signer names and hashed NSEC3 owners in large DNSSEC
+ * responses do not cost one multiply per byte. The tail is mixed in
+ * with djb2, which is also what short labels get.
  */
 static uint16_t
 hash_label(uint16_t init, uint8_t *ptr, bool sensitive) {
 	unsigned int len = ptr[0] + 1;
 	uint32_t hash = init;
 
+	while (len >= 8) {
+		uint64_t octets = isc__ascii_load8(ptr);
+		if (!sensitive) {
+			octets = isc_ascii_tolower8(octets);
+		}
+		hash = (hash + (uint32_t)octets) * 0x9E3779B1;
+		hash = (hash + (uint32_t)(octets >> 32)) * 0x9E3779B1;
+		ptr += 8;
+		len -= 8;
+	}
+
 	if (sensitive) {
 		while (len-- > 0) {
 			hash = hash * 33 + *ptr++;
@@ -236,6 +253,7 @@ insert_label(dns_compress_t *cctx, isc_buffer_t *buffer, const dns_name_t *name,
 			cctx->set[slot].hash = hash;
 			cctx->set[slot].coff = coff;
 			cctx->count++;
+			cctx->maxcoff = ISC_MAX(cctx->maxcoff, coff);
 			return true;
 		}
 		/* he steals from the rich and gives to the poor */
@@ -337,8 +355,21 @@ void
 dns_compress_rollback(dns_compress_t *cctx, unsigned int coff) {
 	REQUIRE(CCTX_VALID(cctx));
 
-	for (unsigned int slot = 0; slot <= cctx->mask; slot++) {
-		if (cctx->set[slot].coff < coff) {
+	/*
+	 * Rolling back is a scan of the whole hash set, which is
+	 * expensive for large sets, so skip it when no entry can be
+	 * affected. That is the common case when rendering a large
+	 * message fails on an RR that did not add any new names.
+	 */
+	if (cctx->count == 0 || coff > cctx->maxcoff) {
+		return;
+	}
+	cctx->maxcoff = coff > 0 ? coff - 1 : 0;
+
+	unsigned int slot = 0;
+	while (slot <= cctx->mask) {
+		if (cctx->set[slot].coff == 0 || cctx->set[slot].coff < coff) {
+			slot++;
 			continue;
 		}
 		/*
@@ -360,5 +391,9 @@ dns_compress_rollback(dns_compress_t *cctx, unsigned int coff) {
 		cctx->set[prev].coff = 0;
 		cctx->set[prev].hash = 0;
 		cctx->count--;
+		/*
+		 * Do not advance: the element that slid into this slot
+		 * may need to be deleted too.
+		 */
 	}
 }
@@ -20,6 +20,7 @@
 #include <inttypes.h>
 #include <stdbool.h>
 
+#include <isc/atomic.h>
 #include <isc/buffer.h>
 #include <isc/hash.h>
 #include <isc/mem.h>
@@ -71,6 +72,7 @@ unsigned int dns_pps = 0U;
 static ISC_LIST(dns_dbimplementation_t) implementations;
 static isc_rwlock_t implock;
 static isc_once_t once = ISC_ONCE_INIT;
+static atomic_uint_fast64_t instances = 0;
 
 static dns_dbimplementation_t rbtimp;
 static dns_dbimplementation_t qpimp;
@@ -149,6 +151,11 @@ dns_db_create(isc_mem_t *mctx, const char *db_type, const dns_name_t *origin,
 					    argv, impinfo->driverarg, dbp));
 		RWUNLOCK(&implock, isc_rwlocktype_read);
 
+		if (result == ISC_R_SUCCESS) {
+			(*dbp)->instance =
+				atomic_fetch_add_relaxed(&instances, 1) + 1;
+		}
+
 #if DNS_DB_TRACE
 		fprintf(stderr, "dns_db_create:%s:%s:%d:%p->references = 1\n",
 			__func__, __FILE__, __LINE__ + 1, *dbp);
@@ -190,6 +197,13 @@ dns_db_iscache(dns_db_t *db) {
 	return (false);
 }
 
+uint64_t
+dns_db_instance(dns_db_t *db) {
+	REQUIRE(DNS_DB_VALID(db));
+
+	return (db->instance);
+}
+
 bool
 dns_db_iszone(dns_db_t *db) {
 	/*
@@ -168,6 +168,12 @@ ISC_REFCOUNT_DECL(dns_dispentry);
 #define QIDS_INIT_SIZE (1 << 4) /* Must be power of 2 */
 #define QIDS_MIN_SIZE  (1 << 4) /* Must be power of 2 */
 
+/*
+ * How long (in milliseconds) an idle TCP connection created with
+ * DNS_DISPATCHOPT_KEEPALIVE is kept open for reuse.
+ */
+#define DISPATCH_TCP_KEEPALIVE 5000
+
 /*
  * Statics.
  */
@@ -794,6 +800,17 @@ tcp_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
 	 */
 	switch (result) {
 	case ISC_R_TIMEDOUT:
+		if (ISC_LIST_EMPTY(disp->active) &&
+		    (disp->options & DNS_DISPATCHOPT_KEEPALIVE) != 0)
+		{
+			/*
+			 * The idle connection was not reused in time;
+			 * shut it down.
+			 */
+			result = ISC_R_CANCELED;
+			break;
+		}
+
 		/*
 		 * Time out the oldest response in the active queue.
 		 */
@@ -1242,8 +1259,13 @@ dns_dispatch_gettcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *destaddr,
 			/* A dispatch in indeterminate state, skip it */
 			break;
 		case DNS_DISPATCHSTATE_CONNECTED:
-			if (ISC_LIST_EMPTY(disp->active)) {
-				/* Ignore dispatch with no responses */
+			if (ISC_LIST_EMPTY(disp->active) &&
+			    (disp->options & DNS_DISPATCHOPT_KEEPALIVE) == 0)
+			{
+				/*
+				 * Ignore dispatch with no responses,
+				 * unless it is being kept alive.
+				 */
 				break;
 			}
 			/* We found a connected dispatch */
@@ -1650,40 +1672,30 @@ tcp_dispentry_cancel(dns_dispentry_t *resp, isc_result_t result) {
 		if (ISC_LIST_EMPTY(disp->active)) {
 			INSIST(disp->handle != NULL);
 
-#if DISPATCH_TCP_KEEPALIVE
-			/*
-			 * This is an experimental code that keeps the TCP
-			 * connection open for 1 second before it is finally
-			 * closed.  By keeping the TCP connection open, it can
-			 * be reused by dns_request that uses
-			 * dns_dispatch_gettcp() to join existing TCP
-			 * connections.
-			 *
-			 * It is disabled for now, because it changes the
-			 * behaviour, but I am keeping the code here for future
-			 * reference when we improve the dns_dispatch to reuse
-			 * the TCP connections also in the resolver.
-			 *
-			 * The TCP connection reuse should be seamless and not
-			 * require any extra handling on the client side though.
-			 */
-			isc_nmhandle_cleartimeout(disp->handle);
-			isc_nmhandle_settimeout(disp->handle, 1000);
-
-			if (!disp->reading) {
-				dispentry_log(resp, ISC_LOG_DEBUG(90),
-					      "final 1 second timeout on %p",
-					      disp->handle);
-				tcp_startrecv(disp, NULL);
-			}
-#else
-			if (disp->reading) {
+			if ((disp->options & DNS_DISPATCHOPT_KEEPALIVE) != 0) {
+				/*
+				 * Keep the idle TCP connection open for a
+				 * while, so that it can be reused by a
+				 * dns_request that uses dns_dispatch_gettcp()
+				 * to join existing TCP connections.  The
+				 * read holds a reference to the dispatch.
+				 */
+				isc_nmhandle_cleartimeout(disp->handle);
+				isc_nmhandle_settimeout(disp->handle,
+							DISPATCH_TCP_KEEPALIVE);
+
+				if (!disp->reading) {
+					dispentry_log(resp, ISC_LOG_DEBUG(90),
+						      "idle timeout on %p",
+						      disp->handle);
+					tcp_startrecv(disp, NULL);
+				}
+			} else if (disp->reading) {
 				dispentry_log(resp, ISC_LOG_DEBUG(90),
 					      "canceling read on %p",
 					      disp->handle);
 				isc_nm_cancelread(disp->handle);
 			}
-#endif
 		}
 		break;
 
@@ -2005,6 +2017,10 @@ tcp_dispatch_connect(dns_dispatch_t *disp, dns_dispentry_t *resp) {
 		if (!disp->reading) {
 			/* Restart the reading */
 			tcp_startrecv(disp, resp);
+		} else if (ISC_LIST_HEAD(disp->active) == resp) {
+			/* Reusing an idle connection; replace its timeout */
+			isc_nmhandle_cleartimeout(disp->handle);
+			isc_nmhandle_settimeout(disp->handle, resp->timeout);
 		}
 
 		/* Already connected; call the connected cb asynchronously */
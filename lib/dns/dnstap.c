@@ -57,6 +57,7 @@
 #include <isc/async.h>
 #include <isc/buffer.h>
 #include <isc/file.h>
+#include <isc/hash.h>
 #include <isc/log.h>
 #include <isc/mem.h>
 #include <isc/mutex.h>
@@ -82,8 +83,7 @@
 #define DTENV_MAGIC	 ISC_MAGIC('D', 't', 'n', 'v')
 #define VALID_DTENV(env) ISC_MAGIC_VALID(env, DTENV_MAGIC)
 
-#define DNSTAP_CONTENT_TYPE	"protobuf:dnstap.Dnstap"
-#define DNSTAP_INITIAL_BUF_SIZE 256
+#define DNSTAP_CONTENT_TYPE "protobuf:dnstap.Dnstap"
 
 struct dns_dtmsg {
 	void *buf;
@@ -119,6 +119,10 @@ struct dns_dtenv {
 	int rolls;
 	isc_log_rollsuffix_t suffix;
 	isc_stats_t *stats;
+
+	atomic_uint_fast32_t sample_rate;
+	atomic_uint_fast32_t sample_mode;
+	atomic_uint_fast32_t size_checked; /* seconds */
 };
 
 #define CHECK(x)                             \
@@ -135,6 +139,8 @@ typedef struct ioq {
 
 static thread_local dt__ioq_t dt_ioq = { 0 };
 
+static thread_local uint32_t dt_sample_count = 0;
+
 static atomic_uint_fast32_t global_generation;
 
 isc_result_t
@@ -422,6 +428,14 @@ dns_dt_setversion(dns_dtenv_t *env, const char *version) {
 	return (toregion(env, &env->version, version));
 }
 
+void
+dns_dt_setsampling(dns_dtenv_t *env, uint32_t rate, dns_dtsample_t mode) {
+	REQUIRE(VALID_DTENV(env));
+
+	atomic_store_relaxed(&env->sample_mode, mode);
+	atomic_store_relaxed(&env->sample_rate, rate);
+}
+
 static void
 set_dt_ioq(unsigned int generation, struct fstrm_iothr_queue *ioq) {
 	dt_ioq.generation = generation;
@@ -519,28 +533,29 @@ dns_dt_detach(dns_dtenv_t **envp) {
 
 static isc_result_t
 pack_dt(const Dnstap__Dnstap *d, void **buf, size_t *sz) {
-	ProtobufCBufferSimple sbuf;
+	size_t len;
+	void *data = NULL;
 
 	REQUIRE(d != NULL);
 	REQUIRE(sz != NULL);
 
-	memset(&sbuf, 0, sizeof(sbuf));
-	sbuf.base.append = protobuf_c_buffer_simple_append;
-	sbuf.len = 0;
-	sbuf.alloced = DNSTAP_INITIAL_BUF_SIZE;
+	/*
+	 * Size the frame up front so that it is encoded into a single
+	 * allocation, rather than growing a buffer while packing.  Every
+	 * frame needs an allocation of its own: fstrm takes ownership of
+	 * it and frees it from its I/O thread once it has been written.
+	 */
+	len = dnstap__dnstap__get_packed_size(d);
 
-	/* Need to use malloc() here because protobuf uses free() */
-	sbuf.data = malloc(sbuf.alloced);
-	if (sbuf.data == NULL) {
+	/* Need to use malloc() here because fstrm uses free() */
+	data = malloc(len);
+	if (data == NULL) {
 		return (ISC_R_NOMEMORY);
 	}
-	sbuf.must_free_data = 1;
 
-	*sz = dnstap__dnstap__pack_to_buffer(d, (ProtobufCBuffer *)&sbuf);
-	if (sbuf.data == NULL) {
-		return (ISC_R_FAILURE);
-	}
-	*buf = sbuf.data;
+	*sz = dnstap__dnstap__pack(d, data);
+	INSIST(*sz == len);
+	*buf = data;
 
 	return (ISC_R_SUCCESS);
 }
@@ -711,14 +726,27 @@ perform_reopen(void *arg) {
  * actual roll happens asynchronously).
  */
 static void
-check_file_size_and_maybe_reopen(dns_dtenv_t *env) {
+check_file_size_and_maybe_reopen(dns_dtenv_t *env, const isc_time_t *now) {
 	struct stat statbuf;
+	uint32_t seconds = isc_time_seconds(now);
+	uint_fast32_t checked = atomic_load_relaxed(&env->size_checked);
 
 	/* If a loopmgr wasn't specified, abort. */
 	if (env->loop == NULL) {
 		return;
 	}
 
+	/*
+	 * Calling stat() for every message is expensive, so only check
+	 * the size of the output file once per second.
+	 */
+	if (checked == seconds ||
+	    !atomic_compare_exchange_strong_relaxed(&env->size_checked,
+						    &checked, seconds))
+	{
+		return;
+	}
+
 	/*
 	 * If an output file roll is not currently queued, check the current
 	 * size of the output file to see whether a roll is needed.  Return if
@@ -742,6 +770,56 @@ unlock_and_return:
 	UNLOCK(&env->reopen_lock);
 }
 
+/*%
+ * Decide whether a message is logged under the configured sampling rate.
+ */
+static bool
+dt_sampled(dns_dtenv_t *env, dns_dtmsgtype_t msgtype, isc_sockaddr_t *qaddr,
+	   isc_sockaddr_t *raddr) {
+	uint32_t rate = atomic_load_relaxed(&env->sample_rate);
+	isc_sockaddr_t *peer = NULL;
+	uint8_t prefix[7];
+	size_t len;
+
+	if (rate <= 1) {
+		return (true);
+	}
+
+	if (atomic_load_relaxed(&env->sample_mode) == dns_dtsample_message) {
+		return (dt_sample_count++ % rate == 0);
+	}
+
+	/*
+	 * The remote peer of resolver and forwarder traffic is the
+	 * server that was queried; for everything else it is the client.
+	 */
+	if ((msgtype & (DNS_DTTYPE_RQ | DNS_DTTYPE_RR | DNS_DTTYPE_FQ |
+			DNS_DTTYPE_FR)) != 0)
+	{
+		peer = raddr;
+	} else {
+		peer = qaddr;
+	}
+	if (peer == NULL) {
+		return (dt_sample_count++ % rate == 0);
+	}
+
+	switch (isc_sockaddr_pf(peer)) {
+	case AF_INET:
+		len = 3; /* /24 */
+		memmove(prefix, &peer->type.sin.sin_addr.s_addr, len);
+		break;
+	case AF_INET6:
+		len = 7; /* /56 */
+		memmove(prefix, peer->type.sin6.sin6_addr.s6_addr, len);
+		break;
+	default:
+		return (true);
+	}
+
+	return (isc_hash32(prefix, len, true) % rate == 0);
+}
+
 void
 dns_dt_send(dns_view_t *view, dns_dtmsgtype_t msgtype, isc_sockaddr_t *qaddr,
 	    isc_sockaddr_t *raddr, dns_transport_type_t transport,
@@ -762,13 +840,17 @@ dns_dt_send(dns_view_t *view, dns_dtmsgtype_t msgtype, isc_sockaddr_t *qaddr,
 
 	REQUIRE(VALID_DTENV(view->dtenv));
 
-	if (view->dtenv->max_size != 0) {
-		check_file_size_and_maybe_reopen(view->dtenv);
+	if (!dt_sampled(view->dtenv, msgtype, qaddr, raddr)) {
+		return;
 	}
 
 	now = isc_time_now();
 	t = &now;
 
+	if (view->dtenv->max_size != 0) {
+		check_file_size_and_maybe_reopen(view->dtenv, &now);
+	}
+
 	init_msg(view->dtenv, &dm, dnstap_type(msgtype));
 
 	/* Query/response times */
@@ -94,6 +94,7 @@ struct dns_compress {
 	dns_compress_flags_t flags;
 	uint16_t	     mask;
 	uint16_t	     count;
+	uint16_t	     maxcoff;
 	isc_mem_t	    *mctx;
 	dns_compress_slot_t *set;
 	dns_compress_slot_t  smallset[1 << DNS_COMPRESS_SMALLBITS];
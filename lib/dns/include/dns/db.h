@@ -217,6 +217,7 @@ struct dns_db {
 	isc_mem_t	*mctx;
 	isc_refcount_t	 references;
 	struct cds_lfht *update_listeners;
+	uint64_t	 instance;
 };
 
 enum {
@@ -392,6 +393,23 @@ dns_db_iscache(dns_db_t *db);
  * \li	#false	otherwise
  */
 
+uint64_t
+dns_db_instance(dns_db_t *db);
+/*%<
+ * Return a number that identifies 'db' among all the databases created
+ * with dns_db_create() during the lifetime of the process, even after
+ * 'db' has been freed.  This lets 'db' be recognised without holding a
+ * reference to it.
+ *
+ * Requires:
+ *
+ * \li	'db' is a valid database.
+ *
+ * Returns:
+ * \li	a non-zero number, or 0 if 'db' was not created by
+ *	dns_db_create().
+ */
+
 bool
 dns_db_iszone(dns_db_t *db);
 /*%<
@@ -75,6 +75,7 @@ struct dns_dispatchset {
 typedef enum dns_dispatchopt {
 	DNS_DISPATCHOPT_FIXEDID = 1 << 0,
 	DNS_DISPATCHOPT_UNSHARED = 1 << 1, /* Don't share this connection */
+	DNS_DISPATCHOPT_KEEPALIVE = 1 << 2, /* Keep an idle connection */
 } dns_dispatchopt_t;
 
 isc_result_t
@@ -86,6 +86,14 @@ typedef enum {
 	dns_dtmode_unix
 } dns_dtmode_t;
 
+/*%
+ * Sampling modes for dns_dt_setsampling().
+ */
+typedef enum {
+	dns_dtsample_message = 0,
+	dns_dtsample_client
+} dns_dtsample_t;
+
 typedef struct dns_dthandle dns_dthandle_t;
 
 #ifdef HAVE_DNSTAP
@@ -213,6 +221,23 @@ dns_dt_setversion(dns_dtenv_t *env, const char *version);
  *\li	'env' is a valid dnstap environment.
  */
 
+void
+dns_dt_setsampling(dns_dtenv_t *env, uint32_t rate, dns_dtsample_t mode);
+/*%<
+ * Only log one out of every 'rate' dnstap messages; a rate of 0 or 1
+ * logs every message.
+ *
+ * With 'dns_dtsample_message', every 'rate'-th message sent from each
+ * thread is logged.  With 'dns_dtsample_client', messages are selected
+ * by a hash of the remote address, truncated to a /24 for IPv4 or a /56
+ * for IPv6, so that all traffic to and from a sampled network (queries
+ * together with their responses) is logged.
+ *
+ * Requires:
+ *
+ *\li	'env' is a valid dnstap environment.
+ */
+
 void
 dns_dt_attach(dns_dtenv_t *source, dns_dtenv_t **destp);
 /*%<
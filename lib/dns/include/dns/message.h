@@ -695,6 +695,33 @@ dns_message_rendersection(dns_message_t *msg, dns_section_t section,
  *				   are records remaining for this section.
  */
 
+isc_result_t
+dns_message_renderraw(dns_message_t *msg, dns_section_t section,
+		      const isc_region_t *r, unsigned int count);
+/*%<
+ * Append 'count' records of 'section' that have already been rendered
+ * to wire format in 'r'.  This allows a previously rendered message body
+ * to be replayed with a new header, OPT record and TSIG.
+ *
+ * Compression pointers in 'r' are copied verbatim, so they must refer
+ * to data at the same offsets in the message being rendered; the names
+ * in 'r' are not added to the compression table.
+ *
+ * Requires:
+ *\li	'msg' be valid.
+ *
+ *\li	'section' be a valid section, and no records have been rendered
+ *	to any later section.
+ *
+ *\li	'r' be a valid region.
+ *
+ *\li	dns_message_renderbegin() was called.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS		-- the records were appended.
+ *\li	#ISC_R_NOSPACE		-- Not enough room in the buffer.
+ */
+
 void
 dns_message_renderheader(dns_message_t *msg, isc_buffer_t *target);
 /*%<
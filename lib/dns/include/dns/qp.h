@@ -310,6 +310,10 @@ typedef struct dns_qp_memusage {
 	size_t chunk_count; /*%< allocated chunks */
 	size_t bytes;	    /*%< total memory in chunks and metadata */
 	bool   fragmented;  /*%< trie needs compaction */
+	bool   hugepages;   /*%< chunks come from the huge page pool */
+	size_t pool_bytes;  /*%< huge page pool size, for all tries */
+	size_t pool_resvd;  /*%< of which explicitly reserved */
+	size_t pool_free;   /*%< unused bytes in the pool */
 } dns_qp_memusage_t;
 
 /*%
@@ -319,6 +323,7 @@ typedef enum dns_qpgc {
 	DNS_QPGC_MAYBE,
 	DNS_QPGC_NOW,
 	DNS_QPGC_ALL,
+	DNS_QPGC_STEP,
 } dns_qpgc_t;
 
 /***********************************************************************
@@ -407,6 +412,13 @@ dns_qp_compact(dns_qp_t *qp, dns_qpgc_t mode);
  *
  * \li	If `mode == DNS_QPGC_ALL`, the entire trie is compacted
  *
+ * \li	If `mode == DNS_QPGC_STEP`, a bounded amount of work is done
+ *	towards cleaning a fragmented trie, carrying on from where the
+ *	previous step stopped; unused chunks are released when a pass
+ *	over the trie is complete. This is intended to be called
+ *	repeatedly, e.g. from a timer, to spread the cost of compaction
+ *	over time.
+ *
  * Requires:
  * \li  `qp` is a pointer to a valid qp-trie
  */
@@ -434,6 +446,21 @@ dns_qp_memusage(dns_qp_t *qp);
  * \li  a `dns_qp_memusage_t` structure described above
  */
 
+void
+dns_qp_hugepages(bool enable);
+/*%<
+ * Set whether qp-tries created after this call allocate their chunks
+ * from a pool of 2MB huge pages. Explicitly reserved huge pages are used
+ * if there are any, otherwise transparent huge pages are requested with
+ * madvise(). Chunks in the pool are shared by all tries; a region whose
+ * chunks are all free is returned to the system, apart from one that is
+ * kept for reuse. The chunks a trie takes from the pool are charged to
+ * its memory context.
+ *
+ * Tries that already exist keep allocating chunks the way they did when
+ * they were created.
+ */
+
 dns_qp_memusage_t
 dns_qpmulti_memusage(dns_qpmulti_t *multi);
 /*%<
@@ -526,6 +553,29 @@ dns_qp_getname(dns_qpreadable_t qpr, const dns_name_t *name, void **pval_r,
  * \li  ISC_R_SUCCESS if the leaf was found
  */
 
+void
+dns_qp_getnames(dns_qpreadable_t qpr, const dns_name_t *const names[],
+		size_t count, isc_result_t results[], void *pvals[],
+		uint32_t ivals[]);
+/*%<
+ * Find the leaves in a qp-trie that match each of `count` DNS names
+ *
+ * This is equivalent to calling dns_qp_getname() for each name, but the
+ * searches are interleaved so that their memory accesses overlap, which
+ * is faster when the trie is larger than the CPU cache.
+ *
+ * For each name, `results[i]` is set to ISC_R_SUCCESS or ISC_R_NOTFOUND,
+ * as dns_qp_getname() would return. When a leaf is found, its values are
+ * assigned to `pvals[i]` and `ivals[i]` if those arrays are not NULL;
+ * otherwise they are left unchanged.
+ *
+ * Requires:
+ * \li  `qpr` is a pointer to a readable qp-trie
+ * \li  `names` is an array of `count` pointers to valid `dns_name_t`
+ * \li  `results` is an array of `count` elements
+ * \li  `pvals` and `ivals` are NULL or arrays of `count` elements
+ */
+
 isc_result_t
 dns_qp_lookup(dns_qpreadable_t qpr, const dns_name_t *name,
 	      dns_name_t *foundname, dns_qpiter_t *iter, dns_qpchain_t *chain,
@@ -99,6 +99,13 @@ typedef struct dns_rdatasetmethods {
 	void (*getownercase)(const dns_rdataset_t *rdataset, dns_name_t *name);
 	isc_result_t (*addglue)(dns_rdataset_t	*rdataset,
 				dns_dbversion_t *version, dns_message_t *msg);
+	/*
+	 * Optional: append the records after the current one to 'target'
+	 * in wire format, each preceded by 'head'.  See towiresorted().
+	 */
+	isc_result_t (*rawrender)(dns_rdataset_t     *rdataset,
+				  const isc_region_t *head,
+				  isc_buffer_t *target, unsigned int *countp);
 } dns_rdatasetmethods_t;
 
 #define DNS_RDATASET_MAGIC	ISC_MAGIC('D', 'N', 'S', 'R')
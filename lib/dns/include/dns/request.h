@@ -44,10 +44,11 @@
 
 /* Add -DDNS_REQUEST_TRACE=1 to CFLAGS for detailed reference tracing */
 
-#define DNS_REQUESTOPT_TCP     0x00000001U
-#define DNS_REQUESTOPT_CASE    0x00000002U
-#define DNS_REQUESTOPT_FIXEDID 0x00000004U
-#define DNS_REQUESTOPT_LARGE   0x00000008U
+#define DNS_REQUESTOPT_TCP	 0x00000001U
+#define DNS_REQUESTOPT_CASE	 0x00000002U
+#define DNS_REQUESTOPT_FIXEDID	 0x00000004U
+#define DNS_REQUESTOPT_LARGE	 0x00000008U
+#define DNS_REQUESTOPT_KEEPALIVE 0x00000010U
 
 ISC_LANG_BEGINDECLS
 
@@ -136,6 +137,11 @@ dns_request_create(dns_requestmgr_t *requestmgr, dns_message_t *message,
  *\li	If the #DNS_REQUESTOPT_LARGE option is set, use a large
  *	compression context to accommodate more names.
  *
+ *\li	If the #DNS_REQUESTOPT_KEEPALIVE option is set and a new TCP
+ *	connection has to be opened, it is kept open for a few seconds
+ *	after its last response, so that later TCP requests to the same
+ *	server from the same loop can reuse it.
+ *
  *\li	When the request completes, successfully, due to a timeout, or
  *	because it was canceled, a completion callback will run on 'loop'.
  *
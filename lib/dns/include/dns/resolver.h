@@ -49,6 +49,7 @@
 #include <netinet/in.h>
 #include <stdbool.h>
 
+#include <isc/histo.h>
 #include <isc/lang.h>
 #include <isc/loop.h>
 #include <isc/refcount.h>
@@ -151,6 +152,11 @@ enum {
 #define DNS_RESOLVER_QRYRTTCLASS4    1600
 #define DNS_RESOLVER_QRYRTTCLASS4STR "1600"
 
+/*
+ * Precision of the upstream query RTT histogram, in microseconds.
+ */
+#define DNS_RESOLVER_RTTHISTO_SIGBITS 4
+
 /*
  * XXXRTH  Should this API be made semi-private?  (I.e.
  * _dns_resolver_create()).
@@ -667,6 +673,17 @@ dns_resolver_getstats(dns_resolver_t *res, isc_stats_t **statsp);
  *\li	'statsp' != NULL && '*statsp' != NULL
  */
 
+isc_histomulti_t *
+dns_resolver_getrttstats(dns_resolver_t *res);
+/*%<
+ * Get the histogram of upstream query round trip times, in
+ * microseconds, measured by 'res'.  The histogram is owned by the
+ * resolver and is only valid as long as 'res' is.
+ *
+ * Requires:
+ * \li	'res' is valid.
+ */
+
 void
 dns_resolver_incstats(dns_resolver_t *res, isc_statscounter_t counter);
 /*%<
@@ -102,8 +102,13 @@ enum {
 	dns_zonestatscounter_ixfrreqv6 = 10,
 	dns_zonestatscounter_xfrsuccess = 11,
 	dns_zonestatscounter_xfrfail = 12,
+	dns_zonestatscounter_catzqueued = 13,
+	dns_zonestatscounter_catzadded = 14,
+	dns_zonestatscounter_catzmodified = 15,
+	dns_zonestatscounter_catzdeleted = 16,
+	dns_zonestatscounter_catzfailed = 17,
 
-	dns_zonestatscounter_max = 13,
+	dns_zonestatscounter_max = 18,
 
 	/*
 	 * Adb statistics values.
@@ -500,6 +500,22 @@ dns_view_delzone(dns_view_t *view, dns_zone_t *zone);
  *\li	'zone' is a valid zone.
  */
 
+void
+dns_view_beginzonebatch(dns_view_t *view);
+void
+dns_view_endzonebatch(dns_view_t *view);
+/*%<
+ * Group the dns_view_addzone() and dns_view_delzone() calls made by
+ * this thread in between into a single zone table update; see
+ * dns_zt_beginbatch().  Does nothing if the view is shutting down.
+ *
+ * Requires:
+ *
+ *\li	'view' is a valid view.
+ *
+ *\li	The caller is running on a loop thread.
+ */
+
 void
 dns_view_freeze(dns_view_t *view);
 /*%<
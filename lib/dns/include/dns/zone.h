@@ -25,6 +25,7 @@
 
 #include <isc/formatcheck.h>
 #include <isc/lang.h>
+#include <isc/netaddr.h>
 #include <isc/rwlock.h>
 #include <isc/tls.h>
 
@@ -1860,6 +1861,19 @@ dns_zonemgr_setserialqueryrate(dns_zonemgr_t *zmgr, unsigned int value);
  *\li	'zmgr' to be a valid zone manager
  */
 
+void
+dns_zonemgr_setserialquerybatch(dns_zonemgr_t *zmgr, unsigned int value);
+/*%<
+ *	Set the maximum number of SOA queries to the same primary that
+ *	are sent together, over one TCP connection, when the refresh
+ *	rate limiter lets the first of them through.  Zero or one
+ *	disables batching: every SOA query then waits for the rate
+ *	limiter on its own and is sent over UDP.
+ *
+ * Requires:
+ *\li	'zmgr' to be a valid zone manager
+ */
+
 unsigned int
 dns_zonemgr_getnotifyrate(dns_zonemgr_t *zmgr);
 /*%<
@@ -1897,6 +1911,43 @@ dns_zonemgr_getcount(dns_zonemgr_t *zmgr, dns_zonestate_t state);
  *\li	'state' to be a valid DNS_ZONESTATE_ enum.
  */
 
+/*%
+ * Incoming transfer scheduling state of a primary server.
+ */
+typedef struct dns_xfrprimary {
+	isc_netaddr_t addr;	 /*%< the primary's address */
+	unsigned int  running;	 /*%< transfers in progress */
+	unsigned int  limit;	 /*%< current adaptive limit */
+	uint64_t      rate;	 /*%< average throughput, bytes/second */
+	uint64_t      transfers; /*%< completed transfers */
+	uint64_t      failures;	 /*%< transfers that failed */
+	unsigned int  waiting;	 /*%< zones waiting for a transfer */
+	dns_zone_t  **queue;	 /*%< the waiting zones, next first */
+} dns_xfrprimary_t;
+
+typedef isc_result_t (*dns_xfrprimary_cb_t)(const dns_xfrprimary_t *primary,
+					    void		   *arg);
+
+isc_result_t
+dns_zonemgr_xfrprimaries(dns_zonemgr_t *zmgr, dns_xfrprimary_cb_t cb,
+			 void *arg);
+/*%<
+ *	Call 'cb' for each primary server that incoming zone transfers
+ *	have been scheduled from, stopping at the first callback that
+ *	does not return ISC_R_SUCCESS and returning its result.
+ *	'primary->queue' lists the 'primary->waiting' zones queued for
+ *	a transfer from the primary, in the order they will be started;
+ *	it is only valid while 'cb' runs.
+ *
+ *	The zone manager is locked while 'cb' runs, so 'cb' must not
+ *	call back into it (dns_zone_name() and the like may be used on
+ *	the queued zones).
+ *
+ * Requires:
+ *\li	'zmgr' to be a valid zone manager.
+ *\li	'cb' to be non NULL.
+ */
+
 isc_result_t
 dns_zone_getxfr(dns_zone_t *zone, dns_xfrin_t **xfrp, bool *is_firstrefresh,
 		bool *is_running, bool *is_deferred, bool *is_presoa,
@@ -2323,6 +2374,26 @@ dns_zone_getautomatic(dns_zone_t *zone);
  * \li	'zone' to be valid.
  */
 
+void
+dns_zone_setconfigdigest(dns_zone_t *zone, uint64_t digest);
+/*%
+ * Records a digest of the configuration that was used to configure
+ * the zone, so that reconfiguration can skip zones whose configuration
+ * has not changed. Zero means that the configuration is unknown.
+ *
+ * Requires:
+ * \li	'zone' to be valid.
+ */
+
+uint64_t
+dns_zone_getconfigdigest(dns_zone_t *zone);
+/*%
+ * Returns the digest set by dns_zone_setconfigdigest(), or zero.
+ *
+ * Requires:
+ * \li	'zone' to be valid.
+ */
+
 isc_result_t
 dns_zone_dlzpostload(dns_zone_t *zone, dns_db_t *db);
 /*%
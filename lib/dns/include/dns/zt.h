@@ -54,6 +54,32 @@ dns_zt_compact(dns_zt_t *zt);
  * \li	'zt' to be valid
  */
 
+void
+dns_zt_beginbatch(dns_zt_t *zt);
+void
+dns_zt_endbatch(dns_zt_t *zt);
+/*%<
+ * Open and close a batch of zone table changes.
+ *
+ * Between dns_zt_beginbatch() and dns_zt_endbatch(), dns_zt_mount()
+ * and dns_zt_unmount() called from the same thread add to a single
+ * qp-trie write transaction instead of committing one transaction
+ * per zone, which makes adding or removing a large number of zones
+ * much cheaper. dns_zt_find(), dns_zt_apply() and dns_zt_compact()
+ * called from that thread see the uncommitted changes; other
+ * threads see the zone table as it was when the batch was opened
+ * until dns_zt_endbatch() commits it.
+ *
+ * Other writers are blocked while a batch is open, so a batch should
+ * be short-lived and must be closed by the thread that opened it.
+ *
+ * Requires:
+ * \li	'zt' to be valid
+ * \li	dns_zt_beginbatch(): called from a loop thread, and no batch is
+ *	open on 'zt' in this thread
+ * \li	dns_zt_endbatch(): a batch was opened on 'zt' by this thread
+ */
+
 isc_result_t
 dns_zt_mount(dns_zt_t *zt, dns_zone_t *zone);
 /*%<
@@ -2106,31 +2106,21 @@ dns_journal_current_rr(dns_journal_t *j, dns_name_t **name, uint32_t *ttl,
  */
 
 /*
- * Construct a diff containing all the RRs at the current name of the
- * database iterator 'dbit' in database 'db', version 'ver'.
- * Set '*name' to the current name, and append the diff to 'diff'.
+ * Construct a diff containing all the RRs at node 'node', named 'name',
+ * in database 'db', version 'ver', and append it to 'diff'.
  * All new tuples will have the operation 'op'.
- *
- * Requires: 'name' must have buffer large enough to hold the name.
- * Typically, a dns_fixedname_t would be used.
  */
 static isc_result_t
 get_name_diff(dns_db_t *db, dns_dbversion_t *ver, isc_stdtime_t now,
-	      dns_dbiterator_t *dbit, dns_name_t *name, dns_diffop_t op,
+	      dns_dbnode_t *node, dns_name_t *name, dns_diffop_t op,
 	      dns_diff_t *diff) {
 	isc_result_t result;
-	dns_dbnode_t *node = NULL;
 	dns_rdatasetiter_t *rdsiter = NULL;
 	dns_difftuple_t *tuple = NULL;
 
-	result = dns_dbiterator_current(dbit, &node, name);
-	if (result != ISC_R_SUCCESS) {
-		return (result);
-	}
-
 	result = dns_db_allrdatasets(db, node, ver, 0, now, &rdsiter);
 	if (result != ISC_R_SUCCESS) {
-		goto cleanup_node;
+		return (result);
 	}
 
 	for (result = dns_rdatasetiter_first(rdsiter); result == ISC_R_SUCCESS;
@@ -2170,12 +2160,103 @@ get_name_diff(dns_db_t *db, dns_dbversion_t *ver, isc_stdtime_t now,
 cleanup_iterator:
 	dns_rdatasetiter_destroy(&rdsiter);
 
-cleanup_node:
-	dns_db_detachnode(db, &node);
-
 	return (result);
 }
 
+/*
+ * Return true if the rdatasets 'a' and 'b' hold the same RRs with
+ * the same TTL.  The rdata are compared in iteration order, which is
+ * canonical for slab-based databases; a set whose order differs is
+ * reported as different and left to dns_diff_subtract() to resolve.
+ */
+static bool
+rdataset_equal(dns_rdataset_t *a, dns_rdataset_t *b) {
+	isc_result_t ra, rb;
+
+	if (a->ttl != b->ttl ||
+	    dns_rdataset_count(a) != dns_rdataset_count(b))
+	{
+		return (false);
+	}
+
+	for (ra = dns_rdataset_first(a), rb = dns_rdataset_first(b);
+	     ra == ISC_R_SUCCESS && rb == ISC_R_SUCCESS;
+	     ra = dns_rdataset_next(a), rb = dns_rdataset_next(b))
+	{
+		dns_rdata_t rdataa = DNS_RDATA_INIT;
+		dns_rdata_t rdatab = DNS_RDATA_INIT;
+
+		dns_rdataset_current(a, &rdataa);
+		dns_rdataset_current(b, &rdatab);
+		if (dns_rdata_compare(&rdataa, &rdatab) != 0) {
+			return (false);
+		}
+	}
+
+	return (ra == ISC_R_NOMORE && rb == ISC_R_NOMORE);
+}
+
+/*
+ * Return true if 'node[0]' and 'node[1]', which have the same name,
+ * are known to hold identical data, so that the names can be skipped
+ * without building and subtracting per-RR diffs.  A false result only
+ * means the cheap comparison could not prove equality.
+ */
+static bool
+node_equal(dns_db_t *db[2], dns_dbversion_t *ver[2], dns_dbnode_t *node[2]) {
+	isc_result_t result;
+	dns_rdatasetiter_t *rdsiter = NULL;
+	unsigned int count = 0;
+	bool equal = true;
+
+	result = dns_db_allrdatasets(db[0], node[0], ver[0], 0, 0, &rdsiter);
+	if (result != ISC_R_SUCCESS) {
+		return (false);
+	}
+	for (result = dns_rdatasetiter_first(rdsiter);
+	     result == ISC_R_SUCCESS && equal;
+	     result = dns_rdatasetiter_next(rdsiter))
+	{
+		dns_rdataset_t rdataset, other;
+
+		dns_rdataset_init(&rdataset);
+		dns_rdataset_init(&other);
+		dns_rdatasetiter_current(rdsiter, &rdataset);
+		result = dns_db_findrdataset(db[1], node[1], ver[1],
+					     rdataset.type, rdataset.covers, 0,
+					     &other, NULL);
+		equal = (result == ISC_R_SUCCESS &&
+			 rdataset_equal(&rdataset, &other));
+		if (dns_rdataset_isassociated(&other)) {
+			dns_rdataset_disassociate(&other);
+		}
+		dns_rdataset_disassociate(&rdataset);
+		count++;
+	}
+	dns_rdatasetiter_destroy(&rdsiter);
+	if (!equal || result != ISC_R_NOMORE) {
+		return (false);
+	}
+
+	/*
+	 * Every rdataset at node[0] has an identical match at node[1];
+	 * the nodes are equal if node[1] has nothing else.
+	 */
+	result = dns_db_allrdatasets(db[1], node[1], ver[1], 0, 0, &rdsiter);
+	if (result != ISC_R_SUCCESS) {
+		return (false);
+	}
+	for (result = dns_rdatasetiter_first(rdsiter);
+	     result == ISC_R_SUCCESS && count > 0;
+	     result = dns_rdatasetiter_next(rdsiter))
+	{
+		count--;
+	}
+	dns_rdatasetiter_destroy(&rdsiter);
+
+	return (result == ISC_R_NOMORE && count == 0);
+}
+
 /*
  * Comparison function for use by dns_diff_subtract when sorting
  * the diffs to be subtracted.  The sort keys are the rdata type
@@ -2267,8 +2348,9 @@ diff_namespace(dns_db_t *dba, dns_dbversion_t *dbvera, dns_db_t *dbb,
 	dns_db_t *db[2];
 	dns_dbversion_t *ver[2];
 	dns_dbiterator_t *dbit[2] = { NULL, NULL };
-	bool have[2] = { false, false };
+	dns_dbnode_t *node[2] = { NULL, NULL };
 	dns_fixedname_t fixname[2];
+	dns_name_t *name[2];
 	isc_result_t result, itresult[2];
 	dns_diff_t diff[2];
 	int i, t;
@@ -2279,8 +2361,8 @@ diff_namespace(dns_db_t *dba, dns_dbversion_t *dbvera, dns_db_t *dbb,
 	dns_diff_init(resultdiff->mctx, &diff[0]);
 	dns_diff_init(resultdiff->mctx, &diff[1]);
 
-	dns_fixedname_init(&fixname[0]);
-	dns_fixedname_init(&fixname[1]);
+	name[0] = dns_fixedname_initname(&fixname[0]);
+	name[1] = dns_fixedname_initname(&fixname[1]);
 
 	result = dns_db_createiterator(db[0], options, &dbit[0]);
 	if (result != ISC_R_SUCCESS) {
@@ -2296,56 +2378,65 @@ diff_namespace(dns_db_t *dba, dns_dbversion_t *dbvera, dns_db_t *dbb,
 
 	for (;;) {
 		for (i = 0; i < 2; i++) {
-			if (!have[i] && itresult[i] == ISC_R_SUCCESS) {
-				CHECK(get_name_diff(
-					db[i], ver[i], 0, dbit[i],
-					dns_fixedname_name(&fixname[i]),
-					i == 0 ? DNS_DIFFOP_ADD
-					       : DNS_DIFFOP_DEL,
-					&diff[i]));
+			if (node[i] == NULL && itresult[i] == ISC_R_SUCCESS) {
+				CHECK(dns_dbiterator_current(dbit[i], &node[i],
+							     name[i]));
 				itresult[i] = dns_dbiterator_next(dbit[i]);
-				have[i] = true;
 			}
 		}
 
-		if (!have[0] && !have[1]) {
-			INSIST(ISC_LIST_EMPTY(diff[0].tuples));
-			INSIST(ISC_LIST_EMPTY(diff[1].tuples));
+		if (node[0] == NULL && node[1] == NULL) {
 			break;
 		}
 
-		for (i = 0; i < 2; i++) {
-			if (!have[!i]) {
-				ISC_LIST_APPENDLIST(resultdiff->tuples,
-						    diff[i].tuples, link);
-				INSIST(ISC_LIST_EMPTY(diff[i].tuples));
-				have[i] = false;
-				goto next;
-			}
+		if (node[1] == NULL) {
+			t = -1;
+		} else if (node[0] == NULL) {
+			t = 1;
+		} else {
+			t = dns_name_compare(name[0], name[1]);
 		}
 
-		t = dns_name_compare(dns_fixedname_name(&fixname[0]),
-				     dns_fixedname_name(&fixname[1]));
+		/*
+		 * A name present on only one side contributes all of its
+		 * RRs.
+		 */
 		if (t < 0) {
+			CHECK(get_name_diff(db[0], ver[0], 0, node[0], name[0],
+					    DNS_DIFFOP_ADD, &diff[0]));
 			ISC_LIST_APPENDLIST(resultdiff->tuples, diff[0].tuples,
 					    link);
-			INSIST(ISC_LIST_EMPTY(diff[0].tuples));
-			have[0] = false;
+			dns_db_detachnode(db[0], &node[0]);
 			continue;
 		}
 		if (t > 0) {
+			CHECK(get_name_diff(db[1], ver[1], 0, node[1], name[1],
+					    DNS_DIFFOP_DEL, &diff[1]));
 			ISC_LIST_APPENDLIST(resultdiff->tuples, diff[1].tuples,
 					    link);
-			INSIST(ISC_LIST_EMPTY(diff[1].tuples));
-			have[1] = false;
+			dns_db_detachnode(db[1], &node[1]);
 			continue;
 		}
 		INSIST(t == 0);
-		CHECK(dns_diff_subtract(diff, resultdiff));
+
+		/*
+		 * A name present on both sides is skipped outright when
+		 * its nodes are identical, which is the common case when
+		 * only a handful of records changed between the two
+		 * databases; only the names that differ pay for building,
+		 * sorting and subtracting the per-RR diffs.
+		 */
+		if (!node_equal(db, ver, node)) {
+			CHECK(get_name_diff(db[0], ver[0], 0, node[0], name[0],
+					    DNS_DIFFOP_ADD, &diff[0]));
+			CHECK(get_name_diff(db[1], ver[1], 0, node[1], name[1],
+					    DNS_DIFFOP_DEL, &diff[1]));
+			CHECK(dns_diff_subtract(diff, resultdiff));
+		}
 		INSIST(ISC_LIST_EMPTY(diff[0].tuples));
 		INSIST(ISC_LIST_EMPTY(diff[1].tuples));
-		have[0] = have[1] = false;
-	next:;
+		dns_db_detachnode(db[0], &node[0]);
+		dns_db_detachnode(db[1], &node[1]);
 	}
 	if (itresult[0] != ISC_R_NOMORE) {
 		FAIL(itresult[0]);
@@ -2358,6 +2449,11 @@ diff_namespace(dns_db_t *dba, dns_dbversion_t *dbvera, dns_db_t *dbb,
 	INSIST(ISC_LIST_EMPTY(diff[1].tuples));
 
 failure:
+	for (i = 0; i < 2; i++) {
+		if (node[i] != NULL) {
+			dns_db_detachnode(db[i], &node[i]);
+		}
+	}
 	dns_dbiterator_destroy(&dbit[1]);
 
 cleanup_iterator:
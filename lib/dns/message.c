@@ -2238,6 +2238,30 @@ dns_message_rendersection(dns_message_t *msg, dns_section_t sectionid,
 	return (ISC_R_SUCCESS);
 }
 
+isc_result_t
+dns_message_renderraw(dns_message_t *msg, dns_section_t sectionid,
+		      const isc_region_t *r, unsigned int count) {
+	REQUIRE(DNS_MESSAGE_VALID(msg));
+	REQUIRE(msg->buffer != NULL);
+	REQUIRE(VALID_NAMED_SECTION(sectionid));
+	REQUIRE(r != NULL);
+
+	for (dns_section_t i = sectionid + 1; i < DNS_SECTION_MAX; i++) {
+		REQUIRE(msg->counts[i] == 0);
+	}
+
+	if (isc_buffer_availablelength(msg->buffer) <
+	    r->length + msg->reserved)
+	{
+		return (ISC_R_NOSPACE);
+	}
+
+	isc_buffer_putmem(msg->buffer, r->base, r->length);
+	msg->counts[sectionid] += count;
+
+	return (ISC_R_SUCCESS);
+}
+
 void
 dns_message_renderheader(dns_message_t *msg, isc_buffer_t *target) {
 	uint16_t tmp;
@@ -764,6 +764,30 @@ dns_name_fromregion(dns_name_t *name, const isc_region_t *r) {
 	}
 }
 
+/*
+ * Return the length of the run of ordinary characters (anything but '.'
+ * and '\\') at the start of 'text', examining no more than 'max' bytes,
+ * eight at a time. A tail shorter than a word is left for the caller to
+ * handle one character at a time.
+ */
+static unsigned int
+ordinary_run(const char *text, unsigned int max) {
+	unsigned int run = 0;
+
+	while (max - run >= 8) {
+		uint64_t octets = le64toh(
+			isc__ascii_load8((const uint8_t *)text + run));
+		uint64_t special = isc_ascii_match8(octets, '.') |
+				   isc_ascii_match8(octets, '\\');
+		if (special != 0) {
+			return (run + __builtin_ctzll(special) / 8);
+		}
+		run += 8;
+	}
+
+	return (run);
+}
+
 isc_result_t
 dns_name_fromtext(dns_name_t *name, isc_buffer_t *source,
 		  const dns_name_t *origin, unsigned int options,
@@ -775,6 +799,7 @@ dns_name_fromtext(dns_name_t *name, isc_buffer_t *source,
 	unsigned int value = 0, count = 0;
 	unsigned int n1 = 0, n2 = 0;
 	unsigned int tlen, nrem, nused, digits = 0, labels, tused;
+	unsigned int run;
 	bool done;
 	unsigned char *offsets;
 	dns_offsets_t odata;
@@ -900,6 +925,28 @@ dns_name_fromtext(dns_name_t *name, isc_buffer_t *source,
 				*ndata++ = c;
 				nrem--;
 				nused++;
+
+				/*
+				 * Copy the rest of a run of ordinary
+				 * characters in bulk.
+				 */
+				run = ISC_MIN(ISC_MIN(tlen, nrem),
+					      DNS_NAME_LABELLEN - count);
+				run = ordinary_run(tdata, run);
+				if (downcase) {
+					isc_ascii_lowercopy(ndata,
+							    (uint8_t *)tdata,
+							    run);
+				} else {
+					memmove(ndata, tdata, run);
+				}
+				tdata += run;
+				tlen -= run;
+				tused += run;
+				ndata += run;
+				nrem -= run;
+				nused += run;
+				count += run;
 			}
 			break;
 		case ft_initialescape:
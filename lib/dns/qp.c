@@ -20,9 +20,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #if FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
-#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -31,6 +31,7 @@
 #include <isc/magic.h>
 #include <isc/mem.h>
 #include <isc/mutex.h>
+#include <isc/once.h>
 #include <isc/refcount.h>
 #include <isc/result.h>
 #include <isc/rwlock.h>
@@ -359,6 +360,196 @@ qpkey_compare(const dns_qpkey_t key_a, const size_t keylen_a,
 	return (QPKEY_EQUAL);
 }
 
+/***********************************************************************
+ *
+ *  huge page chunk pool
+ */
+
+/*
+ * When enabled by dns_qp_hugepages(), tries get their chunks from a pool
+ * of 2MB regions that are backed by huge pages, either explicitly
+ * reserved ones or transparent huge pages, so that a large trie needs
+ * far fewer TLB entries than when its chunks are scattered across the
+ * heap.
+ *
+ * Chunks are freed from RCU callbacks on any thread, so the pool is
+ * shared by all tries and protected by a mutex. Each region keeps its
+ * own list of free chunks, linked through their first word, in a small
+ * header after its last chunk; regions are aligned, so a chunk finds its
+ * region by masking its address. Regions with free chunks are kept on a
+ * list, with a region that was full put first, so that allocations
+ * tend to fill up busy regions and let the others drain.
+ * When a region becomes entirely free it is returned to the system,
+ * except for one that is kept to avoid mapping and unmapping a region
+ * over and over at the boundary.
+ *
+ * The chunks a trie takes from the pool are charged to its memory
+ * context, so they count towards its usage and its water marks just
+ * like chunks from the heap.
+ */
+#define HUGEPAGE_SIZE	(2 * 1024 * 1024)
+#define HUGEPAGE_CHUNKS (HUGEPAGE_SIZE / QP_CHUNK_BYTES)
+
+typedef struct hugeregion hugeregion_t;
+struct hugeregion {
+	ISC_LINK(hugeregion_t) link;
+	void *free;
+	size_t nfree;
+	bool explicit;
+};
+
+STATIC_ASSERT(HUGEPAGE_SIZE - HUGEPAGE_CHUNKS * QP_CHUNK_BYTES >=
+		      sizeof(hugeregion_t),
+	      "no room for the huge page region header");
+
+static atomic_bool hugepages;
+static isc_once_t hugepool_once = ISC_ONCE_INIT;
+static isc_mutex_t hugepool_lock;
+static ISC_LIST(hugeregion_t) hugepool_list;
+static size_t hugepool_regions = 0;
+static size_t hugepool_explicit = 0;
+static size_t hugepool_free = 0;
+static size_t hugepool_idle = 0;
+
+static void
+hugepool_initialize(void) {
+	isc_mutex_init(&hugepool_lock);
+	ISC_LIST_INIT(hugepool_list);
+}
+
+static hugeregion_t *
+hugepool_header(uint8_t *region) {
+	return ((hugeregion_t *)(region + HUGEPAGE_CHUNKS * QP_CHUNK_BYTES));
+}
+
+static uint8_t *
+hugepool_map(bool *explicitp) {
+	void *ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	ptr = mmap(NULL, HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+		   MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+	if (ptr != MAP_FAILED) {
+		*explicitp = true;
+		return (ptr);
+	}
+#endif /* ifdef MAP_HUGETLB */
+
+	/*
+	 * No huge pages have been reserved, so map twice as much as we
+	 * need and trim it to an aligned region that the kernel can back
+	 * with a transparent huge page.
+	 */
+	ptr = mmap(NULL, 2 * HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+		   MAP_ANON | MAP_PRIVATE, -1, 0);
+	RUNTIME_CHECK(ptr != MAP_FAILED);
+
+	uint8_t *raw = ptr;
+	uintptr_t offset = (uintptr_t)raw & (HUGEPAGE_SIZE - 1);
+	size_t head = offset == 0 ? 0 : HUGEPAGE_SIZE - offset;
+	uint8_t *region = raw + head;
+	if (head > 0) {
+		RUNTIME_CHECK(munmap(raw, head) == 0);
+	}
+	RUNTIME_CHECK(munmap(region + HUGEPAGE_SIZE, HUGEPAGE_SIZE - head) ==
+		      0);
+
+#ifdef MADV_HUGEPAGE
+	(void)madvise(region, HUGEPAGE_SIZE, MADV_HUGEPAGE);
+#endif /* ifdef MADV_HUGEPAGE */
+
+	*explicitp = false;
+	return (region);
+}
+
+static hugeregion_t *
+hugepool_newregion(void) {
+	bool explicit = false;
+	uint8_t *region = hugepool_map(&explicit);
+	hugeregion_t *hr = hugepool_header(region);
+
+	*hr = (hugeregion_t){
+		.link = ISC_LINK_INITIALIZER,
+		.nfree = HUGEPAGE_CHUNKS,
+		.explicit = explicit,
+	};
+	/* backwards, so chunks are handed out in address order */
+	for (size_t i = HUGEPAGE_CHUNKS; i-- > 0;) {
+		void **chunk = (void **)(region + i * QP_CHUNK_BYTES);
+		*chunk = hr->free;
+		hr->free = chunk;
+	}
+
+	hugepool_regions++;
+	hugepool_explicit += explicit ? 1 : 0;
+	hugepool_free += HUGEPAGE_CHUNKS;
+	hugepool_idle++;
+
+	return (hr);
+}
+
+static void *
+hugepool_get(void) {
+	hugeregion_t *hr = NULL;
+	void **chunk = NULL;
+
+	LOCK(&hugepool_lock);
+	hr = ISC_LIST_HEAD(hugepool_list);
+	if (hr == NULL) {
+		hr = hugepool_newregion();
+		ISC_LIST_APPEND(hugepool_list, hr, link);
+	}
+	if (hr->nfree == HUGEPAGE_CHUNKS) {
+		hugepool_idle--;
+	}
+	chunk = hr->free;
+	hr->free = *chunk;
+	hr->nfree--;
+	hugepool_free--;
+	if (hr->nfree == 0) {
+		ISC_LIST_UNLINK(hugepool_list, hr, link);
+	}
+	UNLOCK(&hugepool_lock);
+
+	return (chunk);
+}
+
+static void
+hugepool_put(void *ptr) {
+	void **chunk = ptr;
+	uint8_t *region = (uint8_t *)((uintptr_t)ptr &
+				      ~(uintptr_t)(HUGEPAGE_SIZE - 1));
+	hugeregion_t *hr = hugepool_header(region);
+
+	LOCK(&hugepool_lock);
+	*chunk = hr->free;
+	hr->free = chunk;
+	hr->nfree++;
+	hugepool_free++;
+	if (hr->nfree == 1) {
+		/* it was full, so it is now the fullest one */
+		ISC_LIST_PREPEND(hugepool_list, hr, link);
+	} else if (hr->nfree == HUGEPAGE_CHUNKS) {
+		ISC_LIST_UNLINK(hugepool_list, hr, link);
+		if (hugepool_idle > 0) {
+			hugepool_regions--;
+			hugepool_explicit -= hr->explicit ? 1 : 0;
+			hugepool_free -= HUGEPAGE_CHUNKS;
+			RUNTIME_CHECK(munmap(region, HUGEPAGE_SIZE) == 0);
+		} else {
+			hugepool_idle++;
+			ISC_LIST_APPEND(hugepool_list, hr, link);
+		}
+	}
+	UNLOCK(&hugepool_lock);
+}
+
+void
+dns_qp_hugepages(bool enable) {
+	isc_once_do(&hugepool_once, hugepool_initialize);
+	atomic_store_relaxed(&hugepages, enable);
+}
+
 /***********************************************************************
  *
  *  allocator wrappers
@@ -388,6 +579,9 @@ chunk_get_raw(dns_qp_t *qp) {
 				 MAP_ANON | MAP_PRIVATE, -1, 0);
 		RUNTIME_CHECK(ptr != MAP_FAILED);
 		return (ptr);
+	} else if (qp->hugepages) {
+		isc_mem_charge(qp->mctx, QP_CHUNK_BYTES);
+		return (hugepool_get());
 	} else {
 		return (isc_mem_allocate(qp->mctx, QP_CHUNK_BYTES));
 	}
@@ -397,6 +591,9 @@ static void
 chunk_free_raw(dns_qp_t *qp, void *ptr) {
 	if (qp->write_protect) {
 		RUNTIME_CHECK(munmap(ptr, chunk_size_raw()) == 0);
+	} else if (qp->hugepages) {
+		hugepool_put(ptr);
+		isc_mem_uncharge(qp->mctx, QP_CHUNK_BYTES);
 	} else {
 		isc_mem_free(qp->mctx, ptr);
 	}
@@ -404,7 +601,7 @@ chunk_free_raw(dns_qp_t *qp, void *ptr) {
 
 static void *
 chunk_shrink_raw(dns_qp_t *qp, void *ptr, size_t bytes) {
-	if (qp->write_protect) {
+	if (qp->write_protect || qp->hugepages) {
 		return (ptr);
 	} else {
 		return (isc_mem_reallocate(qp->mctx, ptr, bytes));
@@ -427,10 +624,34 @@ write_protect(dns_qp_t *qp, dns_qpchunk_t chunk) {
 
 #else
 
-#define chunk_get_raw(qp)	isc_mem_allocate(qp->mctx, QP_CHUNK_BYTES)
-#define chunk_free_raw(qp, ptr) isc_mem_free(qp->mctx, ptr)
+static void *
+chunk_get_raw(dns_qp_t *qp) {
+	if (qp->hugepages) {
+		isc_mem_charge(qp->mctx, QP_CHUNK_BYTES);
+		return (hugepool_get());
+	} else {
+		return (isc_mem_allocate(qp->mctx, QP_CHUNK_BYTES));
+	}
+}
+
+static void
+chunk_free_raw(dns_qp_t *qp, void *ptr) {
+	if (qp->hugepages) {
+		hugepool_put(ptr);
+		isc_mem_uncharge(qp->mctx, QP_CHUNK_BYTES);
+	} else {
+		isc_mem_free(qp->mctx, ptr);
+	}
+}
 
-#define chunk_shrink_raw(qp, ptr, size) isc_mem_reallocate(qp->mctx, ptr, size)
+static void *
+chunk_shrink_raw(dns_qp_t *qp, void *ptr, size_t bytes) {
+	if (qp->hugepages) {
+		return (ptr);
+	} else {
+		return (isc_mem_reallocate(qp->mctx, ptr, bytes));
+	}
+}
 
 #define write_protect(qp, chunk)
 
@@ -925,6 +1146,149 @@ compact_recursive(dns_qp_t *qp, dns_qpnode_t *parent) {
 	return (twigs_ref);
 }
 
+/*
+ * Find the first leaf in a subtree.
+ */
+static dns_qpnode_t *
+leftmost_leaf(dns_qp_t *qp, dns_qpnode_t *n) {
+	while (is_branch(n)) {
+		n = branch_twigs(qp, n);
+	}
+	return (n);
+}
+
+/*
+ * Incremental compaction walks the trie in key order like
+ * compact_recursive(), but stops when it has used up its budget,
+ * saving the key of the leftmost leaf in the next subtree it would have
+ * visited. The next step walks down towards that key, skipping subtrees
+ * that sort before it, and carries on from there.
+ *
+ * The trie can be modified between steps, so the cursor might not be
+ * in the trie any more. That does not matter, because the cursor is
+ * only a position in key order. Anything that changes behind the cursor
+ * is left to the next compaction.
+ *
+ * The walk down to the cursor is not charged to the budget, so every
+ * step makes progress.
+ */
+static dns_qpref_t
+compact_step(dns_qp_t *qp, dns_qpnode_t *parent, bool resume,
+	     size_t *budget) {
+	dns_qpweight_t size = branch_twigs_size(parent);
+	dns_qpref_t twigs_ref = branch_twigs_ref(parent);
+	dns_qpchunk_t chunk = ref_chunk(twigs_ref);
+	qp_cursor_t *cursor = qp->cursor;
+	dns_qpweight_t first = 0, resume_pos = size;
+
+	/*
+	 * A real branch has at least two twigs; the fake root has one,
+	 * which always leads towards the cursor.
+	 */
+	if (resume && size == 1) {
+		resume_pos = 0;
+	} else if (resume) {
+		dns_qpkey_t key;
+		size_t len = leaf_qpkey(qp, leftmost_leaf(qp, parent), key);
+		size_t offset = qpkey_compare(cursor->key, cursor->len, key,
+					      len);
+		if (offset < branch_key_offset(parent)) {
+			/*
+			 * the cursor is outside this subtree, which is
+			 * either entirely behind it or entirely ahead
+			 */
+			if (qpkey_bit(cursor->key, cursor->len, offset) >
+			    qpkey_bit(key, len, offset))
+			{
+				return (twigs_ref);
+			}
+		} else {
+			dns_qpshift_t bit = branch_keybit(parent, cursor->key,
+							  cursor->len);
+			first = branch_twig_pos(parent, bit);
+			if (branch_has_twig(parent, bit)) {
+				resume_pos = first;
+			}
+		}
+	}
+
+	if (resume_pos == size) {
+		*budget -= ISC_MIN(*budget, size);
+	}
+
+	if (chunk != qp->bump && chunk_usage(qp, chunk) < QP_MIN_USED) {
+		twigs_ref = evacuate(qp, parent);
+		*budget -= ISC_MIN(*budget, size);
+	}
+	bool immutable = cells_immutable(qp, twigs_ref);
+	for (dns_qpweight_t pos = first; pos < size; pos++) {
+		dns_qpnode_t *child = ref_ptr(qp, twigs_ref) + pos;
+		if (!is_branch(child)) {
+			continue;
+		}
+		if (*budget == 0) {
+			cursor->len = leaf_qpkey(qp, leftmost_leaf(qp, child),
+						 cursor->key);
+			qp->compact_suspended = true;
+			break;
+		}
+		dns_qpref_t old_grandtwigs = branch_twigs_ref(child);
+		dns_qpref_t new_grandtwigs = compact_step(
+			qp, child, pos == resume_pos, budget);
+		if (old_grandtwigs != new_grandtwigs) {
+			if (immutable) {
+				twigs_ref = evacuate(qp, parent);
+				/* the twigs have moved */
+				child = ref_ptr(qp, twigs_ref) + pos;
+				immutable = false;
+			}
+			*child = make_node(branch_index(child),
+					   new_grandtwigs);
+		}
+		if (qp->compact_suspended) {
+			break;
+		}
+	}
+	return (twigs_ref);
+}
+
+/*
+ * Do one step of incremental compaction, and return true if that
+ * finished a pass over the whole trie.
+ */
+static bool
+compact_incremental(dns_qp_t *qp) {
+	bool resume = qp->compact_suspended;
+	size_t budget = QP_COMPACT_BUDGET;
+
+	isc_nanosecs_t start = isc_time_monotonic();
+
+	if (qp->cursor == NULL) {
+		qp->cursor = isc_mem_get(qp->mctx, sizeof(*qp->cursor));
+	}
+
+	if (!resume && qp->usage[qp->bump].free > QP_MAX_FREE) {
+		alloc_reset(qp);
+	}
+
+	qp->compact_suspended = false;
+	if (qp->leaf_count > 0) {
+		qp->root_ref = compact_step(qp, MOVABLE_ROOT(qp), resume,
+					    &budget);
+	}
+
+	isc_nanosecs_t time = isc_time_monotonic() - start;
+	atomic_fetch_add_relaxed(&compact_time, time);
+
+	LOG_STATS("qp compact step" PRItime
+		  "%s leaf %u live %u used %u free %u hold %u",
+		  time, qp->compact_suspended ? "suspended" : "finished",
+		  qp->leaf_count, qp->used_count - qp->free_count,
+		  qp->used_count, qp->free_count, qp->hold_count);
+
+	return (!qp->compact_suspended);
+}
+
 static void
 compact(dns_qp_t *qp) {
 	LOG_STATS("qp compact before leaf %u live %u used %u free %u hold %u",
@@ -941,6 +1305,7 @@ compact(dns_qp_t *qp) {
 		qp->root_ref = compact_recursive(qp, MOVABLE_ROOT(qp));
 	}
 	qp->compact_all = false;
+	qp->compact_suspended = false;
 
 	isc_nanosecs_t time = isc_time_monotonic() - start;
 	atomic_fetch_add_relaxed(&compact_time, time);
@@ -957,6 +1322,14 @@ dns_qp_compact(dns_qp_t *qp, dns_qpgc_t mode) {
 	if (mode == DNS_QPGC_MAYBE && !QP_NEEDGC(qp)) {
 		return;
 	}
+	if (mode == DNS_QPGC_STEP) {
+		if (qp->compact_suspended || QP_NEEDGC(qp)) {
+			if (compact_incremental(qp)) {
+				recycle(qp);
+			}
+		}
+		return;
+	}
 	if (mode == DNS_QPGC_ALL) {
 		alloc_reset(qp);
 		qp->compact_all = true;
@@ -982,14 +1355,21 @@ dns_qp_compact(dns_qp_t *qp, dns_qpgc_t mode) {
  * when garbage collection might be worthwhile. Hence we can trigger
  * collection when garbage passes a threshold.
  *
- * XXXFANF: If we need to avoid latency outliers caused by compaction in
- * write transactions, we can check qp->transaction_mode here.
+ * To avoid latency outliers caused by compaction in write transactions,
+ * each write only does a step of incremental compaction, and chunks are
+ * recycled when a pass over the trie is complete. Update transactions
+ * compact the whole trie when they commit anyway, so they still do it
+ * in one go, as does the recovery path below.
  */
 static inline bool
 squash_twigs(dns_qp_t *qp, dns_qpref_t twigs, dns_qpweight_t size) {
 	bool destroyed = free_twigs(qp, twigs, size);
 	if (destroyed && QP_AUTOGC(qp)) {
-		compact(qp);
+		if (qp->transaction_mode == QP_UPDATE || qp->compact_all) {
+			compact(qp);
+		} else if (!compact_incremental(qp)) {
+			return (destroyed);
+		}
 		recycle(qp);
 		/*
 		 * This shouldn't happen if the garbage collector is
@@ -1045,6 +1425,15 @@ dns_qp_memusage(dns_qp_t *qp) {
 			 qp->chunk_max * sizeof(qp->base->ptr[0]) +
 			 qp->chunk_max * sizeof(qp->usage[0]);
 
+	if (qp->hugepages) {
+		LOCK(&hugepool_lock);
+		memusage.hugepages = true;
+		memusage.pool_bytes = hugepool_regions * HUGEPAGE_SIZE;
+		memusage.pool_resvd = hugepool_explicit * HUGEPAGE_SIZE;
+		memusage.pool_free = hugepool_free * QP_CHUNK_BYTES;
+		UNLOCK(&hugepool_lock);
+	}
+
 	return (memusage);
 }
 
@@ -1293,6 +1682,8 @@ dns_qpmulti_rollback(dns_qpmulti_t *multi, dns_qp_t **qptp) {
 
 	/* reset allocator state */
 	INSIST(multi->rollback != NULL);
+	/* the compaction cursor might have been allocated since */
+	multi->rollback->cursor = qp->cursor;
 	memmove(qp, multi->rollback, sizeof(*qp));
 	isc_mem_free(qp->mctx, multi->rollback);
 	INSIST(multi->rollback == NULL);
@@ -1432,6 +1823,7 @@ dns_qp_create(isc_mem_t *mctx, const dns_qpmethods_t *methods, void *uctx,
 
 	dns_qp_t *qp = isc_mem_get(mctx, sizeof(*qp));
 	QP_INIT(qp, methods, uctx);
+	qp->hugepages = atomic_load_relaxed(&hugepages);
 	isc_mem_attach(mctx, &qp->mctx);
 	alloc_reset(qp);
 	TRACE("");
@@ -1458,6 +1850,7 @@ dns_qpmulti_create(isc_mem_t *mctx, const dns_qpmethods_t *methods, void *uctx,
 	 */
 	dns_qp_t *qp = &multi->writer;
 	QP_INIT(qp, methods, uctx);
+	qp->hugepages = atomic_load_relaxed(&hugepages);
 	isc_mem_attach(mctx, &qp->mctx);
 	qp->transaction_mode = QP_UPDATE;
 	TRACE("");
@@ -1466,6 +1859,9 @@ dns_qpmulti_create(isc_mem_t *mctx, const dns_qpmethods_t *methods, void *uctx,
 
 static void
 destroy_guts(dns_qp_t *qp) {
+	if (qp->cursor != NULL) {
+		isc_mem_put(qp->mctx, qp->cursor, sizeof(*qp->cursor));
+	}
 	if (qp->chunk_max == 0) {
 		return;
 	}
@@ -2016,6 +2412,107 @@ dns_qp_getname(dns_qpreadable_t qpr, const dns_name_t *name, void **pval_r,
 	return (dns_qp_getkey(qpr, key, keylen, pval_r, ival_r));
 }
 
+/*
+ * Look up a batch of names, interleaving their walks down the trie.
+ * Each pass takes one step for every key that is still searching, and
+ * prefetches the next twig vector for that key before moving on to the
+ * next one, so that the cache misses of all the walks overlap instead
+ * of happening one after the other.
+ */
+static void
+getnames_batch(dns_qpreader_t *qp, const dns_name_t *const names[],
+	       size_t count, isc_result_t results[], void *pvals[],
+	       uint32_t ivals[]) {
+	dns_qpkey_t keys[QP_BATCH];
+	size_t keylens[QP_BATCH];
+	dns_qpnode_t *nodes[QP_BATCH];
+	dns_qpnode_t *root = get_root(qp);
+	size_t searching = 0;
+
+	INSIST(count <= QP_BATCH);
+
+	for (size_t i = 0; i < count; i++) {
+		keylens[i] = dns_qpkey_fromname(keys[i], names[i]);
+		results[i] = ISC_R_NOTFOUND;
+		nodes[i] = root;
+	}
+
+	if (root == NULL) {
+		return;
+	}
+
+	if (is_branch(root)) {
+		prefetch_twigs(qp, root);
+		searching = count;
+	}
+
+	while (searching > 0) {
+		for (size_t i = 0; i < count; i++) {
+			dns_qpnode_t *n = nodes[i];
+			dns_qpshift_t bit;
+
+			if (n == NULL || !is_branch(n)) {
+				continue;
+			}
+
+			bit = branch_keybit(n, keys[i], keylens[i]);
+			if (!branch_has_twig(n, bit)) {
+				nodes[i] = NULL;
+				searching--;
+				continue;
+			}
+
+			n = branch_twig_ptr(qp, n, bit);
+			if (is_branch(n)) {
+				prefetch_twigs(qp, n);
+			} else {
+				searching--;
+			}
+			nodes[i] = n;
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		dns_qpkey_t found_key;
+		size_t found_keylen;
+
+		if (nodes[i] == NULL) {
+			continue;
+		}
+
+		found_keylen = leaf_qpkey(qp, nodes[i], found_key);
+		if (qpkey_compare(keys[i], keylens[i], found_key,
+				  found_keylen) != QPKEY_EQUAL)
+		{
+			continue;
+		}
+
+		results[i] = ISC_R_SUCCESS;
+		if (pvals != NULL) {
+			pvals[i] = leaf_pval(nodes[i]);
+		}
+		if (ivals != NULL) {
+			ivals[i] = leaf_ival(nodes[i]);
+		}
+	}
+}
+
+void
+dns_qp_getnames(dns_qpreadable_t qpr, const dns_name_t *const names[],
+		size_t count, isc_result_t results[], void *pvals[],
+		uint32_t ivals[]) {
+	dns_qpreader_t *qp = dns_qpreader(qpr);
+
+	REQUIRE(QP_VALID(qp));
+	REQUIRE(count == 0 || (names != NULL && results != NULL));
+
+	for (size_t i = 0; i < count; i += QP_BATCH) {
+		getnames_batch(qp, names + i, ISC_MIN(count - i, QP_BATCH),
+			       results + i, pvals != NULL ? pvals + i : NULL,
+			       ivals != NULL ? ivals + i : NULL);
+	}
+}
+
 static inline void
 add_link(dns_qpchain_t *chain, dns_qpnode_t *node, size_t offset) {
 	/* prevent duplication */
@@ -183,6 +183,20 @@ STATIC_ASSERT(6 <= QP_CHUNK_LOG && QP_CHUNK_LOG <= 20,
 #define QP_NEEDGC(qp) QP_GC_HEURISTIC(qp, (qp)->free_count)
 #define QP_AUTOGC(qp) QP_GC_HEURISTIC(qp, (qp)->free_count - (qp)->hold_count)
 
+/*
+ * When a write needs garbage collection, it does this many cells' worth
+ * of incremental compaction, so that the cost of compacting a large trie
+ * is spread over many writes instead of landing on one of them.
+ */
+#define QP_COMPACT_BUDGET (QP_CHUNK_SIZE * 4)
+
+/*
+ * dns_qp_getnames() interleaves the lookups of this many keys at a time.
+ * It needs to be large enough to cover memory latency with independent
+ * work, and small enough that the keys and cursors stay in L1 cache.
+ */
+#define QP_BATCH 8
+
 /*
  * The chunk base and usage arrays are resized geometically and start off
  * with two entries.
@@ -410,6 +424,15 @@ struct dns_qpsnap {
 	ISC_LINK(struct dns_qpsnap) link;
 };
 
+/*
+ * Where an incremental compaction will resume: it has finished with the
+ * parts of the trie whose keys sort before this one.
+ */
+typedef struct qp_cursor {
+	size_t len;
+	dns_qpkey_t key;
+} qp_cursor_t;
+
 /*
  * Read-write access to a qp-trie requires extra fields to support the
  * allocator and garbage collector.
@@ -446,6 +469,12 @@ struct dns_qpsnap {
  *    normal compaction failed to clear the QP_MAX_GARBAGE() condition.
  *    (This emergency is a bug even tho we have a rescue mechanism.)
  *
+ *  - When a write outside an update transaction finds that the trie
+ *    needs compaction, it does a bounded amount of work and leaves the
+ *    `compact_suspended` flag set, with the `cursor` recording where the
+ *    next write (or `dns_qp_compact(DNS_QPGC_STEP)`) should carry on.
+ *    Updates still compact the whole trie in one go.
+ *
  *  - When a qp-trie is destroyed while it has pending cleanup work, its
  *    `destroy` flag is set so that it is destroyed by the reclaim worker.
  *    (Because items cannot be removed from the middle of the cleanup list.)
@@ -477,12 +506,18 @@ struct dns_qp {
 	dns_qpcell_t used_count, free_count;
 	/*% free cells that cannot be recovered right now */
 	dns_qpcell_t hold_count;
+	/*% resume point for incremental compaction, allocated on demand */
+	qp_cursor_t *cursor;
 	/*% what kind of transaction was most recently started [MT] */
 	enum { QP_NONE, QP_WRITE, QP_UPDATE } transaction_mode : 2;
 	/*% compact the entire trie [MT] */
 	bool compact_all : 1;
+	/*% an incremental compaction stopped at `cursor` */
+	bool compact_suspended : 1;
 	/*% optionally when compiled with fuzzing support [MT] */
 	bool write_protect : 1;
+	/*% chunks come from the huge page pool (const) */
+	bool hugepages : 1;
 };
 
 /*
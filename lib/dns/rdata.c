@@ -693,6 +693,31 @@ dns_rdata_clone(const dns_rdata_t *src, dns_rdata_t *target) {
 	target->flags = src->flags;
 }
 
+/*%
+ * Wire format length of the fixed size address types, which make up most
+ * of the rdata we parse and render; zero for every other type.  These
+ * take a fast path in dns_rdata_fromwire(), dns_rdata_towire() and
+ * dns_rdata_compare() that skips the per-type dispatch and the generic
+ * buffer bookkeeping.  Anything unusual, such as a malformed length or
+ * a short target buffer, falls through to the generic code so that the
+ * error handling stays in one place.
+ */
+static unsigned int
+fixedlength(dns_rdataclass_t rdclass, dns_rdatatype_t type) {
+	if (rdclass != dns_rdataclass_in) {
+		return (0);
+	}
+
+	switch (type) {
+	case dns_rdatatype_a:
+		return (4);
+	case dns_rdatatype_aaaa:
+		return (16);
+	default:
+		return (0);
+	}
+}
+
 /***
  *** Comparisons
  ***/
@@ -701,6 +726,7 @@ int
 dns_rdata_compare(const dns_rdata_t *rdata1, const dns_rdata_t *rdata2) {
 	int result = 0;
 	bool use_default = false;
+	unsigned int length;
 
 	REQUIRE(rdata1 != NULL);
 	REQUIRE(rdata2 != NULL);
@@ -717,6 +743,14 @@ dns_rdata_compare(const dns_rdata_t *rdata1, const dns_rdata_t *rdata2) {
 		return (rdata1->type < rdata2->type ? -1 : 1);
 	}
 
+	length = fixedlength(rdata1->rdclass, rdata1->type);
+	if (length != 0 && rdata1->length == length &&
+	    rdata2->length == length)
+	{
+		result = memcmp(rdata1->data, rdata2->data, length);
+		return ((result < 0) ? -1 : (result > 0) ? 1 : 0);
+	}
+
 	COMPARESWITCH
 
 	if (use_default) {
@@ -816,12 +850,26 @@ dns_rdata_fromwire(dns_rdata_t *rdata, dns_rdataclass_t rdclass,
 		return (DNS_R_FORMERR);
 	}
 
-	ss = *source;
-	st = *target;
-
 	activelength = isc_buffer_activelength(source);
 	INSIST(activelength < 65536);
 
+	length = fixedlength(rdclass, type);
+	if (length != 0 && activelength == length &&
+	    isc_buffer_availablelength(target) >= length)
+	{
+		region.base = isc_buffer_used(target);
+		region.length = length;
+		isc_buffer_putmem(target, isc_buffer_current(source), length);
+		isc_buffer_forward(source, length);
+		if (rdata != NULL) {
+			dns_rdata_fromregion(rdata, rdclass, type, &region);
+		}
+		return (ISC_R_SUCCESS);
+	}
+
+	ss = *source;
+	st = *target;
+
 	FROMWIRESWITCH
 
 	if (use_default) {
@@ -871,6 +919,7 @@ dns_rdata_towire(dns_rdata_t *rdata, dns_compress_t *cctx,
 	bool use_default = false;
 	isc_region_t tr;
 	isc_buffer_t st;
+	unsigned int length;
 
 	REQUIRE(rdata != NULL);
 	REQUIRE(DNS_RDATA_VALIDFLAGS(rdata));
@@ -883,6 +932,14 @@ dns_rdata_towire(dns_rdata_t *rdata, dns_compress_t *cctx,
 		return (ISC_R_SUCCESS);
 	}
 
+	length = fixedlength(rdata->rdclass, rdata->type);
+	if (length != 0 && rdata->length == length &&
+	    isc_buffer_availablelength(target) >= length)
+	{
+		isc_buffer_putmem(target, rdata->data, length);
+		return (ISC_R_SUCCESS);
+	}
+
 	st = *target;
 
 	TOWIRESWITCH
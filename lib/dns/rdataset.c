@@ -235,6 +235,36 @@ swap_rdata(dns_rdata_t *in, unsigned int a, unsigned int b) {
 	in[b] = rdata;
 }
 
+/*
+ * Return true if rdata of 'rdataset' contains no domain names, so
+ * that its wire format is identical to the stored form and can be
+ * copied into the message without going through dns_rdata_towire().
+ * Types with embedded names are excluded even when those names are
+ * never compressed, because writing them still adds them to the
+ * compression table.
+ */
+static bool
+rawcopy(const dns_rdataset_t *rdataset) {
+	switch (rdataset->type) {
+	case dns_rdatatype_a:
+	case dns_rdatatype_aaaa:
+		/* CH A contains a domain name */
+		return (rdataset->rdclass == dns_rdataclass_in);
+	case dns_rdatatype_txt:
+	case dns_rdatatype_ds:
+	case dns_rdatatype_cds:
+	case dns_rdatatype_dnskey:
+	case dns_rdatatype_cdnskey:
+	case dns_rdatatype_nsec3:
+	case dns_rdatatype_nsec3param:
+	case dns_rdatatype_sshfp:
+	case dns_rdatatype_tlsa:
+		return (true);
+	default:
+		return (false);
+	}
+}
+
 static isc_result_t
 towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 	     dns_compress_t *cctx, isc_buffer_t *target,
@@ -246,7 +276,7 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 	unsigned int i, count = 0, added;
 	isc_buffer_t savedbuffer, rdlen, rrbuffer;
 	unsigned int headlen;
-	bool question = false;
+	bool question = false, copy = false, bulk = false;
 	bool shuffle = false, sort = false;
 	bool want_random, want_cyclic;
 	dns_rdata_t in_fixed[MAX_SHUFFLE];
@@ -378,6 +408,12 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 
 	name->attributes.nocompress |= owner_name->attributes.nocompress;
 
+	if (!question) {
+		copy = rawcopy(rdataset);
+		bulk = copy && !shuffle && !sort &&
+		       rdataset->methods->rawrender != NULL;
+	}
+
 	do {
 		/*
 		 * Copy out the name, type, class, ttl.
@@ -421,9 +457,20 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 				dns_rdata_reset(&rdata);
 				dns_rdataset_current(rdataset, &rdata);
 			}
-			result = dns_rdata_towire(&rdata, cctx, target);
-			if (result != ISC_R_SUCCESS) {
-				goto rollback;
+			if (copy) {
+				if (isc_buffer_availablelength(target) <
+				    rdata.length)
+				{
+					result = ISC_R_NOSPACE;
+					goto rollback;
+				}
+				isc_buffer_putmem(target, rdata.data,
+						  rdata.length);
+			} else {
+				result = dns_rdata_towire(&rdata, cctx, target);
+				if (result != ISC_R_SUCCESS) {
+					goto rollback;
+				}
 			}
 			INSIST((target->used >= rdlen.used + 2) &&
 			       (target->used - rdlen.used - 2 < 65536));
@@ -431,6 +478,34 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 				&rdlen,
 				(uint16_t)(target->used - rdlen.used - 2));
 			added++;
+
+			/*
+			 * From the second record on, the owner name is
+			 * written the same way every time, so all the
+			 * remaining records start with the same bytes as
+			 * this one.  Let the rdataset copy them in bulk.
+			 */
+			if (bulk && added == 2) {
+				isc_region_t head = {
+					.base = (unsigned char *)rrbuffer.base +
+						rrbuffer.used,
+					.length = rdlen.used - 2 -
+						  rrbuffer.used,
+				};
+				unsigned int n = 0;
+
+				result = (rdataset->methods->rawrender)(
+					rdataset, &head, target, &n);
+				added += n;
+				if (result == ISC_R_NOMORE) {
+					break;
+				}
+				if (result == ISC_R_NOSPACE) {
+					rrbuffer = *target;
+					goto rollback;
+				}
+				INSIST(result == ISC_R_NOTIMPLEMENTED);
+			}
 		}
 
 		if (shuffle || sort) {
@@ -126,6 +126,9 @@ static void
 rdataset_setownercase(dns_rdataset_t *rdataset, const dns_name_t *name);
 static void
 rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name);
+static isc_result_t
+rdataset_rawrender(dns_rdataset_t *rdataset, const isc_region_t *head,
+		   isc_buffer_t *target, unsigned int *countp);
 
 /*% Note: the "const void *" are just to make qsort happy.  */
 static int
@@ -1150,6 +1153,7 @@ dns_rdatasetmethods_t dns_rdataslab_rdatasetmethods = {
 	.clearprefetch = rdataset_clearprefetch,
 	.setownercase = rdataset_setownercase,
 	.getownercase = rdataset_getownercase,
+	.rawrender = rdataset_rawrender,
 };
 
 /* Fixed RRSet helper macros */
@@ -1468,3 +1472,54 @@ rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name) {
 unlock:
 	dns_db_unlocknode(header->db, header->node, isc_rwlocktype_read);
 }
+
+/*
+ * Write the records after the current one straight from the slab.  In
+ * DNSSEC order each record is stored as its rdata length followed by
+ * the rdata, which is the wire format of the end of an RR, so after
+ * the fixed 'head' each record takes a single copy.
+ */
+static isc_result_t
+rdataset_rawrender(dns_rdataset_t *rdataset, const isc_region_t *head,
+		   isc_buffer_t *target, unsigned int *countp) {
+	unsigned char *raw = rdataset->slab.iter_pos;
+	unsigned int count = 0;
+	isc_result_t result = ISC_R_NOMORE;
+
+	REQUIRE(raw != NULL);
+	REQUIRE(rdataset->type != dns_rdatatype_rrsig);
+
+	if ((rdataset->attributes & DNS_RDATASETATTR_LOADORDER) != 0) {
+		return (ISC_R_NOTIMPLEMENTED);
+	}
+
+	while (rdataset->slab.iter_count > 0) {
+		unsigned char *next = raw + peek_uint16(raw) +
+				      DNS_RDATASET_ORDER + 2;
+		unsigned int length = peek_uint16(next);
+
+		if (isc_buffer_availablelength(target) <
+		    head->length + 2 + length)
+		{
+			result = ISC_R_NOSPACE;
+			break;
+		}
+
+		isc_buffer_putmem(target, head->base, head->length);
+#if DNS_RDATASET_FIXED
+		isc_buffer_putuint16(target, length);
+		isc_buffer_putmem(target, next + 2 + DNS_RDATASET_ORDER,
+				  length);
+#else  /* if DNS_RDATASET_FIXED */
+		isc_buffer_putmem(target, next, 2 + length);
+#endif /* if DNS_RDATASET_FIXED */
+
+		raw = next;
+		rdataset->slab.iter_pos = raw;
+		rdataset->slab.iter_count--;
+		count++;
+	}
+
+	*countp = count;
+	return (result);
+}
@@ -336,7 +336,7 @@ isblackholed(dns_dispatchmgr_t *dispatchmgr, const isc_sockaddr_t *destaddr) {
 }
 
 static isc_result_t
-tcp_dispatch(bool newtcp, dns_requestmgr_t *requestmgr,
+tcp_dispatch(bool newtcp, bool keepalive, dns_requestmgr_t *requestmgr,
 	     const isc_sockaddr_t *srcaddr, const isc_sockaddr_t *destaddr,
 	     dns_dispatch_t **dispatchp) {
 	isc_result_t result;
@@ -354,8 +354,9 @@ tcp_dispatch(bool newtcp, dns_requestmgr_t *requestmgr,
 		}
 	}
 
-	result = dns_dispatch_createtcp(requestmgr->dispatchmgr, srcaddr,
-					destaddr, 0, dispatchp);
+	result = dns_dispatch_createtcp(
+		requestmgr->dispatchmgr, srcaddr, destaddr,
+		keepalive ? DNS_DISPATCHOPT_KEEPALIVE : 0, dispatchp);
 	return (result);
 }
 
@@ -389,14 +390,15 @@ udp_dispatch(dns_requestmgr_t *requestmgr, const isc_sockaddr_t *srcaddr,
 }
 
 static isc_result_t
-get_dispatch(bool tcp, bool newtcp, dns_requestmgr_t *requestmgr,
-	     const isc_sockaddr_t *srcaddr, const isc_sockaddr_t *destaddr,
-	     dns_dispatch_t **dispatchp) {
+get_dispatch(bool tcp, bool newtcp, unsigned int options,
+	     dns_requestmgr_t *requestmgr, const isc_sockaddr_t *srcaddr,
+	     const isc_sockaddr_t *destaddr, dns_dispatch_t **dispatchp) {
 	isc_result_t result;
 
 	if (tcp) {
-		result = tcp_dispatch(newtcp, requestmgr, srcaddr, destaddr,
-				      dispatchp);
+		result = tcp_dispatch(newtcp,
+				      (options & DNS_REQUESTOPT_KEEPALIVE) != 0,
+				      requestmgr, srcaddr, destaddr, dispatchp);
 	} else {
 		result = udp_dispatch(requestmgr, srcaddr, destaddr, dispatchp);
 	}
@@ -470,8 +472,8 @@ dns_request_createraw(dns_requestmgr_t *requestmgr, isc_buffer_t *msgbuf,
 	}
 
 again:
-	result = get_dispatch(tcp, newtcp, requestmgr, srcaddr, destaddr,
-			      &request->dispatch);
+	result = get_dispatch(tcp, newtcp, options, requestmgr, srcaddr,
+			      destaddr, &request->dispatch);
 	if (result != ISC_R_SUCCESS) {
 		goto cleanup;
 	}
@@ -595,8 +597,8 @@ dns_request_create(dns_requestmgr_t *requestmgr, dns_message_t *message,
 	}
 
 again:
-	result = get_dispatch(tcp, false, requestmgr, srcaddr, destaddr,
-			      &request->dispatch);
+	result = get_dispatch(tcp, false, options, requestmgr, srcaddr,
+			      destaddr, &request->dispatch);
 	if (result != ISC_R_SUCCESS) {
 		goto cleanup;
 	}
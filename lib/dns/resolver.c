@@ -23,6 +23,7 @@
 #include <isc/counter.h>
 #include <isc/hash.h>
 #include <isc/hashmap.h>
+#include <isc/histo.h>
 #include <isc/log.h>
 #include <isc/loop.h>
 #include <isc/mutex.h>
@@ -568,6 +569,7 @@ struct dns_resolver {
 	isc_result_t quotaresp[2];
 	isc_stats_t *stats;
 	dns_stats_t *querystats;
+	isc_histomulti_t *rttstats;
 
 	/* Additions for serve-stale feature. */
 	unsigned int retryinterval; /* in milliseconds */
@@ -1123,6 +1125,8 @@ fctx_cancelquery(resquery_t **queryp, isc_time_t *finish, bool no_response,
 			rttms = rtt / US_PER_MS;
 			factor = DNS_ADB_RTTADJDEFAULT;
 
+			isc_histomulti_inc(fctx->res->rttstats, rtt);
+
 			if (rttms < DNS_RESOLVER_QRYRTTCLASS0) {
 				inc_stats(fctx->res,
 					  dns_resstatscounter_queryrtt0);
@@ -9798,6 +9802,7 @@ dns_resolver__destroy(dns_resolver_t *res) {
 	if (res->stats != NULL) {
 		isc_stats_detach(&res->stats);
 	}
+	isc_histomulti_destroy(&res->rttstats);
 
 	isc_mutex_destroy(&res->primelock);
 	isc_mutex_destroy(&res->lock);
@@ -9945,6 +9950,9 @@ dns_resolver_create(dns_view_t *view, isc_loopmgr_t *loopmgr, isc_nm_t *nm,
 	dns_nametree_create(res->mctx, DNS_NAMETREE_BOOL,
 			    "dnssec-must-be-secure", &res->mustbesecure);
 
+	isc_histomulti_create(res->mctx, DNS_RESOLVER_RTTHISTO_SIGBITS,
+			      &res->rttstats);
+
 	res->namepools = isc_mem_cget(res->mctx, res->nloops,
 				      sizeof(res->namepools[0]));
 	res->rdspools = isc_mem_cget(res->mctx, res->nloops,
@@ -10966,6 +10974,13 @@ dns_resolver_getstats(dns_resolver_t *res, isc_stats_t **statsp) {
 	}
 }
 
+isc_histomulti_t *
+dns_resolver_getrttstats(dns_resolver_t *res) {
+	REQUIRE(VALID_RESOLVER(res));
+
+	return (res->rttstats);
+}
+
 void
 dns_resolver_incstats(dns_resolver_t *res, isc_statscounter_t counter) {
 	REQUIRE(VALID_RESOLVER(res));
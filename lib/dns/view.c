@@ -787,6 +787,30 @@ dns_view_delzone(dns_view_t *view, dns_zone_t *zone) {
 	return (result);
 }
 
+static void
+zonebatch(dns_view_t *view, void (*fn)(dns_zt_t *)) {
+	dns_zt_t *zonetable = NULL;
+
+	REQUIRE(DNS_VIEW_VALID(view));
+
+	rcu_read_lock();
+	zonetable = rcu_dereference(view->zonetable);
+	if (zonetable != NULL) {
+		fn(zonetable);
+	}
+	rcu_read_unlock();
+}
+
+void
+dns_view_beginzonebatch(dns_view_t *view) {
+	zonebatch(view, dns_zt_beginbatch);
+}
+
+void
+dns_view_endzonebatch(dns_view_t *view) {
+	zonebatch(view, dns_zt_endbatch);
+}
+
 isc_result_t
 dns_view_findzone(dns_view_t *view, const dns_name_t *name,
 		  unsigned int options, dns_zone_t **zonep) {
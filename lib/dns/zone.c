@@ -22,6 +22,7 @@
 #include <isc/file.h>
 #include <isc/hash.h>
 #include <isc/hashmap.h>
+#include <isc/heap.h>
 #include <isc/hex.h>
 #include <isc/loop.h>
 #include <isc/md.h>
@@ -166,6 +167,7 @@
 #endif			   /* ifndef DNS_DUMP_DELAY */
 
 typedef struct dns_notify dns_notify_t;
+typedef ISC_LIST(dns_notify_t) dns_notifylist_t;
 typedef struct dns_checkds dns_checkds_t;
 typedef struct dns_stub dns_stub_t;
 typedef struct dns_load dns_load_t;
@@ -180,6 +182,27 @@ typedef struct dns_nsfetch dns_nsfetch_t;
 typedef struct dns_keyfetch dns_keyfetch_t;
 typedef struct dns_asyncload dns_asyncload_t;
 typedef struct dns_include dns_include_t;
+typedef struct zmgr_primary zmgr_primary_t;
+
+/*
+ * The order in which deferred transfers are started.  Zones with no
+ * data at all go first, then zones that can be brought up to date
+ * incrementally, then the ones that need a full transfer; within each
+ * class smaller expected transfers go first, and then the zones
+ * closest to (or furthest past) expiry.
+ *
+ * So that a steady stream of more urgent zones cannot hold back the
+ * others forever, class and size are turned into how long a zone may
+ * wait: 'due' is the time it was queued plus that, and the zones that
+ * are due first go first.  A zone that is expired or about to expire
+ * is due at once, whatever its class and size.
+ */
+typedef struct {
+	uint64_t due; /* seconds */
+	unsigned int class;
+	unsigned int size;
+	isc_time_t deadline;
+} xfrin_prio_t;
 
 #define DNS_ZONE_CHECKLOCK
 #ifdef DNS_ZONE_CHECKLOCK
@@ -271,7 +294,11 @@ struct dns_zone {
 	dns_zonemgr_t *zmgr;
 	ISC_LINK(dns_zone_t) link; /* Used by zmgr. */
 	isc_loop_t *loop;
-	isc_timer_t *timer;
+	/* Maintenance timer, see zonewheel_t. */
+	bool wheeled;
+	bool timerqueued; /* zone_timer() is queued to run */
+	uint64_t wheeltick;
+	ISC_LINK(dns_zone_t) wheellink;
 	isc_refcount_t irefs;
 	dns_name_t origin;
 	char *masterfile;
@@ -300,6 +327,18 @@ struct dns_zone {
 	isc_time_t nsec3chaintime;
 	isc_time_t refreshkeytime;
 	isc_time_t xfrintime;
+	isc_time_t xfrqueued;
+	uint64_t xfrinbytes;
+
+	/*
+	 * Incoming transfer scheduling, locked by the zone manager's
+	 * rwlock: the primary the transfer is queued for or charged to,
+	 * the zone's place in that primary's queue, and its priority
+	 * there.
+	 */
+	zmgr_primary_t *xfrprimary;
+	unsigned int xfrheapidx;
+	xfrin_prio_t xfrprio;
 	uint32_t refreshkeyinterval;
 	uint32_t refreshkeycount;
 	uint32_t refresh;
@@ -436,6 +475,11 @@ struct dns_zone {
 	 */
 	bool automatic;
 
+	/*%
+	 * Digest of the configuration the zone was last configured with
+	 */
+	uint64_t configdigest;
+
 	/*%
 	 * response policy data to be relayed to the database
 	 */
@@ -468,6 +512,14 @@ struct dns_zone {
 	 */
 	bool requestexpire;
 
+	/*%
+	 * Whether the last SOA query went over TCP only because it was
+	 * batched, and whether the next one must go over UDP on its own
+	 * because such a query failed.
+	 */
+	bool soabatchtcp;
+	bool soaudp;
+
 	/*%
 	 * Outstanding forwarded UPDATE requests.
 	 */
@@ -507,8 +559,8 @@ struct dns_zone {
 	} while (0)
 
 #define DNS_ZONE_FLAG(z, f)    ((atomic_load_relaxed(&(z)->flags) & (f)) != 0)
-#define DNS_ZONE_SETFLAG(z, f) atomic_fetch_or(&(z)->flags, (f))
-#define DNS_ZONE_CLRFLAG(z, f) atomic_fetch_and(&(z)->flags, ~(f))
+#define DNS_ZONE_SETFLAG(z, f) zone_setflag((z), (f))
+#define DNS_ZONE_CLRFLAG(z, f) zone_clrflag((z), (f))
 typedef enum {
 	DNS_ZONEFLG_REFRESH = 0x00000001U,     /*%< refresh check in progress */
 	DNS_ZONEFLG_NEEDDUMP = 0x00000002U,    /*%< zone need consolidation */
@@ -592,6 +644,57 @@ struct dns_unreachable {
 	uint32_t count;
 };
 
+/*%
+ * Incoming transfer scheduling state for a primary server.
+ *
+ * The number of transfers from each primary is capped by 'limit',
+ * which moves between 1 and the configured transfers-per-ns: it is
+ * halved when a transfer fails in a way that suggests the primary is
+ * overloaded or unreachable, decreased when a transfer is much slower
+ * than the recent average, and raised by one after 'limit'
+ * consecutive successful transfers.
+ *
+ * Zones waiting for a transfer from the primary are kept in 'waiting',
+ * a heap ordered as described above xfrin_priority().  A primary that
+ * has had neither running nor waiting transfers for XFRIN_PRIMARY_IDLE
+ * seconds is forgotten.
+ */
+struct zmgr_primary {
+	isc_netaddr_t addr;
+	uint32_t running;
+	uint32_t limit;
+	uint32_t max;	    /* configured transfers-per-ns */
+	uint32_t successes; /* since 'limit' last changed */
+	uint64_t rate;	    /* bytes/second, moving average */
+	uint64_t transfers;
+	uint64_t failures;
+	isc_heap_t *waiting;
+	unsigned int nwaiting;
+	isc_stdtime_t idlesince;
+	ISC_LINK(zmgr_primary_t) link;	   /* zmgr->xfrprimaries */
+	ISC_LINK(zmgr_primary_t) waitlink; /* zmgr->xfrwaiting */
+	ISC_LINK(zmgr_primary_t) idlelink; /* zmgr->xfridle */
+};
+
+#define XFRIN_PRIMARY_BITS 4
+#define XFRIN_PRIMARY_IDLE 3600 /*%< 1 hour */
+
+/*
+ * Transfers shorter than this are dominated by latency, so they say
+ * little about the primary's throughput.
+ */
+#define XFRIN_RATE_MINBYTES (64 * 1024)
+
+/*
+ * How long a deferred transfer may wait for each class below the
+ * first and for each doubling of its expected size, and how close to
+ * expiry a zone has to be to go ahead of all of them (see
+ * xfrin_prio_t).
+ */
+#define XFRIN_CLASS_WAIT    600	 /*%< 10 minutes */
+#define XFRIN_SIZE_WAIT	    5	 /*%< 5 seconds */
+#define XFRIN_EXPIRE_MARGIN 3600 /*%< 1 hour */
+
 struct dns_zonemgr {
 	unsigned int magic;
 	isc_mem_t *mctx;
@@ -608,10 +711,40 @@ struct dns_zonemgr {
 	isc_rwlock_t rwlock;
 	isc_rwlock_t urlock;
 
+	/* Locked by notifylock. */
+	isc_mutex_t notifylock;
+	isc_hashmap_t *notifybatches;
+	isc_hashmap_t *notifydests;
+
+	/* Per-primary SOA query batches, locked by soalock. */
+	isc_mutex_t soalock;
+	isc_hashmap_t *soabatches;
+	unsigned int soabatchmax;
+
 	/* Locked by rwlock. */
 	dns_zonelist_t zones;
 	dns_zonelist_t waiting_for_xfrin;
 	dns_zonelist_t xfrin_in_progress;
+	unsigned int waiting_count;
+	unsigned int xfrin_count;
+	ISC_LIST(zmgr_primary_t) xfrprimaries;
+	ISC_LIST(zmgr_primary_t) xfrwaiting; /* with zones waiting */
+	ISC_LIST(zmgr_primary_t) xfridle;    /* oldest first */
+	isc_hashmap_t *xfrprimarymap;
+
+	/*
+	 * Zones not in the _bind view, and the automatic zones among
+	 * them, see zmgr_countzone().
+	 */
+	atomic_uint_fast32_t any_count;
+	atomic_uint_fast32_t automatic_count;
+
+	/* Zones with DNS_ZONEFLG_REFRESH and DNS_ZONEFLG_FIRSTREFRESH */
+	atomic_uint_fast32_t refresh_count;
+	atomic_uint_fast32_t firstrefresh_count;
+
+	/* Per-loop maintenance timers, indexed by zone->tid. */
+	struct zonewheel *wheels;
 
 	/* Configuration data. */
 	uint32_t transfersin;
@@ -632,6 +765,120 @@ struct dns_zonemgr {
 	isc_rwlock_t tlsctx_cache_rwlock;
 };
 
+/*%
+ * Zone maintenance timers.
+ *
+ * Instead of an isc_timer_t per zone, each loop has a hashed timing
+ * wheel: a ring of ZONEWHEEL_SLOTS lists of zones, one per tick of
+ * ZONEWHEEL_TICK. A zone that needs maintenance at a given time is
+ * put on the list for the tick that follows it. While any zone on the
+ * loop is waiting, a ticker timer visits one slot per tick and runs
+ * zone_maintenance() for the zones in it that are due. Zones that are
+ * due more than a revolution later stay put until a later visit, so
+ * the work per tick is proportional to the number of zones in a slot.
+ *
+ * A wheel is only used from its own loop, so it needs no locking.
+ * Maintenance that is already due is run via isc_async_run() as soon
+ * as possible, as before.
+ */
+#define ZONEWHEEL_TICK	(100 * NS_PER_MS)
+#define ZONEWHEEL_SLOTS 4096
+
+typedef struct zonewheel {
+	isc_timer_t *timer;
+	uint64_t tick;		/* last tick that was processed */
+	unsigned int zones;	/* zones that use this wheel */
+	unsigned int scheduled; /* zones that are waiting in a slot */
+	dns_zonelist_t slots[ZONEWHEEL_SLOTS];
+} zonewheel_t;
+
+/*
+ * DNS_ZONE_SETFLAG() and DNS_ZONE_CLRFLAG() keep count of the zones
+ * with flags that dns_zonemgr_getcount() reports. Those flags are only
+ * changed with the zone locked, and dns_zonemgr_managezone() and
+ * dns_zonemgr_releasezone() hold the zone lock too while they add or
+ * remove the zone's contribution, so every change is counted exactly
+ * once.
+ */
+#define ZONE_COUNTED_FLAGS (DNS_ZONEFLG_REFRESH | DNS_ZONEFLG_FIRSTREFRESH)
+
+static void
+zmgr_countflags(dns_zonemgr_t *zmgr, uint64_t flags, bool set) {
+	if ((flags & DNS_ZONEFLG_REFRESH) != 0) {
+		if (set) {
+			atomic_fetch_add_relaxed(&zmgr->refresh_count, 1);
+		} else {
+			atomic_fetch_sub_relaxed(&zmgr->refresh_count, 1);
+		}
+	}
+	if ((flags & DNS_ZONEFLG_FIRSTREFRESH) != 0) {
+		if (set) {
+			atomic_fetch_add_relaxed(&zmgr->firstrefresh_count, 1);
+		} else {
+			atomic_fetch_sub_relaxed(&zmgr->firstrefresh_count, 1);
+		}
+	}
+}
+
+static inline uint64_t
+zone_setflag(dns_zone_t *zone, uint64_t flags) {
+	uint64_t old;
+
+	if ((flags & ZONE_COUNTED_FLAGS) == 0) {
+		return (atomic_fetch_or(&zone->flags, flags));
+	}
+
+	INSIST(LOCKED_ZONE(zone));
+	old = atomic_fetch_or(&zone->flags, flags);
+	if (zone->zmgr != NULL) {
+		zmgr_countflags(zone->zmgr, flags & ~old & ZONE_COUNTED_FLAGS,
+				true);
+	}
+
+	return (old);
+}
+
+static inline uint64_t
+zone_clrflag(dns_zone_t *zone, uint64_t flags) {
+	uint64_t old;
+
+	if ((flags & ZONE_COUNTED_FLAGS) == 0) {
+		return (atomic_fetch_and(&zone->flags, ~flags));
+	}
+
+	INSIST(LOCKED_ZONE(zone));
+	old = atomic_fetch_and(&zone->flags, ~flags);
+	if (zone->zmgr != NULL) {
+		zmgr_countflags(zone->zmgr, flags & old & ZONE_COUNTED_FLAGS,
+				false);
+	}
+
+	return (old);
+}
+
+/*
+ * Add 'zone' to, or remove it from, the counts of dns_zonemgr_getcount()
+ * for DNS_ZONESTATE_ANY and DNS_ZONESTATE_AUTOMATIC.  Requires the zone
+ * lock, which also covers changes of its view and 'automatic' setting.
+ */
+static void
+zmgr_countzone(dns_zonemgr_t *zmgr, dns_zone_t *zone, bool add) {
+	if (zone->view != NULL && strcmp(zone->view->name, "_bind") == 0) {
+		return;
+	}
+	if (add) {
+		atomic_fetch_add_relaxed(&zmgr->any_count, 1);
+		if (zone->automatic) {
+			atomic_fetch_add_relaxed(&zmgr->automatic_count, 1);
+		}
+	} else {
+		atomic_fetch_sub_relaxed(&zmgr->any_count, 1);
+		if (zone->automatic) {
+			atomic_fetch_sub_relaxed(&zmgr->automatic_count, 1);
+		}
+	}
+}
+
 /*%
  * Hold notify state.
  */
@@ -649,14 +896,54 @@ struct dns_notify {
 	dns_transport_t *transport;
 	ISC_LINK(dns_notify_t) link;
 	isc_rlevent_t *rlevent;
+
+	/*
+	 * Notifies to the same destination that are waiting for this one
+	 * to come off the ratelimiter.  Locked by zmgr->notifylock.
+	 */
+	isc_ratelimiter_t *batchrl;
+	dns_notifylist_t batch;
+	ISC_LINK(dns_notify_t) batchlink;
+	unsigned int nbatch;
+	dns_notify_t *leader;
+	bool canceled;
 };
 
+/*%
+ * The notify batch size for one destination, kept only while it
+ * differs from NOTIFY_BATCH_DEFAULT.  Locked by zmgr->notifylock.
+ */
+typedef struct notify_dest {
+	isc_sockaddr_t addr;
+	unsigned int batchsize;
+} notify_dest_t;
+
 typedef enum dns_notify_flags {
 	DNS_NOTIFY_NOSOA = 1 << 0,
 	DNS_NOTIFY_STARTUP = 1 << 1,
 	DNS_NOTIFY_TCP = 1 << 2,
 } dns_notify_flags_t;
 
+/*%
+ * Bounds for the number of notifies to a single destination that are
+ * released by one ratelimiter tick.  The effective limit for each
+ * destination moves between these as its responses arrive: it grows
+ * by one with every answered notify and is halved on every timeout.
+ */
+#define NOTIFY_BATCH_MIN     1
+#define NOTIFY_BATCH_DEFAULT 8
+#define NOTIFY_BATCH_MAX     64
+#define NOTIFY_BATCH_BITS    8
+
+/*%
+ * Default upper bound on the number of SOA queries to a single
+ * primary that are released by one refresh ratelimiter tick, see
+ * dns_zonemgr_setserialquerybatch().  Batched queries are sent over
+ * TCP so that they share one pipelined connection.
+ */
+#define SOAQUERY_BATCH_DEFAULT 256
+#define SOAQUERY_BATCH_BITS    8
+
 /*%
  * Hold checkds state.
  */
@@ -825,6 +1112,8 @@ unsigned int dns_zone_mkey_month = MONTH;
 
 static void
 zone_timer_set(dns_zone_t *zone, isc_time_t *next, isc_time_t *now);
+static void
+zone_timer_destroy(dns_zone_t *zone);
 
 typedef struct zone_settimer {
 	dns_zone_t *zone;
@@ -936,12 +1225,32 @@ static void
 notify_done(void *arg);
 static void
 notify_send_toaddr(void *arg);
+static void
+notify_destroy(dns_notify_t *notify, bool locked);
+static isc_result_t
+notify_send_queue(dns_notify_t *notify, bool startup);
+static void
+notify_batch_requeue(dns_notify_t *notify);
+static bool
+notify_batch_leave(dns_notify_t *notify);
 static isc_result_t
 zone_dump(dns_zone_t *, bool);
 static void
 got_transfer_quota(void *arg);
-static isc_result_t
-zmgr_start_xfrin_ifquota(dns_zonemgr_t *zmgr, dns_zone_t *zone);
+static void
+zmgr_start_xfrin(dns_zonemgr_t *zmgr, dns_zone_t *zone);
+static void
+zmgr_xfrin_enqueue(dns_zonemgr_t *zmgr, dns_zone_t *zone,
+		   const isc_netaddr_t *addr, uint32_t max);
+static void
+zmgr_xfrin_dequeue(dns_zonemgr_t *zmgr, dns_zone_t *zone);
+static bool
+xfrin_precedes(const xfrin_prio_t *a, const xfrin_prio_t *b);
+static void
+zmgr_primary_free(dns_zonemgr_t *zmgr, zmgr_primary_t *primary);
+static void
+zmgr_xfrin_release(dns_zonemgr_t *zmgr, dns_zone_t *zone, isc_result_t result,
+		   uint64_t nbytes, uint64_t usecs);
 static void
 zmgr_resume_xfrs(dns_zonemgr_t *zmgr, bool multi);
 static void
@@ -1142,6 +1451,7 @@ dns_zone_create(dns_zone_t **zonep, isc_mem_t *mctx, unsigned int tid) {
 		.setnsec3param_queue = ISC_LIST_INITIALIZER,
 		.forwards = ISC_LIST_INITIALIZER,
 		.link = ISC_LINK_INITIALIZER,
+		.wheellink = ISC_LINK_INITIALIZER,
 		.statelink = ISC_LINK_INITIALIZER,
 	};
 	dns_remote_t r = {
@@ -1200,7 +1510,7 @@ zone_free(dns_zone_t *zone) {
 
 	REQUIRE(DNS_ZONE_VALID(zone));
 	REQUIRE(!LOCKED_ZONE(zone));
-	REQUIRE(zone->timer == NULL);
+	REQUIRE(!zone->wheeled);
 	REQUIRE(zone->zmgr == NULL);
 
 	isc_refcount_destroy(&zone->references);
@@ -1583,6 +1893,9 @@ dns_zone_setview_helper(dns_zone_t *zone, dns_view_t *view) {
 	}
 
 	INSIST(zone != zone->raw);
+	if (zone->zmgr != NULL) {
+		zmgr_countzone(zone->zmgr, zone, false);
+	}
 	if (zone->view != NULL) {
 		dns_view_sfd_del(zone->view, &zone->origin);
 		dns_view_weakdetach(&zone->view);
@@ -1602,6 +1915,10 @@ dns_zone_setview_helper(dns_zone_t *zone, dns_view_t *view) {
 	zone_viewname_tostr(zone, namebuf, sizeof namebuf);
 	zone->strviewname = isc_mem_strdup(zone->mctx, namebuf);
 
+	if (zone->zmgr != NULL) {
+		zmgr_countzone(zone->zmgr, zone, true);
+	}
+
 	if (inline_secure(zone)) {
 		dns_zone_setview(zone->raw, view);
 	}
@@ -12100,11 +12417,36 @@ requeue:
 			return (true);
 		}
 
+		/*
+		 * The notifies batched behind this one are still startup
+		 * notifies; they go back on the startup ratelimiter.
+		 */
+		notify_batch_requeue(notify);
+
 		notify->flags &= ~DNS_NOTIFY_STARTUP;
-		result = isc_ratelimiter_enqueue(
-			notify->zone->zmgr->notifyrl, notify->zone->loop,
-			notify_send_toaddr, notify, &notify->rlevent);
+		result = notify_send_queue(notify, false);
+		if (result != ISC_R_SUCCESS) {
+			notify_destroy(notify, true);
+			return (false);
+		}
+	} else if (notify->rlevent == NULL &&
+		   (flags & DNS_NOTIFY_STARTUP) == 0 &&
+		   (notify->flags & DNS_NOTIFY_STARTUP) != 0)
+	{
+		/*
+		 * A startup notify batched behind another one leaves
+		 * that batch and is queued on the normal ratelimiter.
+		 * If its leader has already been released, it is on
+		 * its way out and is left alone.
+		 */
+		if (!notify_batch_leave(notify)) {
+			return (true);
+		}
+
+		notify->flags &= ~DNS_NOTIFY_STARTUP;
+		result = notify_send_queue(notify, false);
 		if (result != ISC_R_SUCCESS) {
+			notify_destroy(notify, true);
 			return (false);
 		}
 	}
@@ -12164,6 +12506,9 @@ notify_destroy(dns_notify_t *notify, bool locked) {
 	isc_mem_t *mctx;
 
 	REQUIRE(DNS_NOTIFY_VALID(notify));
+	REQUIRE(notify->batchrl == NULL);
+	REQUIRE(ISC_LIST_EMPTY(notify->batch));
+	REQUIRE(notify->leader == NULL);
 
 	if (notify->zone != NULL) {
 		if (!locked) {
@@ -12218,6 +12563,8 @@ notify_create(isc_mem_t *mctx, unsigned int flags, dns_notify_t **notifyp) {
 	isc_sockaddr_any(&notify->dst);
 	dns_name_init(&notify->ns, NULL);
 	ISC_LINK_INIT(notify, link);
+	ISC_LIST_INIT(notify->batch);
+	ISC_LINK_INIT(notify, batchlink);
 	notify->magic = NOTIFY_MAGIC;
 	*notifyp = notify;
 	return (ISC_R_SUCCESS);
@@ -12300,13 +12647,247 @@ destroy:
 	notify_destroy(notify, false);
 }
 
+static bool
+notify_batch_match(void *node, const void *key) {
+	const dns_notify_t *notify = node;
+
+	return (isc_sockaddr_equal(&notify->dst, key));
+}
+
+/*
+ * Queue 'notify' for sending.  If another notify to the same
+ * destination is already waiting on the same ratelimiter and its batch
+ * is not full, 'notify' rides along with it rather than taking a
+ * ratelimiter slot of its own; this keeps a large fan-out from being
+ * serialised at 'notify-rate' per zone when all the zones share the
+ * same secondaries.
+ */
+static bool
+notify_dest_match(void *node, const void *key) {
+	const notify_dest_t *dest = node;
+
+	return (isc_sockaddr_equal(&dest->addr, key));
+}
+
+/*
+ * Return the current batch size for notifies to 'dst'.
+ * Requires zmgr->notifylock to be held.
+ */
+static unsigned int
+notify_batch_size(dns_zonemgr_t *zmgr, const isc_sockaddr_t *dst) {
+	notify_dest_t *dest = NULL;
+	isc_result_t result;
+
+	result = isc_hashmap_find(zmgr->notifydests,
+				  isc_sockaddr_hash(dst, false),
+				  notify_dest_match, dst, (void **)&dest);
+	if (result != ISC_R_SUCCESS) {
+		return (NOTIFY_BATCH_DEFAULT);
+	}
+	return (dest->batchsize);
+}
+
 static isc_result_t
 notify_send_queue(dns_notify_t *notify, bool startup) {
-	return (isc_ratelimiter_enqueue(
-		startup ? notify->zone->zmgr->startupnotifyrl
-			: notify->zone->zmgr->notifyrl,
-		notify->zone->loop, notify_send_toaddr, notify,
-		&notify->rlevent));
+	dns_zonemgr_t *zmgr = notify->zone->zmgr;
+	isc_ratelimiter_t *rl = startup ? zmgr->startupnotifyrl
+					: zmgr->notifyrl;
+	dns_notify_t *leader = NULL;
+	uint32_t hashval = isc_sockaddr_hash(&notify->dst, false);
+	isc_result_t result;
+
+	REQUIRE(notify->rlevent == NULL);
+	REQUIRE(notify->batchrl == NULL);
+	REQUIRE(notify->leader == NULL);
+
+	LOCK(&zmgr->notifylock);
+	result = isc_hashmap_find(zmgr->notifybatches, hashval,
+				  notify_batch_match, &notify->dst,
+				  (void **)&leader);
+	if (result == ISC_R_SUCCESS && leader->batchrl == rl &&
+	    leader->nbatch + 1 < notify_batch_size(zmgr, &notify->dst))
+	{
+		ISC_LIST_APPEND(leader->batch, notify, batchlink);
+		leader->nbatch++;
+		notify->leader = leader;
+		UNLOCK(&zmgr->notifylock);
+		return (ISC_R_SUCCESS);
+	}
+
+	result = isc_ratelimiter_enqueue(rl, notify->zone->loop,
+					 notify_send_toaddr, notify,
+					 &notify->rlevent);
+	if (result == ISC_R_SUCCESS) {
+		/* The newest notify becomes the leader for this destination. */
+		if (leader != NULL) {
+			(void)isc_hashmap_delete(zmgr->notifybatches, hashval,
+						 notify_batch_match,
+						 &notify->dst);
+		}
+		result = isc_hashmap_add(zmgr->notifybatches, hashval,
+					 notify_batch_match, &notify->dst,
+					 notify, NULL);
+		INSIST(result == ISC_R_SUCCESS);
+		notify->batchrl = rl;
+	}
+	UNLOCK(&zmgr->notifylock);
+
+	return (result);
+}
+
+/*
+ * Stop 'notify' from accepting new followers and move those it has
+ * already collected to 'batch'.
+ */
+static void
+notify_batch_detach(dns_notify_t *notify, dns_notifylist_t *batch) {
+	dns_zonemgr_t *zmgr = notify->zone->zmgr;
+	dns_notify_t *leader = NULL;
+	dns_notify_t *follower = NULL;
+	uint32_t hashval;
+	isc_result_t result;
+
+	LOCK(&zmgr->notifylock);
+	if (notify->batchrl == NULL) {
+		UNLOCK(&zmgr->notifylock);
+		return;
+	}
+	hashval = isc_sockaddr_hash(&notify->dst, false);
+	result = isc_hashmap_find(zmgr->notifybatches, hashval,
+				  notify_batch_match, &notify->dst,
+				  (void **)&leader);
+	if (result == ISC_R_SUCCESS && leader == notify) {
+		result = isc_hashmap_delete(zmgr->notifybatches, hashval,
+					    notify_batch_match, &notify->dst);
+		INSIST(result == ISC_R_SUCCESS);
+	}
+	for (follower = ISC_LIST_HEAD(notify->batch); follower != NULL;
+	     follower = ISC_LIST_NEXT(follower, batchlink))
+	{
+		follower->leader = NULL;
+	}
+	ISC_LIST_MOVE(*batch, notify->batch);
+	notify->nbatch = 0;
+	notify->batchrl = NULL;
+	UNLOCK(&zmgr->notifylock);
+}
+
+/*
+ * Take the follower 'notify' out of its leader's batch.  Returns false
+ * if the leader has already handed it over for sending.
+ */
+static bool
+notify_batch_leave(dns_notify_t *notify) {
+	dns_zonemgr_t *zmgr = notify->zone->zmgr;
+	dns_notify_t *leader = NULL;
+
+	LOCK(&zmgr->notifylock);
+	leader = notify->leader;
+	if (leader == NULL) {
+		UNLOCK(&zmgr->notifylock);
+		return (false);
+	}
+	ISC_LIST_UNLINK(leader->batch, notify, batchlink);
+	INSIST(leader->nbatch > 0);
+	leader->nbatch--;
+	notify->leader = NULL;
+	UNLOCK(&zmgr->notifylock);
+
+	return (true);
+}
+
+/*
+ * Called when 'notify' is taken off the startup ratelimiter before its
+ * time: queue its followers again on the startup ratelimiter, where
+ * they form new batches.  A follower that cannot be queued is sent
+ * from its zone's loop as canceled, which frees it.
+ */
+static void
+notify_batch_requeue(dns_notify_t *notify) {
+	dns_notify_t *follower = NULL;
+	dns_notifylist_t batch = ISC_LIST_INITIALIZER;
+	isc_result_t result;
+
+	notify_batch_detach(notify, &batch);
+
+	while ((follower = ISC_LIST_HEAD(batch)) != NULL) {
+		ISC_LIST_UNLINK(batch, follower, batchlink);
+		result = notify_send_queue(follower, true);
+		if (result != ISC_R_SUCCESS) {
+			follower->canceled = true;
+			isc_async_run(follower->zone->loop, notify_send_toaddr,
+				      follower);
+		}
+	}
+}
+
+/*
+ * Called when 'notify' comes off the ratelimiter: stop accepting new
+ * followers and send those already collected from their own zone's loop.
+ */
+static void
+notify_batch_flush(dns_notify_t *notify, bool canceled) {
+	dns_notify_t *follower = NULL;
+	dns_notifylist_t batch = ISC_LIST_INITIALIZER;
+
+	notify_batch_detach(notify, &batch);
+
+	while ((follower = ISC_LIST_HEAD(batch)) != NULL) {
+		ISC_LIST_UNLINK(batch, follower, batchlink);
+		follower->canceled = canceled;
+		isc_async_run(follower->zone->loop, notify_send_toaddr,
+			      follower);
+	}
+}
+
+/*
+ * Additive increase, multiplicative decrease of the batch size for
+ * 'dst', driven by how that secondary is answering.  A destination
+ * whose batch size is back at the default is forgotten.
+ */
+static void
+notify_batch_adjust(dns_zonemgr_t *zmgr, const isc_sockaddr_t *dst,
+		    bool answered) {
+	notify_dest_t *dest = NULL;
+	uint32_t hashval = isc_sockaddr_hash(dst, false);
+	unsigned int size = NOTIFY_BATCH_DEFAULT;
+	unsigned int newsize;
+	isc_result_t result;
+
+	LOCK(&zmgr->notifylock);
+	result = isc_hashmap_find(zmgr->notifydests, hashval,
+				  notify_dest_match, dst, (void **)&dest);
+	if (result == ISC_R_SUCCESS) {
+		size = dest->batchsize;
+	}
+
+	if (answered) {
+		newsize = ISC_MIN(size + 1, NOTIFY_BATCH_MAX);
+	} else {
+		newsize = ISC_MAX(size / 2, NOTIFY_BATCH_MIN);
+	}
+
+	if (newsize == NOTIFY_BATCH_DEFAULT) {
+		if (dest != NULL) {
+			result = isc_hashmap_delete(zmgr->notifydests, hashval,
+						    notify_dest_match, dst);
+			INSIST(result == ISC_R_SUCCESS);
+			isc_mem_put(zmgr->mctx, dest, sizeof(*dest));
+		}
+	} else if (dest != NULL) {
+		dest->batchsize = newsize;
+	} else {
+		dest = isc_mem_get(zmgr->mctx, sizeof(*dest));
+		*dest = (notify_dest_t){
+			.addr = *dst,
+			.batchsize = newsize,
+		};
+		result = isc_hashmap_add(zmgr->notifydests, hashval,
+					 notify_dest_match, &dest->addr, dest,
+					 NULL);
+		INSIST(result == ISC_R_SUCCESS);
+	}
+	UNLOCK(&zmgr->notifylock);
 }
 
 static void
@@ -12323,12 +12904,17 @@ notify_send_toaddr(void *arg) {
 
 	REQUIRE(DNS_NOTIFY_VALID(notify));
 
+	if (notify->rlevent != NULL && notify->rlevent->canceled) {
+		notify->canceled = true;
+	}
+	notify_batch_flush(notify, notify->canceled);
+
 	LOCK_ZONE(notify->zone);
 
 	isc_sockaddr_format(&notify->dst, addrbuf, sizeof(addrbuf));
 
 	if (DNS_ZONE_FLAG(notify->zone, DNS_ZONEFLG_LOADED) == 0 ||
-	    notify->rlevent->canceled ||
+	    notify->canceled ||
 	    DNS_ZONE_FLAG(notify->zone, DNS_ZONEFLG_EXITING) ||
 	    notify->zone->view->requestmgr == NULL || notify->zone->db == NULL)
 	{
@@ -13729,7 +14315,24 @@ refresh_callback(void *arg) {
 	isc_sockaddr_format(&curraddr, primary, sizeof(primary));
 	isc_sockaddr_format(&zone->sourceaddr, source, sizeof(source));
 
-	switch (dns_request_getresult(request)) {
+	result = dns_request_getresult(request);
+	if (result != ISC_R_SUCCESS && result != ISC_R_SHUTTINGDOWN &&
+	    zone->soabatchtcp)
+	{
+		/*
+		 * The query only went over TCP because it was batched;
+		 * the primary may not support TCP, so retry over UDP.
+		 */
+		dns_zone_log(zone, ISC_LOG_DEBUG(1),
+			     "refresh: batched TCP query to primary %s "
+			     "(source %s) failed: %s, retrying over UDP",
+			     primary, source, isc_result_totext(result));
+		zone->soabatchtcp = false;
+		zone->soaudp = true;
+		goto same_primary;
+	}
+
+	switch (result) {
 	case ISC_R_SUCCESS:
 		break;
 	case ISC_R_SHUTTINGDOWN:
@@ -14111,36 +14714,151 @@ detach:
 struct soaquery {
 	dns_zone_t *zone;
 	isc_rlevent_t *rlevent;
+	isc_sockaddr_t dst;
+	bool batched;
+	bool canceled;
+	bool tcp;
+	bool udp;
+	ISC_LIST(struct soaquery) batch;
+	ISC_LINK(struct soaquery) batchlink;
+	unsigned int nbatch;
 };
 
-static void
-queue_soa_query(dns_zone_t *zone) {
-	isc_result_t result;
-	struct soaquery *sq = NULL;
+static bool
+soaquery_batch_match(void *node, const void *key) {
+	const struct soaquery *sq = node;
 
-	ENTER;
-	/*
-	 * Locked by caller
-	 */
-	REQUIRE(LOCKED_ZONE(zone));
+	return (isc_sockaddr_equal(&sq->dst, key));
+}
 
-	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING)) {
-		cancel_refresh(zone);
-		return;
+/*
+ * Queue 'sq' on the refresh ratelimiter.  If an SOA query to the same
+ * primary is already waiting there and its batch is not full, 'sq'
+ * rides along with it instead of taking a ratelimiter slot of its own,
+ * so that a refresh storm for many zones served by the same primaries
+ * is not serialised at 'serial-query-rate' per zone.
+ */
+static isc_result_t
+soaquery_queue(struct soaquery *sq) {
+	dns_zonemgr_t *zmgr = sq->zone->zmgr;
+	struct soaquery *leader = NULL;
+	uint32_t hashval = isc_sockaddr_hash(&sq->dst, false);
+	isc_result_t result;
+
+	if (sq->udp) {
+		/* Sent on its own, see refresh_callback(). */
+		return (isc_ratelimiter_enqueue(zmgr->refreshrl, sq->zone->loop,
+						soa_query, sq, &sq->rlevent));
 	}
 
-	sq = isc_mem_get(zone->mctx, sizeof(*sq));
-	*sq = (struct soaquery){ .zone = NULL };
+	LOCK(&zmgr->soalock);
+	if (zmgr->soabatchmax <= 1) {
+		/* Batching is disabled. */
+		UNLOCK(&zmgr->soalock);
+		return (isc_ratelimiter_enqueue(zmgr->refreshrl, sq->zone->loop,
+						soa_query, sq, &sq->rlevent));
+	}
 
-	/* Shows in the statistics channel the duration of the current step. */
-	zone->xfrintime = isc_time_now();
+	result = isc_hashmap_find(zmgr->soabatches, hashval,
+				  soaquery_batch_match, &sq->dst,
+				  (void **)&leader);
+	if (result == ISC_R_SUCCESS && leader->nbatch + 1 < zmgr->soabatchmax)
+	{
+		ISC_LIST_APPEND(leader->batch, sq, batchlink);
+		leader->nbatch++;
+		UNLOCK(&zmgr->soalock);
+		return (ISC_R_SUCCESS);
+	}
+
+	result = isc_ratelimiter_enqueue(zmgr->refreshrl, sq->zone->loop,
+					 soa_query, sq, &sq->rlevent);
+	if (result == ISC_R_SUCCESS) {
+		/* The newest query becomes the leader for this primary. */
+		if (leader != NULL) {
+			(void)isc_hashmap_delete(zmgr->soabatches, hashval,
+						 soaquery_batch_match,
+						 &sq->dst);
+			leader->batched = false;
+		}
+		result = isc_hashmap_add(zmgr->soabatches, hashval,
+					 soaquery_batch_match, &sq->dst, sq,
+					 NULL);
+		INSIST(result == ISC_R_SUCCESS);
+		sq->batched = true;
+	}
+	UNLOCK(&zmgr->soalock);
+
+	return (result);
+}
+
+/*
+ * Called when 'sq' comes off the ratelimiter: stop accepting new
+ * followers and send those already collected from their own zone's
+ * loop.  Returns true if there were any.
+ */
+static bool
+soaquery_batch_flush(struct soaquery *sq) {
+	dns_zonemgr_t *zmgr = sq->zone->zmgr;
+	struct soaquery *follower = NULL;
+	ISC_LIST(struct soaquery) batch = ISC_LIST_INITIALIZER;
+	bool tcp;
+
+	LOCK(&zmgr->soalock);
+	if (sq->batched) {
+		isc_result_t result = isc_hashmap_delete(
+			zmgr->soabatches, isc_sockaddr_hash(&sq->dst, false),
+			soaquery_batch_match, &sq->dst);
+		INSIST(result == ISC_R_SUCCESS);
+		sq->batched = false;
+	}
+	ISC_LIST_MOVE(batch, sq->batch);
+	tcp = (sq->nbatch > 0);
+	sq->nbatch = 0;
+	UNLOCK(&zmgr->soalock);
+
+	while ((follower = ISC_LIST_HEAD(batch)) != NULL) {
+		ISC_LIST_UNLINK(batch, follower, batchlink);
+		follower->canceled = sq->canceled;
+		follower->tcp = true;
+		isc_async_run(follower->zone->loop, soa_query, follower);
+	}
+
+	return (tcp);
+}
+
+static void
+queue_soa_query(dns_zone_t *zone) {
+	isc_result_t result;
+	struct soaquery *sq = NULL;
+
+	ENTER;
+	/*
+	 * Locked by caller
+	 */
+	REQUIRE(LOCKED_ZONE(zone));
+
+	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING)) {
+		cancel_refresh(zone);
+		return;
+	}
+
+	sq = isc_mem_get(zone->mctx, sizeof(*sq));
+	*sq = (struct soaquery){
+		.dst = dns_remote_curraddr(&zone->primaries),
+		.udp = zone->soaudp,
+		.batch = ISC_LIST_INITIALIZER,
+		.batchlink = ISC_LINK_INITIALIZER,
+	};
+	zone->soaudp = false;
+
+	/* Shows in the statistics channel the duration of the current step. */
+	zone->xfrintime = isc_time_now();
 
 	/*
 	 * Attach so that we won't clean up until the event is delivered.
 	 */
 	zone_iattach(zone, &sq->zone);
-	result = isc_ratelimiter_enqueue(zone->zmgr->refreshrl, zone->loop,
-					 soa_query, sq, &sq->rlevent);
+	result = soaquery_queue(sq);
 	if (result != ISC_R_SUCCESS) {
 		zone_idetach(&sq->zone);
 		isc_mem_put(zone->mctx, sq, sizeof(*sq));
@@ -14169,8 +14887,15 @@ soa_query(void *arg) {
 
 	ENTER;
 
+	if (sq->rlevent != NULL && sq->rlevent->canceled) {
+		sq->canceled = true;
+	}
+	if (soaquery_batch_flush(sq)) {
+		sq->tcp = true;
+	}
+
 	LOCK_ZONE(zone);
-	if (sq->rlevent->canceled || DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING) ||
+	if (sq->canceled || DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING) ||
 	    zone->view->requestmgr == NULL)
 	{
 		if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING)) {
@@ -14268,6 +14993,16 @@ again:
 		}
 	}
 
+	zone->soabatchtcp = false;
+	if (sq->tcp && isc_sockaddr_equal(&curraddr, &sq->dst)) {
+		/*
+		 * Share the batch's pipelined connection to this primary,
+		 * and keep it open for the next batch.
+		 */
+		zone->soabatchtcp = ((options & DNS_REQUESTOPT_TCP) == 0);
+		options |= DNS_REQUESTOPT_TCP | DNS_REQUESTOPT_KEEPALIVE;
+	}
+
 	switch (isc_sockaddr_pf(&curraddr)) {
 	case PF_INET:
 		if (!have_xfrsource) {
@@ -14370,7 +15105,9 @@ cleanup:
 	if (do_queue_xfrin) {
 		queue_xfrin(zone);
 	}
-	isc_rlevent_free(&sq->rlevent);
+	if (sq->rlevent != NULL) {
+		isc_rlevent_free(&sq->rlevent);
+	}
 	isc_mem_put(zone->mctx, sq, sizeof(*sq));
 	dns_zone_idetach(&zone);
 	return;
@@ -14664,13 +15401,19 @@ zone_shutdown(void *arg) {
 		if (zone->statelist == &zone->zmgr->waiting_for_xfrin) {
 			ISC_LIST_UNLINK(zone->zmgr->waiting_for_xfrin, zone,
 					statelink);
+			zone->zmgr->waiting_count--;
 			linked = true;
 			zone->statelist = NULL;
+			zmgr_xfrin_dequeue(zone->zmgr, zone);
+			zone->xfrprimary = NULL;
 		}
 		if (zone->statelist == &zone->zmgr->xfrin_in_progress) {
 			ISC_LIST_UNLINK(zone->zmgr->xfrin_in_progress, zone,
 					statelink);
+			zone->zmgr->xfrin_count--;
 			zone->statelist = NULL;
+			zmgr_xfrin_release(zone->zmgr, zone, ISC_R_CANCELED, 0,
+					   0);
 			zmgr_resume_xfrs(zone->zmgr, false);
 		}
 		RWUNLOCK(&zone->zmgr->rwlock, isc_rwlocktype_write);
@@ -14727,10 +15470,7 @@ zone_shutdown(void *arg) {
 
 	forward_cancel(zone);
 
-	if (zone->timer != NULL) {
-		isc_refcount_decrement(&zone->irefs);
-		isc_timer_destroy(&zone->timer);
-	}
+	zone_timer_destroy(zone);
 
 	/*
 	 * We have now canceled everything set the flag to allow exit_check()
@@ -14776,38 +15516,157 @@ zone_shutdown(void *arg) {
 static void
 zone_timer(void *arg) {
 	dns_zone_t *zone = (dns_zone_t *)arg;
+	bool free_needed;
 
 	REQUIRE(DNS_ZONE_VALID(zone));
 
+	LOCK_ZONE(zone);
+	zone->timerqueued = false;
+	UNLOCK_ZONE(zone);
+
 	zone_maintenance(zone);
+
+	LOCK_ZONE(zone);
+	isc_refcount_decrement(&zone->irefs);
+	free_needed = exit_check(zone);
+	UNLOCK_ZONE(zone);
+	if (free_needed) {
+		zone_free(zone);
+	}
+}
+
+static void
+zonewheel_tick(void *arg) {
+	zonewheel_t *wheel = arg;
+	isc_time_t now = isc_time_now();
+	uint64_t tick = isc_nanosecs_fromtime(now) / ZONEWHEEL_TICK;
+	dns_zonelist_t due;
+	dns_zone_t *zone = NULL, *next = NULL;
+
+	ISC_LIST_INIT(due);
+
+	/*
+	 * After a long delay or a clock jump, visit each slot once.
+	 */
+	if (tick > wheel->tick + ZONEWHEEL_SLOTS) {
+		wheel->tick = tick - ZONEWHEEL_SLOTS;
+	}
+	while (wheel->tick < tick) {
+		wheel->tick++;
+		dns_zonelist_t *slot =
+			&wheel->slots[wheel->tick % ZONEWHEEL_SLOTS];
+		for (zone = ISC_LIST_HEAD(*slot); zone != NULL; zone = next) {
+			next = ISC_LIST_NEXT(zone, wheellink);
+			if (zone->wheeltick > tick) {
+				continue;
+			}
+			ISC_LIST_UNLINK(*slot, zone, wheellink);
+			ISC_LIST_APPEND(due, zone, wheellink);
+			zone->wheeltick = 0;
+			wheel->scheduled--;
+		}
+	}
+
+	if (wheel->scheduled == 0) {
+		isc_timer_stop(wheel->timer);
+	}
+
+	/*
+	 * The wheel holds an internal reference to each zone, and
+	 * zone_maintenance() only reschedules zones asynchronously,
+	 * so the list of due zones stays intact.
+	 */
+	while ((zone = ISC_LIST_HEAD(due)) != NULL) {
+		ISC_LIST_UNLINK(due, zone, wheellink);
+		zone_maintenance(zone);
+	}
+}
+
+static void
+zonewheel_unlink(zonewheel_t *wheel, dns_zone_t *zone) {
+	if (zone->wheeltick != 0) {
+		ISC_LIST_UNLINK(wheel->slots[zone->wheeltick % ZONEWHEEL_SLOTS],
+				zone, wheellink);
+		zone->wheeltick = 0;
+		wheel->scheduled--;
+	}
 }
 
 static void
 zone_timer_stop(dns_zone_t *zone) {
 	zone_debuglog(zone, __func__, 10, "stop zone timer");
-	if (zone->timer != NULL) {
-		isc_timer_stop(zone->timer);
+	if (zone->wheeled) {
+		zonewheel_unlink(&zone->zmgr->wheels[zone->tid], zone);
 	}
 }
 
 static void
 zone_timer_set(dns_zone_t *zone, isc_time_t *next, isc_time_t *now) {
-	isc_interval_t interval;
-
-	if (isc_time_compare(next, now) <= 0) {
-		isc_interval_set(&interval, 0, 0);
-	} else {
-		isc_time_subtract(next, now, &interval);
-	}
+	zonewheel_t *wheel = NULL;
+	uint64_t tick;
 
 	if (zone->loop == NULL) {
 		zone_debuglog(zone, __func__, 10, "zone is not managed");
-	} else if (zone->timer == NULL) {
+		return;
+	}
+
+	wheel = &zone->zmgr->wheels[zone->tid];
+	if (!zone->wheeled) {
 		isc_refcount_increment0(&zone->irefs);
-		isc_timer_create(zone->loop, zone_timer, zone, &zone->timer);
+		zone->wheeled = true;
+		if (wheel->zones++ == 0) {
+			isc_timer_create(zone->loop, zonewheel_tick, wheel,
+					 &wheel->timer);
+		}
+	}
+	zonewheel_unlink(wheel, zone);
+
+	if (isc_time_compare(next, now) <= 0) {
+		/* One queued zone_timer() serves any number of resets. */
+		if (!zone->timerqueued) {
+			zone->timerqueued = true;
+			isc_refcount_increment0(&zone->irefs);
+			isc_async_run(zone->loop, zone_timer, zone);
+		}
+		return;
+	}
+
+	if (wheel->scheduled == 0) {
+		isc_interval_t interval;
+		isc_time_t current = isc_time_now();
+
+		wheel->tick = isc_nanosecs_fromtime(current) / ZONEWHEEL_TICK;
+		isc_interval_set(&interval, 0, ZONEWHEEL_TICK);
+		isc_timer_start(wheel->timer, isc_timertype_ticker, &interval);
+	}
+
+	/* round up, and never into a slot that has been visited */
+	tick = (isc_nanosecs_fromtime(*next) + ZONEWHEEL_TICK - 1) /
+	       ZONEWHEEL_TICK;
+	tick = ISC_MAX(tick, wheel->tick + 1);
+
+	zone->wheeltick = tick;
+	ISC_LIST_APPEND(wheel->slots[tick % ZONEWHEEL_SLOTS], zone, wheellink);
+	wheel->scheduled++;
+}
+
+/*
+ * Take the zone off its loop's timing wheel for good.
+ */
+static void
+zone_timer_destroy(dns_zone_t *zone) {
+	zonewheel_t *wheel = NULL;
+
+	if (!zone->wheeled) {
+		return;
 	}
-	if (zone->timer != NULL) {
-		isc_timer_start(zone->timer, isc_timertype_once, &interval);
+
+	wheel = &zone->zmgr->wheels[zone->tid];
+	zonewheel_unlink(wheel, zone);
+	zone->wheeled = false;
+	isc_refcount_decrement(&zone->irefs);
+	if (--wheel->zones == 0) {
+		isc_timer_destroy(&wheel->timer);
 	}
 }
 
@@ -15959,6 +16818,12 @@ notify_done(void *arg) {
 fail:
 	dns_message_detach(&message);
 
+	if (result == ISC_R_SUCCESS) {
+		notify_batch_adjust(notify->zone->zmgr, &notify->dst, true);
+	} else if (result == ISC_R_TIMEDOUT) {
+		notify_batch_adjust(notify->zone->zmgr, &notify->dst, false);
+	}
+
 	if (result == ISC_R_SUCCESS) {
 		notify_log(notify->zone, ISC_LOG_DEBUG(1),
 			   "notify to %s successful", addrbuf);
@@ -17548,6 +18413,7 @@ zone_xfrdone(dns_zone_t *zone, uint32_t *expireopt, isc_result_t result) {
 	unsigned int nscount;
 	uint32_t serial, refresh, retry, expire, minimum, soattl, oldexpire;
 	isc_result_t xfrresult = result;
+	uint64_t xfrbytes = 0, xfrusecs = 0;
 	bool free_needed;
 	dns_zone_t *secure = NULL;
 
@@ -17793,6 +18659,16 @@ again:
 	 * it down, we can detach our reference.
 	 */
 	if (zone->xfr != NULL) {
+		unsigned int nmsg, nrecs;
+		isc_time_t start = dns_xfrin_getstarttime(zone->xfr);
+
+		dns_xfrin_getstats(zone->xfr, &nmsg, &nrecs, &xfrbytes);
+		if (!isc_time_isepoch(&start)) {
+			xfrusecs = isc_time_microdiff(&now, &start);
+		}
+		if (xfrresult == ISC_R_SUCCESS) {
+			zone->xfrinbytes = xfrbytes;
+		}
 		dns_xfrin_detach(&zone->xfr);
 	}
 
@@ -17829,7 +18705,10 @@ again:
 		UNLOCK_ZONE(zone);
 		RWLOCK(&zone->zmgr->rwlock, isc_rwlocktype_write);
 		ISC_LIST_UNLINK(zone->zmgr->xfrin_in_progress, zone, statelink);
+		zone->zmgr->xfrin_count--;
 		zone->statelist = NULL;
+		zmgr_xfrin_release(zone->zmgr, zone, xfrresult, xfrbytes,
+				   xfrusecs);
 		zmgr_resume_xfrs(zone->zmgr, false);
 		RWUNLOCK(&zone->zmgr->rwlock, isc_rwlocktype_write);
 		LOCK_ZONE(zone);
@@ -18038,27 +18917,57 @@ dns_zone_getxfrintime(const dns_zone_t *zone) {
 
 static void
 queue_xfrin(dns_zone_t *zone) {
-	isc_result_t result;
 	dns_zonemgr_t *zmgr = zone->zmgr;
+	dns_peer_t *peer = NULL;
+	isc_netaddr_t addr;
+	isc_sockaddr_t curraddr;
+	uint32_t max;
+	bool exiting, deferred = false;
 
 	ENTER;
 
 	INSIST(zone->statelist == NULL);
 
+	/*
+	 * Find any configured information about the server we'd
+	 * like to transfer this zone from.
+	 */
+	LOCK_ZONE(zone);
+	exiting = DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING);
+	if (!exiting) {
+		curraddr = dns_remote_curraddr(&zone->primaries);
+		isc_netaddr_fromsockaddr(&addr, &curraddr);
+		(void)dns_peerlist_peerbyaddr(zone->view->peers, &addr, &peer);
+	}
+	UNLOCK_ZONE(zone);
+
 	RWLOCK(&zmgr->rwlock, isc_rwlocktype_write);
 	ISC_LIST_APPEND(zmgr->waiting_for_xfrin, zone, statelink);
+	zmgr->waiting_count++;
 	isc_refcount_increment0(&zone->irefs);
 	zone->statelist = &zmgr->waiting_for_xfrin;
-	result = zmgr_start_xfrin_ifquota(zmgr, zone);
+	zone->xfrqueued = isc_time_now();
+	if (exiting) {
+		/*
+		 * Let the transfer "start" right away, so that the zone
+		 * is cleaned up in its loop's context.
+		 */
+		zone->xfrprimary = NULL;
+		zmgr_start_xfrin(zmgr, zone);
+	} else {
+		max = zmgr->transfersperns;
+		if (peer != NULL) {
+			(void)dns_peer_gettransfers(peer, &max);
+		}
+		zmgr_xfrin_enqueue(zmgr, zone, &addr, max);
+		zmgr_resume_xfrs(zmgr, false);
+		deferred = (zone->statelist == &zmgr->waiting_for_xfrin);
+	}
 	RWUNLOCK(&zmgr->rwlock, isc_rwlocktype_write);
 
-	if (result == ISC_R_QUOTA) {
+	if (deferred) {
 		dns_zone_logc(zone, DNS_LOGCATEGORY_XFER_IN, ISC_LOG_INFO,
 			      "zone transfer deferred due to quota");
-	} else if (result != ISC_R_SUCCESS) {
-		dns_zone_logc(zone, DNS_LOGCATEGORY_XFER_IN, ISC_LOG_ERROR,
-			      "starting zone transfer: %s",
-			      isc_result_totext(result));
 	}
 }
 
@@ -18792,6 +19701,11 @@ dns_zonemgr_create(isc_mem_t *mctx, isc_nm_t *netmgr, dns_zonemgr_t **zmgrp) {
 	ISC_LIST_INIT(zmgr->zones);
 	ISC_LIST_INIT(zmgr->waiting_for_xfrin);
 	ISC_LIST_INIT(zmgr->xfrin_in_progress);
+	ISC_LIST_INIT(zmgr->xfrprimaries);
+	ISC_LIST_INIT(zmgr->xfrwaiting);
+	ISC_LIST_INIT(zmgr->xfridle);
+	isc_hashmap_create(zmgr->mctx, XFRIN_PRIMARY_BITS,
+			   &zmgr->xfrprimarymap);
 	memset(zmgr->unreachable, 0, sizeof(zmgr->unreachable));
 	for (size_t i = 0; i < UNREACH_CACHE_SIZE; i++) {
 		atomic_init(&zmgr->unreachable[i].expire, 0);
@@ -18801,6 +19715,16 @@ dns_zonemgr_create(isc_mem_t *mctx, isc_nm_t *netmgr, dns_zonemgr_t **zmgrp) {
 	/* Unreachable lock. */
 	isc_rwlock_init(&zmgr->urlock);
 
+	/* Per-destination notify batches. */
+	isc_mutex_init(&zmgr->notifylock);
+	isc_hashmap_create(zmgr->mctx, NOTIFY_BATCH_BITS, &zmgr->notifybatches);
+	isc_hashmap_create(zmgr->mctx, NOTIFY_BATCH_BITS, &zmgr->notifydests);
+
+	/* Per-primary SOA query batches. */
+	isc_mutex_init(&zmgr->soalock);
+	isc_hashmap_create(zmgr->mctx, SOAQUERY_BATCH_BITS, &zmgr->soabatches);
+	zmgr->soabatchmax = SOAQUERY_BATCH_DEFAULT;
+
 	isc_ratelimiter_create(loop, &zmgr->checkdsrl);
 	isc_ratelimiter_create(loop, &zmgr->notifyrl);
 	isc_ratelimiter_create(loop, &zmgr->refreshrl);
@@ -18809,6 +19733,13 @@ dns_zonemgr_create(isc_mem_t *mctx, isc_nm_t *netmgr, dns_zonemgr_t **zmgrp) {
 
 	zmgr->mctxpool = isc_mem_cget(zmgr->mctx, zmgr->workers,
 				      sizeof(zmgr->mctxpool[0]));
+	zmgr->wheels = isc_mem_cget(zmgr->mctx, zmgr->workers,
+				    sizeof(zmgr->wheels[0]));
+	for (size_t i = 0; i < zmgr->workers; i++) {
+		for (size_t j = 0; j < ZONEWHEEL_SLOTS; j++) {
+			ISC_LIST_INIT(zmgr->wheels[i].slots[j]);
+		}
+	}
 	for (size_t i = 0; i < zmgr->workers; i++) {
 		isc_mem_create(&zmgr->mctxpool[i]);
 		isc_mem_setname(zmgr->mctxpool[i], "zonemgr-mctxpool");
@@ -18868,7 +19799,7 @@ dns_zonemgr_managezone(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
 
 	RWLOCK(&zmgr->rwlock, isc_rwlocktype_write);
 	LOCK_ZONE(zone);
-	REQUIRE(zone->timer == NULL);
+	REQUIRE(!zone->wheeled);
 	REQUIRE(zone->zmgr == NULL);
 
 	isc_loop_t *loop = isc_loop_get(zmgr->loopmgr, zone->tid);
@@ -18879,6 +19810,9 @@ dns_zonemgr_managezone(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
 
 	ISC_LIST_APPEND(zmgr->zones, zone, link);
 	zone->zmgr = zmgr;
+	zmgr_countflags(zmgr, atomic_load(&zone->flags) & ZONE_COUNTED_FLAGS,
+			true);
+	zmgr_countzone(zmgr, zone, true);
 
 	isc_refcount_increment(&zmgr->refs);
 
@@ -18903,14 +19837,14 @@ dns_zonemgr_releasezone(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
 		ENSURE(zone->kfio == NULL);
 	}
 
-	if (zone->timer != NULL) {
-		isc_refcount_decrement(&zone->irefs);
-		isc_timer_destroy(&zone->timer);
-	}
+	zone_timer_destroy(zone);
 
 	isc_loop_detach(&zone->loop);
 
 	/* Detach below, outside of the write lock. */
+	zmgr_countflags(zmgr, atomic_load(&zone->flags) & ZONE_COUNTED_FLAGS,
+			false);
+	zmgr_countzone(zmgr, zone, false);
 	zone->zmgr = NULL;
 
 	UNLOCK_ZONE(zone);
@@ -19008,12 +19942,37 @@ dns_zonemgr_shutdown(dns_zonemgr_t *zmgr) {
 	RWUNLOCK(&zmgr->rwlock, isc_rwlocktype_read);
 }
 
+static void
+notify_dests_destroy(dns_zonemgr_t *zmgr) {
+	isc_hashmap_iter_t *it = NULL;
+	isc_result_t result;
+
+	isc_hashmap_iter_create(zmgr->notifydests, &it);
+	for (result = isc_hashmap_iter_first(it); result == ISC_R_SUCCESS;
+	     result = isc_hashmap_iter_delcurrent_next(it))
+	{
+		notify_dest_t *dest = NULL;
+		isc_hashmap_iter_current(it, (void **)&dest);
+		isc_mem_put(zmgr->mctx, dest, sizeof(*dest));
+	}
+	isc_hashmap_iter_destroy(&it);
+	isc_hashmap_destroy(&zmgr->notifydests);
+}
+
 static void
 zonemgr_free(dns_zonemgr_t *zmgr) {
+	zmgr_primary_t *primary = NULL;
+
 	REQUIRE(ISC_LIST_EMPTY(zmgr->zones));
 
 	zmgr->magic = 0;
 
+	while ((primary = ISC_LIST_HEAD(zmgr->xfrprimaries)) != NULL) {
+		INSIST(primary->running == 0 && primary->nwaiting == 0);
+		zmgr_primary_free(zmgr, primary);
+	}
+	isc_hashmap_destroy(&zmgr->xfrprimarymap);
+
 	isc_refcount_destroy(&zmgr->refs);
 	isc_ratelimiter_detach(&zmgr->checkdsrl);
 	isc_ratelimiter_detach(&zmgr->notifyrl);
@@ -19024,10 +19983,23 @@ zonemgr_free(dns_zonemgr_t *zmgr) {
 	isc_mem_cput(zmgr->mctx, zmgr->mctxpool, zmgr->workers,
 		     sizeof(zmgr->mctxpool[0]));
 
+	for (size_t i = 0; i < zmgr->workers; i++) {
+		INSIST(zmgr->wheels[i].timer == NULL);
+	}
+	isc_mem_cput(zmgr->mctx, zmgr->wheels, zmgr->workers,
+		     sizeof(zmgr->wheels[0]));
+
 	isc_rwlock_destroy(&zmgr->urlock);
 	isc_rwlock_destroy(&zmgr->rwlock);
 	isc_rwlock_destroy(&zmgr->tlsctx_cache_rwlock);
 
+	isc_hashmap_destroy(&zmgr->notifybatches);
+	notify_dests_destroy(zmgr);
+	isc_mutex_destroy(&zmgr->notifylock);
+
+	isc_hashmap_destroy(&zmgr->soabatches);
+	isc_mutex_destroy(&zmgr->soalock);
+
 	zonemgr_keymgmt_destroy(zmgr);
 
 	if (zmgr->tlsctx_cache != NULL) {
@@ -19064,151 +20036,414 @@ dns_zonemgr_gettransfersperns(dns_zonemgr_t *zmgr) {
 	return (zmgr->transfersperns);
 }
 
+static uint32_t
+zmgr_primary_hash(const isc_netaddr_t *addr) {
+	isc_sockaddr_t sockaddr;
+
+	isc_sockaddr_fromnetaddr(&sockaddr, addr, 0);
+	return (isc_sockaddr_hash(&sockaddr, true));
+}
+
+static bool
+zmgr_primary_match(void *node, const void *key) {
+	const zmgr_primary_t *primary = node;
+
+	return (isc_netaddr_equal(&primary->addr, key));
+}
+
+static bool
+xfrin_heap_precedes(void *a, void *b) {
+	dns_zone_t *za = a, *zb = b;
+
+	return (xfrin_precedes(&za->xfrprio, &zb->xfrprio));
+}
+
+static void
+xfrin_heap_index(void *what, unsigned int idx) {
+	dns_zone_t *zone = what;
+
+	zone->xfrheapidx = idx;
+}
+
+static void
+zmgr_primary_free(dns_zonemgr_t *zmgr, zmgr_primary_t *primary) {
+	isc_result_t result;
+
+	if (ISC_LINK_LINKED(primary, idlelink)) {
+		ISC_LIST_UNLINK(zmgr->xfridle, primary, idlelink);
+	}
+	ISC_LIST_UNLINK(zmgr->xfrprimaries, primary, link);
+	result = isc_hashmap_delete(zmgr->xfrprimarymap,
+				    zmgr_primary_hash(&primary->addr),
+				    zmgr_primary_match, &primary->addr);
+	INSIST(result == ISC_R_SUCCESS);
+	isc_heap_destroy(&primary->waiting);
+	isc_mem_put(zmgr->mctx, primary, sizeof(*primary));
+}
+
 /*
- * Try to start a new incoming zone transfer to fill a quota
- * slot that was just vacated.
+ * Forget the primaries that have been idle for XFRIN_PRIMARY_IDLE
+ * seconds or more.
  *
  * Requires:
- *	The zone manager is locked by the caller.
+ *	The zone manager is write-locked by the caller.
  */
 static void
-zmgr_resume_xfrs(dns_zonemgr_t *zmgr, bool multi) {
-	dns_zone_t *zone;
-	dns_zone_t *next;
+zmgr_primary_prune(dns_zonemgr_t *zmgr) {
+	isc_stdtime_t now = isc_stdtime_now();
+	zmgr_primary_t *primary = NULL;
 
-	for (zone = ISC_LIST_HEAD(zmgr->waiting_for_xfrin); zone != NULL;
-	     zone = next)
+	while ((primary = ISC_LIST_HEAD(zmgr->xfridle)) != NULL &&
+	       primary->idlesince + XFRIN_PRIMARY_IDLE <= now)
 	{
-		isc_result_t result;
-		next = ISC_LIST_NEXT(zone, statelink);
-		result = zmgr_start_xfrin_ifquota(zmgr, zone);
-		if (result == ISC_R_SUCCESS) {
-			if (multi) {
-				continue;
-			}
-			/*
-			 * We successfully filled the slot.  We're done.
-			 */
-			break;
-		} else if (result == ISC_R_QUOTA) {
+		zmgr_primary_free(zmgr, primary);
+	}
+}
+
+/*
+ * Move 'primary' on or off the lists of primaries with waiting zones
+ * and of idle primaries after its counters have changed.
+ *
+ * Requires:
+ *	The zone manager is write-locked by the caller.
+ */
+static void
+zmgr_primary_update(dns_zonemgr_t *zmgr, zmgr_primary_t *primary) {
+	bool waiting = (primary->nwaiting > 0);
+	bool idle = (!waiting && primary->running == 0);
+
+	if (waiting && !ISC_LINK_LINKED(primary, waitlink)) {
+		ISC_LIST_APPEND(zmgr->xfrwaiting, primary, waitlink);
+	} else if (!waiting && ISC_LINK_LINKED(primary, waitlink)) {
+		ISC_LIST_UNLINK(zmgr->xfrwaiting, primary, waitlink);
+	}
+
+	if (idle && !ISC_LINK_LINKED(primary, idlelink)) {
+		primary->idlesince = isc_stdtime_now();
+		ISC_LIST_APPEND(zmgr->xfridle, primary, idlelink);
+	} else if (!idle && ISC_LINK_LINKED(primary, idlelink)) {
+		ISC_LIST_UNLINK(zmgr->xfridle, primary, idlelink);
+	}
+}
+
+/*
+ * Find the transfer scheduling state for the primary 'addr', creating
+ * it if necessary.
+ *
+ * Requires:
+ *	The zone manager is write-locked by the caller.
+ */
+static zmgr_primary_t *
+zmgr_primary_get(dns_zonemgr_t *zmgr, const isc_netaddr_t *addr) {
+	zmgr_primary_t *primary = NULL;
+	uint32_t hashval = zmgr_primary_hash(addr);
+	isc_result_t result;
+
+	zmgr_primary_prune(zmgr);
+
+	result = isc_hashmap_find(zmgr->xfrprimarymap, hashval,
+				  zmgr_primary_match, addr, (void **)&primary);
+	if (result == ISC_R_SUCCESS) {
+		return (primary);
+	}
+
+	primary = isc_mem_get(zmgr->mctx, sizeof(*primary));
+	*primary = (zmgr_primary_t){
+		.addr = *addr,
+		.limit = UINT32_MAX,
+		.link = ISC_LINK_INITIALIZER,
+		.waitlink = ISC_LINK_INITIALIZER,
+		.idlelink = ISC_LINK_INITIALIZER,
+	};
+	isc_heap_create(zmgr->mctx, xfrin_heap_precedes, xfrin_heap_index, 0,
+			&primary->waiting);
+	result = isc_hashmap_add(zmgr->xfrprimarymap, hashval,
+				 zmgr_primary_match, &primary->addr, primary,
+				 NULL);
+	INSIST(result == ISC_R_SUCCESS);
+	ISC_LIST_APPEND(zmgr->xfrprimaries, primary, link);
+
+	return (primary);
+}
+
+/*
+ * Does the result of a transfer suggest that the primary is
+ * overloaded or cannot be reached?
+ */
+static bool
+xfrin_overloaded(isc_result_t result) {
+	switch (result) {
+	case ISC_R_TIMEDOUT:
+	case ISC_R_CONNREFUSED:
+	case ISC_R_CONNECTIONRESET:
+	case ISC_R_EOF:
+	case ISC_R_HOSTUNREACH:
+	case ISC_R_NETUNREACH:
+	case DNS_R_SERVFAIL:
+		return (true);
+	default:
+		return (false);
+	}
+}
+
+/*
+ * Release the transfer slot that 'zone' holds on its primary and adapt
+ * the primary's transfer limit to the outcome: 'result' is the result
+ * of the transfer, and 'nbytes' bytes were received in 'usecs'
+ * microseconds.
+ *
+ * Requires:
+ *	The zone manager is write-locked by the caller.
+ */
+static void
+zmgr_xfrin_release(dns_zonemgr_t *zmgr, dns_zone_t *zone, isc_result_t result,
+		   uint64_t nbytes, uint64_t usecs) {
+	zmgr_primary_t *primary = zone->xfrprimary;
+	uint64_t rate;
+
+	if (primary == NULL) {
+		return;
+	}
+
+	zone->xfrprimary = NULL;
+	INSIST(primary->running > 0);
+	primary->running--;
+	zmgr_primary_update(zmgr, primary);
+
+	if (result == ISC_R_CANCELED || result == ISC_R_SHUTTINGDOWN) {
+		return;
+	}
+
+	primary->transfers++;
+	if (xfrin_overloaded(result)) {
+		primary->failures++;
+		primary->limit = ISC_MAX(primary->limit / 2, 1);
+		primary->successes = 0;
+		return;
+	}
+
+	if (result != ISC_R_SUCCESS && result != DNS_R_UPTODATE) {
+		return;
+	}
+
+	if (nbytes >= XFRIN_RATE_MINBYTES && usecs > 0) {
+		rate = nbytes * US_PER_SEC / usecs;
+		if (primary->rate != 0 && rate < primary->rate / 2 &&
+		    primary->limit > 1)
+		{
 			/*
-			 * Not enough quota.  This is probably the per-server
-			 * quota, because we usually get called when a unit of
-			 * global quota has just been freed.  Try the next
-			 * zone, it may succeed if it uses another primary.
+			 * Much slower than recently: running this many
+			 * transfers from the primary is not paying off.
 			 */
-			continue;
-		} else {
-			dns_zone_logc(zone, DNS_LOGCATEGORY_XFER_IN,
-				      ISC_LOG_DEBUG(1),
-				      "starting zone transfer: %s",
-				      isc_result_totext(result));
-			break;
+			primary->limit--;
+			primary->successes = 0;
 		}
+		primary->rate = (primary->rate == 0)
+					? rate
+					: (primary->rate * 7 + rate) / 8;
+	}
+
+	if (++primary->successes >= primary->limit) {
+		if (primary->limit < primary->max) {
+			primary->limit++;
+		}
+		primary->successes = 0;
 	}
 }
 
 /*
- * Try to start an incoming zone transfer for 'zone', quota permitting.
+ * Compute the priority of 'zone' in its primary's queue, see the
+ * description of xfrin_prio_t.
  *
  * Requires:
- *	The zone manager is locked by the caller.
+ *	The zone is locked by the caller.
+ */
+static void
+xfrin_priority(dns_zone_t *zone, xfrin_prio_t *prio) {
+	uint64_t bytes = zone->xfrinbytes;
+	uint64_t expire;
+
+	if (!DNS_ZONE_FLAG(zone, DNS_ZONEFLG_LOADED)) {
+		*prio = (xfrin_prio_t){ .class = 1,
+					.deadline = zone->xfrqueued };
+	} else {
+		bool ixfr = zone->requestixfr &&
+			    !DNS_ZONE_FLAG(zone, DNS_ZONEFLG_FORCEXFER) &&
+			    !DNS_ZONE_FLAG(zone, DNS_ZONEFLG_NOIXFR);
+		*prio = (xfrin_prio_t){ .class = ixfr ? 2 : 3,
+					.deadline = zone->expiretime };
+		if (ixfr) {
+			bytes = 0;
+		}
+	}
+
+	while (bytes > 0) {
+		prio->size++;
+		bytes >>= 1;
+	}
+
+	prio->due = isc_time_seconds(&zone->xfrqueued) +
+		    (prio->class - 1) * XFRIN_CLASS_WAIT +
+		    prio->size * XFRIN_SIZE_WAIT;
+
+	if (prio->class > 1 && !isc_time_isepoch(&zone->expiretime)) {
+		expire = isc_time_seconds(&zone->expiretime);
+		expire = (expire > XFRIN_EXPIRE_MARGIN)
+				 ? expire - XFRIN_EXPIRE_MARGIN
+				 : 0;
+		prio->due = ISC_MIN(prio->due, expire);
+	}
+}
+
+static bool
+xfrin_precedes(const xfrin_prio_t *a, const xfrin_prio_t *b) {
+	if (a->due != b->due) {
+		return (a->due < b->due);
+	}
+	if (a->class != b->class) {
+		return (a->class < b->class);
+	}
+	if (a->size != b->size) {
+		return (a->size < b->size);
+	}
+	return (isc_time_compare(&a->deadline, &b->deadline) < 0);
+}
+
+/*
+ * Queue 'zone' for a transfer from the primary 'addr', which allows
+ * up to 'max' simultaneous transfers.
  *
- * Returns:
- *	ISC_R_SUCCESS	There was enough quota and we attempted to
- *			start a transfer.  zone_xfrdone() has been or will
- *			be called.
- *	ISC_R_QUOTA	Not enough quota.
- *	Others		Failure.
+ * Requires:
+ *	The zone manager is write-locked by the caller.
  */
-static isc_result_t
-zmgr_start_xfrin_ifquota(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
-	dns_peer_t *peer = NULL;
-	isc_netaddr_t primaryip;
-	isc_sockaddr_t curraddr;
-	uint32_t nxfrsin, nxfrsperns;
-	dns_zone_t *x = NULL;
-	uint32_t maxtransfersin, maxtransfersperns;
+static void
+zmgr_xfrin_enqueue(dns_zonemgr_t *zmgr, dns_zone_t *zone,
+		   const isc_netaddr_t *addr, uint32_t max) {
+	zmgr_primary_t *primary = zmgr_primary_get(zmgr, addr);
+
+	primary->max = max;
+	primary->limit = ISC_MIN(primary->limit, max);
 
-	/*
-	 * If we are exiting just pretend we got quota so the zone will
-	 * be cleaned up in the zone's loop context.
-	 */
 	LOCK_ZONE(zone);
-	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING)) {
-		UNLOCK_ZONE(zone);
-		goto gotquota;
+	xfrin_priority(zone, &zone->xfrprio);
+	UNLOCK_ZONE(zone);
+
+	zone->xfrprimary = primary;
+	isc_heap_insert(primary->waiting, zone);
+	primary->nwaiting++;
+	zmgr_primary_update(zmgr, primary);
+}
+
+/*
+ * Take 'zone' out of its primary's queue.  'zone->xfrprimary' is
+ * left alone.
+ *
+ * Requires:
+ *	The zone manager is write-locked by the caller.
+ */
+static void
+zmgr_xfrin_dequeue(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
+	zmgr_primary_t *primary = zone->xfrprimary;
+
+	if (primary == NULL) {
+		return;
 	}
 
-	/*
-	 * Find any configured information about the server we'd
-	 * like to transfer this zone from.
-	 */
-	curraddr = dns_remote_curraddr(&zone->primaries);
-	isc_netaddr_fromsockaddr(&primaryip, &curraddr);
-	(void)dns_peerlist_peerbyaddr(zone->view->peers, &primaryip, &peer);
-	UNLOCK_ZONE(zone);
+	INSIST(primary->nwaiting > 0);
+	isc_heap_delete(primary->waiting, zone->xfrheapidx);
+	primary->nwaiting--;
+	zmgr_primary_update(zmgr, primary);
+}
 
-	/*
-	 * Determine the total maximum number of simultaneous
-	 * transfers allowed, and the maximum for this specific
-	 * primary.
-	 */
-	maxtransfersin = zmgr->transfersin;
-	maxtransfersperns = zmgr->transfersperns;
-	if (peer != NULL) {
-		(void)dns_peer_gettransfers(peer, &maxtransfersperns);
+/*
+ * Return the waiting zone whose transfer should be started next, or
+ * NULL if there is no quota to start any: either all transfer slots
+ * are in use, or every primary with waiting zones has reached its
+ * limit.  Only the head of each primary's queue is considered.
+ *
+ * Requires:
+ *	The zone manager is locked by the caller.
+ */
+static dns_zone_t *
+zmgr_xfrin_next(dns_zonemgr_t *zmgr) {
+	dns_zone_t *best = NULL;
+
+	if (zmgr->xfrin_count >= zmgr->transfersin) {
+		return (NULL);
 	}
 
-	/*
-	 * Count the total number of transfers that are in progress,
-	 * and the number of transfers in progress from this primary.
-	 * We linearly scan a list of all transfers; if this turns
-	 * out to be too slow, we could hash on the primary address.
-	 */
-	nxfrsin = nxfrsperns = 0;
-	for (x = ISC_LIST_HEAD(zmgr->xfrin_in_progress); x != NULL;
-	     x = ISC_LIST_NEXT(x, statelink))
+	for (zmgr_primary_t *primary = ISC_LIST_HEAD(zmgr->xfrwaiting);
+	     primary != NULL; primary = ISC_LIST_NEXT(primary, waitlink))
 	{
-		isc_netaddr_t xip;
-		isc_sockaddr_t xaddr;
+		dns_zone_t *zone = NULL;
 
-		LOCK_ZONE(x);
-		xaddr = dns_remote_curraddr(&x->primaries);
-		isc_netaddr_fromsockaddr(&xip, &xaddr);
-		UNLOCK_ZONE(x);
+		if (primary->running >= ISC_MIN(primary->limit, primary->max))
+		{
+			continue;
+		}
 
-		nxfrsin++;
-		if (isc_netaddr_equal(&xip, &primaryip)) {
-			nxfrsperns++;
+		zone = isc_heap_element(primary->waiting, 1);
+		INSIST(zone != NULL);
+		if (best == NULL ||
+		    xfrin_precedes(&zone->xfrprio, &best->xfrprio))
+		{
+			best = zone;
 		}
 	}
 
-	/* Enforce quota. */
-	if (nxfrsin >= maxtransfersin) {
-		return (ISC_R_QUOTA);
-	}
+	return (best);
+}
+
+/*
+ * Try to start new incoming zone transfers to fill quota slots that
+ * were just vacated: one if 'multi' is false, as many as the quotas
+ * allow otherwise.
+ *
+ * Requires:
+ *	The zone manager is write-locked by the caller.
+ */
+static void
+zmgr_resume_xfrs(dns_zonemgr_t *zmgr, bool multi) {
+	dns_zone_t *zone = NULL;
+
+	do {
+		zone = zmgr_xfrin_next(zmgr);
+		if (zone == NULL) {
+			return;
+		}
+		zmgr_start_xfrin(zmgr, zone);
+	} while (multi);
+}
 
-	if (nxfrsperns >= maxtransfersperns) {
-		return (ISC_R_QUOTA);
+/*
+ * Start an incoming zone transfer for the waiting 'zone': charge it to
+ * its primary, move the zone to the "xfrin_in_progress" list and start
+ * the actual transfer asynchronously.  zone_xfrdone() will be called.
+ *
+ * Requires:
+ *	The zone manager is write-locked by the caller.
+ */
+static void
+zmgr_start_xfrin(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
+	zmgr_primary_t *primary = zone->xfrprimary;
+
+	if (primary != NULL) {
+		zmgr_xfrin_dequeue(zmgr, zone);
+		primary->running++;
+		zmgr_primary_update(zmgr, primary);
 	}
 
-gotquota:
-	/*
-	 * We have sufficient quota.  Move the zone to the "xfrin_in_progress"
-	 * list and start the actual transfer asynchronously.
-	 */
 	LOCK_ZONE(zone);
 	INSIST(zone->statelist == &zmgr->waiting_for_xfrin);
 	ISC_LIST_UNLINK(zmgr->waiting_for_xfrin, zone, statelink);
 	ISC_LIST_APPEND(zmgr->xfrin_in_progress, zone, statelink);
+	zmgr->waiting_count--;
+	zmgr->xfrin_count++;
 	zone->statelist = &zmgr->xfrin_in_progress;
 	isc_async_run(zone->loop, got_transfer_quota, zone);
 	dns_zone_logc(zone, DNS_LOGCATEGORY_XFER_IN, ISC_LOG_INFO,
 		      "Transfer started.");
 	UNLOCK_ZONE(zone);
-
-	return (ISC_R_SUCCESS);
 }
 
 static void
@@ -19303,6 +20538,15 @@ dns_zonemgr_setserialqueryrate(dns_zonemgr_t *zmgr, unsigned int value) {
 	setrl(zmgr->startuprefreshrl, &zmgr->startupserialqueryrate, value);
 }
 
+void
+dns_zonemgr_setserialquerybatch(dns_zonemgr_t *zmgr, unsigned int value) {
+	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
+
+	LOCK(&zmgr->soalock);
+	zmgr->soabatchmax = value;
+	UNLOCK(&zmgr->soalock);
+}
+
 unsigned int
 dns_zonemgr_getnotifyrate(dns_zonemgr_t *zmgr) {
 	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
@@ -19662,77 +20906,100 @@ dns_zone_getkeystores(dns_zone_t *zone) {
 	return (ks);
 }
 
+static int
+xfrin_queue_cmp(const void *a, const void *b) {
+	dns_zone_t *const *za = a, *const *zb = b;
+
+	if (xfrin_precedes(&(*za)->xfrprio, &(*zb)->xfrprio)) {
+		return (-1);
+	}
+	if (xfrin_precedes(&(*zb)->xfrprio, &(*za)->xfrprio)) {
+		return (1);
+	}
+	return (0);
+}
+
+isc_result_t
+dns_zonemgr_xfrprimaries(dns_zonemgr_t *zmgr, dns_xfrprimary_cb_t cb,
+			 void *arg) {
+	isc_result_t result = ISC_R_SUCCESS;
+
+	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
+	REQUIRE(cb != NULL);
+
+	RWLOCK(&zmgr->rwlock, isc_rwlocktype_read);
+	for (zmgr_primary_t *primary = ISC_LIST_HEAD(zmgr->xfrprimaries);
+	     primary != NULL && result == ISC_R_SUCCESS;
+	     primary = ISC_LIST_NEXT(primary, link))
+	{
+		dns_xfrprimary_t info = {
+			.addr = primary->addr,
+			.running = primary->running,
+			.limit = primary->limit,
+			.rate = primary->rate,
+			.transfers = primary->transfers,
+			.failures = primary->failures,
+			.waiting = primary->nwaiting,
+		};
+		dns_zone_t **queue = NULL;
+
+		if (primary->nwaiting > 0) {
+			queue = isc_mem_cget(zmgr->mctx, primary->nwaiting,
+					     sizeof(queue[0]));
+			for (unsigned int i = 0; i < primary->nwaiting; i++) {
+				queue[i] = isc_heap_element(primary->waiting,
+							    i + 1);
+			}
+			qsort(queue, primary->nwaiting, sizeof(queue[0]),
+			      xfrin_queue_cmp);
+			info.queue = queue;
+		}
+
+		result = cb(&info, arg);
+
+		if (queue != NULL) {
+			isc_mem_cput(zmgr->mctx, queue, primary->nwaiting,
+				     sizeof(queue[0]));
+		}
+	}
+	RWUNLOCK(&zmgr->rwlock, isc_rwlocktype_read);
+
+	return (result);
+}
+
 unsigned int
 dns_zonemgr_getcount(dns_zonemgr_t *zmgr, dns_zonestate_t state) {
-	dns_zone_t *zone;
 	unsigned int count = 0;
 
 	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
 
-	RWLOCK(&zmgr->rwlock, isc_rwlocktype_read);
 	switch (state) {
 	case DNS_ZONESTATE_XFERRUNNING:
-		for (zone = ISC_LIST_HEAD(zmgr->xfrin_in_progress);
-		     zone != NULL; zone = ISC_LIST_NEXT(zone, statelink))
-		{
-			count++;
-		}
+		RWLOCK(&zmgr->rwlock, isc_rwlocktype_read);
+		count = zmgr->xfrin_count;
+		RWUNLOCK(&zmgr->rwlock, isc_rwlocktype_read);
 		break;
 	case DNS_ZONESTATE_XFERDEFERRED:
-		for (zone = ISC_LIST_HEAD(zmgr->waiting_for_xfrin);
-		     zone != NULL; zone = ISC_LIST_NEXT(zone, statelink))
-		{
-			count++;
-		}
+		RWLOCK(&zmgr->rwlock, isc_rwlocktype_read);
+		count = zmgr->waiting_count;
+		RWUNLOCK(&zmgr->rwlock, isc_rwlocktype_read);
 		break;
 	case DNS_ZONESTATE_XFERFIRSTREFRESH:
-		for (zone = ISC_LIST_HEAD(zmgr->zones); zone != NULL;
-		     zone = ISC_LIST_NEXT(zone, link))
-		{
-			if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_FIRSTREFRESH)) {
-				count++;
-			}
-		}
+		count = atomic_load_relaxed(&zmgr->firstrefresh_count);
 		break;
 	case DNS_ZONESTATE_SOAQUERY:
-		for (zone = ISC_LIST_HEAD(zmgr->zones); zone != NULL;
-		     zone = ISC_LIST_NEXT(zone, link))
-		{
-			if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_REFRESH)) {
-				count++;
-			}
-		}
+		count = atomic_load_relaxed(&zmgr->refresh_count);
 		break;
 	case DNS_ZONESTATE_ANY:
-		for (zone = ISC_LIST_HEAD(zmgr->zones); zone != NULL;
-		     zone = ISC_LIST_NEXT(zone, link))
-		{
-			dns_view_t *view = zone->view;
-			if (view != NULL && strcmp(view->name, "_bind") == 0) {
-				continue;
-			}
-			count++;
-		}
+		count = atomic_load_relaxed(&zmgr->any_count);
 		break;
 	case DNS_ZONESTATE_AUTOMATIC:
-		for (zone = ISC_LIST_HEAD(zmgr->zones); zone != NULL;
-		     zone = ISC_LIST_NEXT(zone, link))
-		{
-			dns_view_t *view = zone->view;
-			if (view != NULL && strcmp(view->name, "_bind") == 0) {
-				continue;
-			}
-			if (zone->automatic) {
-				count++;
-			}
-		}
+		count = atomic_load_relaxed(&zmgr->automatic_count);
 		break;
 	default:
 		UNREACHABLE();
 	}
 
-	RWUNLOCK(&zmgr->rwlock, isc_rwlocktype_read);
-
 	return (count);
 }
 
@@ -22765,7 +24032,13 @@ dns_zone_setautomatic(dns_zone_t *zone, bool automatic) {
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
+	if (zone->zmgr != NULL) {
+		zmgr_countzone(zone->zmgr, zone, false);
+	}
 	zone->automatic = automatic;
+	if (zone->zmgr != NULL) {
+		zmgr_countzone(zone->zmgr, zone, true);
+	}
 	UNLOCK_ZONE(zone);
 }
 
@@ -22790,6 +24063,21 @@ dns_zone_getadded(dns_zone_t *zone) {
 	return (zone->added);
 }
 
+void
+dns_zone_setconfigdigest(dns_zone_t *zone, uint64_t digest) {
+	REQUIRE(DNS_ZONE_VALID(zone));
+
+	LOCK_ZONE(zone);
+	zone->configdigest = digest;
+	UNLOCK_ZONE(zone);
+}
+
+uint64_t
+dns_zone_getconfigdigest(dns_zone_t *zone) {
+	REQUIRE(DNS_ZONE_VALID(zone));
+	return (zone->configdigest);
+}
+
 isc_result_t
 dns_zone_dlzpostload(dns_zone_t *zone, dns_db_t *db) {
 	isc_time_t loadtime;
@@ -41,6 +41,13 @@ struct dns_zt {
 	isc_mem_t *mctx;
 	dns_qpmulti_t *multi;
 
+	/*
+	 * An open batch transaction (see dns_zt_beginbatch()) and the
+	 * thread that owns it.
+	 */
+	atomic_ptr(dns_qp_t) batch;
+	atomic_uint_fast32_t batchtid;
+
 	atomic_bool flush;
 	isc_refcount_t references;
 	isc_refcount_t loads_pending;
@@ -108,6 +115,7 @@ dns_zt_create(isc_mem_t *mctx, dns_view_t *view, dns_zt_t **ztp) {
 		.magic = ZTMAGIC,
 		.multi = multi,
 		.references = 1,
+		.batchtid = ISC_TID_UNKNOWN,
 	};
 
 	isc_mem_attach(mctx, &zt->mctx);
@@ -115,6 +123,52 @@ dns_zt_create(isc_mem_t *mctx, dns_view_t *view, dns_zt_t **ztp) {
 	*ztp = zt;
 }
 
+/*
+ * Return the batch opened by the current thread, if any.  Only the
+ * thread that opened a batch may use it; everyone else sees the zone
+ * table as of the last commit.  Batches are only opened from loop
+ * threads, so a thread without a tid never has one.
+ */
+static dns_qp_t *
+getbatch(dns_zt_t *zt) {
+	uint32_t tid = isc_tid();
+
+	if (tid == ISC_TID_UNKNOWN || atomic_load_acquire(&zt->batchtid) != tid)
+	{
+		return (NULL);
+	}
+	return (atomic_load_acquire(&zt->batch));
+}
+
+void
+dns_zt_beginbatch(dns_zt_t *zt) {
+	dns_qp_t *qp = NULL;
+
+	REQUIRE(VALID_ZT(zt));
+	REQUIRE(isc_tid() != ISC_TID_UNKNOWN);
+	REQUIRE(getbatch(zt) == NULL);
+
+	dns_qpmulti_write(zt->multi, &qp);
+	atomic_store_release(&zt->batch, qp);
+	atomic_store_release(&zt->batchtid, isc_tid());
+}
+
+void
+dns_zt_endbatch(dns_zt_t *zt) {
+	dns_qp_t *qp = NULL;
+
+	REQUIRE(VALID_ZT(zt));
+
+	qp = getbatch(zt);
+	REQUIRE(qp != NULL);
+
+	atomic_store_release(&zt->batch, NULL);
+	atomic_store_release(&zt->batchtid, ISC_TID_UNKNOWN);
+
+	dns_qp_compact(qp, DNS_QPGC_MAYBE);
+	dns_qpmulti_commit(zt->multi, &qp);
+}
+
 /*
  * XXXFANF it isn't clear whether this function will be useful. There
  * is only one zone table per view, so it is probably enough to let
@@ -128,6 +182,12 @@ dns_zt_compact(dns_zt_t *zt) {
 
 	REQUIRE(VALID_ZT(zt));
 
+	qp = getbatch(zt);
+	if (qp != NULL) {
+		dns_qp_compact(qp, DNS_QPGC_ALL);
+		return;
+	}
+
 	dns_qpmulti_write(zt->multi, &qp);
 	dns_qp_compact(qp, DNS_QPGC_ALL);
 	dns_qpmulti_commit(zt->multi, &qp);
@@ -140,6 +200,11 @@ dns_zt_mount(dns_zt_t *zt, dns_zone_t *zone) {
 
 	REQUIRE(VALID_ZT(zt));
 
+	qp = getbatch(zt);
+	if (qp != NULL) {
+		return (dns_qp_insert(qp, zone, 0));
+	}
+
 	dns_qpmulti_write(zt->multi, &qp);
 	result = dns_qp_insert(qp, zone, 0);
 	dns_qp_compact(qp, DNS_QPGC_MAYBE);
@@ -155,6 +220,12 @@ dns_zt_unmount(dns_zt_t *zt, dns_zone_t *zone) {
 
 	REQUIRE(VALID_ZT(zt));
 
+	qp = getbatch(zt);
+	if (qp != NULL) {
+		return (dns_qp_deletename(qp, dns_zone_getorigin(zone), NULL,
+					  NULL));
+	}
+
 	dns_qpmulti_write(zt->multi, &qp);
 	result = dns_qp_deletename(qp, dns_zone_getorigin(zone), NULL, NULL);
 	dns_qp_compact(qp, DNS_QPGC_MAYBE);
@@ -168,6 +239,8 @@ dns_zt_find(dns_zt_t *zt, const dns_name_t *name, dns_ztfind_t options,
 	    dns_zone_t **zonep) {
 	isc_result_t result;
 	dns_qpread_t qpr;
+	dns_qpreadable_t reader = { .qpr = &qpr };
+	dns_qp_t *batch = NULL;
 	void *pval = NULL;
 	dns_ztfind_t exactmask = DNS_ZTFIND_NOEXACT | DNS_ZTFIND_EXACT;
 	dns_ztfind_t exactopts = options & exactmask;
@@ -176,12 +249,17 @@ dns_zt_find(dns_zt_t *zt, const dns_name_t *name, dns_ztfind_t options,
 	REQUIRE(VALID_ZT(zt));
 	REQUIRE(exactopts != exactmask);
 
-	dns_qpmulti_query(zt->multi, &qpr);
+	batch = getbatch(zt);
+	if (batch != NULL) {
+		reader.qpt = batch;
+	} else {
+		dns_qpmulti_query(zt->multi, &qpr);
+	}
 
 	if (exactopts == DNS_ZTFIND_EXACT) {
-		result = dns_qp_getname(&qpr, name, &pval, NULL);
+		result = dns_qp_getname(reader, name, &pval, NULL);
 	} else {
-		result = dns_qp_lookup(&qpr, name, NULL, NULL, &chain, &pval,
+		result = dns_qp_lookup(reader, name, NULL, NULL, &chain, &pval,
 				       NULL);
 		if (exactopts == DNS_ZTFIND_NOEXACT && result == ISC_R_SUCCESS)
 		{
@@ -196,7 +274,9 @@ dns_zt_find(dns_zt_t *zt, const dns_name_t *name, dns_ztfind_t options,
 			}
 		}
 	}
-	dns_qpread_destroy(zt->multi, &qpr);
+	if (batch == NULL) {
+		dns_qpread_destroy(zt->multi, &qpr);
+	}
 
 	if (result == ISC_R_SUCCESS || result == DNS_R_PARTIALMATCH) {
 		dns_zone_t *zone = pval;
@@ -250,6 +330,7 @@ static void
 zt_destroy(dns_zt_t *zt) {
 	isc_refcount_destroy(&zt->references);
 	isc_refcount_destroy(&zt->loads_pending);
+	INSIST(atomic_load_acquire(&zt->batch) == NULL);
 
 	if (atomic_load_acquire(&zt->flush)) {
 		(void)dns_zt_apply(zt, false, NULL, flush, NULL);
@@ -517,13 +598,20 @@ dns_zt_apply(dns_zt_t *zt, bool stop, isc_result_t *sub,
 	isc_result_t tresult = ISC_R_SUCCESS;
 	dns_qpiter_t qpi;
 	dns_qpread_t qpr;
+	dns_qpreadable_t reader = { .qpr = &qpr };
+	dns_qp_t *batch = NULL;
 	void *zone = NULL;
 
 	REQUIRE(VALID_ZT(zt));
 	REQUIRE(action != NULL);
 
-	dns_qpmulti_query(zt->multi, &qpr);
-	dns_qpiter_init(&qpr, &qpi);
+	batch = getbatch(zt);
+	if (batch != NULL) {
+		reader.qpt = batch;
+	} else {
+		dns_qpmulti_query(zt->multi, &qpr);
+	}
+	dns_qpiter_init(reader, &qpi);
 
 	while (dns_qpiter_next(&qpi, NULL, &zone, NULL) == ISC_R_SUCCESS) {
 		result = action(zone, uap);
@@ -534,7 +622,9 @@ dns_zt_apply(dns_zt_t *zt, bool stop, isc_result_t *sub,
 			break;
 		}
 	}
-	dns_qpread_destroy(zt->multi, &qpr);
+	if (batch == NULL) {
+		dns_qpread_destroy(zt->multi, &qpr);
+	}
 
 	SET_IF_NOT_NULL(sub, tresult);
 
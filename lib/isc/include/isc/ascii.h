@@ -117,6 +117,28 @@ isc_ascii_tolower4(uint32_t octets) {
 	return (octets | (is_upper >> 2));
 }
 
+/*
+ * Return a word with the top bit set in each byte of `octets` that is
+ * equal to `c`, and every other bit clear. Unlike the classic "has a
+ * zero byte" trick this has no false positives, so the lowest set bit
+ * of a little-endian word locates the first match.
+ */
+static inline uint64_t
+isc_ascii_match8(uint64_t octets, uint8_t c) {
+	uint64_t all_bytes = 0x0101010101010101;
+	/*
+	 * Bytes equal to `c` become zero
+	 */
+	uint64_t diff = octets ^ (c * all_bytes);
+	/*
+	 * Set the top bit of each non-zero byte; the addition cannot carry
+	 * into the next byte because the top bits were cleared first
+	 */
+	uint64_t nonzero = ((diff & (0x7F * all_bytes)) + 0x7F * all_bytes) |
+			   diff;
+	return (~nonzero & (0x80 * all_bytes));
+}
+
 /*
  * Helper function to do an unaligned load of 8 bytes in host byte order
  */
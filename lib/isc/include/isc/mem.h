@@ -303,6 +303,20 @@ isc_mem_inuse(isc_mem_t *mctx);
  * allocated from the system but not yet used.
  */
 
+void
+isc_mem_charge(isc_mem_t *mctx, size_t size);
+void
+isc_mem_uncharge(isc_mem_t *mctx, size_t size);
+/*%<
+ * Add 'size' bytes to, or remove them from, the memory in use by
+ * 'mctx', for memory that its user obtained elsewhere (for instance
+ * with mmap()).  Charged memory counts towards isc_mem_inuse() and the
+ * water marks, and must be uncharged before 'mctx' is destroyed.
+ *
+ * Requires:
+ *\li	'size' does not exceed the memory in use, for isc_mem_uncharge().
+ */
+
 bool
 isc_mem_isovermem(isc_mem_t *mctx);
 /*%<
@@ -199,6 +199,17 @@ isc_tls_free(isc_tls_t **tlsp);
  *\li	'tlsp' != NULL and '*tlsp' != NULL.
  */
 
+void
+isc_tls_handshake_done(isc_tls_t *tls);
+/*%<
+ * Account for the completed handshake on 'tls': if the session was
+ * resumed with a ticket decrypted by a TLS session ticket keys manager
+ * object, increment its 'resumed' counter.
+ *
+ * Requires:
+ *\li	'tls' != NULL.
+ */
+
 const char *
 isc_tls_verify_peer_result_string(isc_tls_t *tls);
 /*%<
@@ -453,6 +464,127 @@ isc_tlsctx_client_session_cache_getctx(isc_tlsctx_client_session_cache_t *cache)
  * too big to avoid keeping too much obsolete sessions.
  */
 
+typedef struct isc_tlsctx_ticket_keys isc_tlsctx_ticket_keys_t;
+/*%<
+ * TLS session ticket keys manager is an object which holds the keys
+ * used to encrypt and decrypt stateless TLS session tickets issued by
+ * the server side contexts.
+ *
+ * By default, OpenSSL generates a random ticket key for every server
+ * side TLS context. That means that a ticket issued by one listener
+ * cannot be used to resume a session on another one (e.g. an IPv4
+ * versus an IPv6 endpoint), and that all the previously issued
+ * tickets become useless whenever the contexts are recreated, e.g.
+ * on reconfiguration. In both cases clients have to do full
+ * handshakes.
+ *
+ * The object is intended to be shared by all server side TLS contexts
+ * (and, thus, all the loops and listeners using them) and to outlive
+ * the contexts. The keys get rotated periodically: new tickets are
+ * always encrypted with the current key, while the tickets encrypted
+ * with the previous key are still accepted (and renewed) for one more
+ * rotation interval.
+ */
+
+void
+isc_tlsctx_ticket_keys_create(isc_mem_t *mctx, const uint32_t interval,
+			      isc_tlsctx_ticket_keys_t **keysp);
+/*%<
+ * Create a new TLS session ticket keys manager object. The keys are
+ * rotated every 'interval' seconds.
+ *
+ * Requires:
+ *\li	'mctx' is a valid memory context object;
+ *\li	'interval' is a positive number;
+ *\li	'keysp' is a valid pointer to a pointer which must be equal to NULL.
+ */
+
+void
+isc_tlsctx_ticket_keys_attach(isc_tlsctx_ticket_keys_t  *source,
+			      isc_tlsctx_ticket_keys_t **targetp);
+/*%<
+ * Create a reference to the TLS session ticket keys manager object.
+ *
+ * Requires:
+ *\li	'source' is a valid TLS session ticket keys manager object;
+ *\li	'targetp' is a valid pointer to a pointer which must equal NULL.
+ */
+
+void
+isc_tlsctx_ticket_keys_detach(isc_tlsctx_ticket_keys_t **keysp);
+/*%<
+ * Remove a reference to the TLS session ticket keys manager object.
+ *
+ * Requires:
+ *\li	'keysp' is a pointer to a pointer to a valid TLS session ticket
+ *	keys manager object.
+ */
+
+/*%
+ * TLS session ticket statistics counters.
+ */
+enum {
+	isc_tlsticketcounter_issued = 0,
+	isc_tlsticketcounter_resumed = 1,
+	isc_tlsticketcounter_unknownkey = 2,
+
+	isc_tlsticketcounter_max = 3,
+};
+
+void
+isc_tlsctx_ticket_keys_getstats(isc_tlsctx_ticket_keys_t *keys,
+				isc_stats_t		**statsp);
+/*%<
+ * Attach to the statistics counters of the TLS session ticket keys
+ * manager object: the number of the tickets issued, the number of the
+ * sessions resumed using a ticket, and the number of the tickets which
+ * could not be used because they were encrypted with an unknown (e.g.
+ * expired) key.
+ *
+ * Requires:
+ *\li	'keys' is a valid TLS session ticket keys manager object;
+ *\li	'statsp' is a valid pointer to a pointer which must equal NULL.
+ */
+
+void
+isc_tlsctx_ticket_keys_setinterval(isc_tlsctx_ticket_keys_t *keys,
+				   const uint32_t	     interval);
+/*%<
+ * Change the key rotation interval to 'interval' seconds. The new
+ * interval applies to the current key as well, and to the session
+ * timeout of the server side TLS contexts created afterwards.
+ *
+ * Requires:
+ *\li	'keys' is a valid TLS session ticket keys manager object;
+ *\li	'interval' is a positive number.
+ */
+
+void
+isc_tlsctx_ticket_keys_rotate(isc_tlsctx_ticket_keys_t *keys);
+/*%<
+ * Rotate the keys immediately: new tickets get encrypted with a freshly
+ * generated key, while the tickets encrypted with the current key are
+ * still accepted until the next rotation.
+ *
+ * Requires:
+ *\li	'keys' is a valid TLS session ticket keys manager object.
+ */
+
+void
+isc_tlsctx_set_ticket_keys(isc_tlsctx_t		    *ctx,
+			   isc_tlsctx_ticket_keys_t *keys);
+/*%<
+ * Make the server side TLS context 'ctx' use the session ticket keys
+ * from 'keys' instead of its own ones. The context keeps a reference
+ * to 'keys'. The session timeout of the context is set to the key
+ * rotation interval.
+ *
+ * Requires:
+ *\li	'ctx' is a valid, non-'NULL' server side TLS context which does
+ *	not use a TLS session ticket keys manager object yet;
+ *\li	'keys' is a valid TLS session ticket keys manager object.
+ */
+
 typedef struct isc_tlsctx_cache isc_tlsctx_cache_t;
 /*%<
  * The TLS context cache is an object which allows retrieving a
@@ -942,6 +942,20 @@ isc_mem_inuse(isc_mem_t *ctx) {
 	return (atomic_load_relaxed(&ctx->inuse));
 }
 
+void
+isc_mem_charge(isc_mem_t *ctx, size_t size) {
+	REQUIRE(VALID_CONTEXT(ctx));
+
+	mem_getstats(ctx, size);
+}
+
+void
+isc_mem_uncharge(isc_mem_t *ctx, size_t size) {
+	REQUIRE(VALID_CONTEXT(ctx));
+
+	mem_putstats(ctx, size);
+}
+
 void
 isc_mem_clearwater(isc_mem_t *mctx) {
 	isc_mem_setwater(mctx, 0, 0);
@@ -358,6 +358,12 @@ struct isc_nm {
 	atomic_int_fast32_t send_udp_buffer_size;
 	atomic_int_fast32_t recv_tcp_buffer_size;
 	atomic_int_fast32_t send_tcp_buffer_size;
+
+	/*
+	 * BIO method used to pass the outgoing TLS records directly
+	 * into the send requests (see tlsstream.c).
+	 */
+	BIO_METHOD *tls_bio_method;
 };
 
 /*%
@@ -527,6 +533,7 @@ struct isc_nmsocket {
 		size_t nsending;
 		bool tcp_nodelay_value;
 		isc_nmsocket_tls_send_req_t *send_req; /*%< Send req to reuse */
+		isc_nmsocket_tls_send_req_t *out_req;  /*%< Pending output */
 		bool reading;
 	} tlsstream;
 
@@ -958,6 +965,14 @@ isc__nm_tls_read_stop(isc_nmhandle_t *handle);
 void
 isc__nm_tls_cleanup_data(isc_nmsocket_t *sock);
 
+void
+isc__nm_tls_initialize(isc_nm_t *netmgr);
+void
+isc__nm_tls_shutdown(isc_nm_t *netmgr);
+/*%<
+ * Create and destroy the per-netmgr TLS stream resources.
+ */
+
 void
 isc__nm_tls_stoplistening(isc_nmsocket_t *sock);
 
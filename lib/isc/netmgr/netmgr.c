@@ -201,6 +201,8 @@ isc_netmgr_create(isc_mem_t *mctx, isc_loopmgr_t *loopmgr, isc_nm_t **netmgrp) {
 	atomic_init(&netmgr->keepalive, 30000);
 	atomic_init(&netmgr->advertised, 30000);
 
+	isc__nm_tls_initialize(netmgr);
+
 	netmgr->workers = isc_mem_cget(mctx, netmgr->nloops,
 				       sizeof(netmgr->workers[0]));
 
@@ -257,6 +259,8 @@ nm_destroy(isc_nm_t **mgr0) {
 		isc_stats_detach(&mgr->stats);
 	}
 
+	isc__nm_tls_shutdown(mgr);
+
 	isc_mem_cput(mgr->mctx, mgr->workers, mgr->nloops,
 		     sizeof(mgr->workers[0]));
 	isc_mem_putanddetach(&mgr->mctx, mgr, sizeof(*mgr));
@@ -162,6 +162,38 @@ tls_call_connect_cb(isc_nmsocket_t *sock, isc_nmhandle_t *handle,
 	}
 }
 
+static isc_nmsocket_tls_send_req_t *
+tls_get_send_req(isc_nmsocket_t *sock) {
+	isc_nmsocket_tls_send_req_t *send_req = NULL;
+
+	/* Try to reuse previously allocated object */
+	if (sock->tlsstream.send_req != NULL) {
+		send_req = sock->tlsstream.send_req;
+		sock->tlsstream.send_req = NULL;
+	} else {
+		send_req = isc_mem_get(sock->worker->mctx, sizeof(*send_req));
+		*send_req = (isc_nmsocket_tls_send_req_t){ .finish = false };
+		isc_buffer_init(&send_req->data, &send_req->smallbuf,
+				sizeof(send_req->smallbuf));
+		isc_buffer_setmctx(&send_req->data, sock->worker->mctx);
+	}
+	INSIST(isc_buffer_remaininglength(&send_req->data) == 0);
+
+	return (send_req);
+}
+
+static void
+tls_put_send_req(isc_nmsocket_t *sock,
+		 isc_nmsocket_tls_send_req_t **send_reqp) {
+	isc_nmsocket_tls_send_req_t *send_req = *send_reqp;
+
+	*send_reqp = NULL;
+
+	isc_buffer_clearmctx(&send_req->data);
+	isc_buffer_invalidate(&send_req->data);
+	isc_mem_put(sock->worker->mctx, send_req, sizeof(*send_req));
+}
+
 static void
 tls_senddone(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
 	isc_nmsocket_tls_send_req_t *send_req =
@@ -212,10 +244,7 @@ tls_senddone(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
 			isc_buffer_clear(&send_req->data);
 		}
 	} else {
-		isc_buffer_clearmctx(&send_req->data);
-		isc_buffer_invalidate(&send_req->data);
-		isc_mem_put(handle->sock->worker->mctx, send_req,
-			    sizeof(*send_req));
+		tls_put_send_req(tlssock, &send_req);
 	}
 	tlssock->tlsstream.nsending--;
 
@@ -348,14 +377,97 @@ async_tls_do_bio(isc_nmsocket_t *sock) {
 	isc_async_run(sock->worker->loop, tls_do_bio_cb, sock);
 }
 
+/*
+ * The outgoing BIO: instead of buffering the TLS records produced by
+ * OpenSSL in a memory BIO and then copying them once more into a send
+ * request, append them directly to the send request which is going to
+ * be passed to the underlying transport.
+ */
+static int
+tls_bio_write(BIO *bio, const char *data, int len) {
+	isc_nmsocket_t *sock = BIO_get_data(bio);
+
+	REQUIRE(VALID_NMSOCK(sock));
+
+	BIO_clear_retry_flags(bio);
+
+	if (len <= 0) {
+		return (0);
+	}
+
+	if (sock->tlsstream.out_req == NULL) {
+		sock->tlsstream.out_req = tls_get_send_req(sock);
+	}
+
+	isc_buffer_putmem(&sock->tlsstream.out_req->data,
+			  (const unsigned char *)data, (unsigned int)len);
+
+	return (len);
+}
+
+static long
+tls_bio_ctrl(BIO *bio, int cmd, long num, void *ptr) {
+	isc_nmsocket_t *sock = BIO_get_data(bio);
+
+	UNUSED(num);
+	UNUSED(ptr);
+
+	switch (cmd) {
+	case BIO_CTRL_FLUSH:
+		return (1);
+	case BIO_CTRL_WPENDING:
+		if (sock == NULL || sock->tlsstream.out_req == NULL) {
+			return (0);
+		}
+		return ((long)isc_buffer_usedlength(
+			&sock->tlsstream.out_req->data));
+	default:
+		return (0);
+	}
+}
+
+static int
+tls_bio_create(BIO *bio) {
+	BIO_set_init(bio, 1);
+	return (1);
+}
+
+static int
+tls_bio_destroy(BIO *bio) {
+	if (bio == NULL) {
+		return (0);
+	}
+
+	BIO_set_data(bio, NULL);
+	BIO_set_init(bio, 0);
+	return (1);
+}
+
+void
+isc__nm_tls_initialize(isc_nm_t *netmgr) {
+	BIO_METHOD *method = BIO_meth_new(
+		BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "isc_nm_tls");
+	RUNTIME_CHECK(method != NULL);
+
+	RUNTIME_CHECK(BIO_meth_set_write(method, tls_bio_write) == 1);
+	RUNTIME_CHECK(BIO_meth_set_ctrl(method, tls_bio_ctrl) == 1);
+	RUNTIME_CHECK(BIO_meth_set_create(method, tls_bio_create) == 1);
+	RUNTIME_CHECK(BIO_meth_set_destroy(method, tls_bio_destroy) == 1);
+
+	netmgr->tls_bio_method = method;
+}
+
+void
+isc__nm_tls_shutdown(isc_nm_t *netmgr) {
+	BIO_meth_free(netmgr->tls_bio_method);
+	netmgr->tls_bio_method = NULL;
+}
+
 static int
 tls_send_outgoing(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
 		  isc_nm_cb_t cb, void *cbarg) {
 	isc_nmsocket_tls_send_req_t *send_req = NULL;
 	int pending;
-	int rv;
-	size_t len = 0;
-	bool new_send_req = false;
 	isc_region_t used_region = { 0 };
 	bool shutting_down = isc__nm_closing(sock->worker);
 
@@ -374,29 +486,17 @@ tls_send_outgoing(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
 		tls_keep_client_tls_session(sock);
 	}
 
-	pending = BIO_pending(sock->tlsstream.bio_out);
-	if (pending <= 0) {
-		return (pending);
-	}
-
-	/* Try to reuse previously allocated object */
-	if (sock->tlsstream.send_req != NULL) {
-		send_req = sock->tlsstream.send_req;
-		send_req->finish = finish;
-		sock->tlsstream.send_req = NULL;
-	} else {
-		send_req = isc_mem_get(sock->worker->mctx, sizeof(*send_req));
-		*send_req = (isc_nmsocket_tls_send_req_t){ .finish = finish };
-		new_send_req = true;
+	/* The TLS records are collected in the send request by the BIO */
+	send_req = sock->tlsstream.out_req;
+	if (send_req == NULL) {
+		return (0);
 	}
+	sock->tlsstream.out_req = NULL;
 
-	if (new_send_req) {
-		isc_buffer_init(&send_req->data, &send_req->smallbuf,
-				sizeof(send_req->smallbuf));
-		isc_buffer_setmctx(&send_req->data, sock->worker->mctx);
-	}
-	INSIST(isc_buffer_remaininglength(&send_req->data) == 0);
+	pending = (int)isc_buffer_remaininglength(&send_req->data);
+	INSIST(pending > 0);
 
+	send_req->finish = finish;
 	isc__nmsocket_attach(sock, &send_req->tlssock);
 	if (cb != NULL) {
 		send_req->cb = cb;
@@ -404,14 +504,6 @@ tls_send_outgoing(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
 		isc_nmhandle_attach(tlshandle, &send_req->handle);
 	}
 
-	RUNTIME_CHECK(isc_buffer_reserve(&send_req->data, pending) ==
-		      ISC_R_SUCCESS);
-	isc_buffer_add(&send_req->data, pending);
-	rv = BIO_read_ex(sock->tlsstream.bio_out,
-			 isc_buffer_base(&send_req->data), pending, &len);
-	/* There's something pending, read must succeed */
-	RUNTIME_CHECK(rv == 1 && len == (size_t)pending);
-
 	INSIST(VALID_NMHANDLE(sock->outerhandle));
 
 	sock->tlsstream.nsending++;
@@ -463,6 +555,7 @@ tls_try_handshake(isc_nmsocket_t *sock, isc_result_t *presult) {
 		REQUIRE(sock->statichandle == NULL);
 		INSIST(SSL_is_init_finished(sock->tlsstream.tls) == 1);
 
+		isc_tls_handshake_done(sock->tlsstream.tls);
 		isc__nmsocket_log_tls_session_reuse(sock, sock->tlsstream.tls);
 		tlshandle = isc__nmhandle_get(sock, &sock->peer, &sock->iface);
 		tls_read_stop(sock);
@@ -849,7 +942,7 @@ initialize_tls(isc_nmsocket_t *sock, bool server) {
 		isc_tls_free(&sock->tlsstream.tls);
 		return (ISC_R_TLSERROR);
 	}
-	sock->tlsstream.bio_out = BIO_new(BIO_s_mem());
+	sock->tlsstream.bio_out = BIO_new(sock->worker->netmgr->tls_bio_method);
 	if (sock->tlsstream.bio_out == NULL) {
 		BIO_free_all(sock->tlsstream.bio_in);
 		sock->tlsstream.bio_in = NULL;
@@ -857,9 +950,9 @@ initialize_tls(isc_nmsocket_t *sock, bool server) {
 		return (ISC_R_TLSERROR);
 	}
 
-	if (BIO_set_mem_eof_return(sock->tlsstream.bio_in, EOF) != 1 ||
-	    BIO_set_mem_eof_return(sock->tlsstream.bio_out, EOF) != 1)
-	{
+	BIO_set_data(sock->tlsstream.bio_out, sock);
+
+	if (BIO_set_mem_eof_return(sock->tlsstream.bio_in, EOF) != 1) {
 		goto error;
 	}
 
@@ -1336,11 +1429,10 @@ isc__nm_tls_cleanup_data(isc_nmsocket_t *sock) {
 		}
 
 		if (sock->tlsstream.send_req != NULL) {
-			isc_buffer_clearmctx(&sock->tlsstream.send_req->data);
-			isc_buffer_invalidate(&sock->tlsstream.send_req->data);
-			isc_mem_put(sock->worker->mctx,
-				    sock->tlsstream.send_req,
-				    sizeof(*sock->tlsstream.send_req));
+			tls_put_send_req(sock, &sock->tlsstream.send_req);
+		}
+		if (sock->tlsstream.out_req != NULL) {
+			tls_put_send_req(sock, &sock->tlsstream.out_req);
 		}
 	} else if ((sock->type == isc_nm_tcpsocket ||
 		    sock->type == isc_nm_proxystreamsocket) &&
@@ -27,11 +27,16 @@
 #include <openssl/dh.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/opensslv.h>
 #include <openssl/rand.h>
 #include <openssl/rsa.h>
 #include <openssl/x509_vfy.h>
 #include <openssl/x509v3.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif /* OPENSSL_VERSION_NUMBER >= 0x30000000L */
 
 #include <isc/atomic.h>
 #include <isc/ht.h>
@@ -44,7 +49,10 @@
 #include <isc/random.h>
 #include <isc/refcount.h>
 #include <isc/rwlock.h>
+#include <isc/safe.h>
 #include <isc/sockaddr.h>
+#include <isc/stats.h>
+#include <isc/stdtime.h>
 #include <isc/thread.h>
 #include <isc/tls.h>
 #include <isc/util.h>
@@ -56,6 +64,13 @@
 
 static isc_mem_t *isc__tls_mctx = NULL;
 
+static int ticket_keys_ex_index = -1;
+static int ticket_used_ex_index = -1;
+
+static void
+ticket_keys_ex_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx,
+		    long argl, void *argp);
+
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 static isc_mutex_t *locks = NULL;
 static int nlocks;
@@ -204,6 +219,13 @@ isc__tls_initialize(void) {
 			    "cannot be initialized (see the `PRNG not "
 			    "seeded' message in the OpenSSL FAQ)");
 	}
+
+	ticket_keys_ex_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL,
+							ticket_keys_ex_free);
+	RUNTIME_CHECK(ticket_keys_ex_index >= 0);
+	ticket_used_ex_index = SSL_get_ex_new_index(0, NULL, NULL, NULL,
+						    NULL);
+	RUNTIME_CHECK(ticket_used_ex_index >= 0);
 }
 
 void
@@ -1778,6 +1800,359 @@ isc_tlsctx_client_session_cache_getctx(
 	return (cache->ctx);
 }
 
+#define TLSCTX_TICKET_KEYS_MAGIC    ISC_MAGIC('T', 'l', 'T', 'k')
+#define VALID_TLSCTX_TICKET_KEYS(t) ISC_MAGIC_VALID(t, TLSCTX_TICKET_KEYS_MAGIC)
+
+#define TICKET_KEY_NAME_LEN 16
+#define TICKET_KEY_AES_LEN  32
+#define TICKET_KEY_HMAC_LEN 32
+
+typedef struct ticket_key {
+	unsigned char name[TICKET_KEY_NAME_LEN];
+	unsigned char aes_key[TICKET_KEY_AES_LEN];
+	unsigned char hmac_key[TICKET_KEY_HMAC_LEN];
+	isc_stdtime_t created;
+} ticket_key_t;
+
+struct isc_tlsctx_ticket_keys {
+	uint32_t magic;
+	isc_refcount_t references;
+	isc_mem_t *mctx;
+
+	uint32_t interval;
+
+	/*
+	 * The current key (used to encrypt new tickets) is always the
+	 * first one, the previous key (if any) - the second one.
+	 */
+	isc_rwlock_t rwlock;
+	ticket_key_t keys[2];
+	size_t nkeys;
+
+	isc_stats_t *stats;
+};
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+typedef EVP_MAC_CTX ticket_hmac_ctx_t;
+#else
+typedef HMAC_CTX ticket_hmac_ctx_t;
+#endif /* OPENSSL_VERSION_NUMBER >= 0x30000000L */
+
+static void
+ticket_key_generate(ticket_key_t *key, const isc_stdtime_t now) {
+	RUNTIME_CHECK(RAND_bytes(key->name, sizeof(key->name)) == 1);
+	RUNTIME_CHECK(RAND_bytes(key->aes_key, sizeof(key->aes_key)) == 1);
+	RUNTIME_CHECK(RAND_bytes(key->hmac_key, sizeof(key->hmac_key)) == 1);
+	key->created = now;
+}
+
+void
+isc_tlsctx_ticket_keys_create(isc_mem_t *mctx, const uint32_t interval,
+			      isc_tlsctx_ticket_keys_t **keysp) {
+	isc_tlsctx_ticket_keys_t *keys = NULL;
+
+	REQUIRE(interval > 0);
+	REQUIRE(keysp != NULL && *keysp == NULL);
+
+	keys = isc_mem_get(mctx, sizeof(*keys));
+	*keys = (isc_tlsctx_ticket_keys_t){ .interval = interval, .nkeys = 1 };
+
+	isc_refcount_init(&keys->references, 1);
+	isc_mem_attach(mctx, &keys->mctx);
+	isc_rwlock_init(&keys->rwlock);
+	isc_stats_create(mctx, &keys->stats, isc_tlsticketcounter_max);
+
+	ticket_key_generate(&keys->keys[0], isc_stdtime_now());
+
+	keys->magic = TLSCTX_TICKET_KEYS_MAGIC;
+
+	*keysp = keys;
+}
+
+void
+isc_tlsctx_ticket_keys_attach(isc_tlsctx_ticket_keys_t *source,
+			      isc_tlsctx_ticket_keys_t **targetp) {
+	REQUIRE(VALID_TLSCTX_TICKET_KEYS(source));
+	REQUIRE(targetp != NULL && *targetp == NULL);
+
+	isc_refcount_increment(&source->references);
+
+	*targetp = source;
+}
+
+void
+isc_tlsctx_ticket_keys_detach(isc_tlsctx_ticket_keys_t **keysp) {
+	isc_tlsctx_ticket_keys_t *keys = NULL;
+
+	REQUIRE(keysp != NULL);
+
+	keys = *keysp;
+	*keysp = NULL;
+
+	REQUIRE(VALID_TLSCTX_TICKET_KEYS(keys));
+
+	if (isc_refcount_decrement(&keys->references) != 1) {
+		return;
+	}
+
+	keys->magic = 0;
+
+	isc_refcount_destroy(&keys->references);
+	isc_rwlock_destroy(&keys->rwlock);
+	isc_stats_detach(&keys->stats);
+	isc_safe_memwipe(keys->keys, sizeof(keys->keys));
+	isc_mem_putanddetach(&keys->mctx, keys, sizeof(*keys));
+}
+
+void
+isc_tlsctx_ticket_keys_getstats(isc_tlsctx_ticket_keys_t *keys,
+				isc_stats_t **statsp) {
+	REQUIRE(VALID_TLSCTX_TICKET_KEYS(keys));
+	REQUIRE(statsp != NULL && *statsp == NULL);
+
+	isc_stats_attach(keys->stats, statsp);
+}
+
+void
+isc_tlsctx_ticket_keys_setinterval(isc_tlsctx_ticket_keys_t *keys,
+				   const uint32_t interval) {
+	REQUIRE(VALID_TLSCTX_TICKET_KEYS(keys));
+	REQUIRE(interval > 0);
+
+	RWLOCK(&keys->rwlock, isc_rwlocktype_write);
+	keys->interval = interval;
+	RWUNLOCK(&keys->rwlock, isc_rwlocktype_write);
+}
+
+static void
+ticket_keys_ex_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx,
+		    long argl, void *argp) {
+	isc_tlsctx_ticket_keys_t *keys = (isc_tlsctx_ticket_keys_t *)ptr;
+
+	UNUSED(parent);
+	UNUSED(ad);
+	UNUSED(idx);
+	UNUSED(argl);
+	UNUSED(argp);
+
+	if (keys != NULL) {
+		isc_tlsctx_ticket_keys_detach(&keys);
+	}
+}
+
+/*
+ * Rotate the keys if the current one is too old, or unconditionally if
+ * 'force' is set. The previous key is kept only if it has not expired
+ * yet, that is, if the current key is less than two rotation intervals
+ * old.
+ */
+static void
+ticket_keys_rotate(isc_tlsctx_ticket_keys_t *keys, const isc_stdtime_t now,
+		   const bool force) {
+	bool rotated = false;
+
+	RWLOCK(&keys->rwlock, isc_rwlocktype_write);
+	if (force || now - keys->keys[0].created >= keys->interval) {
+		if (now - keys->keys[0].created < 2 * keys->interval) {
+			keys->keys[1] = keys->keys[0];
+			keys->nkeys = 2;
+		} else {
+			keys->nkeys = 1;
+		}
+		ticket_key_generate(&keys->keys[0], now);
+		rotated = true;
+	}
+	RWUNLOCK(&keys->rwlock, isc_rwlocktype_write);
+
+	if (rotated) {
+		isc_stats_t *stats = keys->stats;
+
+		isc_log_write(
+			isc_lctx, ISC_LOGCATEGORY_GENERAL, ISC_LOGMODULE_NETMGR,
+			ISC_LOG_INFO,
+			"TLS session ticket key rotated (tickets issued: "
+			"%" PRIu64 ", resumed: %" PRIu64
+			", unknown key: %" PRIu64 ")",
+			(uint64_t)isc_stats_get_counter(
+				stats, isc_tlsticketcounter_issued),
+			(uint64_t)isc_stats_get_counter(
+				stats, isc_tlsticketcounter_resumed),
+			(uint64_t)isc_stats_get_counter(
+				stats, isc_tlsticketcounter_unknownkey));
+	}
+}
+
+void
+isc_tlsctx_ticket_keys_rotate(isc_tlsctx_ticket_keys_t *keys) {
+	REQUIRE(VALID_TLSCTX_TICKET_KEYS(keys));
+
+	ticket_keys_rotate(keys, isc_stdtime_now(), true);
+}
+
+/*
+ * Find the key to use. When encrypting, it is always the current key.
+ * When decrypting, it is the key with the name from the ticket. Returns
+ * the index of the key or -1 if the key has not been found.
+ */
+static int
+ticket_keys_find(isc_tlsctx_ticket_keys_t *keys, const bool encrypt,
+		 const unsigned char *name, ticket_key_t *key) {
+	const isc_stdtime_t now = isc_stdtime_now();
+	bool expired = false;
+	int found = -1;
+
+	RWLOCK(&keys->rwlock, isc_rwlocktype_read);
+	expired = (now - keys->keys[0].created >= keys->interval);
+	RWUNLOCK(&keys->rwlock, isc_rwlocktype_read);
+
+	if (expired) {
+		ticket_keys_rotate(keys, now, false);
+	}
+
+	RWLOCK(&keys->rwlock, isc_rwlocktype_read);
+	for (size_t i = 0; i < keys->nkeys; i++) {
+		if (encrypt || memcmp(keys->keys[i].name, name,
+				      sizeof(keys->keys[i].name)) == 0)
+		{
+			*key = keys->keys[i];
+			found = (int)i;
+			break;
+		}
+	}
+	RWUNLOCK(&keys->rwlock, isc_rwlocktype_read);
+
+	return (found);
+}
+
+static int
+ticket_hmac_init(ticket_hmac_ctx_t *hctx, unsigned char *hmac_key) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM params[3];
+
+	params[0] = OSSL_PARAM_construct_octet_string(
+		OSSL_MAC_PARAM_KEY, hmac_key, TICKET_KEY_HMAC_LEN);
+	params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+						     (char *)"SHA256", 0);
+	params[2] = OSSL_PARAM_construct_end();
+
+	return (EVP_MAC_CTX_set_params(hctx, params));
+#else
+	return (HMAC_Init_ex(hctx, hmac_key, TICKET_KEY_HMAC_LEN, EVP_sha256(),
+			     NULL));
+#endif /* OPENSSL_VERSION_NUMBER >= 0x30000000L */
+}
+
+/*
+ * See the OpenSSL documentation for SSL_CTX_set_tlsext_ticket_key_cb()
+ * for the meaning of the arguments and the return values.
+ */
+static int
+ticket_keys_cb(isc_tls_t *tls, unsigned char *key_name, unsigned char *iv,
+	       EVP_CIPHER_CTX *cctx, ticket_hmac_ctx_t *hctx, int enc) {
+	isc_tlsctx_ticket_keys_t *keys = NULL;
+	const EVP_CIPHER *cipher = EVP_aes_256_cbc();
+	ticket_key_t key;
+	int found;
+	int ret = -1;
+
+	keys = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(tls), ticket_keys_ex_index);
+	if (keys == NULL) {
+		return (-1);
+	}
+
+	INSIST(VALID_TLSCTX_TICKET_KEYS(keys));
+
+	found = ticket_keys_find(keys, enc == 1, key_name, &key);
+	if (found < 0) {
+		/* The key is unknown or has expired: do a full handshake */
+		isc_stats_increment(keys->stats,
+				    isc_tlsticketcounter_unknownkey);
+		return (0);
+	}
+
+	if (enc == 1) {
+		if (RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) != 1) {
+			goto cleanup;
+		}
+		memmove(key_name, key.name, sizeof(key.name));
+		if (EVP_EncryptInit_ex(cctx, cipher, NULL, key.aes_key, iv) !=
+			    1 ||
+		    ticket_hmac_init(hctx, key.hmac_key) != 1)
+		{
+			goto cleanup;
+		}
+		isc_stats_increment(keys->stats, isc_tlsticketcounter_issued);
+		ret = 1;
+	} else {
+		if (EVP_DecryptInit_ex(cctx, cipher, NULL, key.aes_key, iv) !=
+			    1 ||
+		    ticket_hmac_init(hctx, key.hmac_key) != 1)
+		{
+			goto cleanup;
+		}
+		/* Counted in isc_tls_handshake_done() if it is accepted */
+		(void)SSL_set_ex_data(tls, ticket_used_ex_index, keys);
+		/* Ask for a ticket renewal if the previous key was used */
+		ret = (found == 0) ? 1 : 2;
+	}
+
+cleanup:
+	isc_safe_memwipe(&key, sizeof(key));
+	return (ret);
+}
+
+void
+isc_tls_handshake_done(isc_tls_t *tls) {
+	isc_tlsctx_ticket_keys_t *keys = NULL;
+
+	REQUIRE(tls != NULL);
+
+	/*
+	 * The ticket is only known to be good once the handshake using it
+	 * has completed: OpenSSL checks its HMAC after the ticket key
+	 * callback has returned.
+	 */
+	keys = SSL_get_ex_data(tls, ticket_used_ex_index);
+	if (keys == NULL) {
+		return;
+	}
+	(void)SSL_set_ex_data(tls, ticket_used_ex_index, NULL);
+
+	if (SSL_session_reused(tls) == 1) {
+		isc_stats_increment(keys->stats, isc_tlsticketcounter_resumed);
+	}
+}
+
+void
+isc_tlsctx_set_ticket_keys(isc_tlsctx_t *ctx, isc_tlsctx_ticket_keys_t *keys) {
+	isc_tlsctx_ticket_keys_t *ref = NULL;
+
+	REQUIRE(ctx != NULL);
+	REQUIRE(VALID_TLSCTX_TICKET_KEYS(keys));
+	REQUIRE(SSL_CTX_get_ex_data(ctx, ticket_keys_ex_index) == NULL);
+
+	isc_tlsctx_ticket_keys_attach(keys, &ref);
+	RUNTIME_CHECK(SSL_CTX_set_ex_data(ctx, ticket_keys_ex_index, ref) ==
+		      1);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	RUNTIME_CHECK(SSL_CTX_set_tlsext_ticket_key_evp_cb(
+			      ctx, ticket_keys_cb) == 1);
+#else
+	RUNTIME_CHECK(SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticket_keys_cb) ==
+		      1);
+#endif /* OPENSSL_VERSION_NUMBER >= 0x30000000L */
+
+	/*
+	 * A ticket encrypted with the previous key remains decryptable for
+	 * at least one rotation interval, so let the sessions live that
+	 * long.
+	 */
+	RWLOCK(&keys->rwlock, isc_rwlocktype_read);
+	(void)SSL_CTX_set_timeout(ctx, keys->interval);
+	RWUNLOCK(&keys->rwlock, isc_rwlocktype_read);
+}
+
 void
 isc_tlsctx_set_random_session_id_context(isc_tlsctx_t *ctx) {
 	uint8_t session_id_ctx[SSL_MAX_SID_CTX_LENGTH] = { 0 };
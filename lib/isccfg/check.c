@@ -1331,6 +1331,16 @@ check_options(const cfg_obj_t *options, const cfg_obj_t *config,
 		if (tresult != ISC_R_SUCCESS) {
 			result = tresult;
 		}
+
+		obj = NULL;
+		(void)cfg_map_get(options, "tls-session-ticket-key-lifetime",
+				  &obj);
+		if (obj != NULL && cfg_obj_asduration(obj) == 0) {
+			cfg_obj_log(obj, logctx, ISC_LOG_ERROR,
+				    "'tls-session-ticket-key-lifetime' must be "
+				    "greater than zero");
+			result = ISC_R_RANGE;
+		}
 	}
 
 	if (optlevel == optlevel_options || optlevel == optlevel_view) {
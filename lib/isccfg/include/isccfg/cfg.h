@@ -121,6 +121,21 @@ cfg_parser_setcallback(cfg_parser_t *pctx, cfg_parsecallback_t callback,
  * callback==NULL and arg==NULL.
  */
 
+void
+cfg_parser_setdirectory(cfg_parser_t *pctx, const char *directory);
+/*%<
+ * Resolve relative file names in "include" statements parsed from now
+ * on against 'directory' rather than the current working directory.
+ * This lets a "directory" callback take effect on the rest of the
+ * configuration without changing the working directory of the process.
+ * A relative 'directory' is itself relative to the current working
+ * directory.
+ *
+ * Requires:
+ *\li 	"pctx" is not NULL.
+ *\li 	"directory" is not NULL.
+ */
+
 isc_result_t
 cfg_parse_file(cfg_parser_t *pctx, const char *file, const cfg_type_t *type,
 	       cfg_obj_t **ret);
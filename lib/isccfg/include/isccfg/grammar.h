@@ -255,6 +255,12 @@ struct cfg_parser {
 
 	cfg_parsecallback_t callback;
 	void		   *callbackarg;
+
+	/*%
+	 * Directory that relative "include" file names are
+	 * resolved against, if not NULL.
+	 */
+	char *directory;
 };
 
 /* Parser context flags */
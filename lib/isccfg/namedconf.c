@@ -1243,6 +1243,12 @@ static cfg_type_t cfg_type_fstrm_model = {
 	cfg_doc_enum, &cfg_rep_string, &fstrm_model_enums
 };
 
+static const char *dnstap_samplemode_enums[] = { "message", "client", NULL };
+static cfg_type_t cfg_type_dnstap_samplemode = {
+	"samplemode", cfg_parse_enum,  cfg_print_ustring,
+	cfg_doc_enum, &cfg_rep_string, &dnstap_samplemode_enums
+};
+
 /*%
  * Clauses that can be found within the 'options' statement.
  */
@@ -1269,11 +1275,17 @@ static cfg_clausedef_t options_clauses[] = {
 #ifdef HAVE_DNSTAP
 	{ "dnstap-output", &cfg_type_dnstapoutput, 0 },
 	{ "dnstap-identity", &cfg_type_serverid, 0 },
+	{ "dnstap-sample-mode", &cfg_type_dnstap_samplemode, 0 },
+	{ "dnstap-sample-rate", &cfg_type_uint32, 0 },
 	{ "dnstap-version", &cfg_type_qstringornone, 0 },
 #else  /* ifdef HAVE_DNSTAP */
 	{ "dnstap-output", &cfg_type_dnstapoutput,
 	  CFG_CLAUSEFLAG_NOTCONFIGURED },
 	{ "dnstap-identity", &cfg_type_serverid, CFG_CLAUSEFLAG_NOTCONFIGURED },
+	{ "dnstap-sample-mode", &cfg_type_dnstap_samplemode,
+	  CFG_CLAUSEFLAG_NOTCONFIGURED },
+	{ "dnstap-sample-rate", &cfg_type_uint32,
+	  CFG_CLAUSEFLAG_NOTCONFIGURED },
 	{ "dnstap-version", &cfg_type_qstringornone,
 	  CFG_CLAUSEFLAG_NOTCONFIGURED },
 #endif /* ifdef HAVE_DNSTAP */
@@ -1356,6 +1368,7 @@ static cfg_clausedef_t options_clauses[] = {
 	{ "reserved-sockets", &cfg_type_uint32, CFG_CLAUSEFLAG_ANCIENT },
 	{ "secroots-file", &cfg_type_qstring, 0 },
 	{ "serial-queries", NULL, CFG_CLAUSEFLAG_ANCIENT },
+	{ "serial-query-batch", &cfg_type_uint32, 0 },
 	{ "serial-query-rate", &cfg_type_uint32, 0 },
 	{ "server-id", &cfg_type_serverid, 0 },
 	{ "session-keyalg", &cfg_type_astring, 0 },
@@ -1378,6 +1391,9 @@ static cfg_clausedef_t options_clauses[] = {
 	{ "tkey-domain", &cfg_type_qstring, 0 },
 	{ "tkey-gssapi-credential", &cfg_type_qstring, 0 },
 	{ "tkey-gssapi-keytab", &cfg_type_qstring, 0 },
+	{ "tls-session-ticket-key-lifetime", &cfg_type_duration, 0 },
+	{ "transfer-cache-entries", &cfg_type_uint32, 0 },
+	{ "transfer-cache-size", &cfg_type_sizeval, 0 },
 	{ "transfer-message-size", &cfg_type_uint32, 0 },
 	{ "transfers-in", &cfg_type_uint32, 0 },
 	{ "transfers-out", &cfg_type_uint32, 0 },
@@ -524,6 +524,7 @@ cfg_parser_create(isc_mem_t *mctx, isc_log_t *lctx, cfg_parser_t **ret) {
 	pctx->line = 0;
 	pctx->callback = NULL;
 	pctx->callbackarg = NULL;
+	pctx->directory = NULL;
 	pctx->token.type = isc_tokentype_unknown;
 	pctx->flags = 0;
 	pctx->buf_name = NULL;
@@ -603,6 +604,17 @@ cfg_parser_setcallback(cfg_parser_t *pctx, cfg_parsecallback_t callback,
 	pctx->callbackarg = arg;
 }
 
+void
+cfg_parser_setdirectory(cfg_parser_t *pctx, const char *directory) {
+	REQUIRE(pctx != NULL);
+	REQUIRE(directory != NULL);
+
+	if (pctx->directory != NULL) {
+		isc_mem_free(pctx->mctx, pctx->directory);
+	}
+	pctx->directory = isc_mem_strdup(pctx->mctx, directory);
+}
+
 void
 cfg_parser_reset(cfg_parser_t *pctx) {
 	REQUIRE(pctx != NULL);
@@ -733,6 +745,9 @@ cfg_parser_destroy(cfg_parser_t **pctxp) {
 		 */
 		CLEANUP_OBJ(pctx->open_files);
 		CLEANUP_OBJ(pctx->closed_files);
+		if (pctx->directory != NULL) {
+			isc_mem_free(pctx->mctx, pctx->directory);
+		}
 		isc_mem_putanddetach(&pctx->mctx, pctx, sizeof(*pctx));
 	}
 }
@@ -2257,6 +2272,8 @@ cfg_parse_mapbody(cfg_parser_t *pctx, const cfg_type_t *type, cfg_obj_t **ret) {
 		 * clause can occur.
 		 */
 		if (strcasecmp(TOKEN_STRING(pctx), "include") == 0) {
+			char pattern[PATH_MAX];
+			const char *dir = "", *sep = "";
 			glob_t g;
 			int rc;
 
@@ -2273,12 +2290,27 @@ cfg_parse_mapbody(cfg_parser_t *pctx, const cfg_type_t *type, cfg_obj_t **ret) {
 				CHECK(ISC_R_FILENOTFOUND);
 			}
 
+			/*
+			 * Relative names are resolved against the directory
+			 * set by cfg_parser_setdirectory(), if any.
+			 */
+			if (pctx->directory != NULL &&
+			    cfg_obj_asstring(includename)[0] != '/')
+			{
+				dir = pctx->directory;
+				sep = "/";
+			}
+			rc = snprintf(pattern, sizeof(pattern), "%s%s%s", dir,
+				      sep, cfg_obj_asstring(includename));
+			if (rc < 0 || (size_t)rc >= sizeof(pattern)) {
+				CHECK(ISC_R_NOSPACE);
+			}
+
 			/*
 			 * Allow include to specify a pattern that follows
 			 * the same rules as the shell e.g "/path/zone*.conf"
 			 */
-			rc = glob(cfg_obj_asstring(includename), GLOB_ERR, NULL,
-				  &g);
+			rc = glob(pattern, GLOB_ERR, NULL, &g);
 
 			switch (rc) {
 			case 0:
@@ -98,6 +98,13 @@
 #define COOKIE_SIZE 24U /* 8 + 4 + 4 + 8 */
 #define ECS_SIZE    20U /* 2 + 1 + 1 + [0..16] */
 
+/*%
+ * Size of each name buffer.  The first one is kept for the lifetime
+ * of the client and cleared between requests, so it should be large
+ * enough to hold all the names needed by a typical response.
+ */
+#define NAMEBUF_SIZE 4096
+
 #define WANTNSID(x)	(((x)->attributes & NS_CLIENTATTR_WANTNSID) != 0)
 #define WANTEXPIRE(x)	(((x)->attributes & NS_CLIENTATTR_WANTEXPIRE) != 0)
 #define WANTPAD(x)	(((x)->attributes & NS_CLIENTATTR_WANTPAD) != 0)
@@ -123,7 +130,6 @@ static void
 compute_cookie(ns_client_t *client, uint32_t when, const unsigned char *secret,
 	       isc_buffer_t *buf);
 
-#ifdef HAVE_DNSTAP
 static dns_transport_type_t
 ns_client_transport_type(const ns_client_t *client) {
 	/*
@@ -168,7 +174,40 @@ ns_client_transport_type(const ns_client_t *client) {
 
 	return DNS_TRANSPORT_UDP;
 }
-#endif /* HAVE_DNSTAP */
+
+static ns_rcodehisto_t
+rcodehisto(dns_rcode_t rcode) {
+	switch (rcode) {
+	case dns_rcode_noerror:
+		return (ns_rcodehisto_noerror);
+	case dns_rcode_nxdomain:
+		return (ns_rcodehisto_nxdomain);
+	case dns_rcode_servfail:
+		return (ns_rcodehisto_servfail);
+	case dns_rcode_refused:
+		return (ns_rcodehisto_refused);
+	default:
+		return (ns_rcodehisto_other);
+	}
+}
+
+/*%
+ * Record the latency and the size of a response that is about to be
+ * sent.  The latency is measured up to 'client->tnow', which is
+ * refreshed whenever query processing resumes after a fetch.
+ */
+static void
+client_histostats(ns_client_t *client, dns_rcode_t rcode, size_t respsize) {
+	ns_server_t *sctx = client->manager->sctx;
+	dns_transport_type_t transport = ns_client_transport_type(client);
+	uint64_t latency = isc_time_microdiff(&client->tnow,
+					      &client->requesttime);
+
+	isc_histomulti_inc(sctx->latencystats[transport], latency);
+	isc_histomulti_inc(sctx->respsizestats[transport], respsize);
+	isc_histomulti_inc(sctx->rcodelatencystats[rcodehisto(rcode)],
+			   latency);
+}
 
 void
 ns_client_recursing(ns_client_t *client) {
@@ -407,13 +446,15 @@ client_allocsendbuf(ns_client_t *client, isc_buffer_t *buffer,
 }
 
 static void
-client_sendpkg(ns_client_t *client, isc_buffer_t *buffer) {
+client_sendpkg(ns_client_t *client, dns_rcode_t rcode, isc_buffer_t *buffer) {
 	isc_result_t result;
 	isc_region_t r;
 	dns_ttl_t min_ttl = 0;
 
 	REQUIRE(client->sendhandle == NULL);
 
+	client_histostats(client, rcode, isc_buffer_usedlength(buffer));
+
 	if (isc_buffer_base(buffer) == client->tcpbuf) {
 		size_t used = isc_buffer_usedlength(buffer);
 		client->tcpbuf = isc_mem_creget(
@@ -493,7 +534,7 @@ ns_client_sendraw(ns_client_t *client, dns_message_t *message) {
 	}
 #endif
 
-	client_sendpkg(client, &buffer);
+	client_sendpkg(client, message->rcode, &buffer);
 
 	return;
 done:
@@ -711,7 +752,7 @@ renderend:
 
 		respsize = isc_buffer_usedlength(&buffer);
 
-		client_sendpkg(client, &buffer);
+		client_sendpkg(client, client->message->rcode, &buffer);
 
 		switch (isc_sockaddr_pf(&client->peeraddr)) {
 		case AF_INET:
@@ -740,7 +781,7 @@ renderend:
 
 		respsize = isc_buffer_usedlength(&buffer);
 
-		client_sendpkg(client, &buffer);
+		client_sendpkg(client, client->message->rcode, &buffer);
 
 		switch (isc_sockaddr_pf(&client->peeraddr)) {
 		case AF_INET:
@@ -2901,7 +2942,7 @@ ns_client_newnamebuf(ns_client_t *client) {
 
 	CTRACE("ns_client_newnamebuf");
 
-	isc_buffer_allocate(client->manager->mctx, &dbuf, 1024);
+	isc_buffer_allocate(client->manager->mctx, &dbuf, NAMEBUF_SIZE);
 	ISC_LIST_APPEND(client->query.namebufs, dbuf, link);
 
 	CTRACE("ns_client_newnamebuf: done");
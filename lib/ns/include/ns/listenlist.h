@@ -63,18 +63,19 @@ struct ns_listenlist {
 };
 
 typedef struct ns_listen_tls_params {
-	const char *name;
-	const char *key;
-	const char *cert;
-	const char *ca_file;
-	uint32_t    protocols;
-	const char *dhparam_file;
-	const char *ciphers;
-	const char *cipher_suites;
-	bool	    prefer_server_ciphers;
-	bool	    prefer_server_ciphers_set;
-	bool	    session_tickets;
-	bool	    session_tickets_set;
+	const char		 *name;
+	const char		 *key;
+	const char		 *cert;
+	const char		 *ca_file;
+	uint32_t		  protocols;
+	const char		 *dhparam_file;
+	const char		 *ciphers;
+	const char		 *cipher_suites;
+	bool			  prefer_server_ciphers;
+	bool			  prefer_server_ciphers_set;
+	bool			  session_tickets;
+	bool			  session_tickets_set;
+	isc_tlsctx_ticket_keys_t *ticket_keys;
 } ns_listen_tls_params_t;
 
 /***
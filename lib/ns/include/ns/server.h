@@ -28,8 +28,10 @@
 #include <isc/types.h>
 
 #include <dns/acl.h>
+#include <dns/transport.h>
 #include <dns/types.h>
 
+#include <ns/stats.h>
 #include <ns/types.h>
 
 #define NS_SERVER_LOGQUERIES	 0x00000001U /*%< log queries */
@@ -126,6 +128,14 @@ struct ns_server {
 	isc_histomulti_t *tcpoutstats4;
 	isc_histomulti_t *tcpinstats6;
 	isc_histomulti_t *tcpoutstats6;
+
+	/*% Response latency and size histograms */
+	isc_histomulti_t *latencystats[DNS_TRANSPORT_COUNT];
+	isc_histomulti_t *respsizestats[DNS_TRANSPORT_COUNT];
+	isc_histomulti_t *rcodelatencystats[ns_rcodehisto_max];
+
+	/*% Rendered outgoing zone transfer messages */
+	ns_xfrcache_t *xfrcache;
 };
 
 struct ns_altsecret {
@@ -117,6 +117,32 @@ enum {
 	ns_statscounter_max = 69,
 };
 
+/*%
+ * Response latency and size histograms.  Latency is measured in
+ * microseconds from the time a request was received until the response
+ * is handed to the network manager, and response size in bytes.  Both
+ * are kept per transport (indexed by dns_transport_type_t); latency is
+ * also kept per class of response code.
+ *
+ * Four significant bits keep the relative error of the exported
+ * latency quantiles below about 6%.  Response sizes use seven, as
+ * the size histograms in <dns/stats.h> do: sizes below 256 bytes are
+ * exact and larger ones are within about 0.8%.  As a DNS message is
+ * at most 64KB, that costs at most about 10KB per thread and transport.
+ */
+#define NS_LATENCYHISTO_SIGBITS	 4
+#define NS_RESPSIZEHISTO_SIGBITS 7
+
+typedef enum {
+	ns_rcodehisto_noerror = 0,
+	ns_rcodehisto_nxdomain = 1,
+	ns_rcodehisto_servfail = 2,
+	ns_rcodehisto_refused = 3,
+	ns_rcodehisto_other = 4,
+
+	ns_rcodehisto_max = 5,
+} ns_rcodehisto_t;
+
 void
 ns_stats_attach(ns_stats_t *stats, ns_stats_t **statsp);
 
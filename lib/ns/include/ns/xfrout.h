@@ -28,3 +28,35 @@
 
 void
 ns_xfr_start(ns_client_t *client, dns_rdatatype_t xfrtype);
+
+void
+ns_xfrcache_create(isc_mem_t *mctx, ns_xfrcache_t **cachep);
+/*%<
+ * Create a cache of rendered outgoing zone transfer messages, which
+ * lets transfers of the same zone version share the work of rendering
+ * and compressing it.
+ *
+ * Requires:
+ *\li	'cachep' is not NULL and '*cachep' is NULL.
+ */
+
+void
+ns_xfrcache_setlimits(ns_xfrcache_t *cache, size_t maxbytes,
+		      unsigned int maxentries);
+/*%<
+ * Limit the cache to 'maxbytes' of rendered messages in at most
+ * 'maxentries' transfers, evicting the least recently used entries
+ * if it is over the new limits.  A transfer larger than half of
+ * 'maxbytes' is not cached.  If either limit is 0, no new transfers
+ * are cached.
+ *
+ * Requires:
+ *\li	'cache' is a valid cache.
+ */
+
+void
+ns_xfrcache_destroy(ns_xfrcache_t **cachep);
+/*%<
+ * Destroy a cache created with ns_xfrcache_create().  Transfers that
+ * are still replaying cached messages keep them until they finish.
+ */
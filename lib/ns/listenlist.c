@@ -151,6 +151,19 @@ listenelt_create(isc_mem_t *mctx, in_port_t port, dns_acl_t *acl,
 					sslctx, tls_params->session_tickets);
 			}
 
+			/*
+			 * Use the shared session ticket keys, so that the
+			 * tickets issued by one listener are accepted by the
+			 * other ones and remain valid across reconfiguration.
+			 */
+			if (tls_params->ticket_keys != NULL &&
+			    (!tls_params->session_tickets_set ||
+			     tls_params->session_tickets))
+			{
+				isc_tlsctx_set_ticket_keys(
+					sslctx, tls_params->ticket_keys);
+			}
+
 #ifdef HAVE_LIBNGHTTP2
 			if (is_http) {
 				isc_tlsctx_enable_http2server_alpn(sslctx);
@@ -750,14 +750,21 @@ query_reset(ns_client_t *client, bool everything) {
 
 	query_freefreeversions(client, everything);
 
-	for (dbuf = ISC_LIST_HEAD(client->query.namebufs); dbuf != NULL;
-	     dbuf = dbuf_next)
-	{
+	/*
+	 * Names from the previous request are no longer referenced, so
+	 * the first name buffer can be reused wholesale; any others that
+	 * were needed for a large response are freed.
+	 */
+	dbuf = ISC_LIST_HEAD(client->query.namebufs);
+	if (!everything && dbuf != NULL) {
+		isc_buffer_clear(dbuf);
+		dbuf = ISC_LIST_NEXT(dbuf, link);
+	}
+	while (dbuf != NULL) {
 		dbuf_next = ISC_LIST_NEXT(dbuf, link);
-		if (dbuf_next != NULL || everything) {
-			ISC_LIST_UNLINK(client->query.namebufs, dbuf, link);
-			isc_buffer_free(&dbuf);
-		}
+		ISC_LIST_UNLINK(client->query.namebufs, dbuf, link);
+		isc_buffer_free(&dbuf);
+		dbuf = dbuf_next;
 	}
 
 	if (client->query.restarts > 0) {
@@ -2580,7 +2587,8 @@ stale_refresh_aftermath(ns_client_t *client, isc_result_t result) {
 		 * database, starting the stale-refresh-time window for it.
 		 * This is a condensed form of query_lookup().
 		 */
-		client->now = isc_stdtime_now();
+		client->tnow = isc_time_now();
+		client->now = isc_time_seconds(&client->tnow);
 		client->query.attributes &= ~NS_QUERYATTR_RECURSIONOK;
 		qctx_init(client, NULL, 0, &qctx);
 
@@ -6253,9 +6261,10 @@ fetch_callback(void *arg) {
 		FETCH_RECTYPE_NORMAL(client) = NULL;
 
 		/*
-		 * Update client->now.
+		 * Update client->tnow and client->now.
 		 */
-		client->now = isc_stdtime_now();
+		client->tnow = isc_time_now();
+		client->now = isc_time_seconds(&client->tnow);
 	} else {
 		/*
 		 * This is a fetch completion event for a canceled fetch.
@@ -6718,7 +6727,8 @@ query_hookresume(void *arg) {
 		INSIST(rev->ctx == client->query.hookactx);
 		client->query.hookactx = NULL;
 		canceled = false;
-		client->now = isc_stdtime_now();
+		client->tnow = isc_time_now();
+		client->now = isc_time_seconds(&client->tnow);
 	} else {
 		canceled = true;
 	}
@@ -25,6 +25,7 @@
 #include <ns/query.h>
 #include <ns/server.h>
 #include <ns/stats.h>
+#include <ns/xfrout.h>
 
 #define SCTX_MAGIC    ISC_MAGIC('S', 'c', 't', 'x')
 #define SCTX_VALID(s) ISC_MAGIC_VALID(s, SCTX_MAGIC)
@@ -101,8 +102,22 @@ ns_server_create(isc_mem_t *mctx, ns_matchview_t matchingview,
 	isc_histomulti_create(mctx, DNS_SIZEHISTO_SIGBITSOUT,
 			      &sctx->tcpoutstats6);
 
+	for (size_t i = DNS_TRANSPORT_UDP; i <= DNS_TRANSPORT_HTTP; i++) {
+		isc_histomulti_create(mctx, NS_LATENCYHISTO_SIGBITS,
+				      &sctx->latencystats[i]);
+		isc_histomulti_create(mctx, NS_RESPSIZEHISTO_SIGBITS,
+				      &sctx->respsizestats[i]);
+	}
+
+	for (size_t i = 0; i < ns_rcodehisto_max; i++) {
+		isc_histomulti_create(mctx, NS_LATENCYHISTO_SIGBITS,
+				      &sctx->rcodelatencystats[i]);
+	}
+
 	ISC_LIST_INIT(sctx->altsecrets);
 
+	ns_xfrcache_create(mctx, &sctx->xfrcache);
+
 	sctx->magic = SCTX_MAGIC;
 	*sctxp = sctx;
 }
@@ -139,6 +154,8 @@ ns_server_detach(ns_server_t **sctxp) {
 		isc_quota_destroy(&sctx->tcpquota);
 		isc_quota_destroy(&sctx->xfroutquota);
 
+		ns_xfrcache_destroy(&sctx->xfrcache);
+
 		http_quota = ISC_LIST_HEAD(sctx->http_quotas);
 		while (http_quota != NULL) {
 			isc_quota_t *next = NULL;
@@ -203,6 +220,22 @@ ns_server_detach(ns_server_t **sctxp) {
 			isc_histomulti_destroy(&sctx->tcpoutstats6);
 		}
 
+		for (size_t i = 0; i < DNS_TRANSPORT_COUNT; i++) {
+			if (sctx->latencystats[i] != NULL) {
+				isc_histomulti_destroy(&sctx->latencystats[i]);
+			}
+			if (sctx->respsizestats[i] != NULL) {
+				isc_histomulti_destroy(
+					&sctx->respsizestats[i]);
+			}
+		}
+		for (size_t i = 0; i < ns_rcodehisto_max; i++) {
+			if (sctx->rcodelatencystats[i] != NULL) {
+				isc_histomulti_destroy(
+					&sctx->rcodelatencystats[i]);
+			}
+		}
+
 		sctx->magic = 0;
 
 		isc_mem_putanddetach(&sctx->mctx, sctx, sizeof(*sctx));
@@ -1937,6 +1937,7 @@ respond(ns_client_t *client, isc_result_t result) {
 	}
 
 	client->message->rcode = dns_result_torcode(result);
+	client->tnow = isc_time_now();
 	ns_client_send(client);
 	isc_nmhandle_detach(&client->reqhandle);
 }
@@ -3551,6 +3552,7 @@ forward_done(void *arg) {
 	update_t *uev = (update_t *)arg;
 	ns_client_t *client = uev->client;
 
+	client->tnow = isc_time_now();
 	ns_client_sendraw(client, uev->answer);
 	dns_message_detach(&uev->answer);
 
@@ -624,6 +624,184 @@ static rrstream_methods_t compound_rrstream_methods = {
 
 /**************************************************************************/
 
+/*%
+ * Cache of rendered zone transfer messages.
+ *
+ * The question and answer sections of each message of a transfer are
+ * kept in wire format, keyed by the zone, the database instance (see
+ * dns_db_instance()), the serial numbers and everything else that
+ * determines where the message boundaries fall.  Entries do not hold
+ * the database, so a replaced zone version is freed as soon as nothing
+ * else uses it; its entries no longer match and are dropped when they
+ * are next looked at.
+ * Later transfers of the same zone version replay these with their own
+ * message ID, OPT record and TSIG instead of rendering and compressing
+ * every record again.  Cached layouts always leave XFRCACHE_RESERVE
+ * bytes free, so they do not depend on the size of the requester's
+ * OPT record or TSIG.
+ *
+ * An entry is filled in by the first transfer that misses the cache
+ * and can be read while it is being filled; a transfer that catches up
+ * with the one filling the entry skips its own stream forward and
+ * renders the rest of the zone itself.
+ *
+ * The cache is limited in size and in number of entries (see
+ * ns_xfrcache_setlimits()); a single transfer larger than half of the
+ * size limit is not cached.  Only transfers over TCP are cached.
+ */
+#define XFRCACHE_RESERVE    1024
+#define XFRCACHE_MAXBYTES   (64 * 1024 * 1024) /* default */
+#define XFRCACHE_MAXENTRIES 64		       /* default */
+
+typedef struct xfrcache_msg xfrcache_msg_t;
+struct xfrcache_msg {
+	ISC_LINK(xfrcache_msg_t) link;
+	unsigned int nrecs; /* records taken from the stream */
+	unsigned int qdcount;
+	unsigned int ancount;
+	unsigned int qdlen; /* length of the question section */
+	unsigned int length;
+	unsigned char data[]; /* question and answer sections */
+};
+
+typedef struct xfrcache_entry xfrcache_entry_t;
+struct xfrcache_entry {
+	isc_refcount_t references;
+	const void *zone;    /* for identification only, not attached */
+	uint64_t dbinstance; /* dns_db_instance(); the database is not held */
+	dns_rdatatype_t qtype;
+	bool delta;	       /* IXFR from the journal */
+	uint32_t begin_serial; /* IXFR deltas only */
+	uint32_t end_serial;
+	bool many_answers;
+	uint16_t msgsize;
+	dns_fixedname_t fqname;
+	dns_name_t *qname;
+
+	/* Locked by the cache lock. */
+	ISC_LIST(xfrcache_msg_t) msgs;
+	size_t nbytes;
+	bool complete; /* all messages are present */
+	bool linked;   /* still in the cache */
+	ISC_LINK(xfrcache_entry_t) link;
+};
+
+struct ns_xfrcache {
+	isc_mem_t *mctx;
+	isc_mutex_t lock;
+	ISC_LIST(xfrcache_entry_t) entries; /* most recently used first */
+	unsigned int nentries;
+	size_t nbytes;
+	unsigned int maxentries;
+	size_t maxbytes;
+};
+
+void
+ns_xfrcache_create(isc_mem_t *mctx, ns_xfrcache_t **cachep) {
+	ns_xfrcache_t *cache = NULL;
+
+	REQUIRE(cachep != NULL && *cachep == NULL);
+
+	cache = isc_mem_get(mctx, sizeof(*cache));
+	*cache = (ns_xfrcache_t){
+		.entries = ISC_LIST_INITIALIZER,
+		.maxentries = XFRCACHE_MAXENTRIES,
+		.maxbytes = XFRCACHE_MAXBYTES,
+	};
+	isc_mem_attach(mctx, &cache->mctx);
+	isc_mutex_init(&cache->lock);
+
+	*cachep = cache;
+}
+
+static void
+xfrcache_entry_detach(ns_xfrcache_t *cache, xfrcache_entry_t **entryp) {
+	xfrcache_entry_t *entry = *entryp;
+	xfrcache_msg_t *cmsg = NULL;
+
+	*entryp = NULL;
+
+	if (isc_refcount_decrement(&entry->references) > 1) {
+		return;
+	}
+
+	INSIST(!entry->linked);
+	while ((cmsg = ISC_LIST_HEAD(entry->msgs)) != NULL) {
+		ISC_LIST_UNLINK(entry->msgs, cmsg, link);
+		isc_mem_put(cache->mctx, cmsg,
+			    STRUCT_FLEX_SIZE(cmsg, data, cmsg->length));
+	}
+	isc_refcount_destroy(&entry->references);
+	isc_mem_put(cache->mctx, entry, sizeof(*entry));
+}
+
+/*
+ * Remove 'entry' from the cache.  Transfers already reading it keep
+ * their references.  Requires the cache lock.
+ */
+static void
+xfrcache_unlink(ns_xfrcache_t *cache, xfrcache_entry_t *entry) {
+	REQUIRE(entry->linked);
+
+	ISC_LIST_UNLINK(cache->entries, entry, link);
+	entry->linked = false;
+	cache->nentries--;
+	cache->nbytes -= entry->nbytes;
+	xfrcache_entry_detach(cache, &entry);
+}
+
+/*
+ * Evict the least recently used entries other than 'keep' until the
+ * cache is within its limits.  Requires the cache lock.
+ */
+static void
+xfrcache_trim(ns_xfrcache_t *cache, xfrcache_entry_t *keep) {
+	xfrcache_entry_t *entry = ISC_LIST_TAIL(cache->entries);
+
+	while (entry != NULL && (cache->nbytes > cache->maxbytes ||
+				 cache->nentries > cache->maxentries))
+	{
+		xfrcache_entry_t *prev = ISC_LIST_PREV(entry, link);
+		if (entry != keep) {
+			xfrcache_unlink(cache, entry);
+		}
+		entry = prev;
+	}
+}
+
+void
+ns_xfrcache_setlimits(ns_xfrcache_t *cache, size_t maxbytes,
+		      unsigned int maxentries) {
+	REQUIRE(cache != NULL);
+
+	LOCK(&cache->lock);
+	cache->maxbytes = maxbytes;
+	cache->maxentries = maxentries;
+	xfrcache_trim(cache, NULL);
+	UNLOCK(&cache->lock);
+}
+
+void
+ns_xfrcache_destroy(ns_xfrcache_t **cachep) {
+	ns_xfrcache_t *cache = NULL;
+	xfrcache_entry_t *entry = NULL;
+
+	REQUIRE(cachep != NULL && *cachep != NULL);
+
+	cache = *cachep;
+	*cachep = NULL;
+
+	while ((entry = ISC_LIST_HEAD(cache->entries)) != NULL) {
+		xfrcache_unlink(cache, entry);
+	}
+	INSIST(cache->nbytes == 0);
+
+	isc_mutex_destroy(&cache->lock);
+	isc_mem_putanddetach(&cache->mctx, cache, sizeof(*cache));
+}
+
+/**************************************************************************/
+
 /*%
  * Structure holding outgoing transfer statistics
  */
@@ -635,11 +813,37 @@ struct xfr_stats {
 	isc_time_t end;	  /*%< End time of the transfer */
 };
 
+/*%
+ * Messages are rendered ahead of the network: each one is handed to
+ * the network manager as soon as it is ready, so that up to
+ * XFROUT_TXRING of them are queued on the connection at once and it
+ * does not sit idle while the next message is rendered.  When the peer
+ * stops reading, the sends stop completing and the ring fills up,
+ * which stops the rendering until there is room again.
+ *
+ * Each slot of the ring is a NS_CLIENT_TCP_BUFFER_SIZE buffer that is
+ * allocated the first time it is needed, so a transfer that fits in a
+ * single message uses one, and no transfer uses more than
+ * XFROUT_TXRING of them (256KB) on top of its render buffer.  The
+ * total is bounded by "transfers-out".  The ring is only used over
+ * TCP; an IXFR answered over UDP is sent by ns_client_send().
+ */
+#define XFROUT_TXRING 4
+
+typedef struct xfrout_tx xfrout_tx_t;
+struct xfrout_tx {
+	struct xfrout_ctx *xfr;
+	isc_nmhandle_t *handle; /* Attached while the send is in progress */
+	void *mem;     /* Allocated when the slot is first used */
+	size_t length; /* Length of the message being sent */
+	bool busy;
+};
+
 /*%
  * An 'xfrout_ctx_t' contains the state of an outgoing AXFR or IXFR
  * in progress.
  */
-typedef struct {
+typedef struct xfrout_ctx {
 	isc_mem_t *mctx;
 	ns_client_t *client;
 	unsigned int id;       /* ID of request */
@@ -655,14 +859,16 @@ typedef struct {
 	isc_buffer_t buf;    /* Buffer for message owner
 			      * names and rdatas */
 	isc_buffer_t txbuf;  /* Transmit message buffer */
-	size_t cbytes;	     /* Length of current message */
-	void *txmem;
+	xfrout_tx_t *tx;     /* Ring slot that txbuf belongs to (TCP) */
+	xfrout_tx_t txring[XFROUT_TXRING];
 	unsigned int txmemlen;
 	dns_tsigkey_t *tsigkey; /* Key used to create TSIG */
 	isc_buffer_t *lasttsig; /* the last TSIG */
 	bool verified_tsig;	/* verified request MAC */
 	bool many_answers;
-	int sends; /* Send in progress */
+	unsigned int sends;	/* Sends in progress */
+	bool delayed;		/* Send held back by the test options */
+	unsigned int sendahead; /* Limit on xfrout_queued() */
 	bool shuttingdown;
 	bool poll;
 	const char *mnemonic;	/* Style of transfer */
@@ -677,6 +883,12 @@ typedef struct {
 
 	/* Delayed send */
 	isc_nm_timer_t *delayed_send_timer;
+
+	/* Rendered message cache */
+	xfrcache_entry_t *cache;
+	xfrcache_msg_t *cachemsg; /* last message replayed */
+	uint64_t cache_nrecs;	  /* records in the messages replayed */
+	bool cache_fill;	  /* 'cache' is being filled in by us */
 } xfrout_ctx_t;
 
 static void
@@ -689,9 +901,12 @@ xfrout_ctx_create(isc_mem_t *mctx, ns_client_t *client, unsigned int id,
 		  unsigned int idletime, bool many_answers,
 		  xfrout_ctx_t **xfrp);
 
-static void
+static isc_result_t
 sendstream(xfrout_ctx_t *xfr);
 
+static void
+xfrout_sendahead(xfrout_ctx_t *xfr);
+
 static void
 xfrout_senddone(isc_nmhandle_t *handle, isc_result_t result, void *arg);
 
@@ -720,6 +935,250 @@ xfrout_delayed_timeout(void *arg, isc_result_t result);
 
 /**************************************************************************/
 
+/*
+ * Find the cache entry for 'xfr', or start a new one that 'xfr' will
+ * fill in.
+ */
+static void
+xfrout_cache_attach(xfrout_ctx_t *xfr, bool delta, uint32_t begin_serial) {
+	ns_server_t *sctx = xfr->client->manager->sctx;
+	ns_xfrcache_t *cache = sctx->xfrcache;
+	xfrcache_entry_t *entry = NULL, *next = NULL;
+	uint64_t dbinstance = dns_db_instance(xfr->db);
+
+	REQUIRE(xfr->cache == NULL);
+
+	if (dbinstance == 0) {
+		/* The database cannot be told apart from others. */
+		return;
+	}
+
+	LOCK(&cache->lock);
+	for (entry = ISC_LIST_HEAD(cache->entries); entry != NULL;
+	     entry = next)
+	{
+		next = ISC_LIST_NEXT(entry, link);
+		if (entry->zone != xfr->zone) {
+			continue;
+		}
+		if (entry->dbinstance != dbinstance ||
+		    entry->end_serial != xfr->end_serial)
+		{
+			/* An older version of the zone. */
+			xfrcache_unlink(cache, entry);
+			continue;
+		}
+		if (entry->qtype == xfr->qtype && entry->delta == delta &&
+		    entry->begin_serial == begin_serial &&
+		    entry->many_answers == xfr->many_answers &&
+		    entry->msgsize == sctx->transfer_tcp_message_size &&
+		    dns_name_caseequal(entry->qname, xfr->qname))
+		{
+			break;
+		}
+	}
+
+	if (entry != NULL) {
+		ISC_LIST_UNLINK(cache->entries, entry, link);
+		ISC_LIST_PREPEND(cache->entries, entry, link);
+		isc_refcount_increment(&entry->references);
+		UNLOCK(&cache->lock);
+
+		xfr->cache = entry;
+		xfrout_log(xfr, ISC_LOG_DEBUG(1), "using cached messages");
+		return;
+	}
+
+	if (cache->maxbytes == 0 || cache->maxentries == 0) {
+		/* Caching is disabled. */
+		UNLOCK(&cache->lock);
+		return;
+	}
+
+	entry = isc_mem_get(cache->mctx, sizeof(*entry));
+	*entry = (xfrcache_entry_t){
+		.zone = xfr->zone,
+		.dbinstance = dbinstance,
+		.qtype = xfr->qtype,
+		.delta = delta,
+		.begin_serial = begin_serial,
+		.end_serial = xfr->end_serial,
+		.many_answers = xfr->many_answers,
+		.msgsize = sctx->transfer_tcp_message_size,
+		.msgs = ISC_LIST_INITIALIZER,
+		.linked = true,
+		.link = ISC_LINK_INITIALIZER,
+	};
+	/* One reference for the cache, one for 'xfr'. */
+	isc_refcount_init(&entry->references, 2);
+	entry->qname = dns_fixedname_initname(&entry->fqname);
+	dns_name_copy(xfr->qname, entry->qname);
+
+	ISC_LIST_PREPEND(cache->entries, entry, link);
+	cache->nentries++;
+	xfrcache_trim(cache, entry);
+	UNLOCK(&cache->lock);
+
+	xfr->cache = entry;
+	xfr->cache_fill = true;
+}
+
+/*
+ * Stop using the cache.  An entry that 'xfr' was filling in and has not
+ * finished is dropped, as it can never be completed.
+ */
+static void
+xfrout_cache_detach(xfrout_ctx_t *xfr) {
+	ns_xfrcache_t *cache = xfr->client->manager->sctx->xfrcache;
+
+	LOCK(&cache->lock);
+	if (xfr->cache_fill && !xfr->cache->complete && xfr->cache->linked) {
+		xfrcache_unlink(cache, xfr->cache);
+	}
+	UNLOCK(&cache->lock);
+
+	xfrcache_entry_detach(cache, &xfr->cache);
+	xfr->cachemsg = NULL;
+	xfr->cache_fill = false;
+}
+
+/*
+ * Stop replaying cached messages and move the stream past the records
+ * that they contained, so that 'xfr' can render the rest itself.
+ */
+static isc_result_t
+xfrout_cache_leave(xfrout_ctx_t *xfr) {
+	isc_result_t result;
+
+	REQUIRE(!xfr->cache_fill);
+
+	for (uint64_t i = 0; i < xfr->cache_nrecs; i++) {
+		result = xfr->stream->methods->next(xfr->stream);
+		if (result == ISC_R_NOMORE) {
+			result = ISC_R_UNEXPECTED;
+		}
+		if (result != ISC_R_SUCCESS) {
+			return (result);
+		}
+	}
+
+	xfrout_log(xfr, ISC_LOG_DEBUG(1),
+		   "caught up with cached messages after %" PRIu64
+		   " records",
+		   xfr->cache_nrecs);
+
+	xfrout_cache_detach(xfr);
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Get the next cached message to replay.  '*cmsgp' is left NULL once
+ * 'xfr' has caught up with the transfer filling in the entry.
+ */
+static isc_result_t
+xfrout_cache_next(xfrout_ctx_t *xfr, xfrcache_msg_t **cmsgp) {
+	ns_xfrcache_t *cache = xfr->client->manager->sctx->xfrcache;
+	xfrcache_entry_t *entry = xfr->cache;
+	xfrcache_msg_t *cmsg = NULL;
+	bool last = false;
+
+	REQUIRE(cmsgp != NULL && *cmsgp == NULL);
+
+	LOCK(&cache->lock);
+	if (xfr->cachemsg == NULL) {
+		cmsg = ISC_LIST_HEAD(entry->msgs);
+	} else {
+		cmsg = ISC_LIST_NEXT(xfr->cachemsg, link);
+	}
+	if (cmsg != NULL && ISC_LIST_NEXT(cmsg, link) == NULL) {
+		last = entry->complete;
+	}
+	UNLOCK(&cache->lock);
+
+	if (cmsg == NULL) {
+		return (xfrout_cache_leave(xfr));
+	}
+
+	xfr->cachemsg = cmsg;
+	xfr->cache_nrecs += cmsg->nrecs;
+	xfr->stats.nrecs += cmsg->nrecs;
+	if (last) {
+		xfr->end_of_stream = true;
+	}
+
+	*cmsgp = cmsg;
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Add the message just rendered into xfr->txbuf, which holds 'nrecs'
+ * records, to the entry that 'xfr' is filling in.
+ */
+static void
+xfrout_cache_fill(xfrout_ctx_t *xfr, dns_message_t *msg, unsigned int qdlen,
+		  unsigned int nrecs) {
+	ns_xfrcache_t *cache = xfr->client->manager->sctx->xfrcache;
+	xfrcache_entry_t *entry = xfr->cache;
+	xfrcache_msg_t *cmsg = NULL;
+	isc_region_t r;
+	bool linked;
+
+	isc_buffer_usedregion(&xfr->txbuf, &r);
+	isc_region_consume(&r, DNS_MESSAGE_HEADERLEN);
+
+	cmsg = isc_mem_get(cache->mctx, STRUCT_FLEX_SIZE(cmsg, data, r.length));
+	*cmsg = (xfrcache_msg_t){
+		.link = ISC_LINK_INITIALIZER,
+		.nrecs = nrecs,
+		.qdcount = msg->counts[DNS_SECTION_QUESTION],
+		.ancount = msg->counts[DNS_SECTION_ANSWER],
+		.qdlen = qdlen,
+		.length = r.length,
+	};
+	memmove(cmsg->data, r.base, r.length);
+
+	LOCK(&cache->lock);
+	ISC_LIST_APPEND(entry->msgs, cmsg, link);
+	entry->nbytes += r.length;
+	entry->complete = xfr->end_of_stream;
+	if (entry->linked) {
+		cache->nbytes += r.length;
+		if (entry->nbytes > cache->maxbytes / 2) {
+			/* Too large to be worth keeping. */
+			xfrcache_unlink(cache, entry);
+		} else {
+			xfrcache_trim(cache, entry);
+		}
+	}
+	linked = entry->linked;
+	UNLOCK(&cache->lock);
+
+	if (!linked) {
+		xfrout_cache_detach(xfr);
+	}
+}
+
+static isc_result_t
+xfrout_cache_render(dns_message_t *msg, const xfrcache_msg_t *cmsg) {
+	isc_region_t r;
+	isc_result_t result;
+
+	r = (isc_region_t){ .base = UNCONST(cmsg->data),
+			    .length = cmsg->qdlen };
+	result = dns_message_renderraw(msg, DNS_SECTION_QUESTION, &r,
+				       cmsg->qdcount);
+	if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+
+	r = (isc_region_t){ .base = UNCONST(cmsg->data + cmsg->qdlen),
+			    .length = cmsg->length - cmsg->qdlen };
+	return (dns_message_renderraw(msg, DNS_SECTION_ANSWER, &r,
+				      cmsg->ancount));
+}
+
+/**************************************************************************/
+
 void
 ns_xfr_start(ns_client_t *client, dns_rdatatype_t reqtype) {
 	isc_result_t result;
@@ -1110,6 +1569,12 @@ have_stream:
 
 	CHECK(xfr->stream->methods->first(xfr->stream));
 
+	if (!is_dlz && !is_poll &&
+	    (client->attributes & NS_CLIENTATTR_TCP) != 0)
+	{
+		xfrout_cache_attach(xfr, is_ixfr, is_ixfr ? begin_serial : 0);
+	}
+
 	if (xfr->tsigkey != NULL) {
 		dns_name_format(xfr->tsigkey->name, keyname, sizeof(keyname));
 	} else {
@@ -1163,11 +1628,11 @@ have_stream:
 	}
 
 	/*
-	 * Hand the context over to sendstream().  Set xfr to NULL;
-	 * sendstream() is responsible for either passing the
+	 * Hand the context over to xfrout_sendahead().  Set xfr to NULL;
+	 * xfrout_sendahead() is responsible for either passing the
 	 * context on to a later event handler or destroying it.
 	 */
-	sendstream(xfr);
+	xfrout_sendahead(xfr);
 	xfr = NULL;
 
 	result = ISC_R_SUCCESS;
@@ -1239,10 +1704,22 @@ xfrout_ctx_create(isc_mem_t *mctx, ns_client_t *client, unsigned int id,
 		.lasttsig = lasttsig,
 		.verified_tsig = verified_tsig,
 		.many_answers = many_answers,
+		.sendahead = XFROUT_TXRING,
 	};
 
 	isc_mem_attach(mctx, &xfr->mctx);
 
+	/*
+	 * The test options that delay sends can only hold back one
+	 * message at a time.
+	 */
+	if (ns_server_getoption(client->manager->sctx,
+				NS_SERVER_TRANSFERSLOWLY) ||
+	    ns_server_getoption(client->manager->sctx, NS_SERVER_TRANSFERSTUCK))
+	{
+		xfr->sendahead = 1;
+	}
+
 	if (zone != NULL) { /* zone will be NULL if it's DLZ */
 		dns_zone_attach(zone, &xfr->zone);
 	}
@@ -1273,12 +1750,12 @@ xfrout_ctx_create(isc_mem_t *mctx, ns_client_t *client, unsigned int id,
 	isc_buffer_init(&xfr->buf, mem, len);
 
 	/*
-	 * Allocate another temporary buffer for the compressed
-	 * response message.
+	 * The buffers for the compressed response messages are
+	 * allocated by xfrout_tx_get() as they are needed.
 	 */
-	mem = isc_mem_get(mctx, len);
-	isc_buffer_init(&xfr->txbuf, (char *)mem, len);
-	xfr->txmem = mem;
+	for (size_t i = 0; i < ARRAY_SIZE(xfr->txring); i++) {
+		xfr->txring[i] = (xfrout_tx_t){ .xfr = xfr };
+	}
 	xfr->txmemlen = len;
 
 	/*
@@ -1296,20 +1773,19 @@ xfrout_send(xfrout_ctx_t *xfr) {
 			     0);
 
 	if (is_tcp) {
+		xfrout_tx_t *tx = xfr->tx;
 		isc_region_t used;
 
 		isc_buffer_usedregion(&xfr->txbuf, &used);
 
-		isc_nmhandle_attach(xfr->client->handle,
-				    &xfr->client->sendhandle);
+		isc_nmhandle_attach(xfr->client->handle, &tx->handle);
 		if (xfr->idletime > 0) {
-			isc_nmhandle_setwritetimeout(xfr->client->sendhandle,
+			isc_nmhandle_setwritetimeout(tx->handle,
 						     xfr->idletime);
 		}
-		isc_nm_send(xfr->client->sendhandle, &used, xfrout_senddone,
-			    xfr);
+		tx->length = used.length;
 		xfr->sends++;
-		xfr->cbytes = used.length;
+		isc_nm_send(tx->handle, &used, xfrout_senddone, tx);
 	} else {
 		ns_client_send(xfr->client);
 		xfr->stream->methods->pause(xfr->stream);
@@ -1324,13 +1800,57 @@ xfrout_delayed_timeout(void *arg, isc_result_t result) {
 	UNUSED(result);
 
 	isc_nm_timer_stop(xfr->delayed_send_timer);
+
+	INSIST(xfr->delayed);
+	xfr->delayed = false;
+
+	if (xfr->shuttingdown) {
+		if (xfr->tx != NULL) {
+			xfr->tx->busy = false;
+		}
+		xfrout_maybe_destroy(xfr);
+		return;
+	}
+
 	xfrout_send(xfr);
 }
 
+/*
+ * Get a ring slot to render the next message into.
+ */
+static xfrout_tx_t *
+xfrout_tx_get(xfrout_ctx_t *xfr) {
+	for (size_t i = 0; i < ARRAY_SIZE(xfr->txring); i++) {
+		xfrout_tx_t *tx = &xfr->txring[i];
+
+		if (!tx->busy) {
+			if (tx->mem == NULL) {
+				tx->mem = isc_mem_get(xfr->mctx,
+						      xfr->txmemlen);
+			}
+			return (tx);
+		}
+	}
+
+	UNREACHABLE();
+}
+
+/*
+ * The number of messages that have been rendered but not sent yet.
+ */
+static unsigned int
+xfrout_queued(xfrout_ctx_t *xfr) {
+	return (xfr->sends + (xfr->delayed ? 1 : 0));
+}
+
 static void
 xfrout_enqueue_send(xfrout_ctx_t *xfr) {
 	uint64_t timeout = 0;
 
+	if ((xfr->client->attributes & NS_CLIENTATTR_TCP) != 0) {
+		xfr->tx->busy = true;
+	}
+
 	/*
 	 * System test helper options to simulate network issues.
 	 *
@@ -1354,7 +1874,9 @@ xfrout_enqueue_send(xfrout_ctx_t *xfr) {
 		return;
 	}
 
-	/* delay */
+	/* delay; the send is counted when xfrout_send() issues it */
+	INSIST(!xfr->delayed);
+	xfr->delayed = true;
 	isc_nm_timer_start(xfr->delayed_send_timer, timeout);
 }
 
@@ -1366,7 +1888,7 @@ xfrout_enqueue_send(xfrout_ctx_t *xfr) {
  *      or possibly at the end of the stream (that is, the
  *      _first method of the iterator has been called).
  */
-static void
+static isc_result_t
 sendstream(xfrout_ctx_t *xfr) {
 	dns_message_t *tcpmsg = NULL;
 	dns_message_t *msg = NULL; /* Client message if UDP, tcpmsg if TCP */
@@ -1380,16 +1902,20 @@ sendstream(xfrout_ctx_t *xfr) {
 	bool cleanup_cctx = false;
 	bool is_tcp;
 	int n_rrs;
+	xfrcache_msg_t *cmsg = NULL;
+	uint64_t nrecs = xfr->stats.nrecs;
+	unsigned int qdlen;
 
 	isc_buffer_clear(&xfr->buf);
-	isc_buffer_clear(&xfr->txbuf);
 
 	is_tcp = ((xfr->client->attributes & NS_CLIENTATTR_TCP) != 0);
 	if (!is_tcp) {
 		/*
 		 * In the UDP case, we put the response data directly into
-		 * the client message.
+		 * the client message, which ns_client_send() renders into
+		 * a buffer of its own, so no ring slot is needed.
 		 */
+		xfr->tx = NULL;
 		msg = xfr->client->message;
 		CHECK(dns_message_reply(msg, true));
 	} else {
@@ -1401,6 +1927,10 @@ sendstream(xfrout_ctx_t *xfr) {
 		 * message.
 		 */
 
+		/* Render into the first ring slot that is not being sent. */
+		xfr->tx = xfrout_tx_get(xfr);
+		isc_buffer_init(&xfr->txbuf, xfr->tx->mem, xfr->txmemlen);
+
 		dns_message_create(xfr->mctx, NULL, NULL,
 				   DNS_MESSAGE_INTENTRENDER, &tcpmsg);
 		msg = tcpmsg;
@@ -1433,13 +1963,37 @@ sendstream(xfrout_ctx_t *xfr) {
 			xfr->client->attributes &= ~NS_CLIENTATTR_HAVEEXPIRE;
 		}
 
+		/*
+		 * Replay a cached message if there is one.  Cached
+		 * layouts have room for the largest OPT and TSIG that
+		 * fit in XFRCACHE_RESERVE.
+		 */
+		if (xfr->cache != NULL && msg->reserved > XFRCACHE_RESERVE) {
+			if (xfr->cache_fill) {
+				xfrout_cache_detach(xfr);
+			} else {
+				CHECK(xfrout_cache_leave(xfr));
+			}
+		}
+		if (xfr->cache != NULL && !xfr->cache_fill) {
+			CHECK(xfrout_cache_next(xfr, &cmsg));
+		}
+		if (cmsg != NULL) {
+			if (xfr->question_added) {
+				msg->tcp_continuation = 1;
+			}
+			xfr->question_added = true;
+			goto render;
+		}
+
 		/*
 		 * Account for reserved space.
 		 */
 		if (xfr->tsigkey != NULL) {
 			INSIST(msg->reserved != 0U);
 		}
-		isc_buffer_add(&xfr->buf, msg->reserved);
+		isc_buffer_add(&xfr->buf, xfr->cache != NULL ? XFRCACHE_RESERVE
+							     : msg->reserved);
 
 		/*
 		 * Include a question section in the first message only.
@@ -1595,13 +2149,26 @@ sendstream(xfrout_ctx_t *xfr) {
 		}
 	}
 
+render:
 	if (is_tcp) {
 		dns_compress_init(&cctx, xfr->mctx,
 				  DNS_COMPRESS_CASE | DNS_COMPRESS_LARGE);
 		cleanup_cctx = true;
 		CHECK(dns_message_renderbegin(msg, &cctx, &xfr->txbuf));
-		CHECK(dns_message_rendersection(msg, DNS_SECTION_QUESTION, 0));
-		CHECK(dns_message_rendersection(msg, DNS_SECTION_ANSWER, 0));
+		if (cmsg != NULL) {
+			CHECK(xfrout_cache_render(msg, cmsg));
+		} else {
+			CHECK(dns_message_rendersection(
+				msg, DNS_SECTION_QUESTION, 0));
+			qdlen = isc_buffer_usedlength(&xfr->txbuf) -
+				DNS_MESSAGE_HEADERLEN;
+			CHECK(dns_message_rendersection(msg,
+							DNS_SECTION_ANSWER, 0));
+			if (xfr->cache_fill) {
+				xfrout_cache_fill(xfr, msg, qdlen,
+						  xfr->stats.nrecs - nrecs);
+			}
+		}
 		CHECK(dns_message_renderend(msg));
 		dns_compress_invalidate(&cctx);
 		cleanup_cctx = false;
@@ -1615,7 +2182,7 @@ sendstream(xfrout_ctx_t *xfr) {
 		xfrout_log(xfr, ISC_LOG_DEBUG(8), "sending IXFR UDP response");
 
 		xfrout_enqueue_send(xfr);
-		return;
+		return (ISC_R_SUCCESS);
 	}
 
 	/* Advance lasttsig to be the last TSIG generated */
@@ -1635,11 +2202,33 @@ failure:
 	 */
 	xfr->stream->methods->pause(xfr->stream);
 
-	if (result == ISC_R_SUCCESS) {
+	return (result);
+}
+
+/*
+ * Render and queue messages until the ring is full or the end of the
+ * stream has been reached.
+ */
+static void
+xfrout_sendahead(xfrout_ctx_t *xfr) {
+	isc_result_t result;
+
+	if ((xfr->client->attributes & NS_CLIENTATTR_TCP) == 0) {
+		/* A single UDP response; sending it destroys 'xfr'. */
+		result = sendstream(xfr);
+		if (result != ISC_R_SUCCESS) {
+			xfrout_fail(xfr, result, "sending zone data");
+		}
 		return;
 	}
 
-	xfrout_fail(xfr, result, "sending zone data");
+	do {
+		result = sendstream(xfr);
+		if (result != ISC_R_SUCCESS) {
+			xfrout_fail(xfr, result, "sending zone data");
+			return;
+		}
+	} while (!xfr->end_of_stream && xfrout_queued(xfr) < xfr->sendahead);
 }
 
 static void
@@ -1655,14 +2244,21 @@ xfrout_ctx_destroy(xfrout_ctx_t **xfrp) {
 	isc_nm_timer_stop(xfr->maxtime_timer);
 	isc_nm_timer_detach(&xfr->maxtime_timer);
 
+	if (xfr->cache != NULL) {
+		xfrout_cache_detach(xfr);
+	}
 	if (xfr->stream != NULL) {
 		xfr->stream->methods->destroy(&xfr->stream);
 	}
 	if (xfr->buf.base != NULL) {
 		isc_mem_put(xfr->mctx, xfr->buf.base, xfr->buf.length);
 	}
-	if (xfr->txmem != NULL) {
-		isc_mem_put(xfr->mctx, xfr->txmem, xfr->txmemlen);
+	for (size_t i = 0; i < ARRAY_SIZE(xfr->txring); i++) {
+		INSIST(xfr->txring[i].handle == NULL);
+		if (xfr->txring[i].mem != NULL) {
+			isc_mem_put(xfr->mctx, xfr->txring[i].mem,
+				    xfr->txmemlen);
+		}
 	}
 	if (xfr->lasttsig != NULL) {
 		isc_buffer_free(&xfr->lasttsig);
@@ -1685,16 +2281,19 @@ xfrout_ctx_destroy(xfrout_ctx_t **xfrp) {
 
 static void
 xfrout_senddone(isc_nmhandle_t *handle, isc_result_t result, void *arg) {
-	xfrout_ctx_t *xfr = (xfrout_ctx_t *)arg;
+	xfrout_tx_t *tx = (xfrout_tx_t *)arg;
+	xfrout_ctx_t *xfr = tx->xfr;
 
 	REQUIRE((xfr->client->attributes & NS_CLIENTATTR_TCP) != 0);
 
 	INSIST(handle == xfr->client->handle);
+	INSIST(tx->busy);
 
+	INSIST(xfr->sends > 0);
 	xfr->sends--;
-	INSIST(xfr->sends == 0);
+	tx->busy = false;
 
-	isc_nmhandle_detach(&xfr->client->sendhandle);
+	isc_nmhandle_detach(&tx->handle);
 
 	/*
 	 * Update transfer statistics if sending succeeded, accounting for the
@@ -1702,7 +2301,7 @@ xfrout_senddone(isc_nmhandle_t *handle, isc_result_t result, void *arg) {
 	 */
 	if (result == ISC_R_SUCCESS) {
 		xfr->stats.nmsg++;
-		xfr->stats.nbytes += xfr->cbytes;
+		xfr->stats.nbytes += tx->length;
 	}
 
 	if (xfr->shuttingdown) {
@@ -1710,9 +2309,9 @@ xfrout_senddone(isc_nmhandle_t *handle, isc_result_t result, void *arg) {
 	} else if (result != ISC_R_SUCCESS) {
 		xfrout_fail(xfr, result, "send");
 	} else if (!xfr->end_of_stream) {
-		sendstream(xfr);
-	} else {
-		/* End of zone transfer stream. */
+		xfrout_sendahead(xfr);
+	} else if (xfrout_queued(xfr) == 0) {
+		/* End of zone transfer stream, and all of it has been sent. */
 		uint64_t msecs, persec;
 
 		inc_stats(xfr->client, xfr->zone, ns_statscounter_xfrdone);
@@ -1754,6 +2353,20 @@ static void
 xfrout_maybe_destroy(xfrout_ctx_t *xfr) {
 	REQUIRE(xfr->shuttingdown);
 
+	if (xfr->sends > 0) {
+		/* The last send callback will finish the job. */
+		return;
+	}
+
+	if (xfr->delayed) {
+		/* Drop the send that the test options held back. */
+		isc_nm_timer_stop(xfr->delayed_send_timer);
+		if (xfr->tx != NULL) {
+			xfr->tx->busy = false;
+		}
+		xfr->delayed = false;
+	}
+
 	ns_client_drop(xfr->client, ISC_R_CANCELED);
 	isc_nmhandle_detach(&xfr->client->reqhandle);
 	xfrout_ctx_destroy(&xfr);
@@ -1763,9 +2376,7 @@ static void
 xfrout_client_timeout(void *arg, isc_result_t result) {
 	xfrout_ctx_t *xfr = (xfrout_ctx_t *)arg;
 
-	xfr->shuttingdown = true;
-	xfrout_log(xfr, ISC_LOG_ERROR, "%s: %s", "aborted",
-		   isc_result_totext(result));
+	xfrout_fail(xfr, result, "aborted");
 }
 
 /*
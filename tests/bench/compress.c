@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <isc/ascii.h>
 #include <isc/buffer.h>
 #include <isc/mem.h>
 #include <isc/result.h>
@@ -35,6 +36,113 @@ CHECKRESULT(isc_result_t result, const char *msg) {
 	}
 }
 
+/*
+ * Each workload renders the input names as a stream of messages of a
+ * given size. Every RR has a compressed owner name, ten bytes for the
+ * type, class, TTL and rdlength, and the next input name as its rdata,
+ * like the targets of NS, CNAME or RRSIG records. When an RR does not
+ * fit it is rolled back the same way as dns_rdataset_towire() does, and
+ * the message is sent and a new one started.
+ */
+struct workload {
+	const char *name;
+	unsigned int size;
+	dns_compress_flags_t flags;
+	bool mixcase;
+};
+
+static struct workload workloads[] = {
+	{ "udp", 512, 0, false },
+	{ "edns", 1232, 0, false },
+	{ "edns-mixcase", 1232, 0, true },
+	{ "edns-case", 4096, DNS_COMPRESS_CASE, true },
+	{ "axfr", 65535, DNS_COMPRESS_LARGE, false },
+	{ "axfr-mixcase", 65535, DNS_COMPRESS_LARGE, true },
+};
+
+static dns_fixedname_t fixedname[65536];
+static dns_fixedname_t mixedname[65536];
+static unsigned int count = 0;
+
+static isc_result_t
+render(dns_compress_t *cctx, isc_buffer_t *buf, dns_name_t *owner,
+       dns_name_t *target) {
+	isc_result_t result;
+	isc_buffer_t rrstart = *buf;
+
+	dns_compress_setpermitted(cctx, true);
+	result = dns_name_towire(owner, cctx, buf, NULL);
+	if (result != ISC_R_SUCCESS) {
+		goto rollback;
+	}
+	if (isc_buffer_availablelength(buf) < 10) {
+		result = ISC_R_NOSPACE;
+		goto rollback;
+	}
+	isc_buffer_putuint16(buf, 0);
+	isc_buffer_putuint16(buf, 0);
+	isc_buffer_putuint32(buf, 0);
+	isc_buffer_putuint16(buf, 0);
+	result = dns_name_towire(target, cctx, buf, NULL);
+	if (result != ISC_R_SUCCESS) {
+		goto rollback;
+	}
+	return (ISC_R_SUCCESS);
+
+rollback:
+	dns_compress_rollback(cctx, rrstart.used);
+	*buf = rrstart;
+	return (result);
+}
+
+static void
+run(isc_mem_t *mctx, struct workload *w) {
+	static uint8_t wire[65535];
+	unsigned int repeat = 100;
+	unsigned int messages = 0;
+	isc_buffer_t buf;
+	dns_compress_t cctx;
+
+	isc_time_t start = isc_time_now_hires();
+
+	for (unsigned int n = 0; n < repeat; n++) {
+		isc_buffer_init(&buf, wire, w->size);
+		isc_buffer_putuint16(&buf, 0xEAD);
+		dns_compress_init(&cctx, mctx, w->flags);
+
+		for (unsigned int i = 0; i < count; i++) {
+			dns_fixedname_t *names = w->mixcase && i % 2 == 1
+							 ? mixedname
+							 : fixedname;
+			dns_name_t *owner = dns_fixedname_name(&names[i]);
+			dns_name_t *target =
+				dns_fixedname_name(&names[(i + 1) % count]);
+			isc_result_t result = render(&cctx, &buf, owner,
+						     target);
+			if (result == ISC_R_NOSPACE) {
+				dns_compress_invalidate(&cctx);
+				dns_compress_init(&cctx, mctx, w->flags);
+				isc_buffer_init(&buf, wire, w->size);
+				isc_buffer_putuint16(&buf, 0xEAD);
+				messages++;
+				result = render(&cctx, &buf, owner, target);
+			}
+			CHECKRESULT(result, "render");
+		}
+		dns_compress_invalidate(&cctx);
+		messages++;
+	}
+
+	isc_time_t finish = isc_time_now_hires();
+
+	uint64_t microseconds = isc_time_microdiff(&finish, &start);
+	printf("%-14s %8.3f s %10.0f names/s %8u messages\n", w->name,
+	       (double)microseconds / 1000000.0,
+	       (double)count * 2 * repeat * 1000000.0 /
+		       (double)(microseconds > 0 ? microseconds : 1),
+	       messages / repeat);
+}
+
 int
 main(void) {
 	isc_result_t result;
@@ -43,9 +151,6 @@ main(void) {
 	isc_mem_t *mctx = NULL;
 	isc_mem_create(&mctx);
 
-	static dns_fixedname_t fixedname[65536];
-	unsigned int count = 0;
-
 	char *line = NULL;
 	size_t linecap = 0;
 	ssize_t linelen;
@@ -59,45 +164,33 @@ main(void) {
 		if (count == ARRAY_SIZE(fixedname)) {
 			errx(1, "too many names");
 		}
-		dns_name_t *name = dns_fixedname_initname(&fixedname[count++]);
+		dns_name_t *name = dns_fixedname_initname(&fixedname[count]);
 		result = dns_name_fromtext(name, &buf, dns_rootname, 0, NULL);
 		CHECKRESULT(result, line);
-	}
-
-	unsigned int repeat = 100;
-
-	isc_time_t start;
-	start = isc_time_now_hires();
-
-	for (unsigned int n = 0; n < repeat; n++) {
-		static uint8_t wire[4 * 1024];
-		dns_compress_t cctx;
-
-		isc_buffer_init(&buf, wire, sizeof(wire));
-		dns_compress_init(&cctx, mctx, 0);
 
-		for (unsigned int i = 0; i < count; i++) {
-			dns_name_t *name = dns_fixedname_name(&fixedname[i]);
-			result = dns_name_towire(name, &cctx, &buf, NULL);
-			if (result == ISC_R_NOSPACE) {
-				dns_compress_invalidate(&cctx);
-				dns_compress_init(&cctx, mctx, 0);
-				isc_buffer_init(&buf, wire, sizeof(wire));
-			} else {
-				CHECKRESULT(result, "dns_name_towire");
-			}
+		/*
+		 * The same name with every other letter in upper case, as
+		 * seen in queries from resolvers that use 0x20 encoding.
+		 */
+		dns_name_t *mixed = dns_fixedname_initname(&mixedname[count]);
+		dns_name_copy(name, mixed);
+		for (unsigned int i = 0; i < mixed->length; i += 2) {
+			mixed->ndata[i] = isc_ascii_toupper(mixed->ndata[i]);
 		}
-		dns_compress_invalidate(&cctx);
+		count++;
 	}
+	free(line);
 
-	isc_time_t finish;
-	finish = isc_time_now_hires();
-
-	uint64_t microseconds = isc_time_microdiff(&finish, &start);
-	printf("time %f / %u\n", (double)microseconds / 1000000.0, repeat);
+	if (count == 0) {
+		errx(1, "no names");
+	}
 
 	printf("names %u\n", count);
 
+	for (size_t i = 0; i < ARRAY_SIZE(workloads); i++) {
+		run(mctx, &workloads[i]);
+	}
+
 	isc_mem_destroy(&mctx);
 
 	return (0);
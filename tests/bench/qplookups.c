@@ -17,6 +17,7 @@
 #include <isc/commandline.h>
 #include <isc/file.h>
 #include <isc/ht.h>
+#include <isc/random.h>
 #include <isc/rwlock.h>
 #include <isc/time.h>
 #include <isc/util.h>
@@ -29,6 +30,12 @@
 #include <tests/dns.h>
 #include <tests/qp.h>
 
+/*
+ * Number of names passed to each dns_qp_getnames() call, as a caller
+ * with a list of names to check (such as RPZ) might do
+ */
+#define BATCH 64
+
 static inline size_t
 smallname_length(void *pval, uint32_t ival) {
 	UNUSED(pval);
@@ -123,7 +130,8 @@ const dns_qpmethods_t methods = {
 
 static void
 usage(void) {
-	fprintf(stderr, "usage: lookups <filename>\n");
+	fprintf(stderr, "usage: lookups [-H] <filename>\n");
+	fprintf(stderr, "\t-H\tallocate trie chunks from huge pages\n");
 	exit(EXIT_FAILURE);
 }
 
@@ -202,10 +210,26 @@ main(int argc, char **argv) {
 	dns_fixedname_t *items = NULL;
 	dns_qpiter_t it = { 0 };
 	dns_name_t *name = NULL;
+	const dns_name_t **shuffled = NULL;
+	isc_result_t *results = NULL;
 	size_t i = 0, n = 0;
 	char buf[BUFSIZ];
+	int opt;
+
+	while ((opt = isc_commandline_parse(argc, argv, "H")) != -1) {
+		switch (opt) {
+		case 'H':
+			dns_qp_hugepages(true);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	argc -= isc_commandline_index;
+	argv += isc_commandline_index;
 
-	if (argc != 2) {
+	if (argc != 1) {
 		usage();
 	}
 
@@ -214,13 +238,22 @@ main(int argc, char **argv) {
 	dns_qp_create(mctx, &methods, NULL, &qp);
 
 	start = isc_time_monotonic();
-	n = load_qp(qp, argv[1]);
+	n = load_qp(qp, argv[0]);
 	dns_qp_compact(qp, DNS_QPGC_ALL);
 	stop = isc_time_monotonic();
 
 	snprintf(buf, sizeof(buf), "load %zd names:", n);
 	printf("%-57s%7.3fsec\n", buf, (stop - start) / (double)NS_PER_SEC);
 
+	dns_qp_memusage_t memusage = dns_qp_memusage(qp);
+	printf("trie %zu chunks, %zu bytes\n", memusage.chunk_count,
+	       memusage.bytes);
+	if (memusage.hugepages) {
+		printf("huge page pool %zu bytes, %zu reserved, %zu free\n",
+		       memusage.pool_bytes, memusage.pool_resvd,
+		       memusage.pool_free);
+	}
+
 	items = isc_mem_cget(mctx, n, sizeof(dns_fixedname_t));
 	dns_qpiter_init(qp, &it);
 
@@ -257,6 +290,50 @@ main(int argc, char **argv) {
 	snprintf(buf, sizeof(buf), "look up %zd names (dns_qp_lookup):", n);
 	printf("%-57s%7.3fsec\n", buf, (stop - start) / (double)NS_PER_SEC);
 
+	/*
+	 * Looking names up in trie order means consecutive searches share
+	 * most of their path, so it mostly hits the cache. Shuffle them
+	 * to measure how well the lookups hide memory latency.
+	 */
+	shuffled = isc_mem_cget(mctx, n, sizeof(shuffled[0]));
+	for (i = 0; i < n; i++) {
+		shuffled[i] = dns_fixedname_name(&items[i]);
+	}
+	for (i = n; i > 1; i--) {
+		size_t j = isc_random_uniform(i);
+		const dns_name_t *tmp = shuffled[i - 1];
+		shuffled[i - 1] = shuffled[j];
+		shuffled[j] = tmp;
+	}
+	results = isc_mem_cget(mctx, n, sizeof(results[0]));
+
+	start = isc_time_monotonic();
+	for (i = 0; i < n; i++) {
+		results[i] = dns_qp_getname(qp, shuffled[i], NULL, NULL);
+	}
+	stop = isc_time_monotonic();
+
+	snprintf(buf, sizeof(buf),
+		 "look up %zd shuffled names (dns_qp_getname):", n);
+	printf("%-57s%7.3fsec\n", buf, (stop - start) / (double)NS_PER_SEC);
+
+	start = isc_time_monotonic();
+	for (i = 0; i < n; i += BATCH) {
+		dns_qp_getnames(qp, shuffled + i, ISC_MIN(n - i, BATCH),
+				results + i, NULL, NULL);
+	}
+	stop = isc_time_monotonic();
+
+	snprintf(buf, sizeof(buf),
+		 "look up %zd shuffled names (dns_qp_getnames):", n);
+	printf("%-57s%7.3fsec\n", buf, (stop - start) / (double)NS_PER_SEC);
+
+	for (i = 0; i < n; i++) {
+		INSIST(results[i] == ISC_R_SUCCESS);
+	}
+	isc_mem_cput(mctx, results, n, sizeof(results[0]));
+	isc_mem_cput(mctx, shuffled, n, sizeof(shuffled[0]));
+
 	start = isc_time_monotonic();
 	for (i = 0; i < n; i++) {
 		/*
@@ -0,0 +1,730 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * End-to-end query path benchmark.
+ *
+ * Synthetic wire-format queries are fed to ns_client_request() on every
+ * loop, exactly as the UDP listener would, and the responses are
+ * collected from isc_nm_send().  The network manager handle functions
+ * used by lib/ns are replaced below, so no sockets are involved: what is
+ * measured is client.c, query.c, message.c and the databases.
+ *
+ * The queries are an even mix of positive answers and NXDOMAINs from an
+ * authoritative qpzone, and of answers from a primed cache.
+ */
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <isc/async.h>
+#include <isc/atomic.h>
+#include <isc/buffer.h>
+#include <isc/commandline.h>
+#include <isc/histo.h>
+#include <isc/loop.h>
+#include <isc/managers.h>
+#include <isc/mem.h>
+#include <isc/netmgr.h>
+#include <isc/os.h>
+#include <isc/refcount.h>
+#include <isc/result.h>
+#include <isc/sockaddr.h>
+#include <isc/stdtime.h>
+#include <isc/thread.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/db.h>
+#include <dns/dispatch.h>
+#include <dns/fixedname.h>
+#include <dns/masterdump.h>
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdatalist.h>
+#include <dns/rdataset.h>
+#include <dns/view.h>
+#include <dns/zone.h>
+
+#include <ns/client.h>
+#include <ns/interfacemgr.h>
+#include <ns/server.h>
+
+#include <tests/dns.h>
+
+#if ISC_NETMGR_TRACE
+#define FLARG                                                                 \
+	, const char *func ISC_ATTR_UNUSED, const char *file ISC_ATTR_UNUSED, \
+		unsigned int line ISC_ATTR_UNUSED
+#else
+#define FLARG
+#endif
+
+#define ZONE_ORIGIN  "bench."
+#define CACHE_ORIGIN "cache."
+#define QUERY_BUFLEN 512
+#define NQUERIES     4096
+#define HISTO_BITS   4
+
+typedef struct bench_loop bench_loop_t;
+
+/*
+ * Stands in for an isc_nmhandle_t; the network manager functions that
+ * lib/ns calls on a handle are all overridden in this file.
+ */
+typedef struct bench_handle {
+	isc_refcount_t references;
+	bench_loop_t *bl;
+	void *data;
+	isc_nm_opaquecb_t doreset;
+	isc_nm_opaquecb_t dofree;
+	isc_sockaddr_t peer;
+	isc_nanosecs_t start;
+	isc_nm_cb_t sendcb;
+	void *sendcbarg;
+	unsigned char buf[QUERY_BUFLEN];
+	isc_region_t region;
+} bench_handle_t;
+
+struct bench_loop {
+	isc_loop_t *loop;
+	uint32_t tid;
+	uint64_t issued;
+	uint64_t inflight;
+	uint64_t responses;
+	uint64_t respbytes;
+	uint64_t allocs;
+	bool done;
+	isc_nanosecs_t start;
+	isc_nanosecs_t stop;
+	isc_histo_t *latency;
+};
+
+static uint32_t nloops = 0;
+static uint64_t queries_per_loop = 200000;
+static uint32_t window = 64;
+static uint32_t zone_names = 10000;
+static uint32_t cache_names = 10000;
+
+static bench_loop_t *loops = NULL;
+static atomic_uint_fast32_t running;
+
+static ns_server_t *sctx = NULL;
+static dns_dispatchmgr_t *dispatchmgr = NULL;
+static ns_interfacemgr_t *interfacemgr = NULL;
+static ns_interface_t interface;
+static dns_view_t *view = NULL;
+static dns_zone_t *zone = NULL;
+static char zonefile[] = "/tmp/query-bench-XXXXXX";
+
+static isc_region_t queries[NQUERIES];
+static unsigned char querydata[NQUERIES][QUERY_BUFLEN];
+
+/*
+ * Allocation counting.  Every isc_mem allocation ends up in jemalloc's
+ * mallocx(); when libisc is linked against jemalloc the definition below
+ * takes precedence and counts the calls made on each thread.
+ */
+static thread_local uint64_t allocs = 0;
+
+#if HAVE_JEMALLOC
+void *
+mallocx(size_t size, int flags) {
+	static void *(*real_mallocx)(size_t, int) = NULL;
+
+	if (real_mallocx == NULL) {
+		real_mallocx = (void *(*)(size_t, int))dlsym(RTLD_NEXT,
+							     "mallocx");
+		INSIST(real_mallocx != NULL);
+	}
+	allocs++;
+	return (real_mallocx(size, flags));
+}
+#endif /* HAVE_JEMALLOC */
+
+static void
+query_next(void *arg);
+
+static void
+handle_free(bench_handle_t *handle) {
+	bench_loop_t *bl = handle->bl;
+
+	if (handle->doreset != NULL) {
+		handle->doreset(handle->data);
+	}
+	if (handle->dofree != NULL) {
+		handle->dofree(handle->data);
+	}
+	isc_refcount_destroy(&handle->references);
+	isc_mem_put(mctx, handle, sizeof(*handle));
+
+	/*
+	 * A query is complete once lib/ns lets go of its handle, whether a
+	 * response was sent or not.  Start the next one from a fresh stack.
+	 */
+	bl->inflight--;
+	isc_async_run(bl->loop, query_next, bl);
+}
+
+#if ISC_NETMGR_TRACE
+void
+isc_nmhandle__attach(isc_nmhandle_t *source, isc_nmhandle_t **targetp FLARG) {
+#else
+void
+isc_nmhandle_attach(isc_nmhandle_t *source, isc_nmhandle_t **targetp) {
+#endif
+	bench_handle_t *handle = (bench_handle_t *)source;
+
+	REQUIRE(targetp != NULL && *targetp == NULL);
+
+	isc_refcount_increment(&handle->references);
+	*targetp = source;
+}
+
+#if ISC_NETMGR_TRACE
+void
+isc_nmhandle__detach(isc_nmhandle_t **handlep FLARG) {
+#else
+void
+isc_nmhandle_detach(isc_nmhandle_t **handlep) {
+#endif
+	bench_handle_t *handle = NULL;
+
+	REQUIRE(handlep != NULL && *handlep != NULL);
+
+	handle = (bench_handle_t *)*handlep;
+	*handlep = NULL;
+
+	if (isc_refcount_decrement(&handle->references) == 1) {
+		handle_free(handle);
+	}
+}
+
+void *
+isc_nmhandle_getdata(isc_nmhandle_t *handle0) {
+	bench_handle_t *handle = (bench_handle_t *)handle0;
+
+	return (handle->data);
+}
+
+void
+isc_nmhandle_setdata(isc_nmhandle_t *handle0, void *arg,
+		     isc_nm_opaquecb_t doreset, isc_nm_opaquecb_t dofree) {
+	bench_handle_t *handle = (bench_handle_t *)handle0;
+
+	handle->data = arg;
+	handle->doreset = doreset;
+	handle->dofree = dofree;
+}
+
+bool
+isc_nmhandle_is_stream(isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (false);
+}
+
+isc_nmsocket_type
+isc_nm_socket_type(const isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (isc_nm_udpsocket);
+}
+
+bool
+isc_nm_has_encryption(const isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (false);
+}
+
+bool
+isc_nm_is_http_handle(isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (false);
+}
+
+bool
+isc_nm_is_proxy_handle(isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (false);
+}
+
+isc_sockaddr_t
+isc_nmhandle_peeraddr(isc_nmhandle_t *handle0) {
+	bench_handle_t *handle = (bench_handle_t *)handle0;
+
+	return (handle->peer);
+}
+
+isc_sockaddr_t
+isc_nmhandle_localaddr(isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (interface.addr);
+}
+
+isc_sockaddr_t
+isc_nmhandle_real_peeraddr(isc_nmhandle_t *handle) {
+	return (isc_nmhandle_peeraddr(handle));
+}
+
+isc_sockaddr_t
+isc_nmhandle_real_localaddr(isc_nmhandle_t *handle) {
+	return (isc_nmhandle_localaddr(handle));
+}
+
+isc_nm_t *
+isc_nmhandle_netmgr(isc_nmhandle_t *handle ISC_ATTR_UNUSED) {
+	return (netmgr);
+}
+
+void
+isc_nmhandle_keepalive(isc_nmhandle_t *handle ISC_ATTR_UNUSED,
+		       bool value ISC_ATTR_UNUSED) {}
+
+void
+isc_nm_set_maxage(isc_nmhandle_t *handle ISC_ATTR_UNUSED,
+		  const uint32_t ttl ISC_ATTR_UNUSED) {}
+
+void
+isc_nm_bad_request(isc_nmhandle_t *handle ISC_ATTR_UNUSED) {}
+
+static void
+send_done(void *arg) {
+	bench_handle_t *handle = arg;
+
+	handle->sendcb((isc_nmhandle_t *)handle, ISC_R_SUCCESS,
+		       handle->sendcbarg);
+}
+
+void
+isc_nm_send(isc_nmhandle_t *handle0, isc_region_t *region, isc_nm_cb_t cb,
+	    void *cbarg) {
+	bench_handle_t *handle = (bench_handle_t *)handle0;
+	bench_loop_t *bl = handle->bl;
+
+	isc_histo_inc(bl->latency, isc_time_monotonic() - handle->start);
+	bl->responses++;
+	bl->respbytes += region->length;
+
+	/* Like the real thing, complete the send asynchronously. */
+	handle->sendcb = cb;
+	handle->sendcbarg = cbarg;
+	isc_async_run(bl->loop, send_done, handle);
+}
+
+static isc_result_t
+matchview(isc_netaddr_t *srcaddr ISC_ATTR_UNUSED,
+	  isc_netaddr_t *destaddr ISC_ATTR_UNUSED,
+	  dns_message_t *message ISC_ATTR_UNUSED,
+	  dns_aclenv_t *env ISC_ATTR_UNUSED,
+	  isc_result_t *sigresultp ISC_ATTR_UNUSED, dns_view_t **viewp) {
+	dns_view_attach(view, viewp);
+	return (ISC_R_SUCCESS);
+}
+
+static void
+query_send(bench_loop_t *bl) {
+	bench_handle_t *handle = NULL;
+	isc_nmhandle_t *nmhandle = NULL;
+	isc_region_t *query = &queries[(bl->issued * nloops + bl->tid) %
+				       NQUERIES];
+	struct in_addr ina = { .s_addr = htonl(0xc0000200 + bl->tid) };
+
+	handle = isc_mem_get(mctx, sizeof(*handle));
+	*handle = (bench_handle_t){
+		.bl = bl,
+		.region = { .base = handle->buf, .length = query->length },
+	};
+	isc_refcount_init(&handle->references, 1);
+	isc_sockaddr_fromin(&handle->peer, &ina,
+			    1024 + (bl->issued % 60000));
+	memmove(handle->buf, query->base, query->length);
+
+	bl->issued++;
+	bl->inflight++;
+
+	/*
+	 * The reference taken at creation belongs to the "listener" and
+	 * is dropped as soon as the request has been handed over.
+	 */
+	nmhandle = (isc_nmhandle_t *)handle;
+	handle->start = isc_time_monotonic();
+	ns_client_request(nmhandle, ISC_R_SUCCESS, &handle->region,
+			  &interface);
+	isc_nmhandle_detach(&nmhandle);
+}
+
+static void
+shutdown_bench(void *arg ISC_ATTR_UNUSED);
+
+static void
+query_next(void *arg) {
+	bench_loop_t *bl = arg;
+
+	if (bl->issued < queries_per_loop) {
+		query_send(bl);
+		return;
+	}
+
+	if (bl->inflight == 0 && !bl->done) {
+		bl->done = true;
+		bl->stop = isc_time_monotonic();
+		bl->allocs = allocs - bl->allocs;
+		if (atomic_fetch_sub_release(&running, 1) == 1) {
+			isc_async_run(isc_loop_main(loopmgr), shutdown_bench,
+				      NULL);
+		}
+	}
+}
+
+static void
+start_loop(void *arg) {
+	bench_loop_t *bl = arg;
+
+	bl->allocs = allocs;
+	bl->start = isc_time_monotonic();
+	for (uint32_t i = 0; i < window && bl->issued < queries_per_loop; i++)
+	{
+		query_send(bl);
+	}
+}
+
+static void
+make_query(isc_region_t *region, unsigned char *buf, uint16_t id,
+	   const char *qname, bool rd) {
+	dns_fixedname_t fixed;
+	dns_name_t *name = dns_fixedname_initname(&fixed);
+	isc_buffer_t b;
+	isc_result_t result;
+
+	result = dns_name_fromstring(name, qname, dns_rootname, 0, NULL);
+	INSIST(result == ISC_R_SUCCESS);
+
+	isc_buffer_init(&b, buf, QUERY_BUFLEN);
+	isc_buffer_putuint16(&b, id);
+	isc_buffer_putuint16(&b, rd ? DNS_MESSAGEFLAG_RD : 0);
+	isc_buffer_putuint16(&b, 1); /* QDCOUNT */
+	isc_buffer_putuint16(&b, 0); /* ANCOUNT */
+	isc_buffer_putuint16(&b, 0); /* NSCOUNT */
+	isc_buffer_putuint16(&b, 1); /* ARCOUNT */
+	isc_buffer_putmem(&b, name->ndata, name->length);
+	isc_buffer_putuint16(&b, dns_rdatatype_a);
+	isc_buffer_putuint16(&b, dns_rdataclass_in);
+
+	/* EDNS OPT record, 1232 byte UDP payload. */
+	isc_buffer_putuint8(&b, 0);
+	isc_buffer_putuint16(&b, dns_rdatatype_opt);
+	isc_buffer_putuint16(&b, 1232);
+	isc_buffer_putuint32(&b, 0);
+	isc_buffer_putuint16(&b, 0);
+
+	isc_buffer_usedregion(&b, region);
+}
+
+/*
+ * Queries are drawn from a fixed pseudo-random sequence so that runs
+ * are comparable.
+ */
+static void
+make_queries(void) {
+	uint32_t state = 2463534242;
+	char qname[DNS_NAME_FORMATSIZE];
+
+	for (size_t i = 0; i < NQUERIES; i++) {
+		uint32_t r;
+
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		r = state;
+
+		switch (i % 3) {
+		case 0:
+			snprintf(qname, sizeof(qname), "z%u." ZONE_ORIGIN,
+				 r % zone_names);
+			break;
+		case 1:
+			snprintf(qname, sizeof(qname), "nx%u." ZONE_ORIGIN,
+				 r % zone_names);
+			break;
+		case 2:
+			snprintf(qname, sizeof(qname), "c%u." CACHE_ORIGIN,
+				 r % cache_names);
+			break;
+		}
+		make_query(&queries[i], querydata[i], i, qname, i % 3 == 2);
+	}
+}
+
+static void
+write_zone(void) {
+	FILE *fp = NULL;
+	int fd;
+
+	fd = mkstemp(zonefile);
+	if (fd == -1 || (fp = fdopen(fd, "w")) == NULL) {
+		perror(zonefile);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(fp, "$TTL 3600\n"
+		    "@ SOA ns hostmaster 1 3600 900 604800 300\n"
+		    "@ NS ns\n"
+		    "ns A 192.0.2.1\n");
+	for (uint32_t i = 0; i < zone_names; i++) {
+		fprintf(fp, "z%u A 198.51.%u.%u\n", i, (i >> 8) & 0xff,
+			i & 0xff);
+	}
+
+	fclose(fp);
+}
+
+static void
+prime_cache(void) {
+	dns_db_t *db = NULL;
+	isc_stdtime_t now = isc_stdtime_now();
+	isc_result_t result;
+
+	dns_db_attach(view->cachedb, &db);
+
+	for (uint32_t i = 0; i < cache_names; i++) {
+		dns_fixedname_t fixed;
+		dns_name_t *name = dns_fixedname_initname(&fixed);
+		dns_dbnode_t *node = NULL;
+		dns_rdatalist_t rdatalist;
+		dns_rdataset_t rdataset;
+		dns_rdata_t rdata = DNS_RDATA_INIT;
+		unsigned char addr[4] = { 203, 0, (i >> 8) & 0xff, i & 0xff };
+		isc_region_t r = { .base = addr, .length = sizeof(addr) };
+		char text[DNS_NAME_FORMATSIZE];
+
+		snprintf(text, sizeof(text), "c%u." CACHE_ORIGIN, i);
+		result = dns_name_fromstring(name, text, dns_rootname, 0,
+					     NULL);
+		INSIST(result == ISC_R_SUCCESS);
+
+		dns_rdata_fromregion(&rdata, dns_rdataclass_in,
+				     dns_rdatatype_a, &r);
+		dns_rdatalist_init(&rdatalist);
+		rdatalist.rdclass = dns_rdataclass_in;
+		rdatalist.type = dns_rdatatype_a;
+		rdatalist.ttl = 86400;
+		ISC_LIST_APPEND(rdatalist.rdata, &rdata, link);
+
+		dns_rdataset_init(&rdataset);
+		dns_rdatalist_tordataset(&rdatalist, &rdataset);
+		rdataset.trust = dns_trust_answer;
+
+		result = dns_db_findnode(db, name, true, &node);
+		INSIST(result == ISC_R_SUCCESS);
+		result = dns_db_addrdataset(db, node, NULL, now, &rdataset, 0,
+					    NULL);
+		INSIST(result == ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+		dns_rdataset_disassociate(&rdataset);
+	}
+
+	dns_db_detach(&db);
+}
+
+static isc_result_t
+zone_loaded(void *arg ISC_ATTR_UNUSED) {
+	(void)unlink(zonefile);
+
+	prime_cache();
+	dns_view_freeze(view);
+
+	atomic_store_release(&running, nloops);
+	for (uint32_t i = 0; i < nloops; i++) {
+		isc_async_run(loops[i].loop, start_loop, &loops[i]);
+	}
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+startup(void *arg ISC_ATTR_UNUSED) {
+	struct in_addr ina = { .s_addr = htonl(0x7f000001) };
+	isc_result_t result;
+
+	ns_server_create(mctx, matchview, &sctx);
+
+	result = dns_dispatchmgr_create(mctx, loopmgr, netmgr, &dispatchmgr);
+	INSIST(result == ISC_R_SUCCESS);
+
+	result = ns_interfacemgr_create(mctx, sctx, loopmgr, netmgr,
+					dispatchmgr, NULL, false,
+					&interfacemgr);
+	INSIST(result == ISC_R_SUCCESS);
+
+	interface = (ns_interface_t){ .mgr = interfacemgr };
+	isc_sockaddr_fromin(&interface.addr, &ina, 53);
+
+	result = dns_test_makeview("bench", false, true, &view);
+	INSIST(result == ISC_R_SUCCESS);
+
+	write_zone();
+	result = dns_test_makezone(ZONE_ORIGIN, &zone, view, false);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zone_setnotifytype(zone, dns_notifytype_no);
+	dns_zone_setfile(zone, zonefile, dns_masterformat_text,
+			 &dns_master_style_default);
+
+	dns_test_setupzonemgr();
+	result = dns_test_managezone(zone);
+	INSIST(result == ISC_R_SUCCESS);
+
+	result = dns_zone_asyncload(zone, false, zone_loaded, NULL);
+	INSIST(result == ISC_R_SUCCESS);
+}
+
+static void
+report(void) {
+	static const double fractions[] = { 0.999, 0.99, 0.9, 0.5 };
+	uint64_t values[ARRAY_SIZE(fractions)];
+	isc_histo_t *latency = NULL;
+	uint64_t responses = 0, respbytes = 0, allocs_total = 0;
+	double qps = 0.0;
+	char buf[BUFSIZ];
+
+	for (uint32_t i = 0; i < nloops; i++) {
+		bench_loop_t *bl = &loops[i];
+		double secs = (bl->stop - bl->start) / (double)NS_PER_SEC;
+
+		qps += bl->responses / secs;
+		responses += bl->responses;
+		respbytes += bl->respbytes;
+		allocs_total += bl->allocs;
+		isc_histo_merge(&latency, bl->latency);
+	}
+
+	snprintf(buf, sizeof(buf), "%u loops, %" PRIu64 " responses:",
+		 nloops, responses);
+	printf("%-40s%12.0f qps\n", buf, qps);
+	printf("%-40s%12.0f qps\n", "per loop:", qps / nloops);
+	printf("%-40s%12.1f bytes\n", "mean response size:",
+	       responses > 0 ? respbytes / (double)responses : 0.0);
+#if HAVE_JEMALLOC
+	printf("%-40s%12.1f\n", "allocations per query:",
+	       allocs_total / (double)(queries_per_loop * nloops));
+#else
+	UNUSED(allocs_total);
+	printf("%-40s%12s\n", "allocations per query:", "n/a");
+#endif
+
+	if (isc_histo_quantiles(latency, ARRAY_SIZE(fractions), fractions,
+				values) == ISC_R_SUCCESS)
+	{
+		for (size_t i = 0; i < ARRAY_SIZE(fractions); i++) {
+			snprintf(buf, sizeof(buf), "latency p%g:",
+				 fractions[i] * 100);
+			printf("%-40s%12.3f usec\n", buf, values[i] / 1000.0);
+		}
+	}
+
+	isc_histo_destroy(&latency);
+}
+
+static void
+shutdown_bench(void *arg ISC_ATTR_UNUSED) {
+	report();
+
+	dns_test_releasezone(zone);
+	dns_test_closezonemgr();
+	dns_zone_detach(&zone);
+	dns_view_detach(&view);
+
+	ns_interfacemgr_shutdown(interfacemgr);
+	ns_interfacemgr_detach(&interfacemgr);
+	dns_dispatchmgr_detach(&dispatchmgr);
+	ns_server_detach(&sctx);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+		"usage: query [-c names] [-l loops] [-n queries] [-w window] "
+		"[-z names]\n"
+		"	-c	number of names in the cache (default 10000)\n"
+		"	-l	number of loops (default: number of CPUs)\n"
+		"	-n	queries per loop (default 200000)\n"
+		"	-w	outstanding queries per loop (default 64)\n"
+		"	-z	number of names in the zone (default 10000)\n");
+}
+
+int
+main(int argc, char *argv[]) {
+	int opt;
+
+	while ((opt = isc_commandline_parse(argc, argv, "c:l:n:w:z:")) != -1)
+	{
+		switch (opt) {
+		case 'c':
+			cache_names = atoi(isc_commandline_argument);
+			break;
+		case 'l':
+			nloops = atoi(isc_commandline_argument);
+			break;
+		case 'n':
+			queries_per_loop = strtoull(isc_commandline_argument,
+						    NULL, 10);
+			break;
+		case 'w':
+			window = atoi(isc_commandline_argument);
+			break;
+		case 'z':
+			zone_names = atoi(isc_commandline_argument);
+			break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (nloops == 0) {
+		nloops = isc_os_ncpus();
+	}
+	if (window == 0 || zone_names == 0 || cache_names == 0) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	isc_mem_create(&mctx);
+	isc_loopmgr_create(mctx, nloops, &loopmgr);
+	isc_netmgr_create(mctx, loopmgr, &netmgr);
+
+	make_queries();
+
+	loops = isc_mem_cget(mctx, nloops, sizeof(loops[0]));
+	for (uint32_t i = 0; i < nloops; i++) {
+		loops[i] = (bench_loop_t){
+			.loop = isc_loop_get(loopmgr, i),
+			.tid = i,
+		};
+		isc_histo_create(mctx, HISTO_BITS, &loops[i].latency);
+	}
+
+	isc_loop_setup(isc_loop_main(loopmgr), startup, NULL);
+	isc_loopmgr_run(loopmgr);
+
+	for (uint32_t i = 0; i < nloops; i++) {
+		isc_histo_destroy(&loops[i].latency);
+	}
+	isc_mem_cput(mctx, loops, nloops, sizeof(loops[0]));
+
+	isc_netmgr_destroy(&netmgr);
+	isc_loopmgr_destroy(&loopmgr);
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
@@ -395,6 +395,25 @@ nameserver(isc_nmhandle_t *handle, isc_result_t eresult, isc_region_t *region,
 	isc_nm_send(handle, &response2, server_senddone, NULL);
 }
 
+static void
+single_nameserver(isc_nmhandle_t *handle, isc_result_t eresult,
+		  isc_region_t *region, void *arg ISC_ATTR_UNUSED) {
+	isc_region_t response;
+	static unsigned char buf[16];
+
+	if (eresult != ISC_R_SUCCESS) {
+		return;
+	}
+
+	memmove(buf, region->base, 12);
+	memset(buf + 12, 0, 4);
+	buf[2] |= 0x80; /* qr=1 */
+
+	response.base = buf;
+	response.length = sizeof(buf);
+	isc_nm_send(handle, &response, server_senddone, NULL);
+}
+
 static isc_result_t
 accept_cb(isc_nmhandle_t *handle, isc_result_t eresult, void *arg) {
 	UNUSED(handle);
@@ -546,6 +565,42 @@ connected_newtcp(isc_result_t eresult ISC_ATTR_UNUSED,
 	test_dispatch_done(test3);
 }
 
+static void
+response_keepalive(isc_result_t eresult, isc_region_t *region ISC_ATTR_UNUSED,
+		   void *arg) {
+	test_dispatch_t *test1 = arg;
+	dns_dispatch_t *disp = test1->dispatch;
+	isc_result_t result;
+
+	assert_int_equal(eresult, ISC_R_SUCCESS);
+
+	/* Client 2 */
+	test_dispatch_t *test2 = isc_mem_get(mctx, sizeof(*test2));
+	*test2 = (test_dispatch_t){
+		.dispatchmgr = dns_dispatchmgr_ref(test1->dispatchmgr),
+	};
+
+	/* The last response is done, but the connection stays open */
+	test_dispatch_done(test1);
+
+	result = dns_dispatch_gettcp(test2->dispatchmgr, &tcp_server_addr,
+				     &tcp_connect_addr, &test2->dispatch);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_ptr_equal(test2->dispatch, disp);
+
+	result = dns_dispatch_add(test2->dispatch, isc_loop_main(loopmgr), 0,
+				  T_CLIENT_CONNECT, &tcp_server_addr, NULL,
+				  NULL, connected, client_senddone,
+				  response_shutdown, test2, &test2->id,
+				  &test2->dispentry);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	testdata.message[0] = (test2->id >> 8) & 0xff;
+	testdata.message[1] = test2->id & 0xff;
+
+	dns_dispatch_connect(test2->dispentry);
+}
+
 static void
 timeout_connected(isc_result_t eresult, isc_region_t *region ISC_ATTR_UNUSED,
 		  void *arg) {
@@ -845,9 +900,48 @@ ISC_LOOP_TEST_IMPL(dispatch_newtcp) {
 	dns_dispatch_connect(test->dispentry);
 }
 
+ISC_LOOP_TEST_IMPL(dispatch_keepalive) {
+	isc_result_t result;
+	test_dispatch_t *test = isc_mem_get(mctx, sizeof(*test));
+	*test = (test_dispatch_t){ 0 };
+
+	/* Server */
+	result = isc_nm_listenstreamdns(
+		netmgr, ISC_NM_LISTEN_ONE, &tcp_server_addr, single_nameserver,
+		NULL, accept_cb, NULL, 0, NULL, NULL, ISC_NM_PROXY_NONE, &sock);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	isc_loop_teardown(isc_loop_main(loopmgr), stop_listening, sock);
+
+	/* Client */
+	testdata.region.base = testdata.message;
+	testdata.region.length = sizeof(testdata.message);
+
+	result = dns_dispatchmgr_create(mctx, loopmgr, connect_nm,
+					&test->dispatchmgr);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_dispatch_createtcp(
+		test->dispatchmgr, &tcp_connect_addr, &tcp_server_addr,
+		DNS_DISPATCHOPT_KEEPALIVE, &test->dispatch);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_dispatch_add(
+		test->dispatch, isc_loop_main(loopmgr), 0, T_CLIENT_CONNECT,
+		&tcp_server_addr, NULL, NULL, connected, client_senddone,
+		response_keepalive, test, &test->id, &test->dispentry);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	testdata.message[0] = (test->id >> 8) & 0xff;
+	testdata.message[1] = test->id & 0xff;
+
+	dns_dispatch_connect(test->dispentry);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY_CUSTOM(dispatch_gettcp, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatch_newtcp, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(dispatch_keepalive, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatch_timeout_udp_response, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatchset_create, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatchset_get, setup_test, teardown_test)
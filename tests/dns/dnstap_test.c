@@ -285,6 +285,114 @@ ISC_RUN_TEST_IMPL(dns_dt_send) {
 	}
 }
 
+/* sample dnstap messages */
+ISC_RUN_TEST_IMPL(dns_dt_sample) {
+	isc_result_t result;
+	dns_dtenv_t *dtenv = NULL;
+	dns_dthandle_t *handle = NULL;
+	dns_view_t *view = NULL;
+	struct fstrm_iothr_options *fopt;
+	unsigned char qambuffer[4096], rambuffer[4096];
+	isc_buffer_t qamsg, ramsg;
+	size_t qasize, rasize;
+	isc_sockaddr_t qaddr, raddr;
+	struct in_addr in;
+	uint8_t *data;
+	size_t dsize;
+	size_t nmessage = 0, nquery = 0, nresponse = 0;
+
+	result = dns_test_makeview("test", false, false, &view);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	fopt = fstrm_iothr_options_init();
+	assert_non_null(fopt);
+	fstrm_iothr_options_set_num_input_queues(fopt, 1);
+
+	result = dns_dt_create(mctx, dns_dtmode_file, TAPFILE, &fopt, NULL,
+			       &dtenv);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	dns_dt_attach(dtenv, &view->dtenv);
+	view->dttypes = DNS_DTTYPE_ALL;
+
+	result = dns_test_getdata(TESTS_DIR "/testdata/dnstap/query.auth",
+				  qambuffer, sizeof(qambuffer), &qasize);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	isc_buffer_init(&qamsg, qambuffer, qasize);
+	isc_buffer_add(&qamsg, qasize);
+
+	result = dns_test_getdata(TESTS_DIR "/testdata/dnstap/response.auth",
+				  rambuffer, sizeof(rambuffer), &rasize);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	isc_buffer_init(&ramsg, rambuffer, rasize);
+	isc_buffer_add(&ramsg, rasize);
+
+	in.s_addr = inet_addr("10.53.0.1");
+	isc_sockaddr_fromin(&raddr, &in, 53);
+
+	/* One out of every four messages */
+	dns_dt_setsampling(dtenv, 4, dns_dtsample_message);
+	for (size_t i = 0; i < 64; i++) {
+		in.s_addr = inet_addr("10.53.0.2");
+		isc_sockaddr_fromin(&qaddr, &in, 2112);
+		dns_dt_send(view, DNS_DTTYPE_TQ, &qaddr, &raddr,
+			    DNS_TRANSPORT_UDP, NULL, NULL, NULL, &qamsg);
+	}
+
+	/* Queries and responses from one out of every four networks */
+	dns_dt_setsampling(dtenv, 4, dns_dtsample_client);
+	for (size_t i = 0; i < 256; i++) {
+		in.s_addr = htonl(0x0a000000 | (i << 8) | 1);
+		isc_sockaddr_fromin(&qaddr, &in, 2112);
+		dns_dt_send(view, DNS_DTTYPE_AQ, &qaddr, &raddr,
+			    DNS_TRANSPORT_UDP, NULL, NULL, NULL, &qamsg);
+		dns_dt_send(view, DNS_DTTYPE_AR, &qaddr, &raddr,
+			    DNS_TRANSPORT_UDP, NULL, NULL, NULL, &ramsg);
+	}
+
+	dns_dt_detach(&view->dtenv);
+	dns_dt_detach(&dtenv);
+	dns_view_detach(&view);
+
+	result = dns_dt_open(TAPFILE, dns_dtmode_file, mctx, &handle);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	while (dns_dt_getframe(handle, &data, &dsize) == ISC_R_SUCCESS) {
+		dns_dtdata_t *dtdata = NULL;
+		isc_region_t r = { .base = data, .length = dsize };
+
+		result = dns_dt_parse(mctx, &r, &dtdata);
+		assert_int_equal(result, ISC_R_SUCCESS);
+
+		switch (dtdata->type) {
+		case DNS_DTTYPE_TQ:
+			nmessage++;
+			break;
+		case DNS_DTTYPE_AQ:
+			nquery++;
+			break;
+		case DNS_DTTYPE_AR:
+			nresponse++;
+			break;
+		default:
+			fail();
+		}
+
+		dns_dtdata_free(&dtdata);
+	}
+
+	assert_int_equal(nmessage, 16);
+	assert_int_equal(nquery, nresponse);
+	assert_in_range(nquery, 1, 255);
+
+	if (fopt != NULL) {
+		fstrm_iothr_options_destroy(&fopt);
+	}
+	if (handle != NULL) {
+		dns_dt_close(&handle);
+	}
+}
+
 /* dnstap message to text */
 ISC_RUN_TEST_IMPL(dns_dt_totext) {
 	isc_result_t result;
@@ -354,6 +462,7 @@ ISC_TEST_LIST_START
 
 ISC_TEST_ENTRY_CUSTOM(dns_dt_create, setup, cleanup)
 ISC_TEST_ENTRY_CUSTOM(dns_dt_send, setup, cleanup)
+ISC_TEST_ENTRY_CUSTOM(dns_dt_sample, setup, cleanup)
 ISC_TEST_ENTRY_CUSTOM(dns_dt_totext, setup, cleanup)
 
 ISC_TEST_LIST_END
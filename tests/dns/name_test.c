@@ -452,6 +452,56 @@ ISC_RUN_TEST_IMPL(collision) {
 	dns_compress_invalidate(&cctx);
 }
 
+/*
+ * test case-insensitive compression of labels long enough to be hashed
+ * a word at a time
+ */
+static void
+longlabel_test(dns_compress_flags_t flags, unsigned int expect_prefix,
+	       unsigned int expect_coff) {
+	dns_compress_t cctx;
+	isc_buffer_t message;
+	uint8_t msgbuf[256];
+	unsigned int prefix_len, suffix_coff;
+	dns_name_t name1, name2;
+	isc_region_t r;
+	unsigned char plain1[] = "\020SignerKeyLabel01\007Example\003COM";
+	unsigned char plain2[] = "\020signerkeylabel01\007Example\003COM";
+
+	dns_name_init(&name1, NULL);
+	r = (isc_region_t){ .base = plain1, .length = sizeof(plain1) };
+	dns_name_fromregion(&name1, &r);
+
+	dns_name_init(&name2, NULL);
+	r = (isc_region_t){ .base = plain2, .length = sizeof(plain2) };
+	dns_name_fromregion(&name2, &r);
+
+	dns_compress_init(&cctx, mctx, flags);
+	isc_buffer_init(&message, msgbuf, sizeof(msgbuf));
+	isc_buffer_putuint16(&message, 0xEAD);
+
+	assert_int_equal(dns_name_towire(&name1, &cctx, &message, NULL),
+			 ISC_R_SUCCESS);
+
+	prefix_len = name2.length;
+	suffix_coff = 0;
+	dns_compress_name(&cctx, &message, &name2, &prefix_len, &suffix_coff);
+	assert_int_equal(prefix_len, expect_prefix);
+	assert_int_equal(suffix_coff, expect_coff);
+
+	dns_compress_invalidate(&cctx);
+}
+
+ISC_RUN_TEST_IMPL(longlabels) {
+	UNUSED(state);
+
+	/* the whole name matches */
+	longlabel_test(0, 0, 2);
+
+	/* only "Example.COM" matches */
+	longlabel_test(DNS_COMPRESS_CASE, 17, 2 + 17);
+}
+
 ISC_RUN_TEST_IMPL(fromregion) {
 	dns_name_t name;
 	isc_buffer_t b;
@@ -921,6 +971,82 @@ ISC_RUN_TEST_IMPL(maxlabels) {
 	assert_int_equal(dns_name_countlabels(name), DNS_NAME_MAXLABELS);
 }
 
+/* dns_name_fromtext() with labels long enough to be copied in bulk */
+ISC_RUN_TEST_IMPL(fromtext) {
+	isc_result_t result;
+	dns_fixedname_t fixed;
+	dns_name_t *name = dns_fixedname_initname(&fixed);
+	char text[DNS_NAME_FORMATSIZE];
+	char expect[DNS_NAME_FORMATSIZE];
+	char output[DNS_NAME_FORMATSIZE];
+	isc_buffer_t b;
+	struct {
+		const char *text;
+		unsigned int options;
+		isc_result_t result;
+		const char *expect;
+	} data[] = {
+		{ "abcdefghijklmnopqrstuvwxyz.example", 0, ISC_R_SUCCESS,
+		  "abcdefghijklmnopqrstuvwxyz.example." },
+		{ "ABCDEFGHIJKLMNOPQRSTUVWXYZ.Example", DNS_NAME_DOWNCASE,
+		  ISC_R_SUCCESS, "abcdefghijklmnopqrstuvwxyz.example." },
+		{ "ABCDEFGHIJKLMNOPQRSTUVWXYZ.Example", 0, ISC_R_SUCCESS,
+		  "ABCDEFGHIJKLMNOPQRSTUVWXYZ.Example." },
+		{ "abcdefghijklmno\\065BC.example", DNS_NAME_DOWNCASE,
+		  ISC_R_SUCCESS, "abcdefghijklmnoabc.example." },
+		{ "abcdefghijklmnopq..example", 0, DNS_R_EMPTYLABEL, NULL },
+	};
+
+	UNUSED(state);
+
+	for (size_t i = 0; i < ARRAY_SIZE(data); i++) {
+		isc_buffer_constinit(&b, data[i].text, strlen(data[i].text));
+		isc_buffer_add(&b, strlen(data[i].text));
+		result = dns_name_fromtext(name, &b, dns_rootname,
+					   data[i].options, NULL);
+		assert_int_equal(result, data[i].result);
+		if (result == ISC_R_SUCCESS) {
+			dns_name_format(name, output, sizeof(output));
+			assert_string_equal(output, data[i].expect);
+		}
+	}
+
+	/*
+	 * Labels of every length up to and past the maximum, with an
+	 * escaped dot at every position (or none).
+	 */
+	for (size_t len = 1; len <= DNS_NAME_LABELLEN + 8; len++) {
+		for (size_t dot = 0; dot <= len; dot++) {
+			size_t n = 0;
+
+			for (size_t j = 0; j < len; j++) {
+				if (j == dot) {
+					text[n++] = '\\';
+					text[n++] = '.';
+				} else {
+					text[n++] = 'a' + j % 26;
+				}
+			}
+			strlcpy(text + n, ".example", sizeof(text) - n);
+			strlcpy(expect, text, sizeof(expect));
+			strlcat(expect, ".", sizeof(expect));
+
+			isc_buffer_constinit(&b, text, strlen(text));
+			isc_buffer_add(&b, strlen(text));
+			result = dns_name_fromtext(name, &b, dns_rootname, 0,
+						   NULL);
+			if (len > DNS_NAME_LABELLEN) {
+				assert_int_equal(result, DNS_R_LABELTOOLONG);
+				continue;
+			}
+			assert_int_equal(result, ISC_R_SUCCESS);
+			assert_int_equal(dns_name_countlabels(name), 3);
+			dns_name_format(name, output, sizeof(output));
+			assert_string_equal(output, expect);
+		}
+	}
+}
+
 #ifdef DNS_BENCHMARK_TESTS
 
 /*
@@ -1006,6 +1132,7 @@ ISC_TEST_LIST_START
 ISC_TEST_ENTRY(fullcompare)
 ISC_TEST_ENTRY(compression)
 ISC_TEST_ENTRY(collision)
+ISC_TEST_ENTRY(longlabels)
 ISC_TEST_ENTRY(fromregion)
 ISC_TEST_ENTRY(istat)
 ISC_TEST_ENTRY(init)
@@ -1018,6 +1145,7 @@ ISC_TEST_ENTRY(countlabels)
 ISC_TEST_ENTRY(getlabel)
 ISC_TEST_ENTRY(getlabelsequence)
 ISC_TEST_ENTRY(maxlabels)
+ISC_TEST_ENTRY(fromtext)
 #ifdef DNS_BENCHMARK_TESTS
 ISC_TEST_ENTRY(benchmark)
 #endif /* DNS_BENCHMARK_TESTS */
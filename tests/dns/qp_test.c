@@ -512,6 +512,255 @@ ISC_RUN_TEST_IMPL(partialmatch) {
 	dns_qp_destroy(&qp);
 }
 
+ISC_RUN_TEST_IMPL(getnames) {
+	dns_qp_t *qp = NULL;
+	const char insert[][16] = {
+		"a.b.", "b.", "fo.bar.", "foo.bar.",
+		"fooo.bar.", "web.foo.bar.", "x.y.z.", "y.z.",
+		"ns1.example.", "ns2.example.",
+	};
+	const char *query[] = {
+		"a.b.", "b.c.", "bar.", "foo.bar.", "foooo.bar.",
+		"web.foo.bar.", "fo.bar.", "fooo.bar.", "x.y.z.", "z.", "y.z.",
+		"www.x.y.z.", "b.", "w.foo.bar.", "ns1.example.",
+		"ns2.example.", "ns3.example.",
+	};
+	dns_fixedname_t fixed[ARRAY_SIZE(query)];
+	const dns_name_t *names[ARRAY_SIZE(query)];
+	isc_result_t results[ARRAY_SIZE(query)];
+	void *pvals[ARRAY_SIZE(query)];
+	uint32_t ivals[ARRAY_SIZE(query)];
+
+	dns_qp_create(mctx, &string_methods, NULL, &qp);
+
+	/* an empty trie */
+	dns_test_namefromstring(query[0], &fixed[0]);
+	names[0] = dns_fixedname_name(&fixed[0]);
+	dns_qp_getnames(qp, names, 1, results, NULL, NULL);
+	assert_int_equal(results[0], ISC_R_NOTFOUND);
+
+	/* a trie with just one leaf */
+	insert_str(qp, insert[0]);
+	dns_qp_getnames(qp, names, 1, results, pvals, NULL);
+	assert_int_equal(results[0], ISC_R_SUCCESS);
+	assert_string_equal(pvals[0], insert[0]);
+
+	for (size_t i = 1; i < ARRAY_SIZE(insert); i++) {
+		insert_str(qp, insert[i]);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(query); i++) {
+		dns_test_namefromstring(query[i], &fixed[i]);
+		names[i] = dns_fixedname_name(&fixed[i]);
+		pvals[i] = NULL;
+		ivals[i] = 1;
+	}
+
+	dns_qp_getnames(qp, names, ARRAY_SIZE(query), results, pvals, ivals);
+
+	for (size_t i = 0; i < ARRAY_SIZE(query); i++) {
+		isc_result_t result;
+		void *pval = NULL;
+
+		result = dns_qp_getname(qp, names[i], &pval, NULL);
+		assert_int_equal(results[i], result);
+		if (result == ISC_R_SUCCESS) {
+			assert_string_equal(pvals[i], query[i]);
+			assert_int_equal(ivals[i], 0);
+		} else {
+			assert_null(pvals[i]);
+			assert_int_equal(ivals[i], 1);
+		}
+	}
+
+	dns_qp_destroy(&qp);
+}
+
+ISC_RUN_TEST_IMPL(hugepages) {
+	dns_qp_t *qp = NULL;
+	dns_qp_memusage_t memusage;
+	const char insert[][16] = {
+		"a.b.", "b.", "fo.bar.", "foo.bar.", "fooo.bar.",
+		"web.foo.bar.",
+	};
+
+	dns_qp_hugepages(true);
+	dns_qp_create(mctx, &string_methods, NULL, &qp);
+	dns_qp_hugepages(false);
+
+	for (size_t i = 0; i < ARRAY_SIZE(insert); i++) {
+		insert_str(qp, insert[i]);
+	}
+	static struct check_partialmatch check[] = {
+		{ "foo.bar.", ISC_R_SUCCESS, "foo.bar." },
+		{ "w.foo.bar.", DNS_R_PARTIALMATCH, "foo.bar." },
+		{ NULL, 0, NULL },
+	};
+	check_partialmatch(qp, check);
+
+	memusage = dns_qp_memusage(qp);
+	assert_true(memusage.hugepages);
+	assert_true(memusage.chunk_count > 0);
+	assert_true(memusage.pool_bytes >=
+		    memusage.chunk_count * memusage.chunk_size *
+			    memusage.node_size);
+	assert_true(memusage.pool_free < memusage.pool_bytes);
+
+	dns_qp_destroy(&qp);
+}
+
+#define COMPACT_ITEMS 20000
+
+static void
+compact_check(void *uctx, void *pval, uint32_t ival) {
+	uint32_t *items = uctx;
+	assert_in_range(ival, 1, COMPACT_ITEMS - 1);
+	assert_ptr_equal(items + ival, pval);
+}
+
+static size_t
+compact_makekey(dns_qpkey_t key, void *uctx, void *pval, uint32_t ival) {
+	compact_check(uctx, pval, ival);
+
+	char str[8];
+	snprintf(str, sizeof(str), "%05u", ival);
+
+	size_t i = 0;
+	while (str[i] != '\0') {
+		key[i] = str[i] - '0' + SHIFT_BITMAP;
+		i++;
+	}
+	key[i++] = SHIFT_NOBYTE;
+
+	return (i);
+}
+
+const dns_qpmethods_t compact_methods = {
+	compact_check,
+	compact_check,
+	compact_makekey,
+	getname,
+};
+
+#define HUGEPAGE_BYTES (2 * 1024 * 1024)
+
+ISC_RUN_TEST_IMPL(hugepages_release) {
+	static uint32_t items[COMPACT_ITEMS];
+	dns_qp_t *qp[16] = { NULL };
+	dns_qp_memusage_t memusage;
+	size_t inuse = isc_mem_inuse(mctx);
+	size_t n = 0;
+
+	for (uint32_t i = 0; i < COMPACT_ITEMS; i++) {
+		items[i] = i;
+	}
+
+	/*
+	 * Fill tries until the pool needs more than one region, checking
+	 * that the chunks are charged to the memory context.
+	 */
+	dns_qp_hugepages(true);
+	do {
+		size_t before = isc_mem_inuse(mctx);
+		dns_qp_create(mctx, &compact_methods, items, &qp[n]);
+		for (uint32_t i = 1; i < COMPACT_ITEMS; i++) {
+			dns_qp_insert(qp[n], &items[i], i);
+		}
+		memusage = dns_qp_memusage(qp[n]);
+		assert_true(memusage.hugepages);
+		assert_true(isc_mem_inuse(mctx) >=
+			    before + memusage.chunk_count *
+					     memusage.chunk_size *
+					     memusage.node_size);
+		n++;
+	} while (memusage.pool_bytes < 2 * HUGEPAGE_BYTES &&
+		 n < ARRAY_SIZE(qp));
+	assert_true(memusage.pool_bytes >= 2 * HUGEPAGE_BYTES);
+
+	while (n > 0) {
+		dns_qp_destroy(&qp[--n]);
+	}
+	assert_int_equal(isc_mem_inuse(mctx), inuse);
+
+	/* only one idle region is kept */
+	dns_qp_create(mctx, &compact_methods, items, &qp[0]);
+	dns_qp_insert(qp[0], &items[1], 1);
+	memusage = dns_qp_memusage(qp[0]);
+	assert_int_equal(memusage.pool_bytes, HUGEPAGE_BYTES);
+	assert_true(memusage.pool_free < memusage.pool_bytes);
+	dns_qp_destroy(&qp[0]);
+	dns_qp_hugepages(false);
+}
+
+static void
+compact_verify(dns_qp_t *qp, uint32_t *items) {
+	dns_qpiter_t qpi;
+	uint32_t ival, prev = 0;
+	size_t count = 0, expect = 0;
+
+	dns_qpiter_init(qp, &qpi);
+	while (dns_qpiter_next(&qpi, NULL, NULL, &ival) == ISC_R_SUCCESS) {
+		assert_in_range(ival, prev + 1, COMPACT_ITEMS - 1);
+		assert_int_equal(items[ival], ival);
+		prev = ival;
+		count++;
+	}
+	for (ival = 1; ival < COMPACT_ITEMS; ival++) {
+		expect += (items[ival] != 0);
+	}
+	assert_int_equal(count, expect);
+}
+
+ISC_RUN_TEST_IMPL(compactstep) {
+	static uint32_t items[COMPACT_ITEMS];
+	dns_qp_t *qp = NULL;
+	dns_qpkey_t key;
+	size_t len;
+
+	memset(items, 0, sizeof(items));
+	dns_qp_create(mctx, &compact_methods, items, &qp);
+
+	for (uint32_t i = 1; i < COMPACT_ITEMS; i++) {
+		items[i] = i;
+		assert_int_equal(dns_qp_insert(qp, &items[i], i),
+				 ISC_R_SUCCESS);
+	}
+
+	/* fragment the trie */
+	for (uint32_t i = 1; i < COMPACT_ITEMS; i++) {
+		if (i % 4 != 0) {
+			len = compact_makekey(key, items, &items[i], i);
+			assert_int_equal(dns_qp_deletekey(qp, key, len, NULL,
+							  NULL),
+					 ISC_R_SUCCESS);
+			items[i] = 0;
+		}
+	}
+	compact_verify(qp, items);
+
+	/* modify the trie between compaction steps */
+	for (uint32_t i = 1; i < COMPACT_ITEMS; i += 40) {
+		dns_qp_compact(qp, DNS_QPGC_STEP);
+		items[i] = i;
+		assert_int_equal(dns_qp_insert(qp, &items[i], i),
+				 ISC_R_SUCCESS);
+		len = compact_makekey(key, items, &items[i + 3], i + 3);
+		assert_int_equal(dns_qp_deletekey(qp, key, len, NULL, NULL),
+				 ISC_R_SUCCESS);
+		items[i + 3] = 0;
+	}
+	compact_verify(qp, items);
+
+	/* finish the job */
+	for (size_t steps = 0; dns_qp_memusage(qp).fragmented; steps++) {
+		assert_true(steps < COMPACT_ITEMS);
+		dns_qp_compact(qp, DNS_QPGC_STEP);
+	}
+	compact_verify(qp, items);
+
+	dns_qp_destroy(&qp);
+}
+
 struct check_qpchain {
 	const char *query;
 	isc_result_t result;
@@ -932,6 +1181,10 @@ ISC_TEST_ENTRY(qpkey_name)
 ISC_TEST_ENTRY(qpkey_sort)
 ISC_TEST_ENTRY(qpiter)
 ISC_TEST_ENTRY(partialmatch)
+ISC_TEST_ENTRY(getnames)
+ISC_TEST_ENTRY(hugepages)
+ISC_TEST_ENTRY(hugepages_release)
+ISC_TEST_ENTRY(compactstep)
 ISC_TEST_ENTRY(qpchain)
 ISC_TEST_ENTRY(predecessors)
 ISC_TEST_ENTRY(fixiterator)
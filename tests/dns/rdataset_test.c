@@ -23,8 +23,12 @@
 #define UNIT_TESTING
 #include <cmocka.h>
 
+#include <isc/buffer.h>
 #include <isc/util.h>
 
+#include <dns/compress.h>
+#include <dns/db.h>
+#include <dns/rdatalist.h>
 #include <dns/rdataset.h>
 #include <dns/rdatastruct.h>
 
@@ -101,8 +105,128 @@ ISC_RUN_TEST_IMPL(trimttl) {
 	assert_int_equal(sigrdataset.ttl, 0);
 }
 
+#define NRECORDS 20
+
+static void
+render(dns_rdataset_t *rdataset, const dns_name_t *owner, bool partial,
+       isc_buffer_t *target, unsigned int *countp) {
+	dns_compress_t cctx;
+	isc_result_t result;
+
+	*countp = 0;
+	dns_compress_init(&cctx, mctx, 0);
+	if (partial) {
+		result = dns_rdataset_towirepartial(rdataset, owner, &cctx,
+						    target, NULL, NULL, 0,
+						    countp, NULL);
+	} else {
+		result = dns_rdataset_towire(rdataset, owner, &cctx, target, 0,
+					     countp);
+	}
+	dns_compress_invalidate(&cctx);
+	assert_int_equal(result, partial ? ISC_R_NOSPACE : ISC_R_SUCCESS);
+}
+
+/*
+ * Rendering name-free records straight from a database slab must give
+ * the same bytes as rendering them one at a time from an rdatalist.
+ */
+ISC_LOOP_TEST_IMPL(rawrender) {
+	dns_db_t *db = NULL;
+	dns_dbversion_t *version = NULL;
+	dns_dbnode_t *node = NULL;
+	dns_fixedname_t fname;
+	dns_name_t *name = dns_fixedname_initname(&fname);
+	dns_rdatalist_t rdatalist;
+	dns_rdataset_t listset, slabset;
+	dns_rdata_t rdata[NRECORDS];
+	unsigned char data[NRECORDS][4];
+	unsigned char buf1[1024], buf2[1024];
+	isc_buffer_t b1, b2;
+	unsigned int count1, count2;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	result = dns_db_create(mctx, ZONEDB_DEFAULT, dns_rootname,
+			       dns_dbtype_zone, dns_rdataclass_in, 0, NULL,
+			       &db);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_name_fromstring(name, "www.example.", dns_rootname, 0,
+				     NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* 10.0.0.1 and up, which is also the DNSSEC order */
+	dns_rdatalist_init(&rdatalist);
+	rdatalist.type = dns_rdatatype_a;
+	rdatalist.rdclass = dns_rdataclass_in;
+	rdatalist.ttl = 3600;
+	for (size_t i = 0; i < NRECORDS; i++) {
+		data[i][0] = 10;
+		data[i][1] = 0;
+		data[i][2] = 0;
+		data[i][3] = i + 1;
+		dns_rdata_init(&rdata[i]);
+		rdata[i].data = data[i];
+		rdata[i].length = 4;
+		rdata[i].rdclass = dns_rdataclass_in;
+		rdata[i].type = dns_rdatatype_a;
+		ISC_LIST_APPEND(rdatalist.rdata, &rdata[i], link);
+	}
+	dns_rdataset_init(&listset);
+	dns_rdatalist_tordataset(&rdatalist, &listset);
+
+	result = dns_db_newversion(db, &version);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_db_findnode(db, name, true, &node);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_db_addrdataset(db, node, version, 0, &listset, 0, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_db_closeversion(db, &version, true);
+
+	dns_rdataset_init(&slabset);
+	dns_db_currentversion(db, &version);
+	result = dns_db_findrdataset(db, node, version, dns_rdatatype_a, 0, 0,
+				     &slabset, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(slabset.methods->rawrender);
+	assert_null(listset.methods->rawrender);
+
+	/* The whole RRset */
+	isc_buffer_init(&b1, buf1, sizeof(buf1));
+	isc_buffer_init(&b2, buf2, sizeof(buf2));
+	render(&listset, name, false, &b1, &count1);
+	render(&slabset, name, false, &b2, &count2);
+	assert_int_equal(count1, NRECORDS);
+	assert_int_equal(count2, NRECORDS);
+	assert_int_equal(isc_buffer_usedlength(&b1),
+			 isc_buffer_usedlength(&b2));
+	assert_memory_equal(buf1, buf2, isc_buffer_usedlength(&b1));
+
+	/* Truncated partway through a record */
+	isc_buffer_init(&b1, buf1, 200);
+	isc_buffer_init(&b2, buf2, 200);
+	render(&listset, name, true, &b1, &count1);
+	render(&slabset, name, true, &b2, &count2);
+	assert_in_range(count1, 2, NRECORDS - 1);
+	assert_int_equal(count1, count2);
+	assert_int_equal(isc_buffer_usedlength(&b1),
+			 isc_buffer_usedlength(&b2));
+	assert_memory_equal(buf1, buf2, isc_buffer_usedlength(&b1));
+
+	dns_rdataset_disassociate(&slabset);
+	dns_rdataset_disassociate(&listset);
+	dns_db_closeversion(db, &version, false);
+	dns_db_detachnode(db, &node);
+	dns_db_detach(&db);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY(trimttl)
+ISC_TEST_ENTRY_CUSTOM(rawrender, setup_managers, teardown_managers)
 ISC_TEST_LIST_END
 
 ISC_TEST_MAIN
@@ -31,6 +31,15 @@
 #include <dns/view.h>
 #include <dns/zone.h>
 
+/* Include the main file */
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wshadow"
+#undef CHECK
+#include "zone.c"
+#pragma GCC diagnostic pop
+
+#undef CHECK
 #include <tests/dns.h>
 
 static int
@@ -68,6 +77,7 @@ ISC_LOOP_TEST_IMPL(zonemgr_create) {
 ISC_LOOP_TEST_IMPL(zonemgr_managezone) {
 	dns_zonemgr_t *myzonemgr = NULL;
 	dns_zone_t *zone = NULL;
+	dns_view_t *view = NULL;
 	isc_result_t result;
 
 	UNUSED(arg);
@@ -84,11 +94,37 @@ ISC_LOOP_TEST_IMPL(zonemgr_managezone) {
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	assert_int_equal(dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_ANY), 1);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_AUTOMATIC), 0);
+
+	/* the counts follow changes */
+	dns_zone_setautomatic(zone, true);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_AUTOMATIC), 1);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_XFERRUNNING), 0);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_SOAQUERY), 0);
+
+	/* zones in the _bind view are not counted */
+	result = dns_test_makeview("_bind", false, false, &view);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_zone_setview(zone, view);
+	assert_int_equal(dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_ANY), 0);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_AUTOMATIC), 0);
+	dns_zone_setautomatic(zone, false);
+	dns_zone_setautomatic(zone, true);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_AUTOMATIC), 0);
 
 	dns_zonemgr_releasezone(myzonemgr, zone);
 	dns_zone_detach(&zone);
+	dns_view_detach(&view);
 
 	assert_int_equal(dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_ANY), 0);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_AUTOMATIC), 0);
 
 	dns_zonemgr_shutdown(myzonemgr);
 	dns_zonemgr_detach(&myzonemgr);
@@ -187,11 +223,939 @@ ISC_LOOP_TEST_IMPL(zonemgr_unreachable) {
 	isc_loopmgr_shutdown(loopmgr);
 }
 
+static dns_notify_t *
+make_notify(dns_zone_t *zone, unsigned int flags, isc_sockaddr_t *dst) {
+	dns_notify_t *notify = NULL;
+	isc_result_t result;
+
+	result = notify_create(mctx, flags, &notify);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	LOCK_ZONE(zone);
+	zone_iattach(zone, &notify->zone);
+	ISC_LIST_APPEND(zone->notifies, notify, link);
+	UNLOCK_ZONE(zone);
+	notify->dst = *dst;
+
+	return (notify);
+}
+
+/*
+ * Take a notify off the ratelimiter and free it, without sending.
+ * Leaders must be discarded before their followers.
+ */
+static void
+discard_notify(dns_notify_t *notify, isc_ratelimiter_t *rl) {
+	dns_notifylist_t batch = ISC_LIST_INITIALIZER;
+	dns_notify_t *follower = NULL;
+	isc_result_t result;
+
+	if (notify->rlevent != NULL) {
+		result = isc_ratelimiter_dequeue(rl, &notify->rlevent);
+		assert_int_equal(result, ISC_R_SUCCESS);
+	}
+	notify_batch_detach(notify, &batch);
+	while ((follower = ISC_LIST_HEAD(batch)) != NULL) {
+		ISC_LIST_UNLINK(batch, follower, batchlink);
+	}
+	notify_destroy(notify, false);
+}
+
+static dns_notify_t *
+batch_leader(dns_zonemgr_t *zmgr, isc_sockaddr_t *dst) {
+	dns_notify_t *leader = NULL;
+	isc_result_t result;
+
+	LOCK(&zmgr->notifylock);
+	result = isc_hashmap_find(zmgr->notifybatches,
+				  isc_sockaddr_hash(dst, false),
+				  notify_batch_match, dst, (void **)&leader);
+	UNLOCK(&zmgr->notifylock);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	return (leader);
+}
+
+/* notifies to the same destination share one ratelimiter slot */
+ISC_LOOP_TEST_IMPL(zonemgr_notify_batch) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *zone = NULL;
+	dns_notify_t *notifies[5] = { NULL };
+	isc_sockaddr_t addr1, addr2;
+	struct in_addr in;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	result = dns_test_makezone("foo", &zone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_zonemgr_managezone(myzonemgr, zone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	in.s_addr = inet_addr("10.53.0.1");
+	isc_sockaddr_fromin(&addr1, &in, 53);
+	in.s_addr = inet_addr("10.53.0.2");
+	isc_sockaddr_fromin(&addr2, &in, 53);
+
+	for (size_t i = 0; i < ARRAY_SIZE(notifies); i++) {
+		notifies[i] = make_notify(zone, DNS_NOTIFY_STARTUP,
+					  i == 3 ? &addr2 : &addr1);
+	}
+
+	/* The first notify to a destination leads, the next ones follow */
+	for (size_t i = 0; i < 4; i++) {
+		result = notify_send_queue(notifies[i], true);
+		assert_int_equal(result, ISC_R_SUCCESS);
+	}
+
+	assert_non_null(notifies[0]->rlevent);
+	assert_ptr_equal(notifies[0]->batchrl, myzonemgr->startupnotifyrl);
+	assert_int_equal(notifies[0]->nbatch, 2);
+	assert_ptr_equal(ISC_LIST_HEAD(notifies[0]->batch), notifies[1]);
+	assert_ptr_equal(ISC_LIST_TAIL(notifies[0]->batch), notifies[2]);
+	assert_null(notifies[1]->rlevent);
+	assert_null(notifies[2]->rlevent);
+	assert_ptr_equal(batch_leader(myzonemgr, &addr1), notifies[0]);
+
+	assert_non_null(notifies[3]->rlevent);
+	assert_int_equal(notifies[3]->nbatch, 0);
+	assert_ptr_equal(batch_leader(myzonemgr, &addr2), notifies[3]);
+
+	/* A full batch makes the next notify a leader of its own */
+	notify_batch_adjust(myzonemgr, &addr1, false);
+	notify_batch_adjust(myzonemgr, &addr1, false);
+	result = notify_send_queue(notifies[4], true);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(notifies[4]->rlevent);
+	assert_int_equal(notifies[0]->nbatch, 2);
+	assert_ptr_equal(batch_leader(myzonemgr, &addr1), notifies[4]);
+	for (size_t i = 0; i < NOTIFY_BATCH_DEFAULT - 2; i++) {
+		notify_batch_adjust(myzonemgr, &addr1, true);
+	}
+
+	/*
+	 * A normal notify to the first destination moves the first
+	 * leader to the normal ratelimiter.  Its followers stay on the
+	 * startup ratelimiter, behind the other leader for that address.
+	 */
+	LOCK_ZONE(zone);
+	assert_true(notify_isqueued(zone, 0, NULL, &addr1, NULL, NULL));
+	UNLOCK_ZONE(zone);
+
+	assert_int_equal(notifies[0]->flags & DNS_NOTIFY_STARTUP, 0);
+	assert_non_null(notifies[0]->rlevent);
+	assert_ptr_equal(notifies[0]->batchrl, myzonemgr->notifyrl);
+	assert_true(ISC_LIST_EMPTY(notifies[0]->batch));
+	assert_int_equal(notifies[0]->nbatch, 0);
+	assert_ptr_equal(batch_leader(myzonemgr, &addr1), notifies[0]);
+
+	assert_int_equal(notifies[4]->nbatch, 2);
+	assert_ptr_equal(ISC_LIST_HEAD(notifies[4]->batch), notifies[1]);
+	assert_ptr_equal(ISC_LIST_TAIL(notifies[4]->batch), notifies[2]);
+	assert_null(notifies[1]->rlevent);
+	assert_null(notifies[2]->rlevent);
+
+	discard_notify(notifies[0], myzonemgr->notifyrl);
+	discard_notify(notifies[3], myzonemgr->startupnotifyrl);
+	discard_notify(notifies[4], myzonemgr->startupnotifyrl);
+	discard_notify(notifies[1], myzonemgr->startupnotifyrl);
+	discard_notify(notifies[2], myzonemgr->startupnotifyrl);
+	assert_true(ISC_LIST_EMPTY(zone->notifies));
+
+	dns_zonemgr_releasezone(myzonemgr, zone);
+	dns_zone_detach(&zone);
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* a normal notify promotes a batched startup notify to the normal queue */
+ISC_LOOP_TEST_IMPL(zonemgr_notify_batch_promote) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *zone = NULL;
+	dns_notify_t *leader = NULL, *follower = NULL;
+	dns_fixedname_t fixed;
+	dns_name_t *name = dns_fixedname_initname(&fixed);
+	isc_sockaddr_t addr;
+	struct in_addr in;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	result = dns_test_makezone("foo", &zone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_zonemgr_managezone(myzonemgr, zone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	in.s_addr = inet_addr("10.53.0.1");
+	isc_sockaddr_fromin(&addr, &in, 53);
+
+	result = dns_name_fromstring(name, "ns2.foo", dns_rootname, 0, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	leader = make_notify(zone, DNS_NOTIFY_STARTUP, &addr);
+	follower = make_notify(zone, DNS_NOTIFY_STARTUP, &addr);
+	dns_name_dup(name, mctx, &follower->ns);
+
+	result = notify_send_queue(leader, true);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = notify_send_queue(follower, true);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	assert_null(follower->rlevent);
+	assert_ptr_equal(follower->leader, leader);
+	assert_int_equal(leader->nbatch, 1);
+
+	LOCK_ZONE(zone);
+	assert_true(notify_isqueued(zone, 0, name, NULL, NULL, NULL));
+	UNLOCK_ZONE(zone);
+
+	/* The follower has left the startup batch and leads its own */
+	assert_int_equal(follower->flags & DNS_NOTIFY_STARTUP, 0);
+	assert_null(follower->leader);
+	assert_non_null(follower->rlevent);
+	assert_ptr_equal(follower->batchrl, myzonemgr->notifyrl);
+	assert_ptr_equal(batch_leader(myzonemgr, &addr), follower);
+
+	assert_true(ISC_LIST_EMPTY(leader->batch));
+	assert_int_equal(leader->nbatch, 0);
+	assert_ptr_equal(leader->batchrl, myzonemgr->startupnotifyrl);
+
+	discard_notify(follower, myzonemgr->notifyrl);
+	discard_notify(leader, myzonemgr->startupnotifyrl);
+	assert_true(ISC_LIST_EMPTY(zone->notifies));
+
+	dns_zonemgr_releasezone(myzonemgr, zone);
+	dns_zone_detach(&zone);
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static struct soaquery *
+make_soaquery(dns_zone_t *zone, isc_sockaddr_t *dst, bool udp) {
+	struct soaquery *sq = isc_mem_get(zone->mctx, sizeof(*sq));
+
+	*sq = (struct soaquery){
+		.dst = *dst,
+		.udp = udp,
+		.batch = ISC_LIST_INITIALIZER,
+		.batchlink = ISC_LINK_INITIALIZER,
+	};
+	zone_iattach(zone, &sq->zone);
+
+	return (sq);
+}
+
+/*
+ * Take an SOA query off the ratelimiter and free it, without sending.
+ * Leaders must be discarded before their followers.
+ */
+static void
+discard_soaquery(struct soaquery *sq) {
+	dns_zonemgr_t *zmgr = sq->zone->zmgr;
+	dns_zone_t *zone = sq->zone;
+	struct soaquery *follower = NULL;
+	isc_result_t result;
+
+	if (sq->rlevent != NULL) {
+		result = isc_ratelimiter_dequeue(zmgr->refreshrl,
+						 &sq->rlevent);
+		assert_int_equal(result, ISC_R_SUCCESS);
+	}
+
+	LOCK(&zmgr->soalock);
+	if (sq->batched) {
+		result = isc_hashmap_delete(zmgr->soabatches,
+					    isc_sockaddr_hash(&sq->dst, false),
+					    soaquery_batch_match, &sq->dst);
+		assert_int_equal(result, ISC_R_SUCCESS);
+	}
+	while ((follower = ISC_LIST_HEAD(sq->batch)) != NULL) {
+		ISC_LIST_UNLINK(sq->batch, follower, batchlink);
+	}
+	UNLOCK(&zmgr->soalock);
+
+	zone_idetach(&sq->zone);
+	isc_mem_put(zone->mctx, sq, sizeof(*sq));
+}
+
+static struct soaquery *
+soaquery_leader(dns_zonemgr_t *zmgr, isc_sockaddr_t *dst) {
+	struct soaquery *leader = NULL;
+	isc_result_t result;
+
+	LOCK(&zmgr->soalock);
+	result = isc_hashmap_find(zmgr->soabatches,
+				  isc_sockaddr_hash(dst, false),
+				  soaquery_batch_match, dst, (void **)&leader);
+	UNLOCK(&zmgr->soalock);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	return (leader);
+}
+
+/* SOA queries to the same primary share one ratelimiter slot */
+ISC_LOOP_TEST_IMPL(zonemgr_soaquery_batch) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *zone = NULL;
+	struct soaquery *sqs[7] = { NULL };
+	isc_sockaddr_t addr1, addr2;
+	struct in_addr in;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	result = dns_test_makezone("foo", &zone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_zonemgr_managezone(myzonemgr, zone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	in.s_addr = inet_addr("10.53.0.1");
+	isc_sockaddr_fromin(&addr1, &in, 53);
+	in.s_addr = inet_addr("10.53.0.2");
+	isc_sockaddr_fromin(&addr2, &in, 53);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sqs); i++) {
+		sqs[i] = make_soaquery(zone, i == 3 ? &addr2 : &addr1, i == 4);
+	}
+
+	/* The first query to a primary leads, the next ones follow */
+	for (size_t i = 0; i < 4; i++) {
+		result = soaquery_queue(sqs[i]);
+		assert_int_equal(result, ISC_R_SUCCESS);
+	}
+
+	assert_non_null(sqs[0]->rlevent);
+	assert_true(sqs[0]->batched);
+	assert_int_equal(sqs[0]->nbatch, 2);
+	assert_ptr_equal(ISC_LIST_HEAD(sqs[0]->batch), sqs[1]);
+	assert_ptr_equal(ISC_LIST_TAIL(sqs[0]->batch), sqs[2]);
+	assert_null(sqs[1]->rlevent);
+	assert_null(sqs[2]->rlevent);
+	assert_ptr_equal(soaquery_leader(myzonemgr, &addr1), sqs[0]);
+
+	assert_non_null(sqs[3]->rlevent);
+	assert_int_equal(sqs[3]->nbatch, 0);
+	assert_ptr_equal(soaquery_leader(myzonemgr, &addr2), sqs[3]);
+
+	/* A UDP retry is never batched */
+	result = soaquery_queue(sqs[4]);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(sqs[4]->rlevent);
+	assert_false(sqs[4]->batched);
+	assert_int_equal(sqs[0]->nbatch, 2);
+
+	/* A full batch makes the next query a leader of its own */
+	dns_zonemgr_setserialquerybatch(myzonemgr, 3);
+	result = soaquery_queue(sqs[5]);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(sqs[5]->rlevent);
+	assert_false(sqs[0]->batched);
+	assert_int_equal(sqs[0]->nbatch, 2);
+	assert_ptr_equal(soaquery_leader(myzonemgr, &addr1), sqs[5]);
+
+	/* Batching can be disabled */
+	dns_zonemgr_setserialquerybatch(myzonemgr, 1);
+	result = soaquery_queue(sqs[6]);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(sqs[6]->rlevent);
+	assert_false(sqs[6]->batched);
+	assert_int_equal(sqs[5]->nbatch, 0);
+	assert_ptr_equal(soaquery_leader(myzonemgr, &addr1), sqs[5]);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sqs); i++) {
+		discard_soaquery(sqs[i]);
+	}
+
+	dns_zonemgr_releasezone(myzonemgr, zone);
+	dns_zone_detach(&zone);
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* the batch size grows additively and shrinks multiplicatively */
+ISC_LOOP_TEST_IMPL(zonemgr_notify_batch_adjust) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	isc_sockaddr_t addr1, addr2;
+	struct in_addr in;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	in.s_addr = inet_addr("10.53.0.1");
+	isc_sockaddr_fromin(&addr1, &in, 53);
+	in.s_addr = inet_addr("10.53.0.2");
+	isc_sockaddr_fromin(&addr2, &in, 53);
+
+	LOCK(&myzonemgr->notifylock);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr1),
+			 NOTIFY_BATCH_DEFAULT);
+	UNLOCK(&myzonemgr->notifylock);
+
+	/* Each destination keeps its own batch size */
+	notify_batch_adjust(myzonemgr, &addr1, true);
+	notify_batch_adjust(myzonemgr, &addr2, false);
+	LOCK(&myzonemgr->notifylock);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr1),
+			 NOTIFY_BATCH_DEFAULT + 1);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr2),
+			 NOTIFY_BATCH_DEFAULT / 2);
+	UNLOCK(&myzonemgr->notifylock);
+
+	notify_batch_adjust(myzonemgr, &addr1, false);
+	LOCK(&myzonemgr->notifylock);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr1),
+			 (NOTIFY_BATCH_DEFAULT + 1) / 2);
+	UNLOCK(&myzonemgr->notifylock);
+
+	for (size_t i = 0; i < 8; i++) {
+		notify_batch_adjust(myzonemgr, &addr1, false);
+	}
+	LOCK(&myzonemgr->notifylock);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr1),
+			 NOTIFY_BATCH_MIN);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr2),
+			 NOTIFY_BATCH_DEFAULT / 2);
+	UNLOCK(&myzonemgr->notifylock);
+
+	for (size_t i = 0; i < 2 * NOTIFY_BATCH_MAX; i++) {
+		notify_batch_adjust(myzonemgr, &addr1, true);
+	}
+	LOCK(&myzonemgr->notifylock);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr1),
+			 NOTIFY_BATCH_MAX);
+	UNLOCK(&myzonemgr->notifylock);
+
+	/* A destination back at the default size is forgotten */
+	for (size_t i = 0; i < NOTIFY_BATCH_DEFAULT / 2; i++) {
+		notify_batch_adjust(myzonemgr, &addr2, true);
+	}
+	LOCK(&myzonemgr->notifylock);
+	assert_int_equal(notify_batch_size(myzonemgr, &addr2),
+			 NOTIFY_BATCH_DEFAULT);
+	assert_int_equal(isc_hashmap_count(myzonemgr->notifydests), 1);
+	UNLOCK(&myzonemgr->notifylock);
+
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* the refresh counts follow the flags of managed zones only */
+ISC_LOOP_TEST_IMPL(zonemgr_countflags) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *zone = NULL;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	result = dns_test_makezone("foo", &zone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* set before the zone is managed */
+	LOCK_ZONE(zone);
+	DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_REFRESH);
+	UNLOCK_ZONE(zone);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_SOAQUERY), 0);
+
+	result = dns_zonemgr_managezone(myzonemgr, zone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_SOAQUERY), 1);
+
+	/* setting a flag twice counts it once */
+	LOCK_ZONE(zone);
+	DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_REFRESH | DNS_ZONEFLG_FIRSTREFRESH);
+	DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_FIRSTREFRESH);
+	UNLOCK_ZONE(zone);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_SOAQUERY), 1);
+	assert_int_equal(dns_zonemgr_getcount(myzonemgr,
+					      DNS_ZONESTATE_XFERFIRSTREFRESH),
+			 1);
+
+	LOCK_ZONE(zone);
+	DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_REFRESH);
+	DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_REFRESH);
+	UNLOCK_ZONE(zone);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_SOAQUERY), 0);
+
+	/* releasing the zone takes its flags with it */
+	dns_zonemgr_releasezone(myzonemgr, zone);
+	assert_int_equal(dns_zonemgr_getcount(myzonemgr,
+					      DNS_ZONESTATE_XFERFIRSTREFRESH),
+			 0);
+
+	LOCK_ZONE(zone);
+	DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_FIRSTREFRESH);
+	DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_REFRESH);
+	UNLOCK_ZONE(zone);
+	assert_int_equal(dns_zonemgr_getcount(myzonemgr,
+					      DNS_ZONESTATE_XFERFIRSTREFRESH),
+			 0);
+	assert_int_equal(
+		dns_zonemgr_getcount(myzonemgr, DNS_ZONESTATE_SOAQUERY), 0);
+
+	dns_zone_detach(&zone);
+
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static void
+xfrin_zone(const char *name, bool loaded, bool ixfr, uint64_t bytes,
+	   uint32_t expire, dns_zone_t **zonep) {
+	dns_zone_t *zone = NULL;
+	isc_result_t result;
+
+	result = dns_test_makezone(name, &zone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	if (loaded) {
+		DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_LOADED);
+	}
+	zone->requestixfr = ixfr;
+	zone->xfrinbytes = bytes;
+	isc_time_set(&zone->expiretime, expire, 0);
+
+	*zonep = zone;
+}
+
+/* start the next transfer, minus the actual transfer */
+static dns_zone_t *
+xfrin_take(dns_zonemgr_t *zmgr) {
+	dns_zone_t *zone = zmgr_xfrin_next(zmgr);
+
+	if (zone != NULL) {
+		zmgr_xfrin_dequeue(zmgr, zone);
+		zone->xfrprimary->running++;
+		zmgr_primary_update(zmgr, zone->xfrprimary);
+	}
+
+	return (zone);
+}
+
+static dns_zone_t *xfrin_queue[8];
+static unsigned int xfrin_nqueue;
+
+static isc_result_t
+xfrin_getqueue(const dns_xfrprimary_t *primary, void *arg) {
+	isc_netaddr_t *addr = arg;
+
+	if (isc_netaddr_equal(&primary->addr, addr)) {
+		assert_true(primary->waiting <= ARRAY_SIZE(xfrin_queue));
+		memmove(xfrin_queue, primary->queue,
+			primary->waiting * sizeof(xfrin_queue[0]));
+		xfrin_nqueue = primary->waiting;
+	}
+
+	return (ISC_R_SUCCESS);
+}
+
+/* deferred transfers start in order of urgency, within per-primary limits */
+ISC_LOOP_TEST_IMPL(zonemgr_xfrin_priority) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *full = NULL, *smallfull = NULL, *incr = NULL;
+	dns_zone_t *empty = NULL, *soon = NULL;
+	struct in_addr ina;
+	isc_netaddr_t a, b;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	ina.s_addr = htonl(0xc0000201); /* 192.0.2.1 */
+	isc_netaddr_fromin(&a, &ina);
+	ina.s_addr = htonl(0xc0000202); /* 192.0.2.2 */
+	isc_netaddr_fromin(&b, &ina);
+
+	xfrin_zone("full", true, false, 1024 * 1024, 100, &full);
+	xfrin_zone("smallfull", true, false, 1024, 100, &smallfull);
+	xfrin_zone("incr", true, true, 1024 * 1024, 200, &incr);
+	xfrin_zone("empty", false, true, 0, 0, &empty);
+	xfrin_zone("soon", true, true, 0, 50, &soon);
+
+	zmgr_xfrin_enqueue(myzonemgr, full, &a, 2);
+	zmgr_xfrin_enqueue(myzonemgr, smallfull, &a, 2);
+	zmgr_xfrin_enqueue(myzonemgr, incr, &a, 2);
+	zmgr_xfrin_enqueue(myzonemgr, empty, &a, 2);
+	zmgr_xfrin_enqueue(myzonemgr, soon, &b, 1);
+
+	/* the queue is exposed in the order the transfers will start */
+	result = dns_zonemgr_xfrprimaries(myzonemgr, xfrin_getqueue, &a);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(xfrin_nqueue, 4);
+	assert_ptr_equal(xfrin_queue[0], empty);
+	assert_ptr_equal(xfrin_queue[1], incr);
+	assert_ptr_equal(xfrin_queue[2], smallfull);
+	assert_ptr_equal(xfrin_queue[3], full);
+
+	assert_ptr_equal(xfrin_take(myzonemgr), empty);
+	assert_ptr_equal(xfrin_take(myzonemgr), soon);
+	assert_ptr_equal(xfrin_take(myzonemgr), incr);
+
+	/* both primaries are at their limit */
+	assert_null(xfrin_take(myzonemgr));
+
+	zmgr_xfrin_release(myzonemgr, soon, ISC_R_SUCCESS, 0, 0);
+	assert_null(xfrin_take(myzonemgr));
+
+	zmgr_xfrin_release(myzonemgr, empty, ISC_R_SUCCESS, 0, 0);
+	assert_ptr_equal(xfrin_take(myzonemgr), smallfull);
+	assert_null(xfrin_take(myzonemgr));
+
+	/* so is the zone manager as a whole */
+	zmgr_xfrin_release(myzonemgr, incr, ISC_R_SUCCESS, 0, 0);
+	myzonemgr->transfersin = myzonemgr->xfrin_count = 1;
+	assert_null(xfrin_take(myzonemgr));
+	myzonemgr->xfrin_count = 0;
+	assert_ptr_equal(xfrin_take(myzonemgr), full);
+	assert_null(xfrin_take(myzonemgr));
+
+	zmgr_xfrin_release(myzonemgr, smallfull, ISC_R_SUCCESS, 0, 0);
+	zmgr_xfrin_release(myzonemgr, full, ISC_R_SUCCESS, 0, 0);
+
+	/* leaving the queue */
+	zmgr_xfrin_enqueue(myzonemgr, full, &a, 2);
+	zmgr_xfrin_dequeue(myzonemgr, full);
+	full->xfrprimary = NULL;
+	assert_null(xfrin_take(myzonemgr));
+	assert_true(ISC_LIST_EMPTY(myzonemgr->xfrwaiting));
+
+	dns_zone_detach(&full);
+	dns_zone_detach(&smallfull);
+	dns_zone_detach(&incr);
+	dns_zone_detach(&empty);
+	dns_zone_detach(&soon);
+
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* zones that keep waiting eventually go ahead of more urgent ones */
+ISC_LOOP_TEST_IMPL(zonemgr_xfrin_aging) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *big = NULL, *incr = NULL, *zone = NULL;
+	dns_zone_t *empty = NULL, *expiring = NULL;
+	const uint32_t t0 = 1000000, week = 7 * 24 * 3600;
+	struct in_addr ina;
+	isc_netaddr_t a;
+	char name[32];
+	unsigned int i;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	ina.s_addr = htonl(0xc0000201); /* 192.0.2.1 */
+	isc_netaddr_fromin(&a, &ina);
+
+	xfrin_zone("big", true, false, 1024 * 1024, t0 + week, &big);
+	isc_time_set(&big->xfrqueued, t0, 0);
+	zmgr_xfrin_enqueue(myzonemgr, big, &a, 1);
+
+	/* incremental transfers keep arriving, one a minute */
+	for (i = 0;; i++) {
+		assert_true(i < 20);
+
+		snprintf(name, sizeof(name), "incr%u", i);
+		xfrin_zone(name, true, true, 0, t0 + week, &incr);
+		isc_time_set(&incr->xfrqueued, t0 + i * 60, 0);
+		zmgr_xfrin_enqueue(myzonemgr, incr, &a, 1);
+
+		zone = xfrin_take(myzonemgr);
+		zmgr_xfrin_release(myzonemgr, zone, ISC_R_SUCCESS, 0, 0);
+		if (zone == big) {
+			break;
+		}
+		assert_ptr_equal(zone, incr);
+		dns_zone_detach(&incr);
+	}
+
+	/* ...until the full transfer has waited longer than they will */
+	assert_int_equal(i, 12);
+	assert_ptr_equal(xfrin_take(myzonemgr), incr);
+	zmgr_xfrin_release(myzonemgr, incr, ISC_R_SUCCESS, 0, 0);
+	assert_null(xfrin_take(myzonemgr));
+	dns_zone_detach(&incr);
+
+	/* a zone about to expire goes ahead of everything */
+	xfrin_zone("empty", false, true, 0, 0, &empty);
+	isc_time_set(&empty->xfrqueued, t0, 0);
+	xfrin_zone("expiring", true, false, 1024 * 1024, t0 + 60, &expiring);
+	isc_time_set(&expiring->xfrqueued, t0 + 60, 0);
+
+	zmgr_xfrin_enqueue(myzonemgr, empty, &a, 1);
+	zmgr_xfrin_enqueue(myzonemgr, expiring, &a, 1);
+	assert_ptr_equal(xfrin_take(myzonemgr), expiring);
+	zmgr_xfrin_release(myzonemgr, expiring, ISC_R_SUCCESS, 0, 0);
+	assert_ptr_equal(xfrin_take(myzonemgr), empty);
+	zmgr_xfrin_release(myzonemgr, empty, ISC_R_SUCCESS, 0, 0);
+
+	dns_zone_detach(&big);
+	dns_zone_detach(&empty);
+	dns_zone_detach(&expiring);
+
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* the per-primary limit follows the outcome of the transfers */
+ISC_LOOP_TEST_IMPL(zonemgr_xfrin_limit) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	dns_zone_t *zone = NULL;
+	zmgr_primary_t *primary = NULL;
+	struct in_addr ina;
+	isc_netaddr_t a;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &myzonemgr);
+
+	ina.s_addr = htonl(0xc0000201); /* 192.0.2.1 */
+	isc_netaddr_fromin(&a, &ina);
+
+	xfrin_zone("foo", true, false, 0, 0, &zone);
+
+	zmgr_xfrin_enqueue(myzonemgr, zone, &a, 4);
+	primary = zone->xfrprimary;
+	assert_int_equal(primary->limit, 4);
+
+	/* a timeout halves the limit */
+	assert_ptr_equal(xfrin_take(myzonemgr), zone);
+	zmgr_xfrin_release(myzonemgr, zone, ISC_R_TIMEDOUT, 0, 0);
+	assert_null(zone->xfrprimary);
+	assert_int_equal(primary->running, 0);
+	assert_int_equal(primary->limit, 2);
+	assert_int_equal(primary->failures, 1);
+
+	/* 'limit' successes in a row raise it by one */
+	for (int i = 0; i < 2; i++) {
+		assert_int_equal(primary->limit, 2);
+		zmgr_xfrin_enqueue(myzonemgr, zone, &a, 4);
+		assert_ptr_equal(xfrin_take(myzonemgr), zone);
+		zmgr_xfrin_release(myzonemgr, zone, ISC_R_SUCCESS, 0, 0);
+	}
+	assert_int_equal(primary->limit, 3);
+	assert_int_equal(primary->transfers, 3);
+
+	/* a transfer much slower than the average lowers it */
+	zmgr_xfrin_enqueue(myzonemgr, zone, &a, 4);
+	assert_ptr_equal(xfrin_take(myzonemgr), zone);
+	zmgr_xfrin_release(myzonemgr, zone, ISC_R_SUCCESS, 1024 * 1024,
+			   US_PER_SEC);
+	assert_int_equal(primary->rate, 1024 * 1024);
+	assert_int_equal(primary->limit, 3);
+
+	zmgr_xfrin_enqueue(myzonemgr, zone, &a, 4);
+	assert_ptr_equal(xfrin_take(myzonemgr), zone);
+	zmgr_xfrin_release(myzonemgr, zone, ISC_R_SUCCESS, 1024 * 1024,
+			   4 * US_PER_SEC);
+	assert_int_equal(primary->limit, 2);
+
+	/* a lower configured maximum caps it */
+	zmgr_xfrin_enqueue(myzonemgr, zone, &a, 1);
+	assert_int_equal(primary->limit, 1);
+	assert_ptr_equal(xfrin_take(myzonemgr), zone);
+	zmgr_xfrin_release(myzonemgr, zone, ISC_R_CANCELED, 0, 0);
+	assert_int_equal(primary->transfers, 5);
+
+	/* an idle primary is eventually forgotten */
+	assert_ptr_equal(ISC_LIST_HEAD(myzonemgr->xfridle), primary);
+	zmgr_primary_prune(myzonemgr);
+	assert_ptr_equal(ISC_LIST_HEAD(myzonemgr->xfrprimaries), primary);
+	primary->idlesince -= XFRIN_PRIMARY_IDLE;
+	zmgr_primary_prune(myzonemgr);
+	assert_true(ISC_LIST_EMPTY(myzonemgr->xfrprimaries));
+	assert_true(ISC_LIST_EMPTY(myzonemgr->xfridle));
+
+	dns_zone_detach(&zone);
+
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static dns_zonemgr_t *wheelmgr = NULL;
+static dns_zone_t *nearzone = NULL, *farzone = NULL;
+static isc_timer_t *wheeltimer = NULL;
+
+static void
+zonewheel_set(dns_zone_t *zone, isc_time_t *now, unsigned int seconds,
+	      unsigned int nanoseconds) {
+	isc_interval_t interval;
+	isc_time_t next;
+
+	isc_interval_set(&interval, seconds, nanoseconds);
+	assert_int_equal(isc_time_add(now, &interval, &next), ISC_R_SUCCESS);
+
+	LOCK_ZONE(zone);
+	zone_timer_set(zone, &next, now);
+	UNLOCK_ZONE(zone);
+}
+
+static void
+zonewheel_check(void *arg) {
+	zonewheel_t *wheel = &wheelmgr->wheels[0];
+
+	UNUSED(arg);
+
+	isc_timer_destroy(&wheeltimer);
+
+	/* the near zone was due and has been taken off the wheel */
+	assert_int_equal(nearzone->wheeltick, 0);
+	assert_false(nearzone->timerqueued);
+
+	/* the far zone is due more than a revolution later and stays */
+	assert_int_not_equal(farzone->wheeltick, 0);
+	assert_int_equal(wheel->scheduled, 1);
+	assert_non_null(wheel->timer);
+
+	LOCK_ZONE(farzone);
+	zone_timer_stop(farzone);
+	UNLOCK_ZONE(farzone);
+	assert_int_equal(farzone->wheeltick, 0);
+	assert_int_equal(wheel->scheduled, 0);
+
+	/* the ticker goes when the last zone leaves the wheel */
+	dns_zonemgr_releasezone(wheelmgr, nearzone);
+	assert_int_equal(wheel->zones, 1);
+	assert_non_null(wheel->timer);
+	dns_zonemgr_releasezone(wheelmgr, farzone);
+	assert_int_equal(wheel->zones, 0);
+	assert_null(wheel->timer);
+
+	dns_zone_detach(&nearzone);
+	dns_zone_detach(&farzone);
+
+	dns_zonemgr_shutdown(wheelmgr);
+	dns_zonemgr_detach(&wheelmgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* schedule zone maintenance on the timing wheel */
+ISC_LOOP_TEST_IMPL(zonemgr_zonewheel) {
+	zonewheel_t *wheel = NULL;
+	isc_interval_t interval;
+	isc_result_t result;
+	isc_time_t now = isc_time_now();
+	unsigned int revolution = (uint64_t)ZONEWHEEL_SLOTS * ZONEWHEEL_TICK /
+				  NS_PER_SEC;
+	uint_fast32_t irefs;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, netmgr, &wheelmgr);
+	wheel = &wheelmgr->wheels[0];
+
+	result = dns_test_makezone("near", &nearzone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_zonemgr_managezone(wheelmgr, nearzone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_test_makezone("far", &farzone, NULL, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_zonemgr_managezone(wheelmgr, farzone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	assert_null(wheel->timer);
+
+	/* maintenance that is already due does not go on the wheel */
+	zonewheel_set(nearzone, &now, 0, 0);
+	assert_true(nearzone->wheeled);
+	assert_int_equal(nearzone->wheeltick, 0);
+	assert_int_equal(wheel->zones, 1);
+	assert_int_equal(wheel->scheduled, 0);
+	assert_non_null(wheel->timer);
+
+	/* and is queued to run only once, however often it is reset */
+	assert_true(nearzone->timerqueued);
+	irefs = isc_refcount_current(&nearzone->irefs);
+	zonewheel_set(nearzone, &now, 0, 0);
+	assert_int_equal(isc_refcount_current(&nearzone->irefs), irefs);
+
+	/* a zone is put in the slot for the tick after it is due */
+	zonewheel_set(nearzone, &now, 0, 150 * NS_PER_MS);
+	assert_int_equal(nearzone->wheeltick,
+			 (isc_nanosecs_fromtime(now) + 150 * NS_PER_MS +
+			  ZONEWHEEL_TICK - 1) /
+				 ZONEWHEEL_TICK);
+	assert_ptr_equal(
+		ISC_LIST_HEAD(
+			wheel->slots[nearzone->wheeltick % ZONEWHEEL_SLOTS]),
+		nearzone);
+	assert_int_equal(wheel->scheduled, 1);
+
+	/* rescheduling moves it */
+	zonewheel_set(nearzone, &now, 0, 250 * NS_PER_MS);
+	assert_int_equal(wheel->scheduled, 1);
+	assert_ptr_equal(
+		ISC_LIST_HEAD(
+			wheel->slots[nearzone->wheeltick % ZONEWHEEL_SLOTS]),
+		nearzone);
+
+	zonewheel_set(farzone, &now, revolution + 60, 0);
+	assert_true(farzone->wheeltick > wheel->tick + ZONEWHEEL_SLOTS);
+	assert_int_equal(wheel->zones, 2);
+	assert_int_equal(wheel->scheduled, 2);
+
+	isc_timer_create(isc_loop_main(loopmgr), zonewheel_check, NULL,
+			 &wheeltimer);
+	isc_interval_set(&interval, 1, 0);
+	isc_timer_start(wheeltimer, isc_timertype_once, &interval);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY_CUSTOM(zonemgr_create, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(zonemgr_managezone, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(zonemgr_createzone, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(zonemgr_unreachable, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_notify_batch, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_notify_batch_promote, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_notify_batch_adjust, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_soaquery_batch, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_countflags, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_zonewheel, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_xfrin_priority, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_xfrin_aging, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_xfrin_limit, setup_test, teardown_test)
 ISC_TEST_LIST_END
 
 ISC_TEST_MAIN
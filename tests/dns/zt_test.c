@@ -88,6 +88,75 @@ ISC_LOOP_TEST_IMPL(apply) {
 	isc_loopmgr_shutdown(loopmgr);
 }
 
+/* mount and unmount zones in a batch */
+ISC_LOOP_TEST_IMPL(batch) {
+	isc_result_t result;
+	dns_zone_t *foo = NULL, *bar = NULL, *zone = NULL;
+	dns_fixedname_t fname;
+	dns_name_t *name = dns_fixedname_initname(&fname);
+	int nzones = 0;
+
+	result = dns_test_makeview("view", false, false, &view);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_test_makezone("foo", &foo, view, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	dns_view_beginzonebatch(view);
+
+	result = dns_test_makezone("bar.foo", &bar, view, false);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* Changes are visible to the thread that opened the batch */
+	result = dns_view_findzone(view, dns_zone_getorigin(bar),
+				   DNS_ZTFIND_EXACT, &zone);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_ptr_equal(zone, bar);
+	dns_zone_detach(&zone);
+
+	result = dns_view_apply(view, false, NULL, count_zone, &nzones);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(nzones, 2);
+
+	result = dns_view_delzone(view, foo);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_view_addzone(view, bar);
+	assert_int_equal(result, ISC_R_EXISTS);
+
+	dns_view_endzonebatch(view);
+
+	result = dns_name_fromstring(name, "x.bar.foo", dns_rootname, 0, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_view_findzone(view, name, 0, &zone);
+	assert_int_equal(result, DNS_R_PARTIALMATCH);
+	assert_ptr_equal(zone, bar);
+	dns_zone_detach(&zone);
+
+	result = dns_view_findzone(view, dns_zone_getorigin(foo),
+				   DNS_ZTFIND_EXACT, &zone);
+	assert_int_equal(result, ISC_R_NOTFOUND);
+
+	nzones = 0;
+	result = dns_view_apply(view, false, NULL, count_zone, &nzones);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(nzones, 1);
+
+	/* These steps are necessary so the zones can be detached properly */
+	dns_test_setupzonemgr();
+	result = dns_test_managezone(foo);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_test_managezone(bar);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_test_releasezone(foo);
+	dns_test_releasezone(bar);
+	dns_test_closezonemgr();
+
+	dns_view_detach(&view);
+	dns_zone_detach(&foo);
+	dns_zone_detach(&bar);
+	isc_loopmgr_shutdown(loopmgr);
+}
+
 static isc_result_t
 load_done_last(void *uap) {
 	dns_zone_t *zone = uap;
@@ -273,6 +342,7 @@ ISC_LOOP_TEST_IMPL(asyncload_zt) {
 
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY_CUSTOM(apply, setup_managers, teardown_managers)
+ISC_TEST_ENTRY_CUSTOM(batch, setup_managers, teardown_managers)
 ISC_TEST_ENTRY_CUSTOM(asyncload_zone, setup_managers, teardown_managers)
 ISC_TEST_ENTRY_CUSTOM(asyncload_zt, setup_managers, teardown_managers)
 ISC_TEST_LIST_END
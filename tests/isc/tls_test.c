@@ -25,6 +25,7 @@
  * redefined malloc in cmocka.h.
  */
 #include <openssl/err.h>
+#include <openssl/ssl.h>
 
 #define UNIT_TESTING
 #include <cmocka.h>
@@ -35,7 +36,9 @@
 #include <isc/quota.h>
 #include <isc/refcount.h>
 #include <isc/sockaddr.h>
+#include <isc/stats.h>
 #include <isc/thread.h>
+#include <isc/tls.h>
 #include <isc/util.h>
 #include <isc/uv.h>
 
@@ -114,6 +117,233 @@ ISC_LOOP_TEST_IMPL(tls_recv_send_quota_sendback) {
 	stream_recv_send(arg);
 }
 
+/*
+ * Send a single message spanning several TLS records: the records
+ * produced by OpenSSL are appended by the outgoing BIO to one send
+ * request, which has to grow well past its preallocated buffer.
+ */
+#define LARGE_MSG_SIZE (4 * 16384 + 1000)
+
+static uint8_t large_msg[LARGE_MSG_SIZE];
+static size_t large_received = 0;
+
+static void
+large_send_cb(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
+	isc_nmhandle_t *sendhandle = handle;
+
+	UNUSED(cbarg);
+
+	assert_int_equal(eresult, ISC_R_SUCCESS);
+	atomic_fetch_add(&csends, 1);
+
+	isc_nmhandle_detach(&sendhandle);
+}
+
+static void
+large_connect_cb(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
+	isc_nmhandle_t *sendhandle = NULL;
+	isc_region_t region = { .base = large_msg,
+				.length = sizeof(large_msg) };
+
+	UNUSED(cbarg);
+
+	isc_refcount_decrement(&active_cconnects);
+	assert_int_equal(eresult, ISC_R_SUCCESS);
+	atomic_fetch_add(&cconnects, 1);
+
+	isc_nmhandle_attach(handle, &sendhandle);
+	isc_nm_send(sendhandle, &region, large_send_cb, NULL);
+}
+
+static void
+large_read_cb(isc_nmhandle_t *handle, isc_result_t eresult,
+	      isc_region_t *region, void *cbarg) {
+	isc_nmhandle_t *readhandle = cbarg;
+
+	UNUSED(handle);
+
+	if (eresult != ISC_R_SUCCESS) {
+		isc_nmhandle_detach(&readhandle);
+		return;
+	}
+
+	assert_true(large_received + region->length <= sizeof(large_msg));
+	assert_memory_equal(region->base, large_msg + large_received,
+			    region->length);
+	large_received += region->length;
+
+	if (large_received == sizeof(large_msg)) {
+		atomic_fetch_add(&sreads, 1);
+		isc_loopmgr_shutdown(loopmgr);
+	}
+}
+
+static isc_result_t
+large_accept_cb(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
+	isc_nmhandle_t *readhandle = NULL;
+
+	UNUSED(cbarg);
+
+	if (eresult != ISC_R_SUCCESS) {
+		return (eresult);
+	}
+
+	atomic_fetch_add(&saccepts, 1);
+
+	isc_nmhandle_attach(handle, &readhandle);
+	isc_nm_read(handle, large_read_cb, readhandle);
+
+	return (ISC_R_SUCCESS);
+}
+
+static int
+tls_send_large_setup(void **state) {
+	size_t i;
+
+	for (i = 0; i < sizeof(large_msg); i++) {
+		large_msg[i] = (uint8_t)(i * 7 + i / 256);
+	}
+	large_received = 0;
+
+	return (setup_netmgr_test(state));
+}
+
+static int
+tls_send_large_teardown(void **state) {
+	atomic_assert_int_eq(cconnects, 1);
+	atomic_assert_int_eq(csends, 1);
+	atomic_assert_int_eq(saccepts, 1);
+	atomic_assert_int_eq(sreads, 1);
+	assert_int_equal(large_received, sizeof(large_msg));
+
+	return (teardown_netmgr_test(state));
+}
+
+ISC_LOOP_TEST_IMPL(tls_send_large) {
+	isc_result_t result;
+
+	result = stream_listen(large_accept_cb, NULL, 128, NULL, &listen_sock);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	isc_loop_teardown(mainloop, stop_listening, listen_sock);
+
+	stream_connect(large_connect_cb, NULL, T_CONNECT);
+}
+
+/*
+ * Complete a TLS 1.2 handshake in memory between a new client using
+ * 'client_ctx' and a new server using 'server_ctx', offering 'session'
+ * for resumption if it is not NULL.  Returns whether the session was
+ * resumed; the client session (with the ticket it ended up with) is
+ * returned in '*sessionp'.
+ */
+static bool
+ticket_handshake(isc_tlsctx_t *server_ctx, isc_tlsctx_t *client_ctx,
+		 SSL_SESSION *session, SSL_SESSION **sessionp) {
+	isc_tls_t *server = isc_tls_create(server_ctx);
+	isc_tls_t *client = isc_tls_create(client_ctx);
+	BIO *server_bio = NULL, *client_bio = NULL;
+	int server_ret = 0, client_ret = 0;
+	bool reused;
+
+	assert_non_null(server);
+	assert_non_null(client);
+
+	assert_int_equal(BIO_new_bio_pair(&server_bio, 0, &client_bio, 0), 1);
+	SSL_set_bio(server, server_bio, server_bio);
+	SSL_set_bio(client, client_bio, client_bio);
+	SSL_set_accept_state(server);
+	SSL_set_connect_state(client);
+	assert_int_equal(SSL_set_max_proto_version(client, TLS1_2_VERSION), 1);
+	if (session != NULL) {
+		assert_int_equal(SSL_set_session(client, session), 1);
+	}
+
+	for (size_t i = 0; i < 100 && (client_ret != 1 || server_ret != 1);
+	     i++)
+	{
+		if (client_ret != 1) {
+			client_ret = SSL_do_handshake(client);
+		}
+		if (server_ret != 1) {
+			server_ret = SSL_do_handshake(server);
+		}
+	}
+	assert_int_equal(client_ret, 1);
+	assert_int_equal(server_ret, 1);
+	isc_tls_handshake_done(server);
+
+	reused = (SSL_session_reused(client) == 1);
+	*sessionp = SSL_get1_session(client);
+	assert_non_null(*sessionp);
+
+	isc_tls_free(&client);
+	isc_tls_free(&server);
+
+	return (reused);
+}
+
+/*
+ * Tickets issued by one server context are accepted by another one
+ * sharing the same keys, remain usable (and get renewed) for one key
+ * rotation, and are rejected after the second one.
+ */
+ISC_RUN_TEST_IMPL(tls_ticket_keys) {
+	isc_tlsctx_ticket_keys_t *keys = NULL;
+	isc_tlsctx_t *server_ctx1 = NULL, *server_ctx2 = NULL;
+	isc_tlsctx_t *client_ctx = NULL;
+	SSL_SESSION *first = NULL, *renewed = NULL, *session = NULL;
+	isc_stats_t *stats = NULL;
+
+	isc_tlsctx_ticket_keys_create(mctx, 3600, &keys);
+	assert_int_equal(isc_tlsctx_createserver(NULL, NULL, &server_ctx1),
+			 ISC_R_SUCCESS);
+	assert_int_equal(isc_tlsctx_createserver(NULL, NULL, &server_ctx2),
+			 ISC_R_SUCCESS);
+	assert_int_equal(isc_tlsctx_createclient(&client_ctx), ISC_R_SUCCESS);
+	isc_tlsctx_set_ticket_keys(server_ctx1, keys);
+	isc_tlsctx_set_ticket_keys(server_ctx2, keys);
+
+	/* Full handshake: a ticket is issued with the current key */
+	assert_false(ticket_handshake(server_ctx1, client_ctx, NULL, &first));
+
+	/* The ticket is accepted by the other listener */
+	assert_true(ticket_handshake(server_ctx2, client_ctx, first, &session));
+	SSL_SESSION_free(session);
+
+	/* After a rotation, the ticket is still accepted, and renewed */
+	isc_tlsctx_ticket_keys_rotate(keys);
+	assert_true(ticket_handshake(server_ctx1, client_ctx, first,
+				     &renewed));
+
+	/* After another rotation, the original ticket is rejected... */
+	isc_tlsctx_ticket_keys_rotate(keys);
+	assert_false(ticket_handshake(server_ctx2, client_ctx, first,
+				      &session));
+	SSL_SESSION_free(session);
+
+	/* ...while the renewed one is still accepted */
+	assert_true(ticket_handshake(server_ctx1, client_ctx, renewed,
+				     &session));
+	SSL_SESSION_free(session);
+
+	isc_tlsctx_ticket_keys_getstats(keys, &stats);
+	assert_int_equal(
+		isc_stats_get_counter(stats, isc_tlsticketcounter_resumed), 3);
+	assert_int_equal(
+		isc_stats_get_counter(stats, isc_tlsticketcounter_unknownkey),
+		1);
+	assert_true(isc_stats_get_counter(stats, isc_tlsticketcounter_issued) >=
+		    3);
+	isc_stats_detach(&stats);
+
+	SSL_SESSION_free(renewed);
+	SSL_SESSION_free(first);
+	isc_tlsctx_free(&client_ctx);
+	isc_tlsctx_free(&server_ctx2);
+	isc_tlsctx_free(&server_ctx1);
+	isc_tlsctx_ticket_keys_detach(&keys);
+}
+
 /* PROXY tests */
 
 ISC_LOOP_TEST_IMPL(proxy_tls_noop) { loop_test_tls_noop(arg); }
@@ -183,6 +413,11 @@ ISC_TEST_ENTRY_CUSTOM(tls_recv_send_quota, stream_recv_send_setup,
 ISC_TEST_ENTRY_CUSTOM(tls_recv_send_quota_sendback, stream_recv_send_setup,
 		      stream_recv_send_teardown)
 
+ISC_TEST_ENTRY_CUSTOM(tls_send_large, tls_send_large_setup,
+		      tls_send_large_teardown)
+
+ISC_TEST_ENTRY(tls_ticket_keys)
+
 /* PROXY */
 
 /* TLS */
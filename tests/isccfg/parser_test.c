@@ -12,6 +12,7 @@
  */
 
 #include <inttypes.h>
+#include <limits.h>
 #include <sched.h> /* IWYU pragma: keep */
 #include <setjmp.h>
 #include <stdarg.h>
@@ -216,12 +217,70 @@ ISC_RUN_TEST_IMPL(cfg_map_nextclause) {
 	} while (name != NULL);
 }
 
+static isc_result_t
+directory_callback(const char *clausename, const cfg_obj_t *obj, void *arg) {
+	UNUSED(clausename);
+
+	cfg_parser_setdirectory(arg, cfg_obj_asstring(obj));
+	return (ISC_R_SUCCESS);
+}
+
+/* test cfg_parser_setdirectory() */
+ISC_RUN_TEST_IMPL(cfg_parser_setdirectory) {
+	isc_result_t result;
+	char dir[] = "parser_test.XXXXXX";
+	char path[PATH_MAX], cwd[PATH_MAX], text[1024];
+	isc_buffer_t buf;
+	cfg_parser_t *p = NULL;
+	cfg_obj_t *conf = NULL;
+	const cfg_obj_t *obj = NULL;
+	FILE *f = NULL;
+
+	assert_non_null(mkdtemp(dir));
+	snprintf(path, sizeof(path), "%s/include.conf", dir);
+	f = fopen(path, "w");
+	assert_non_null(f);
+	fputs("acl included { any; };\n", f);
+	fclose(f);
+	assert_non_null(getcwd(cwd, sizeof(cwd)));
+
+	/* Relative includes after "directory" are found in it */
+	snprintf(text, sizeof(text),
+		 "options { directory \"%s\"; };\n"
+		 "include \"include.conf\";\n",
+		 dir);
+	isc_buffer_init(&buf, text, strlen(text));
+	isc_buffer_add(&buf, strlen(text));
+
+	result = cfg_parser_create(mctx, lctx, &p);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	cfg_parser_setcallback(p, directory_callback, p);
+
+	result = cfg_parse_buffer(p, &buf, "text", 0, &cfg_type_namedconf, 0,
+				  &conf);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = cfg_map_get(conf, "acl", &obj);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* ...without changing the working directory */
+	assert_non_null(getcwd(path, sizeof(path)));
+	assert_string_equal(path, cwd);
+
+	cfg_obj_destroy(p, &conf);
+	cfg_parser_destroy(&p);
+
+	snprintf(path, sizeof(path), "%s/include.conf", dir);
+	assert_int_equal(unlink(path), 0);
+	assert_int_equal(rmdir(dir), 0);
+}
+
 ISC_TEST_LIST_START
 
 ISC_TEST_ENTRY(addzoneconf)
 ISC_TEST_ENTRY(parse_buffer)
 ISC_TEST_ENTRY(cfg_map_firstclause)
 ISC_TEST_ENTRY(cfg_map_nextclause)
+ISC_TEST_ENTRY(cfg_parser_setdirectory)
 
 ISC_TEST_LIST_END
 
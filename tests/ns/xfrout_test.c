@@ -0,0 +1,671 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/buffer.h>
+#include <isc/util.h>
+
+#include <dns/compress.h>
+#include <dns/db.h>
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rdataset.h>
+#include <dns/tsig.h>
+
+#include <dst/dst.h>
+
+#include <ns/client.h>
+
+/* Include the main file */
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wshadow"
+#undef CHECK
+#include "xfrout.c"
+#pragma GCC diagnostic pop
+
+#undef CHECK
+#include <tests/ns.h>
+
+/*
+ * A stream of 'nrecs' records, of which only the position is tracked.
+ */
+typedef struct {
+	rrstream_t common;
+	unsigned int nrecs;
+	unsigned int pos;
+} test_rrstream_t;
+
+static isc_result_t
+test_rrstream_first(rrstream_t *rs) {
+	test_rrstream_t *s = (test_rrstream_t *)rs;
+
+	s->pos = 0;
+	return (s->nrecs > 0 ? ISC_R_SUCCESS : ISC_R_NOMORE);
+}
+
+static isc_result_t
+test_rrstream_next(rrstream_t *rs) {
+	test_rrstream_t *s = (test_rrstream_t *)rs;
+
+	if (s->pos + 1 >= s->nrecs) {
+		return (ISC_R_NOMORE);
+	}
+	s->pos++;
+	return (ISC_R_SUCCESS);
+}
+
+static rrstream_methods_t test_rrstream_methods = {
+	test_rrstream_first, test_rrstream_next, NULL, NULL, NULL
+};
+
+/* Length of the question and answer sections of each test message */
+#define TEST_MSGLEN 64
+
+typedef struct {
+	xfrout_ctx_t xfr;
+	test_rrstream_t stream;
+} test_xfr_t;
+
+static dns_db_t *db = NULL;
+static dns_name_t *qname = NULL;
+static dns_fixedname_t fqname;
+static ns_client_t *client = NULL;
+
+static void
+test_xfr_init(test_xfr_t *t, uint32_t end_serial, unsigned int nrecs) {
+	*t = (test_xfr_t){
+		.stream = {
+			.common = {
+				.mctx = mctx,
+				.methods = &test_rrstream_methods,
+			},
+			.nrecs = nrecs,
+		},
+		.xfr = {
+			.mctx = mctx,
+			.client = client,
+			.qname = qname,
+			.qtype = dns_rdatatype_axfr,
+			.qclass = dns_rdataclass_in,
+			.db = db,
+			.end_serial = end_serial,
+			.many_answers = true,
+		},
+	};
+	t->xfr.stream = &t->stream.common;
+	assert_int_equal(test_rrstream_first(t->xfr.stream), ISC_R_SUCCESS);
+}
+
+/*
+ * Pretend that 'xfr' has rendered a message with 'nrecs' records and
+ * add it to the entry it is filling in.
+ */
+static void
+test_xfr_fill(xfrout_ctx_t *xfr, unsigned int nrecs, bool last) {
+	unsigned char data[DNS_MESSAGE_HEADERLEN + TEST_MSGLEN] = { 0 };
+	dns_message_t *msg = NULL;
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTRENDER, &msg);
+	msg->counts[DNS_SECTION_QUESTION] = 0;
+	msg->counts[DNS_SECTION_ANSWER] = nrecs;
+
+	isc_buffer_init(&xfr->txbuf, data, sizeof(data));
+	isc_buffer_add(&xfr->txbuf, sizeof(data));
+	xfr->end_of_stream = last;
+
+	xfrout_cache_fill(xfr, msg, 0, nrecs);
+
+	dns_message_detach(&msg);
+}
+
+static xfrcache_msg_t *
+test_xfr_next(xfrout_ctx_t *xfr) {
+	xfrcache_msg_t *cmsg = NULL;
+
+	assert_int_equal(xfrout_cache_next(xfr, &cmsg), ISC_R_SUCCESS);
+	return (cmsg);
+}
+
+static int
+setup_test(void **state) {
+	isc_result_t result;
+	int ret = setup_server(state);
+
+	if (ret != 0) {
+		return (ret);
+	}
+
+	result = dst_lib_init(mctx, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = ns_test_loaddb(&db, dns_dbtype_zone, "example.com",
+				TESTS_DIR "/testdata/notify/zone1.db");
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	qname = dns_fixedname_initname(&fqname);
+	dns_name_copy(dns_db_origin(db), qname);
+
+	return (0);
+}
+
+static int
+teardown_test(void **state) {
+	dns_db_detach(&db);
+	dst_lib_destroy();
+
+	return (teardown_server(state));
+}
+
+static void
+test_client_get(void) {
+	isc_result_t result;
+
+	result = ns_test_getclient(NULL, true, &client);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_test_makeview("view", false, false, &client->view);
+	assert_int_equal(result, ISC_R_SUCCESS);
+}
+
+static void
+test_client_done(void) {
+	isc_nmhandle_t *handle = client->handle;
+
+	isc_nmhandle_detach(&client->handle);
+	isc_nmhandle_detach(&handle);
+	client = NULL;
+
+	isc_loop_teardown(mainloop, shutdown_interfacemgr, NULL);
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* readers replay an entry while it is filled in, then catch up */
+ISC_LOOP_TEST_IMPL(xfrcache_fill_next) {
+	isc_result_t result;
+	ns_xfrcache_t *cache = sctx->xfrcache;
+	test_xfr_t filler, reader, late;
+	xfrcache_entry_t *entry = NULL;
+	xfrcache_msg_t *cmsg = NULL;
+	dns_db_t *newdb = NULL;
+
+	UNUSED(arg);
+
+	test_client_get();
+
+	/* The first transfer misses and fills in a new entry */
+	test_xfr_init(&filler, 1, 10);
+	xfrout_cache_attach(&filler.xfr, false, 0);
+	entry = filler.xfr.cache;
+	assert_non_null(entry);
+	assert_true(filler.xfr.cache_fill);
+	assert_int_equal(cache->nentries, 1);
+	assert_int_equal(isc_refcount_current(&entry->references), 2);
+
+	test_xfr_fill(&filler.xfr, 2, false);
+	test_xfr_fill(&filler.xfr, 3, false);
+	assert_false(entry->complete);
+
+	/* The next one replays it while it is still being filled in */
+	test_xfr_init(&reader, 1, 10);
+	xfrout_cache_attach(&reader.xfr, false, 0);
+	assert_ptr_equal(reader.xfr.cache, entry);
+	assert_false(reader.xfr.cache_fill);
+	assert_int_equal(isc_refcount_current(&entry->references), 3);
+
+	cmsg = test_xfr_next(&reader.xfr);
+	assert_ptr_equal(cmsg, ISC_LIST_HEAD(entry->msgs));
+	assert_int_equal(cmsg->nrecs, 2);
+	cmsg = test_xfr_next(&reader.xfr);
+	assert_ptr_equal(cmsg, ISC_LIST_TAIL(entry->msgs));
+	assert_false(reader.xfr.end_of_stream);
+	assert_int_equal(reader.xfr.cache_nrecs, 5);
+
+	/* Having caught up, it skips its stream forward and leaves */
+	assert_null(test_xfr_next(&reader.xfr));
+	assert_null(reader.xfr.cache);
+	assert_int_equal(reader.stream.pos, 5);
+	assert_int_equal(isc_refcount_current(&entry->references), 2);
+
+	/* The filler completes the entry, which stays in the cache */
+	test_xfr_fill(&filler.xfr, 5, true);
+	assert_true(entry->complete);
+	xfrout_cache_detach(&filler.xfr);
+	assert_int_equal(cache->nentries, 1);
+	assert_true(entry->linked);
+
+	/* A late transfer replays the whole of it */
+	test_xfr_init(&late, 1, 10);
+	xfrout_cache_attach(&late.xfr, false, 0);
+	assert_ptr_equal(late.xfr.cache, entry);
+	for (size_t i = 0; i < 3; i++) {
+		assert_false(late.xfr.end_of_stream);
+		assert_non_null(test_xfr_next(&late.xfr));
+	}
+	assert_true(late.xfr.end_of_stream);
+	assert_int_equal(late.xfr.cache_nrecs, 10);
+	assert_int_equal(late.stream.pos, 0);
+	xfrout_cache_detach(&late.xfr);
+	assert_int_equal(isc_refcount_current(&entry->references), 1);
+
+	/* A newer version of the zone drops the entry */
+	test_xfr_init(&late, 2, 10);
+	xfrout_cache_attach(&late.xfr, false, 0);
+	assert_true(late.xfr.cache_fill);
+	assert_int_equal(cache->nentries, 1);
+	entry = late.xfr.cache;
+	test_xfr_fill(&late.xfr, 10, true);
+	xfrout_cache_detach(&late.xfr);
+	assert_int_equal(cache->nentries, 1);
+
+	/* So does a reloaded zone, even with the same serial number */
+	result = ns_test_loaddb(&newdb, dns_dbtype_zone, "example.com",
+				TESTS_DIR "/testdata/notify/zone1.db");
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_not_equal(dns_db_instance(newdb), dns_db_instance(db));
+
+	test_xfr_init(&late, 2, 10);
+	late.xfr.db = newdb;
+	xfrout_cache_attach(&late.xfr, false, 0);
+	assert_ptr_not_equal(late.xfr.cache, entry);
+	assert_true(late.xfr.cache_fill);
+	assert_int_equal(cache->nentries, 1);
+	xfrout_cache_detach(&late.xfr);
+	assert_int_equal(cache->nentries, 0);
+	dns_db_detach(&newdb);
+
+	test_client_done();
+}
+
+/* an entry whose filler fails is dropped, but readers keep it */
+ISC_LOOP_TEST_IMPL(xfrcache_fill_fail) {
+	ns_xfrcache_t *cache = sctx->xfrcache;
+	test_xfr_t filler, reader, short_reader;
+	xfrcache_entry_t *entry = NULL;
+
+	UNUSED(arg);
+
+	test_client_get();
+
+	test_xfr_init(&filler, 1, 10);
+	xfrout_cache_attach(&filler.xfr, false, 0);
+	entry = filler.xfr.cache;
+	test_xfr_fill(&filler.xfr, 4, false);
+
+	test_xfr_init(&reader, 1, 10);
+	xfrout_cache_attach(&reader.xfr, false, 0);
+	assert_ptr_equal(reader.xfr.cache, entry);
+	assert_non_null(test_xfr_next(&reader.xfr));
+
+	/* A reader whose stream is shorter than the entry fails */
+	test_xfr_init(&short_reader, 1, 3);
+	xfrout_cache_attach(&short_reader.xfr, false, 0);
+	assert_non_null(test_xfr_next(&short_reader.xfr));
+	assert_int_equal(xfrout_cache_leave(&short_reader.xfr),
+			 ISC_R_UNEXPECTED);
+	xfrout_cache_detach(&short_reader.xfr);
+
+	/* The filler fails before completing the entry */
+	xfrout_cache_detach(&filler.xfr);
+	assert_null(filler.xfr.cache);
+	assert_false(entry->linked);
+	assert_int_equal(cache->nentries, 0);
+	assert_int_equal(cache->nbytes, 0);
+	assert_int_equal(isc_refcount_current(&entry->references), 1);
+
+	/* The reader catches up and renders the rest itself */
+	assert_null(test_xfr_next(&reader.xfr));
+	assert_null(reader.xfr.cache);
+	assert_int_equal(reader.stream.pos, 4);
+
+	/* The next transfer starts over */
+	test_xfr_init(&filler, 1, 10);
+	xfrout_cache_attach(&filler.xfr, false, 0);
+	assert_true(filler.xfr.cache_fill);
+	assert_int_equal(cache->nentries, 1);
+	xfrout_cache_detach(&filler.xfr);
+	assert_int_equal(cache->nentries, 0);
+
+	test_client_done();
+}
+
+/* the cache stays within its configured limits */
+ISC_LOOP_TEST_IMPL(xfrcache_limits) {
+	ns_xfrcache_t *cache = sctx->xfrcache;
+	test_xfr_t first, second;
+	xfrcache_entry_t *entry = NULL;
+
+	UNUSED(arg);
+
+	test_client_get();
+
+	/* Only one transfer is kept */
+	ns_xfrcache_setlimits(cache, XFRCACHE_MAXBYTES, 1);
+
+	test_xfr_init(&first, 1, 10);
+	xfrout_cache_attach(&first.xfr, true, 0);
+	entry = first.xfr.cache;
+	test_xfr_fill(&first.xfr, 10, true);
+	xfrout_cache_detach(&first.xfr);
+	assert_int_equal(cache->nentries, 1);
+
+	test_xfr_init(&second, 1, 10);
+	xfrout_cache_attach(&second.xfr, false, 0);
+	assert_ptr_not_equal(second.xfr.cache, entry);
+	assert_int_equal(cache->nentries, 1);
+	assert_ptr_equal(ISC_LIST_HEAD(cache->entries), second.xfr.cache);
+	xfrout_cache_detach(&second.xfr);
+
+	/* A transfer larger than half of the size limit is not cached */
+	ns_xfrcache_setlimits(cache, 3 * TEST_MSGLEN, 64);
+
+	test_xfr_init(&first, 1, 10);
+	xfrout_cache_attach(&first.xfr, false, 0);
+	assert_non_null(first.xfr.cache);
+	test_xfr_fill(&first.xfr, 5, false);
+	assert_non_null(first.xfr.cache);
+	assert_int_equal(cache->nbytes, TEST_MSGLEN);
+	test_xfr_fill(&first.xfr, 5, true);
+	assert_null(first.xfr.cache);
+	assert_false(first.xfr.cache_fill);
+	assert_int_equal(cache->nentries, 0);
+	assert_int_equal(cache->nbytes, 0);
+
+	/* Caching can be disabled */
+	ns_xfrcache_setlimits(cache, 0, 64);
+
+	test_xfr_init(&first, 1, 10);
+	xfrout_cache_attach(&first.xfr, false, 0);
+	assert_null(first.xfr.cache);
+	assert_int_equal(cache->nentries, 0);
+
+	test_client_done();
+}
+
+/* Time at which the test messages are signed */
+#define TEST_TSIGTIME 1700000000
+
+static void
+test_addquestion(dns_message_t *msg) {
+	dns_name_t *name = NULL;
+	dns_rdataset_t *rdataset = NULL;
+
+	dns_message_gettempname(msg, &name);
+	dns_name_copy(qname, name);
+	dns_message_gettemprdataset(msg, &rdataset);
+	dns_rdataset_makequestion(rdataset, dns_rdataclass_in,
+				  dns_rdatatype_axfr);
+	ISC_LIST_APPEND(name->list, rdataset, link);
+	dns_message_addname(msg, name, DNS_SECTION_QUESTION);
+}
+
+static void
+test_addsoa(dns_message_t *msg) {
+	isc_result_t result;
+	dns_dbnode_t *node = NULL;
+	dns_name_t *name = NULL;
+	dns_rdataset_t *rdataset = NULL;
+
+	result = dns_db_findnode(db, qname, false, &node);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_message_gettemprdataset(msg, &rdataset);
+	result = dns_db_findrdataset(db, node, NULL, dns_rdatatype_soa, 0, 0,
+				     rdataset, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_db_detachnode(db, &node);
+
+	dns_message_gettempname(msg, &name);
+	dns_name_copy(qname, name);
+	ISC_LIST_APPEND(name->list, rdataset, link);
+	dns_message_addname(msg, name, DNS_SECTION_ANSWER);
+}
+
+/*
+ * Sign an AXFR request with 'key' and return its TSIG.
+ */
+static isc_buffer_t *
+test_querytsig(dns_tsigkey_t *key) {
+	unsigned char data[512];
+	isc_buffer_t buf, *querytsig = NULL;
+	dns_message_t *msg = NULL;
+	dns_compress_t cctx;
+
+	isc_buffer_init(&buf, data, sizeof(data));
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTRENDER, &msg);
+	msg->id = 0x1234;
+	msg->fuzzing = 1;
+	msg->fuzztime = TEST_TSIGTIME;
+	assert_int_equal(dns_message_settsigkey(msg, key), ISC_R_SUCCESS);
+	test_addquestion(msg);
+
+	dns_compress_init(&cctx, mctx, 0);
+	assert_int_equal(dns_message_renderbegin(msg, &cctx, &buf),
+			 ISC_R_SUCCESS);
+	assert_int_equal(dns_message_rendersection(msg, DNS_SECTION_QUESTION,
+						   0),
+			 ISC_R_SUCCESS);
+	assert_int_equal(dns_message_renderend(msg), ISC_R_SUCCESS);
+	dns_compress_invalidate(&cctx);
+
+	assert_int_equal(dns_message_getquerytsig(msg, mctx, &querytsig),
+			 ISC_R_SUCCESS);
+	assert_non_null(querytsig);
+	dns_message_detach(&msg);
+
+	return (querytsig);
+}
+
+/*
+ * Render a signed transfer message into 'data' the way sendstream()
+ * does: from 'cmsg' if it is not NULL, otherwise from the database,
+ * filling in the entry of 'xfr'.  '*tsigp' is the TSIG of the previous
+ * message and is replaced by the TSIG of this one.
+ */
+static unsigned int
+test_render(xfrout_ctx_t *xfr, dns_tsigkey_t *key, isc_buffer_t **tsigp,
+	    const xfrcache_msg_t *cmsg, unsigned char *data, size_t size) {
+	dns_message_t *msg = NULL;
+	dns_compress_t cctx;
+	unsigned int qdlen, length;
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTRENDER, &msg);
+	msg->id = 0x1234;
+	msg->flags = DNS_MESSAGEFLAG_QR | DNS_MESSAGEFLAG_AA;
+	msg->fuzzing = 1;
+	msg->fuzztime = TEST_TSIGTIME;
+	assert_int_equal(dns_message_settsigkey(msg, key), ISC_R_SUCCESS);
+	dns_message_setquerytsig(msg, *tsigp);
+	isc_buffer_free(tsigp);
+	msg->verified_sig = true;
+	if (xfr->question_added) {
+		msg->tcp_continuation = 1;
+	}
+	if (cmsg == NULL) {
+		if (!xfr->question_added) {
+			test_addquestion(msg);
+		}
+		test_addsoa(msg);
+	}
+	xfr->question_added = true;
+
+	isc_buffer_init(&xfr->txbuf, data, size);
+	dns_compress_init(&cctx, mctx, DNS_COMPRESS_CASE | DNS_COMPRESS_LARGE);
+	assert_int_equal(dns_message_renderbegin(msg, &cctx, &xfr->txbuf),
+			 ISC_R_SUCCESS);
+	if (cmsg != NULL) {
+		assert_int_equal(xfrout_cache_render(msg, cmsg),
+				 ISC_R_SUCCESS);
+	} else {
+		assert_int_equal(dns_message_rendersection(
+					 msg, DNS_SECTION_QUESTION, 0),
+				 ISC_R_SUCCESS);
+		qdlen = isc_buffer_usedlength(&xfr->txbuf) -
+			DNS_MESSAGE_HEADERLEN;
+		assert_int_equal(dns_message_rendersection(
+					 msg, DNS_SECTION_ANSWER, 0),
+				 ISC_R_SUCCESS);
+		xfrout_cache_fill(xfr, msg, qdlen, 1);
+	}
+	assert_int_equal(dns_message_renderend(msg), ISC_R_SUCCESS);
+	dns_compress_invalidate(&cctx);
+	length = isc_buffer_usedlength(&xfr->txbuf);
+
+	assert_int_equal(dns_message_getquerytsig(msg, mctx, tsigp),
+			 ISC_R_SUCCESS);
+	assert_non_null(*tsigp);
+	dns_message_detach(&msg);
+
+	return (length);
+}
+
+/* replayed messages are signed into the same bytes as rendered ones */
+ISC_LOOP_TEST_IMPL(xfrcache_tsig_replay) {
+	isc_result_t result;
+	unsigned char secret[16] = { 0 };
+	unsigned char rendered[2][1024], replayed[2][1024];
+	unsigned int rlen[2], plen[2];
+	dns_fixedname_t fkeyname;
+	dns_name_t *keyname = NULL;
+	dns_tsigkey_t *key = NULL;
+	isc_buffer_t *tsig = NULL;
+	test_xfr_t filler, reader;
+
+	UNUSED(arg);
+
+	test_client_get();
+
+	keyname = dns_fixedname_initname(&fkeyname);
+	result = dns_name_fromstring(keyname, "test", dns_rootname, 0, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_tsigkey_create(keyname, DST_ALG_HMACSHA256, secret,
+				    sizeof(secret), mctx, &key);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* A transfer of two messages fills in a new entry */
+	test_xfr_init(&filler, 1, 2);
+	xfrout_cache_attach(&filler.xfr, false, 0);
+	assert_true(filler.xfr.cache_fill);
+
+	tsig = test_querytsig(key);
+	rlen[0] = test_render(&filler.xfr, key, &tsig, NULL, rendered[0],
+			      sizeof(rendered[0]));
+	filler.xfr.end_of_stream = true;
+	rlen[1] = test_render(&filler.xfr, key, &tsig, NULL, rendered[1],
+			      sizeof(rendered[1]));
+	isc_buffer_free(&tsig);
+	assert_true(filler.xfr.cache->complete);
+	xfrout_cache_detach(&filler.xfr);
+
+	/* The next transfer replays it */
+	test_xfr_init(&reader, 1, 2);
+	xfrout_cache_attach(&reader.xfr, false, 0);
+	assert_false(reader.xfr.cache_fill);
+
+	tsig = test_querytsig(key);
+	for (size_t i = 0; i < 2; i++) {
+		assert_false(reader.xfr.end_of_stream);
+		plen[i] = test_render(&reader.xfr, key, &tsig,
+				      test_xfr_next(&reader.xfr), replayed[i],
+				      sizeof(replayed[i]));
+	}
+	assert_true(reader.xfr.end_of_stream);
+	isc_buffer_free(&tsig);
+	xfrout_cache_detach(&reader.xfr);
+
+	for (size_t i = 0; i < 2; i++) {
+		assert_int_equal(plen[i], rlen[i]);
+		assert_memory_equal(replayed[i], rendered[i], rlen[i]);
+	}
+
+	dns_tsigkey_detach(&key);
+
+	test_client_done();
+}
+
+/* ring slots are allocated on first use and reused once sent */
+ISC_LOOP_TEST_IMPL(xfrout_txring) {
+	test_xfr_t t;
+	xfrout_ctx_t *xfr = &t.xfr;
+	xfrout_tx_t *tx = NULL;
+
+	UNUSED(arg);
+
+	test_client_get();
+	test_xfr_init(&t, 1, 10);
+	xfr->txmemlen = NS_CLIENT_TCP_BUFFER_SIZE;
+	for (size_t i = 0; i < ARRAY_SIZE(xfr->txring); i++) {
+		xfr->txring[i] = (xfrout_tx_t){ .xfr = xfr };
+	}
+
+	/* A single message needs a single buffer */
+	tx = xfrout_tx_get(xfr);
+	assert_ptr_equal(tx, &xfr->txring[0]);
+	assert_non_null(tx->mem);
+	for (size_t i = 1; i < ARRAY_SIZE(xfr->txring); i++) {
+		assert_null(xfr->txring[i].mem);
+	}
+
+	/* A message being sent keeps its slot */
+	tx->busy = true;
+	xfr->sends++;
+	assert_int_equal(xfrout_queued(xfr), 1);
+
+	tx = xfrout_tx_get(xfr);
+	assert_ptr_equal(tx, &xfr->txring[1]);
+	assert_non_null(tx->mem);
+
+	/* A delayed message is queued, but not counted as a send */
+	tx->busy = true;
+	xfr->delayed = true;
+	assert_int_equal(xfr->sends, 1);
+	assert_int_equal(xfrout_queued(xfr), 2);
+
+	/* Once sent, the first slot is reused */
+	xfr->txring[0].busy = false;
+	xfr->sends--;
+	assert_int_equal(xfrout_queued(xfr), 1);
+
+	tx = xfrout_tx_get(xfr);
+	assert_ptr_equal(tx, &xfr->txring[0]);
+	assert_null(xfr->txring[2].mem);
+	assert_null(xfr->txring[3].mem);
+
+	for (size_t i = 0; i < ARRAY_SIZE(xfr->txring); i++) {
+		if (xfr->txring[i].mem != NULL) {
+			isc_mem_put(mctx, xfr->txring[i].mem, xfr->txmemlen);
+		}
+	}
+
+	test_client_done();
+}
+
+ISC_TEST_LIST_START
+ISC_TEST_ENTRY_CUSTOM(xfrcache_fill_next, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(xfrcache_fill_fail, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(xfrcache_limits, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(xfrcache_tsig_replay, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(xfrout_txring, setup_test, teardown_test)
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN